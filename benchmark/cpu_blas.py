@@ -0,0 +1,78 @@
+'''
+Compare the BLAS providers of `as_matmul` on CPU
+
+The shapes are those of the MatMul and GEMM tests in `test/60.libop`, where
+the overhead of calling a provider dominates, and the same shapes scaled up.
+Providers not found are skipped. Timings are only reported, not checked, so
+this is not a part of the tests. Run from the repository root:
+
+    PYTHONPATH=python:build:$PYTHONPATH python3 benchmark/cpu_blas.py
+'''
+
+import ctypes.util
+
+import freetensor as ft
+import numpy as np
+
+device = ft.CPU()
+
+# (batch, m, k, n)
+libop_shapes = [(1, 4, 5, 6), (2, 4, 5, 6), (8, 4, 5, 6)]
+shapes = libop_shapes + [
+    (batch, m * 32, k * 32, n * 32) for batch, m, k, n in libop_shapes
+]
+
+providers = ["builtin", "mkl", "openblas", "blis"]
+
+
+def available(blas):
+    if blas == "mkl":
+        return bool(ft.with_mkl())
+    if blas in ("openblas", "blis"):
+        return ctypes.util.find_library(blas) is not None
+    return True
+
+
+def matmul_func(batch, m, k, n):
+
+    @ft.transform
+    def f(a, b, c):
+        a: ft.Var[(batch, m, k), "float32", "input", "cpu"]
+        b: ft.Var[(batch, k, n), "float32", "input", "cpu"]
+        c: ft.Var[(batch, m, n), "float32", "output", "cpu"]
+        #! label: L0
+        for p in range(batch):
+            for i in range(m):
+                for j in range(n):
+                    c[p, i, j] = 0
+                    for q in range(k):
+                        c[p, i, j] += a[p, i, q] * b[p, q, j]
+
+    s = ft.Schedule(f)
+    s.as_matmul("L0")
+    return s.func()
+
+
+def measure(blas, batch, m, k, n):
+    target = device.target()
+    target.set_blas(blas)
+    func = ft.lower(matmul_func(batch, m, k, n), target)
+    driver = ft.Driver(func, ft.codegen(func, target), device)
+    a_np = np.random.uniform(size=(batch, m, k)).astype("float32")
+    b_np = np.random.uniform(size=(batch, k, n)).astype("float32")
+    c_arr = ft.Array(np.zeros((batch, m, n), dtype="float32"))
+    driver.set_args(a=ft.Array(a_np), b=ft.Array(b_np), c=c_arr)
+    return driver.benchmark(min_rounds=5, max_rounds=100).median
+
+
+if __name__ == '__main__':
+    found = [blas for blas in providers if available(blas)]
+    skipped = [blas for blas in providers if blas not in found]
+    if skipped:
+        print(f"Skipped (not found): {', '.join(skipped)}")
+    print(f"{'batch, m, k, n':>20}" +
+          "".join(f" {blas + ' (ms)':>14}" for blas in found))
+    for shape in shapes:
+        times = [measure(blas, *shape) for blas in found]
+        print(f"{str(shape)[1:-1]:>20}" +
+              "".join(f" {t:>14.4f}" for t in times))
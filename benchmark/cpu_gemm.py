@@ -0,0 +1,67 @@
+'''
+Compare the built-in GEMM of `as_matmul` with a loop-nest schedule on CPU
+
+Timings are only reported, not checked, so this is not a part of the tests.
+Run from the repository root:
+
+    PYTHONPATH=python:build:$PYTHONPATH python3 benchmark/cpu_gemm.py
+'''
+
+import freetensor as ft
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+
+
+def matmul(n):
+
+    @ft.transform
+    def f(a, b, c):
+        a: ft.Var[(n, n), "float32", "input", "cpu"]
+        b: ft.Var[(n, n), "float32", "input", "cpu"]
+        c: ft.Var[(n, n), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(n):
+            #! label: L2
+            for j in range(n):
+                #! label: L3
+                for k in range(n):
+                    c[i, j] += a[i, k] * b[k, j]
+
+    return f
+
+
+def loop_nest(n):
+    # Parallel rows, vectorized columns
+    s = ft.Schedule(matmul(n))
+    s.reorder(["L1", "L3", "L2"])
+    s.parallelize("L1", "openmp")
+    s.vectorize("L2")
+    return s.func()
+
+
+def gemm(n):
+    s = ft.Schedule(matmul(n))
+    s.as_matmul("L1")
+    return s.func()
+
+
+def measure(func, n):
+    func = ft.lower(func, target)
+    driver = ft.Driver(func, ft.codegen(func, target), device)
+    a_np = np.random.uniform(size=(n, n)).astype("float32")
+    b_np = np.random.uniform(size=(n, n)).astype("float32")
+    c_arr = ft.Array(np.zeros((n, n), dtype="float32"))
+    # `c` accumulates over the runs, which does not affect the time
+    driver.set_args(a=ft.Array(a_np), b=ft.Array(b_np), c=c_arr)
+    return driver.benchmark(min_rounds=5, max_rounds=50)
+
+
+if __name__ == '__main__':
+    print(f"{'n':>6} {'Loop nest (ms)':>16} {'GEMM (ms)':>12} {'Speedup':>8}")
+    for n in [128, 256, 512, 1024]:
+        loop_time = measure(loop_nest(n), n).median
+        gemm_time = measure(gemm(n), n).median
+        print(f"{n:>6} {loop_time:>16.3f} {gemm_time:>12.3f} "
+              f"{loop_time / gemm_time:>7.2f}x")
@@ -0,0 +1,61 @@
+'''
+Measure the write bandwidth of a large write-only loop nest on CPU, with and
+without streaming stores (`CPUTarget.set_streaming_stores`)
+
+Timings are only reported, not checked, so this is not a part of the tests.
+Run from the repository root:
+
+    PYTHONPATH=python:build:$PYTHONPATH python3 benchmark/cpu_streaming_stores.py
+'''
+
+import freetensor as ft
+import numpy as np
+
+device = ft.CPU()
+
+# 1 GiB of output, larger than the last-level cache of most machines. `x` is
+# only one row, which stays in the cache
+m, n = 4096, 65536
+
+
+def fill_func():
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(n,), "float32", "input", "cpu"]
+        y: ft.Var[(m, n), "float32", "output", "cpu"]
+        #! label: L0
+        for i in range(m):
+            #! label: L1
+            for j in range(n):
+                y[i, j] = x[j] * 2
+
+    s = ft.Schedule(f)
+    s.parallelize("L0", "openmp")
+    s.vectorize("L1")
+    return s.func()
+
+
+def measure(streaming_stores):
+    target = device.target()
+    target.set_streaming_stores(streaming_stores)
+    func = ft.lower(fill_func(), target)
+    driver = ft.Driver(func, ft.codegen(func, target), device)
+    x_np = np.random.rand(n).astype("float32")
+    y_arr = ft.Array(np.zeros((m, n), dtype="float32"))
+    driver.set_args(x=ft.Array(x_np), y=y_arr)
+    return driver.benchmark(min_rounds=5, max_rounds=50, perf_counters=True)
+
+
+if __name__ == '__main__':
+    gbytes = m * n * 4 / 1e9
+    times = {}
+    for streaming_stores in [False, True]:
+        result = measure(streaming_stores)
+        times[streaming_stores] = result.median
+        name = "Streaming stores" if streaming_stores else "Normal stores"
+        print(f"{name}: {result.median:.2f} ms, "
+              f"{gbytes / (result.median / 1e3):.2f} GB/s")
+        for counter, value in sorted(result.counters.items()):
+            print(f"    {counter}: {value:.0f}")
+    print(f"Speedup: {times[False] / times[True]:.2f}x")
@@ -17,7 +17,9 @@ void init_ffi_analyze(py::module_ &m) {
         .def_readonly("access_cnt", &NodeFeature::accessCnt_)
         .def_readonly("load_area", &NodeFeature::loadArea_)
         .def_readonly("store_area", &NodeFeature::storeArea_)
-        .def_readonly("access_area", &NodeFeature::accessArea_);
+        .def_readonly("access_area", &NodeFeature::accessArea_)
+        .def_readonly("load_bytes", &NodeFeature::loadBytes_)
+        .def_readonly("store_bytes", &NodeFeature::storeBytes_);
     m.def("structural_feature", structuralFeature);
 
     m.def(
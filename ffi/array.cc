@@ -9,6 +9,7 @@
 #include <config.h>
 #include <debug.h>
 #include <driver/array.h>
+#include <driver/cpu_memory_pool.h>
 #include <ffi.h>
 
 namespace freetensor {
@@ -58,6 +59,14 @@ static DataType dtypeFromPyTorch(torch::ScalarType t) {
         return DataType::Float64;
     case torch::ScalarType::Bool:
         return DataType::Bool;
+    case torch::ScalarType::Half:
+        return DataType::Float16;
+    case torch::ScalarType::BFloat16:
+        return DataType::BFloat16;
+    case torch::ScalarType::Char:
+        return DataType::Int8;
+    case torch::ScalarType::Byte:
+        return DataType::UInt8;
     default:
         throw DriverError("Unsupported PyTorch data type");
     }
@@ -75,6 +84,14 @@ static torch::ScalarType dtypeToPyTorch(DataType dtype) {
         return torch::ScalarType::Double;
     case DataType::Bool:
         return torch::ScalarType::Bool;
+    case DataType::Float16:
+        return torch::ScalarType::Half;
+    case DataType::BFloat16:
+        return torch::ScalarType::BFloat16;
+    case DataType::Int8:
+        return torch::ScalarType::Char;
+    case DataType::UInt8:
+        return torch::ScalarType::Byte;
     default:
         throw DriverError("Unsupported data type by PyTorch");
     }
@@ -107,14 +124,58 @@ void init_ffi_array(py::module_ &m) {
         .def(SHARE_FROM_NUMPY(int64_t, DataType::Int64))
         .def(SHARE_FROM_NUMPY(int32_t, DataType::Int32))
         .def(SHARE_FROM_NUMPY(bool, DataType::Bool))
-        .def(py::init([](const py::array &np) -> Ref<Array> {
-            // Fallback holder. Don't let PyBind11 cast it automatically, or it
-            // will all end up in float64 (the first initializer)
-            throw DriverError(
-                "Unsupported data type or strides from a NumPy Array. Please "
-                "use freetensor.array factory function, instead of "
-                "freetensor.Array, for strided arrays");
-        }))
+        .def(SHARE_FROM_NUMPY(int8_t, DataType::Int8))
+        .def(SHARE_FROM_NUMPY(uint8_t, DataType::UInt8))
+        .def(
+            py::init([](py::array &np) -> Ref<Array> {
+                // PyBind11 has no C++ type for NumPy's float16. Accept it by
+                // checking the dtype
+                if (np.dtype().is(py::dtype("float16")) &&
+                    (np.flags() & py::array::c_style)) {
+                    std::vector<size_t> shape(np.shape(),
+                                              np.shape() + np.ndim());
+                    return Array::borrowFromRaw(
+                        np.mutable_data(), shape, DataType::Float16,
+                        Ref<Device>::make(TargetType::CPU));
+                }
+                // Fallback holder. Don't let PyBind11 cast it automatically,
+                // or it will all end up in float64 (the first initializer)
+                throw DriverError(
+                    "Unsupported data type or strides from a NumPy Array. "
+                    "Please use freetensor.array factory function, instead of "
+                    "freetensor.Array, for strided arrays");
+            }),
+            "data"_a, py::keep_alive<1, 2>())
+        .def_static(
+            "pack_bools",
+            [](py::array_t<bool, py::array::c_style> &np) {
+                std::vector<size_t> shape(np.shape(), np.shape() + np.ndim());
+                return Ref<Array>::make(
+                    Array::packBools(np.unchecked().data(), shape));
+            },
+            "data"_a.noconvert(),
+            "Pack a NumPy array of booleans into a new packed_bool Array, "
+            "which stores 8 elements per byte")
+        .def_static(
+            "map_file",
+            [](const std::string &path, const std::vector<size_t> &shape,
+               const std::string &dtype, size_t offset, bool copyOnWrite,
+               const std::vector<std::string> &advice) {
+                std::vector<MapAdvice> parsed;
+                parsed.reserve(advice.size());
+                for (auto &&item : advice) {
+                    parsed.emplace_back(parseMapAdvice(item));
+                }
+                return Ref<Array>::make(Array::mapFile(path, shape,
+                                                       parseDType(dtype),
+                                                       offset, copyOnWrite,
+                                                       parsed));
+            },
+            "path"_a, "shape"_a, "dtype"_a, "offset"_a = 0,
+            "copy_on_write"_a = false,
+            "advice"_a = std::vector<std::string>{},
+            "Map a file of raw data in row-major order into a new Array on "
+            "CPU. Only the pages accessed are read from the file")
         .def("__eq__", [](const Ref<Array> &lhs, const Ref<Array> &rhs) {
             /**
              * The feature is for testing serialization
@@ -157,15 +218,59 @@ void init_ffi_array(py::module_ &m) {
     pyArray.def(
         "numpy",
         [](Array &arr) -> py::object {
-            switch (arr.dtype()) {
-                SHARE_TO_NUMPY(double, DataType::Float64)
-                SHARE_TO_NUMPY(float, DataType::Float32)
-                SHARE_TO_NUMPY(int64_t, DataType::Int64)
-                SHARE_TO_NUMPY(int32_t, DataType::Int32)
-                SHARE_TO_NUMPY(bool, DataType::Bool)
-            default:
-                ASSERT(false);
+            if (arr.isView() && arr.dtype() != DataType::BFloat16) {
+                // Let NumPy access the base in place via strides
+                arr.flush();
+                size_t elemBytes = sizeOf(arr.dtype());
+                auto ptr = (uint8_t *)arr.base()->rawSharedTo(
+                               Ref<Device>::make(TargetType::CPU)) +
+                           arr.offset() * elemBytes;
+                std::vector<size_t> strides;
+                for (size_t s : arr.strides()) {
+                    strides.emplace_back(s * elemBytes);
+                }
+                py::array ret(py::dtype(toString(arr.dtype())), arr.shape(),
+                              strides, ptr, py::capsule(ptr, [](void *) {}));
+                if (arr.readOnlyOn(Ref<Device>::make(TargetType::CPU))) {
+                    ret.attr("setflags")("write"_a = false);
+                }
+                return ret;
+            }
+            auto share = [&]() -> py::object {
+                switch (arr.dtype()) {
+                    SHARE_TO_NUMPY(double, DataType::Float64)
+                    SHARE_TO_NUMPY(float, DataType::Float32)
+                    SHARE_TO_NUMPY(int64_t, DataType::Int64)
+                    SHARE_TO_NUMPY(int32_t, DataType::Int32)
+                    SHARE_TO_NUMPY(bool, DataType::Bool)
+                    SHARE_TO_NUMPY(int8_t, DataType::Int8)
+                    SHARE_TO_NUMPY(uint8_t, DataType::UInt8)
+                case DataType::Float16: {
+                    auto ptr =
+                        arr.rawSharedTo(Ref<Device>::make(TargetType::CPU));
+                    return py::array(py::dtype("float16"), arr.shape(), ptr,
+                                     py::capsule(ptr, [](void *) {}));
+                }
+                case DataType::BFloat16:
+                    throw DriverError(
+                        "NumPy has no bfloat16. Please convert the Array to "
+                        "PyTorch, or cast it to another type in the program");
+                case DataType::PackedBool: {
+                    // Bits are not addressable by NumPy. Unpack to a new array
+                    py::array_t<bool> ret(arr.shape());
+                    arr.unpackBools(ret.mutable_data());
+                    return ret;
+                }
+                default:
+                    ASSERT(false);
+                }
+            };
+            auto ret = share();
+            if (arr.readOnlyOn(Ref<Device>::make(TargetType::CPU))) {
+                // Writing to a read-only mapped file would crash
+                ret.attr("setflags")("write"_a = false);
             }
+            return ret;
         },
         py::keep_alive<0, 1>());
 #ifdef FT_WITH_PYTORCH
@@ -195,7 +300,93 @@ void init_ffi_array(py::module_ &m) {
             py::keep_alive<0, 1>());
 #endif // FT_WITH_PYTORCH
     pyArray.def_property_readonly("shape", &Array::shape)
-        .def_property_readonly("dtype", &Array::dtype);
+        .def_property_readonly("dtype", &Array::dtype)
+        .def("alignment_on", &Array::alignmentOn, "device"_a,
+             "Alignment in bytes of the copy on a device, or 0 if there is no "
+             "copy on the device")
+        .def("numa_node_on", &Array::numaNodeOn, "device"_a,
+             "NUMA node of the copy on a CPU device, or -1 if there is no "
+             "copy on the device, or it is not bound to a node")
+        .def("resident_node_on", &Array::residentNodeOn, "device"_a,
+             "offset"_a = 0,
+             "NUMA node where a page of the copy on a CPU device actually "
+             "resides, as reported by the OS, or -1 if unknown. `offset` is "
+             "any byte in the page")
+        .def("place_on", &Array::placeOn, "device"_a,
+             "Move the data to a new copy on a CPU device, placed by the NUMA "
+             "policy of the device. The Array no longer shares memory with "
+             "the user object afterwards")
+        .def("read_only_on", &Array::readOnlyOn, "device"_a,
+             "Whether the copy on a device must not be written, e.g. a file "
+             "mapped read-only")
+        .def_property_readonly("is_view", &Array::isView)
+        .def_property_readonly("contiguous", &Array::contiguous)
+        .def(
+            "__getitem__",
+            [](const Ref<Array> &self, const py::object &index) {
+                auto items = py::isinstance<py::tuple>(index)
+                                 ? index.cast<py::tuple>()
+                                 : py::make_tuple(index);
+                auto &&shape = self->shape();
+                if (items.size() > shape.size()) {
+                    throw DriverError("Too many indices for a " +
+                                      std::to_string(shape.size()) +
+                                      "-D Array");
+                }
+                std::vector<SliceRange> ranges;
+                for (size_t i = 0; i < items.size(); i++) {
+                    auto &&item = items[i];
+                    if (py::isinstance<py::slice>(item)) {
+                        py::ssize_t begin, end, step, len;
+                        if (!item.cast<py::slice>().compute(
+                                shape[i], &begin, &end, &step, &len)) {
+                            throw py::error_already_set();
+                        }
+                        if (step < 0) {
+                            throw DriverError(
+                                "Negative steps are not supported in views "
+                                "of Arrays");
+                        }
+                        ranges.push_back({(size_t)(len > 0 ? begin : 0),
+                                          (size_t)len, (size_t)step, true});
+                    } else {
+                        auto idx = item.cast<py::ssize_t>();
+                        if (idx < 0) {
+                            idx += shape[i];
+                        }
+                        if (idx < 0 || (size_t)idx >= shape[i]) {
+                            throw py::index_error(
+                                "Index " + std::to_string(idx) +
+                                " out of range in dimension " +
+                                std::to_string(i));
+                        }
+                        ranges.push_back({(size_t)idx, 1, 1, false});
+                    }
+                }
+                return Ref<Array>::make(Array::slice(self, ranges));
+            },
+            "index"_a, py::keep_alive<0, 1>(),
+            "A view of a sub-tensor, sharing the data of this Array. Indices "
+            "are integers and slices with non-negative steps");
+
+    m.def(
+        "cpu_memory_pool_stats",
+        []() {
+            auto &&pool = CPUMemoryPool::instance();
+            return std::unordered_map<std::string, size_t>{
+                {"live_bytes", pool.liveBytes()},
+                {"peak_bytes", pool.peakBytes()},
+                {"cached_bytes", pool.cachedBytes()}};
+        },
+        "Statistics of memory allocated on CPU by Arrays and programs, in "
+        "bytes");
+    m.def(
+        "reset_cpu_memory_pool_peak",
+        []() { CPUMemoryPool::instance().resetPeakBytes(); },
+        "Reset the peak statistics to the current live bytes");
+    m.def(
+        "trim_cpu_memory_pool", []() { CPUMemoryPool::instance().trim(); },
+        "Return cached free memory on CPU to the system");
 }
 
 } // namespace freetensor
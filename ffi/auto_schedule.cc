@@ -18,11 +18,12 @@ void init_ffi_auto_schedule(py::module_ &m) {
                  const std::function<void(const AutoSchedule::Features &,
                                           const AutoSchedule::Predicts &)> &,
                  std::string, int, std::optional<size_t>,
-                 const std::optional<std::unordered_set<std::string>> &, int>(),
+                 const std::optional<std::unordered_set<std::string>> &, int,
+                 bool>(),
              "schedule"_a, "target"_a, "device"_a, "predict_func"_a,
              "update_func"_a, "tag"_a = "", "min_block_size"_a = 0,
              "random_seed"_a = std::nullopt, "rule_set"_a = std::nullopt,
-             "verbose"_a = 0)
+             "verbose"_a = 0, "perf_counters"_a = false)
         .def("set_params", &AutoSchedule::setParams, "args"_a,
              "kws"_a = std::unordered_map<std::string, Ref<Array>>())
         .def("search_one_round", &AutoSchedule::searchOneRound, "n"_a,
@@ -32,6 +33,7 @@ void init_ffi_auto_schedule(py::module_ &m) {
         .def("get_best_schedule", &AutoSchedule::getBestSchedule)
         .def("test_round", &AutoSchedule::testRound,
              "nth_sketch"_a = std::unordered_map<std::string, int>())
+        .def("get_last_counters", &AutoSchedule::getLastCounters)
         .def("get_flop", &AutoSchedule::getFlop)
         .def("get_tag", &AutoSchedule::getTag)
         .def("get_best_time", &AutoSchedule::getBestTime);
@@ -8,8 +8,14 @@ namespace freetensor {
 using namespace pybind11::literals;
 
 void init_ffi_codegen(py::module_ &m) {
-    m.def("code_gen", &codeGen, "func"_a, "target"_a);
-    m.def("code_gen_cpu", &codeGenCPU, "func"_a);
+    m.def("code_gen", &codeGen, "func"_a, "target"_a, "profile"_a = nullptr);
+    m.def(
+        "code_gen_cpu",
+        [](const Func &func, const Ref<Selector> &profile,
+           const std::string &blas) {
+            return codeGenCPU(func, profile, parseBLASProvider(blas));
+        },
+        "func"_a, "profile"_a = nullptr, "blas"_a = "default");
     m.def("code_gen_cuda", &codeGenCUDA, "func"_a);
 }
 
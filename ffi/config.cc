@@ -69,6 +69,64 @@ void init_ffi_config(py::module_ &m) {
             return std::vector<std::string>(paths.begin(), paths.end());
         },
         "Backend compiler used to compile generated CUDA code");
+    m.def("set_backend_compiler_jobs", Config::setBackendCompilerJobs,
+          "Set the max number of concurrently running backend compilers. 0 for "
+          "the number of hardware threads",
+          "jobs"_a);
+    m.def("backend_compiler_jobs", Config::backendCompilerJobs,
+          "Max number of concurrently running backend compilers");
+    m.def("set_backend_compiler_timeout", Config::setBackendCompilerTimeout,
+          "Set the timeout of a backend compiler in seconds. 0 for no limit",
+          "seconds"_a);
+    m.def("backend_compiler_timeout", Config::backendCompilerTimeout,
+          "Timeout of a backend compiler in seconds");
+    m.def("set_backend_pch", Config::setBackendPCH,
+          "Reuse a precompiled header of the runtime for every CPU kernel",
+          "flag"_a = true);
+    m.def("backend_pch", Config::backendPCH,
+          "Check if reusing a precompiled header of the runtime");
+    m.def("set_array_huge_pages", Config::setArrayHugePages,
+          "Back large Arrays on CPU with transparent huge pages",
+          "flag"_a = true);
+    m.def("array_huge_pages", Config::arrayHugePages,
+          "Check if backing large Arrays on CPU with huge pages");
+    m.def(
+        "set_kernel_cache_dir",
+        [](const std::string &path) { Config::setKernelCacheDir(path); },
+        "Set the directory to cache compiled kernels across processes. Empty "
+        "to disable",
+        "path"_a);
+    m.def(
+        "kernel_cache_dir",
+        []() { return Config::kernelCacheDir().string(); },
+        "Directory to cache compiled kernels across processes");
+    m.def("set_kernel_cache_size_limit", Config::setKernelCacheSizeLimit,
+          "Set the max total size of cached kernels in bytes", "bytes"_a);
+    m.def("kernel_cache_size_limit", Config::kernelCacheSizeLimit,
+          "Max total size of cached kernels in bytes");
+    m.def("kernel_cache_hits", Config::kernelCacheHits,
+          "Number of kernels loaded from the kernel cache");
+    m.def("kernel_cache_misses", Config::kernelCacheMisses,
+          "Number of kernels compiled and inserted into the kernel cache");
+    m.def("reset_kernel_cache_stats", Config::resetKernelCacheStats,
+          "Reset hit and miss counters of the kernel cache");
+    m.def(
+        "set_openblas_dir",
+        [](const std::string &path) { Config::setOpenBLASDir(path); },
+        "Set the installation prefix of OpenBLAS. Empty to search the system "
+        "paths",
+        "path"_a);
+    m.def(
+        "openblas_dir", []() { return Config::openBLASDir().string(); },
+        "Installation prefix of OpenBLAS");
+    m.def(
+        "set_blis_dir",
+        [](const std::string &path) { Config::setBLISDir(path); },
+        "Set the installation prefix of BLIS. Empty to search the system paths",
+        "path"_a);
+    m.def(
+        "blis_dir", []() { return Config::blisDir().string(); },
+        "Installation prefix of BLIS");
     m.def("set_default_target", Config::setDefaultTarget,
           "Set default target (internal implementation of `with Target`)",
           "target"_a);
@@ -2,6 +2,7 @@
 
 #include <driver/device.h>
 #include <ffi.h>
+#include <serialize/to_string.h>
 
 namespace freetensor {
 
@@ -28,7 +29,22 @@ void init_ffi_device(py::module_ &m) {
 
     py::class_<CPUTarget, Ref<CPUTarget>>(m, "CPUTarget", pyTarget)
         .def("set_use_native_arch", &CPUTarget::setUseNativeArch,
-             "use_native_arch"_a = true);
+             "use_native_arch"_a = true)
+        .def("set_vector_bytes", &CPUTarget::setVectorBytes,
+             "vector_bytes"_a = 0)
+        .def("vector_bytes", &CPUTarget::vectorBytes)
+        .def("set_streaming_stores", &CPUTarget::setStreamingStores,
+             "streaming_stores"_a = true)
+        .def("streaming_stores", &CPUTarget::streamingStores)
+        .def(
+            "set_blas",
+            [](CPUTarget &target, const std::string &blas) {
+                target.setBLAS(parseBLASProvider(blas));
+            },
+            "blas"_a = "default")
+        .def("blas", [](const CPUTarget &target) {
+            return toString(target.blas());
+        });
 
 #ifdef FT_WITH_CUDA
     py::class_<GPUTarget, Ref<GPUTarget>>(m, "GPUTarget", pyTarget)
@@ -48,10 +64,30 @@ void init_ffi_device(py::module_ &m) {
         .def("target", &Device::target)
         .def("main_mem_type", &Device::mainMemType)
         .def("sync", &Device::sync)
+        .def(
+            "set_numa_policy",
+            [](Device &device, const std::string &policy, int node) {
+                device.setNUMAPolicy(parseNUMAPolicy(policy), node);
+            },
+            "policy"_a, "node"_a = -1,
+            "(CPU only) Place Arrays allocated on this device among NUMA "
+            "nodes. Policies are \"default\", \"interleave\", \"bind\" (to "
+            "`node`) and \"first_touch\"")
+        .def("numa_policy",
+             [](const Device &device) {
+                 return toString(device.numaPolicy());
+             })
+        .def("numa_node", &Device::numaNode)
         .def("__eq__", [](const Ref<Device> &lhs, const Ref<Device> &rhs) {
             return *lhs == *rhs;
         });
     py::implicitly_convertible<Device, Target>();
+
+    m.def("numa_nodes", numaNodes,
+          "Number of NUMA nodes in the system. 1 if NUMA is not supported");
+    m.def("numa_allowed_nodes", numaAllowedNodes,
+          "IDs of the NUMA nodes allowed for the process, which are not "
+          "necessarily contiguous");
 }
 
 } // namespace freetensor
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <pybind11/numpy.h>
 #include <vector>
 
@@ -12,11 +13,97 @@ namespace freetensor {
 using namespace pybind11::literals;
 
 void init_ffi_driver(py::module_ &m) {
+    py::class_<std::shared_future<Ref<Driver>>>(m, "DriverFuture")
+        .def(
+            "get",
+            [](const std::shared_future<Ref<Driver>> &f) { return f.get(); },
+            py::call_guard<py::gil_scoped_release>())
+        .def("ready", [](const std::shared_future<Ref<Driver>> &f) {
+            return f.wait_for(std::chrono::seconds(0)) ==
+                   std::future_status::ready;
+        });
+
+    py::class_<DriverFrame>(m, "DriverFrame");
+
+    py::class_<ProfileEntry>(m, "ProfileEntry")
+        .def_readonly("id", &ProfileEntry::id_)
+        .def_readonly("metadata", &ProfileEntry::metadata_)
+        .def_readonly("time", &ProfileEntry::time_)
+        .def_readonly("max_thread_time", &ProfileEntry::maxThreadTime_)
+        .def_readonly("count", &ProfileEntry::count_);
+
+    py::class_<BenchmarkResult>(m, "BenchmarkResult")
+        .def_readonly("times", &BenchmarkResult::times_)
+        .def_readonly("mean", &BenchmarkResult::mean_)
+        .def_readonly("stddev", &BenchmarkResult::stddev_)
+        .def_readonly("rel_ci", &BenchmarkResult::relCI_)
+        .def_readonly("min", &BenchmarkResult::min_)
+        .def_readonly("max", &BenchmarkResult::max_)
+        .def_readonly("median", &BenchmarkResult::median_)
+        .def_readonly("outliers", &BenchmarkResult::outliers_)
+        .def_readonly("converged", &BenchmarkResult::converged_)
+        .def_readonly("counters", &BenchmarkResult::counters_)
+        .def_property_readonly(
+            "rounds",
+            [](const BenchmarkResult &r) { return r.times_.size(); })
+        .def("percentile", &BenchmarkResult::percentile, "q"_a)
+        .def("__repr__", [](const BenchmarkResult &r) {
+            return "<BenchmarkResult: mean=" + std::to_string(r.mean_) +
+                   "ms, median=" + std::to_string(r.median_) +
+                   "ms, min=" + std::to_string(r.min_) +
+                   "ms, rounds=" + std::to_string(r.times_.size()) + ">";
+        });
+
+    py::class_<MachinePeak>(m, "MachinePeak")
+        .def_readonly("gflops32", &MachinePeak::gflops32_)
+        .def_readonly("gflops64", &MachinePeak::gflops64_)
+        .def_readonly("bandwidth", &MachinePeak::bandwidth_)
+        .def("gflops", &MachinePeak::gflops, "dtype"_a)
+        .def("__repr__", [](const MachinePeak &p) {
+            return "<MachinePeak: " + std::to_string(p.gflops32_) +
+                   " GFLOP/s (float32), " + std::to_string(p.gflops64_) +
+                   " GFLOP/s (float64), " + std::to_string(p.bandwidth_) +
+                   " GB/s>";
+        });
+    m.def("machine_peak", &machinePeak, "device"_a, "num_threads"_a = 0,
+          py::call_guard<py::gil_scoped_release>());
+
+    py::class_<RooflineEntry>(m, "RooflineEntry")
+        .def_readonly("id", &RooflineEntry::id_)
+        .def_readonly("metadata", &RooflineEntry::metadata_)
+        .def_readonly("time", &RooflineEntry::time_)
+        .def_readonly("flop", &RooflineEntry::flop_)
+        .def_readonly("bytes", &RooflineEntry::bytes_)
+        .def_readonly("dtype", &RooflineEntry::dtype_)
+        .def_readonly("gflops", &RooflineEntry::gflops_)
+        .def_readonly("bandwidth", &RooflineEntry::bandwidth_)
+        .def_readonly("intensity", &RooflineEntry::intensity_)
+        .def_readonly("attainable_gflops", &RooflineEntry::attainableGFlops_)
+        .def_readonly("memory_bound", &RooflineEntry::memoryBound_)
+        .def_readonly("efficiency", &RooflineEntry::efficiency_);
+
+    py::class_<RooflineReport>(m, "RooflineReport")
+        .def_readonly("peak", &RooflineReport::peak_)
+        .def_readonly("benchmark", &RooflineReport::benchmark_)
+        .def_readonly("total", &RooflineReport::total_)
+        .def_readonly("nests", &RooflineReport::nests_);
+
     py::class_<Driver, Ref<Driver>>(m, "Driver")
         .def(py::init<const Func &, const std::string &, const Ref<Device> &,
                       bool>())
         .def(py::init<const Func &, const std::string &, const Ref<Device> &,
                       const Ref<Device> &, bool>())
+        .def(py::init([](const std::shared_future<Ref<Driver>> &f) {
+                 // Release the GIL only while waiting. pybind11 constructs the
+                 // holder and registers the instance after we return, which
+                 // requires the GIL
+                 Ref<Driver> driver;
+                 {
+                     py::gil_scoped_release release;
+                     driver = f.get();
+                 }
+                 return driver;
+             }))
         .def("set_args",
              static_cast<void (Driver::*)(
                  const std::vector<Ref<Array>> &,
@@ -34,10 +121,110 @@ void init_ffi_driver(py::module_ &m) {
              "kws"_a, py::keep_alive<1, 2>()) // Array may keep ref count of
                                               // user data (numpy), so we should
                                               // keep ref count of Array
-        .def("run", &Driver::run)
+        .def("set_args",
+             static_cast<void (Driver::*)(
+                 DriverFrame &, const std::vector<Ref<Array>> &,
+                 const std::unordered_map<std::string, Ref<Array>> &) const>(
+                 &Driver::setArgs),
+             "frame"_a, "args"_a,
+             "kws"_a = std::unordered_map<std::string, Ref<Array>>(),
+             py::keep_alive<2, 3>(),
+             py::keep_alive<2, 4>()) // Keep ref count of Array in the frame
+        .def("run", static_cast<void (Driver::*)()>(&Driver::run))
+        .def("run",
+             static_cast<void (Driver::*)(DriverFrame &) const>(&Driver::run),
+             "frame"_a, py::call_guard<py::gil_scoped_release>())
         .def("sync", &Driver::sync)
-        .def("collect_returns", &Driver::collectReturns)
-        .def("time", &Driver::time, "rounds"_a = 10, "warmpups"_a = 3);
+        .def("collect_returns",
+             static_cast<std::vector<Ref<Array>> (Driver::*)()>(
+                 &Driver::collectReturns))
+        .def("collect_returns",
+             static_cast<std::vector<Ref<Array>> (Driver::*)(DriverFrame &)
+                             const>(&Driver::collectReturns),
+             "frame"_a)
+        .def("new_frame", &Driver::newFrame)
+        .def("profile",
+             static_cast<std::vector<ProfileEntry> (Driver::*)() const>(
+                 &Driver::profile))
+        .def("profile",
+             static_cast<std::vector<ProfileEntry> (Driver::*)(
+                 const DriverFrame &) const>(&Driver::profile),
+             "frame"_a)
+        .def("reset_profile",
+             static_cast<void (Driver::*)()>(&Driver::resetProfile))
+        .def("reset_profile",
+             static_cast<void (Driver::*)(DriverFrame &) const>(
+                 &Driver::resetProfile),
+             "frame"_a)
+        .def("set_num_threads", &Driver::setNumThreads, "num_threads"_a)
+        .def("num_threads", &Driver::numThreads)
+        .def("set_cpu_affinity", &Driver::setCPUAffinity, "cpus"_a)
+        .def("cpu_affinity", &Driver::cpuAffinity)
+        .def("place_array", &Driver::placeArray, "array"_a)
+        .def("time", &Driver::time, "rounds"_a = 10, "warmpups"_a = 3)
+        .def(
+            "benchmark",
+            [](Driver &self, int warmups, int minRounds, int maxRounds,
+               double targetRelCI, double timeBudget, bool flushCache,
+               bool rejectOutliers, bool perfCounters) {
+                BenchmarkOptions options;
+                options.warmups_ = warmups;
+                options.minRounds_ = minRounds;
+                options.maxRounds_ = maxRounds;
+                options.targetRelCI_ = targetRelCI;
+                options.timeBudget_ = timeBudget;
+                options.flushCache_ = flushCache;
+                options.rejectOutliers_ = rejectOutliers;
+                options.perfCounters_ = perfCounters;
+                return self.benchmark(options);
+            },
+            "warmups"_a = 3, "min_rounds"_a = 5, "max_rounds"_a = 1000,
+            "target_rel_ci"_a = 0.01, "time_budget"_a = 1000,
+            "flush_cache"_a = false, "reject_outliers"_a = true,
+            "perf_counters"_a = false,
+            py::call_guard<py::gil_scoped_release>())
+        .def(
+            "roofline",
+            [](Driver &self, int warmups, int minRounds, int maxRounds,
+               double targetRelCI, double timeBudget) {
+                BenchmarkOptions options;
+                options.warmups_ = warmups;
+                options.minRounds_ = minRounds;
+                options.maxRounds_ = maxRounds;
+                options.targetRelCI_ = targetRelCI;
+                options.timeBudget_ = timeBudget;
+                return self.roofline(options);
+            },
+            "warmups"_a = 3, "min_rounds"_a = 5, "max_rounds"_a = 1000,
+            "target_rel_ci"_a = 0.01, "time_budget"_a = 1000,
+            py::call_guard<py::gil_scoped_release>())
+        .def(
+            "run_batch",
+            [](Driver &self,
+               const std::vector<std::vector<Ref<Array>>> &argSets,
+               size_t parallelism) {
+                auto &&result = self.runBatch(argSets, parallelism);
+                return std::make_pair(std::move(result.returns_),
+                                      std::move(result.latencies_));
+            },
+            "arg_sets"_a, "parallelism"_a = 1,
+            py::call_guard<py::gil_scoped_release>())
+        .def("unload", &Driver::unload)
+        .def("shares_kernel_with", &Driver::sharesKernelWith, "other"_a)
+        .def_property_readonly_static("AUTO_NUM_THREADS", [](py::object) {
+            return Driver::AUTO_NUM_THREADS;
+        });
+
+    m.def("build_driver_async",
+          static_cast<std::shared_future<Ref<Driver>> (*)(
+              const Func &, const std::string &, const Ref<Device> &, bool)>(
+              &buildDriverAsync),
+          "func"_a, "src"_a, "device"_a, "verbose"_a = false);
+    m.def("build_driver_async",
+          static_cast<std::shared_future<Ref<Driver>> (*)(
+              const Func &, const std::string &, const Ref<Device> &,
+              const Ref<Device> &, bool)>(&buildDriverAsync),
+          "func"_a, "src"_a, "device"_a, "host_device"_a, "verbose"_a = false);
 
     // Serialization
     m.def("load_target",
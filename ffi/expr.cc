@@ -318,9 +318,9 @@ void init_ffi_ast_expr(py::module_ &m) {
           "lhs"_a, "rhs"_a);
     m.def("makeIntrinsic",
           static_cast<Expr (*)(const std::string &, const std::vector<Expr> &,
-                               DataType, bool)>(&_makeIntrinsic),
+                               DataType, bool, bool)>(&_makeIntrinsic),
           "fmt"_a, "params"_a, "retType"_a = DataType::Void,
-          "hasSideEffect"_a = false);
+          "hasSideEffect"_a = false, "isHint"_a = false);
 }
 
 } // namespace freetensor
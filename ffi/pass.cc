@@ -1,6 +1,7 @@
 #include <ffi.h>
 #include <lower.h>
 #include <pass/cpu/lower_parallel_reduction.h>
+#include <pass/cpu/lower_vector.h>
 #include <pass/flatten_stmt_seq.h>
 #include <pass/float_simplify.h>
 #include <pass/gpu/lower_parallel_reduction.h>
@@ -151,6 +152,15 @@ void init_ffi_pass(py::module_ &m) {
     m.def("cpu_lower_parallel_reduction",
           static_cast<Stmt (*)(const Stmt &)>(&cpu::lowerParallelReduction));
 
+    m.def("cpu_lower_vector",
+          static_cast<Func (*)(const Func &, const Ref<CPUTarget> &)>(
+              &cpu::lowerVector),
+          "func"_a, "target"_a);
+    m.def("cpu_lower_vector",
+          static_cast<Stmt (*)(const Stmt &, const Ref<CPUTarget> &)>(
+              &cpu::lowerVector),
+          "stmt"_a, "target"_a);
+
     // GPU
 #ifdef FT_WITH_CUDA
     m.def("gpu_lower_parallel_reduction",
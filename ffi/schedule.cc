@@ -129,6 +129,8 @@ void init_ffi_schedule(py::module_ &m) {
         .def("parallelize", &Schedule::parallelize, "loop"_a, "parallel"_a)
         .def("unroll", &Schedule::unroll, "loop"_a, "immedate"_a = false)
         .def("vectorize", &Schedule::vectorize, "loop"_a)
+        .def("prefetch", &Schedule::prefetch, "loop"_a, "var"_a,
+             "distance"_a)
         .def("separate_tail", &Schedule::separateTail,
              "noDuplicateVarDefs"_a = false)
         .def("as_matmul", &Schedule::asMatMul)
@@ -56,6 +56,7 @@ SIGMOID:    '@!sigmoid';
 TANH:       '@!tanh';
 INTRINSIC:  '@!intrinsic';
 SIDE_EFFECT:    '@!side_effect';
+HINT:       '@!hint';
 CLOSURE:    '@!closure';
 
 
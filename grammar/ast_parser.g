@@ -524,12 +524,13 @@ expr returns [Expr node]
       {
         $node = $expr.node;
       }
-    | INTRINSIC '(' String '->' dtype { std::vector<Expr> params; bool hasSideEffect = false; }
+    | INTRINSIC '(' String '->' dtype { std::vector<Expr> params; bool hasSideEffect = false; bool isHint = false; }
         (',' expr { params.emplace_back($expr.node); } )*
         (',' SIDE_EFFECT { hasSideEffect = true; } )?
+        (',' HINT { isHint = true; } )?
         ')'
       {
-        $node = makeIntrinsic(slice($String.text, 1, -1), std::move(params), $dtype.type, hasSideEffect);
+        $node = makeIntrinsic(slice($String.text, 1, -1), std::move(params), $dtype.type, hasSideEffect, isHint);
       }
     ;
 
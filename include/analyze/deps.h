@@ -187,6 +187,11 @@ class FindAccessPoint : public SymbolTable<TrackStmt<Visitor>> {
     void visit(const ReduceTo &op) override { visitStoreLike(op); }
     void visit(const Load &op) override;
     void visit(const MatMul &op) override { (*this)(op->equivalent_); }
+    void visit(const Intrinsic &op) override {
+        if (!op->isHint_) {
+            BaseClass::visit(op);
+        }
+    }
 };
 
 enum class DepDirection : int {
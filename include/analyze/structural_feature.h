@@ -22,6 +22,8 @@ struct NodeFeature {
         accessCnt_; // Memory access count
     std::unordered_map<MemType, int64_t> loadArea_, storeArea_,
         accessArea_; // memory footprint
+    std::unordered_map<MemType, int64_t> loadBytes_,
+        storeBytes_; // memory footprint in bytes
 };
 
 /**
@@ -46,6 +48,7 @@ class StructuralFeature : public CompTransientBounds<SymbolTable<Visitor>> {
 
         std::unordered_map<MemType, int64_t> innerLoadArea_, innerStoreArea_,
             innerAccessArea_;
+        std::unordered_map<MemType, int64_t> innerLoadBytes_, innerStoreBytes_;
 
         // buffer name -> all accesses of this buffer
         // If a key does not exist in loads_, stores_ or accesses_, it
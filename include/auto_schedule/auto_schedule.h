@@ -10,6 +10,7 @@
 #include <auto_schedule/rule.h>
 #include <auto_schedule/sketch.h>
 #include <driver/array.h>
+#include <driver/benchmark.h>
 #include <driver/device.h>
 #include <driver/target.h>
 #include <random.h>
@@ -40,14 +41,17 @@ class AutoSchedule {
     int minBlockSize_{0};
     std::optional<std::unordered_set<std::string>> ruleSet_;
     int verbose_ = 0;
+    bool perfCounters_ = false;
+    std::vector<std::unordered_map<std::string, double>> lastCounters_;
 
   private:
     /**
      * Compile and measure all the sketches
      *
-     * @return : list of average time, list of standard deviation
+     * @return : Results of each sketch. `mean_` is infinity if a sketch fails
+     * to compile or run
      */
-    std::pair<std::vector<double>, std::vector<double>>
+    std::vector<BenchmarkResult>
     measure(const std::vector<Ref<Sketch>> &sketches);
 
   public:
@@ -60,7 +64,7 @@ class AutoSchedule {
                  std::optional<size_t> randomSeed = std::nullopt,
                  const std::optional<std::unordered_set<std::string>> &ruleSet =
                      std::nullopt,
-                 int verbose = 0);
+                 int verbose = 0, bool perfCounters = false);
 
     void setParams(const std::vector<Ref<Array>> &args,
                    const std::unordered_map<std::string, Ref<Array>> &kws);
@@ -81,6 +85,19 @@ class AutoSchedule {
     Schedule getBestSchedule();
     double getBestTime();
 
+    /**
+     * Hardware performance counters of the sketches measured in the last
+     * `testAndAdd` (or `searchOneRound`), in the same order as the throughputs
+     * passed to `updateFunc`, as an extra training signal
+     *
+     * Only recorded if constructed with `perfCounters = true`. See
+     * `PerfCounters` for the keys
+     */
+    const std::vector<std::unordered_map<std::string, double>> &
+    getLastCounters() const {
+        return lastCounters_;
+    }
+
     double getFlop() { return flop_; }
     std::string getTag() { return tag_; }
 
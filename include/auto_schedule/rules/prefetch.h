@@ -0,0 +1,42 @@
+#ifndef FREE_TENSOR_AUTO_SCHEDULE_PREFETCH_H
+#define FREE_TENSOR_AUTO_SCHEDULE_PREFETCH_H
+
+#include <auto_schedule/rule.h>
+
+namespace freetensor {
+
+/**
+ * Prefetch indirect reads (e.g. `x[idx[i]]`) in innermost loops, with a tuned
+ * distance. Only for CPU
+ */
+class PrefetchRule : public Rule {
+  public:
+    RuleStatus analyze(const Sketch &sketch) override;
+    std::vector<Ref<Sketch>> genPart(const Sketch &sketch) override;
+};
+
+class PrefetchPart : public SketchPartNode {
+    int distance_ = 0; /// 0 = no prefetching
+
+  public:
+    void genRandAnnotation(RNG &gen) override;
+    void genFakeAnnotation(RNG &gen) override;
+    bool mutate(RNG &gen) override;
+    bool crossover(const SketchPart &part, RNG &gen) override;
+    void apply(Schedule &schedule, SubSketch &subSketch) override;
+    SketchPartType partType() override { return SketchPartType::Prefetch; }
+    [[nodiscard]] std::vector<int> getAnnotation() const override {
+        return {distance_};
+    };
+    [[nodiscard]] size_t hash() const override {
+        return hashCombine(std::hash<std::string>{}("prefetch"),
+                           std::hash<int>{}(distance_));
+    }
+    [[nodiscard]] SketchPart clone() const override {
+        return Ref<PrefetchPart>::make(*this);
+    };
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_AUTO_SCHEDULE_PREFETCH_H
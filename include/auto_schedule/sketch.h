@@ -22,6 +22,7 @@ enum class SketchPartType : int {
     ThreadBind = 2,
     Unroll = 3,
     Parallelize = 4,
+    Prefetch = 5,
 };
 
 struct SubSketch;
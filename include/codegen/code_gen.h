@@ -10,6 +10,7 @@
 
 #include <analyze/symbol_table.h>
 #include <container_utils.h>
+#include <selector.h>
 #include <visitor.h>
 
 namespace freetensor {
@@ -77,8 +78,11 @@ template <class Stream> class CodeGen : public SymbolTable<Visitor> {
  * @param func : The AST to be lowered. It must includes function signature to
  * determine parameters and return values
  * @param target : The target architecture
+ * @param profile : (CPU only) If set, instrument statements matching this
+ * selector for profiling. See `codeGenCPU`
  */
-std::string codeGen(const Func &func, const Ref<Target> &target);
+std::string codeGen(const Func &func, const Ref<Target> &target,
+                    const Ref<Selector> &profile = nullptr);
 
 } // namespace freetensor
 
@@ -28,6 +28,10 @@ template <class Stream> class CodeGenC : public CodeGen<Stream> {
                           const std::string &shapePtr,
                           const std::string &dimPtr) = 0;
 
+    // Whether a variable is stored as bits. Scalars of PackedBool are stored
+    // like Bool
+    static bool isPacked(const VarDef &def);
+
     // Generate a pointer to an multi-dimensional array
     virtual void genMdPtrType(std::ostream &os, const VarDef &def,
                               bool isConst = false);
@@ -43,12 +47,22 @@ template <class Stream> class CodeGenC : public CodeGen<Stream> {
             def, [&]() { this->os() << rawPtr; }, isConst);
     }
 
+    // Generate the raw pointer to the data of a parameter, which is passed
+    // by `_params[nthParam]`
+    virtual std::string paramPtr(const VarDef &def, int nthParam) {
+        return "_params[" + std::to_string(nthParam) + "]";
+    }
+
     // Generate the access to a scalar or an element of an array
     virtual void genScalar(const VarDef &def, const std::vector<Expr> &indices);
     template <class T> void genScalar(const T &op) {
         genScalar(this->def(op->var_), op->indices_);
     }
 
+    // Generate an operand of a math function, promoted to `float` if it is a
+    // 16-bit float, for which the C++ library has no overloads
+    void genMathOperand(const Expr &expr);
+
     virtual void visit(const StmtSeq &op) override;
     virtual void visit(const VarDef &op) override;
     virtual void visit(const Var &op) override;
@@ -4,7 +4,9 @@
 #include <unordered_set>
 
 #include <codegen/code_gen_c.h>
+#include <driver/blas_provider.h>
 #include <func.h>
+#include <selector.h>
 
 namespace freetensor {
 
@@ -13,17 +15,27 @@ class CodeGenCPU : public CodeGenC<CodeGenStream> {
     int64_t sharedStackTop_ = 0, sharedStackSize_ = 0;
     int64_t threadStackTop_ = 0, threadStackSize_ = 0;
     std::unordered_set<For> collapsed_;
+    Stmt hoistedFence_; // Emitted after the current OpenMP loop, not in it
     std::unordered_set<VarDef> usedAsReduction_;
+    std::unordered_set<std::string> threadLocal_; // Defined in parallel loops
+    Ref<Selector> profile_;
+    std::vector<ID> profiledIds_;
+    BLASProvider blas_;
 
   public:
     CodeGenCPU(const std::vector<FuncParam> &params,
-               const std::vector<FuncRet> &returns)
-        : CodeGenC(params, returns) {}
+               const std::vector<FuncRet> &returns,
+               const Ref<Selector> &profile = nullptr,
+               BLASProvider blas = BLASProvider::Builtin)
+        : CodeGenC(params, returns), profile_(profile), blas_(blas) {}
 
     // Stack sizes in bytes
     int64_t sharedStackSize() const { return sharedStackSize_; }
     int64_t threadStackSize() const { return threadStackSize_; }
 
+    // IDs of the instrumented statements, indexed by their counters
+    const std::vector<ID> &profiledIds() const { return profiledIds_; }
+
   protected:
     void genAlloc(const Ref<Tensor> &tensor, const std::string &rawPtr,
                   const std::string &shapePtr,
@@ -32,19 +44,47 @@ class CodeGenCPU : public CodeGenC<CodeGenStream> {
     void genScalar(const VarDef &def,
                    const std::vector<Expr> &indices) override;
 
+    // Tensors on CPU are assumed to be aligned in the `run` entry
+    std::string paramPtr(const VarDef &def, int nthParam) override;
+
+    void visitStmt(const Stmt &stmt) override;
+
+    // Whether other threads may write other bits in the same words of a
+    // packed variable
+    bool sharedPackedWords(const std::string &var);
+
     using CodeGenC<CodeGenStream>::visit;
     void visit(const VarDef &op) override;
+    void visit(const Alloc &op) override;
+    void visit(const Free &op) override;
+    void visit(const Store &op) override;
     void visit(const ReduceTo &op) override;
     void visit(const For &op) override;
+    void visit(const Eval &op) override;
     void visit(const MatMul &op) override;
 };
 
 /**
  * Generate target function code
  *
+ * The code has two entries of the same signature: `run`, which assumes every
+ * tensor parameter on CPU is aligned to `CPU_PARAM_ALIGNMENT`, and
+ * `run_unaligned`, which does not. They are both instances of a template
+ * `run_impl<ALIGNED>`. The Driver calls `run_unaligned` if any parameter is not
+ * aligned
+ *
+ * Vectorized loops are left to the backend compiler, unless lowered by
+ * `cpu::lowerVector` first, as `codeGen` does
+ *
+ * @param profile : If set, instrument statements matching this selector, to
+ * measure their time in each thread. Get the results with `Driver::profile`
+ * @param blas : BLAS library called for `MatMul`. `Default` is resolved as in
+ * `CPUTarget::blas`
  * @return : source
  */
-std::string codeGenCPU(const Func &func);
+std::string codeGenCPU(const Func &func,
+                       const Ref<Selector> &profile = nullptr,
+                       BLASProvider blas = BLASProvider::Default);
 
 } // namespace freetensor
 
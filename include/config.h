@@ -1,6 +1,7 @@
 #ifndef FREE_TENSOR_CONFIG_H
 #define FREE_TENSOR_CONFIG_H
 
+#include <atomic>
 #include <filesystem>
 #include <vector>
 
@@ -31,6 +32,19 @@ class Config {
         backendCompilerNVCC_; /// Env and macro FT_BACKEND_COMPILER_NVCC.
                               /// Colon-separated paths, searched from left to
                               /// right
+    static size_t
+        backendCompilerJobs_; /// Max number of concurrently running backend
+                              /// compilers. 0 for the number of hardware
+                              /// threads. Env FT_BACKEND_COMPILER_JOBS
+    static size_t
+        backendCompilerTimeout_; /// Kill a backend compiler running longer
+                                 /// than this seconds. 0 for no limit. Env
+                                 /// FT_BACKEND_COMPILER_TIMEOUT
+    static bool backendPCH_; /// Compile the runtime headers into a
+                             /// precompiled header once and reuse it for
+                             /// every CPU kernel. Env FT_BACKEND_PCH
+    static bool arrayHugePages_; /// Back large `Array`s on CPU with huge
+                                 /// pages. Env FT_ARRAY_HUGE_PAGES
 
     static Ref<Target>
         defaultTarget_; /// Used for lower and codegen when
@@ -41,6 +55,22 @@ class Config {
         runtimeDir_; /// Where to find the `runtime` directory. Macro
                      /// FT_RUNTIME_DIR. Colon-separated paths, searched from
                      /// left to right
+    static std::filesystem::path
+        kernelCacheDir_; /// Where to cache compiled kernels across processes.
+                         /// Empty to disable. Env FT_KERNEL_CACHE_DIR
+    static size_t kernelCacheSizeLimit_; /// Max total size of cached kernels
+                                         /// in bytes. Least recently used ones
+                                         /// are evicted when exceeding. Env
+                                         /// FT_KERNEL_CACHE_SIZE_LIMIT
+    static std::atomic<size_t> kernelCacheHits_, kernelCacheMisses_;
+    static std::filesystem::path
+        openBLASDir_; /// Installation prefix of OpenBLAS, with `include` and
+                      /// `lib` inside. Empty to search the system paths. Env
+                      /// FT_OPENBLAS_DIR
+    static std::filesystem::path
+        blisDir_; /// Installation prefix of BLIS, with `include` and `lib`
+                  /// inside. Empty to search the system paths. Env
+                  /// FT_BLIS_DIR
 
   private:
     /**
@@ -95,6 +125,37 @@ class Config {
         return backendCompilerNVCC_;
     }
 
+    /**
+     * @brief Set the max number of concurrently running backend compilers
+     *
+     * Applies to both synchronous and asynchronous builds of `Driver`s
+     *
+     * @param jobs : Number of jobs. 0 for the number of hardware threads
+     */
+    static void setBackendCompilerJobs(size_t jobs) {
+        backendCompilerJobs_ = jobs;
+    }
+    static size_t backendCompilerJobs();
+
+    /**
+     * @brief Set the timeout of a backend compiler
+     *
+     * When a timeout is set, each backend compiler runs in its own process
+     * group, so it can be killed together with its subprocesses
+     *
+     * @param seconds : Timeout in seconds. 0 for no limit
+     */
+    static void setBackendCompilerTimeout(size_t seconds) {
+        backendCompilerTimeout_ = seconds;
+    }
+    static size_t backendCompilerTimeout() { return backendCompilerTimeout_; }
+
+    static void setBackendPCH(bool flag = true) { backendPCH_ = flag; }
+    static bool backendPCH() { return backendPCH_; }
+
+    static void setArrayHugePages(bool flag = true) { arrayHugePages_ = flag; }
+    static bool arrayHugePages() { return arrayHugePages_; }
+
     static void setDefaultTarget(const Ref<Target> &target) {
         defaultTarget_ = target;
     }
@@ -111,6 +172,55 @@ class Config {
     static const std::vector<std::filesystem::path> &runtimeDir() {
         return runtimeDir_;
     }
+
+    /**
+     * @brief Set the directory of the persistent kernel cache
+     *
+     * @param path : Path to the cache directory, which will be created if not
+     * existing. Empty to disable the cache
+     */
+    static void setKernelCacheDir(const std::filesystem::path &path) {
+        kernelCacheDir_ = path;
+    }
+    static const std::filesystem::path &kernelCacheDir() {
+        return kernelCacheDir_;
+    }
+
+    static void setKernelCacheSizeLimit(size_t bytes) {
+        kernelCacheSizeLimit_ = bytes;
+    }
+    static size_t kernelCacheSizeLimit() { return kernelCacheSizeLimit_; }
+
+    /**
+     * Statistics of the kernel cache since the start of the process, or since
+     * the last `resetKernelCacheStats`
+     * @{
+     */
+    static void countKernelCacheHit() { kernelCacheHits_++; }
+    static void countKernelCacheMiss() { kernelCacheMisses_++; }
+    static size_t kernelCacheHits() { return kernelCacheHits_; }
+    static size_t kernelCacheMisses() { return kernelCacheMisses_; }
+    static void resetKernelCacheStats() {
+        kernelCacheHits_ = 0;
+        kernelCacheMisses_ = 0;
+    }
+    /** @} */
+
+    /**
+     * Where to find BLAS libraries selected by `CPUTarget::setBLAS`
+     * @{
+     */
+    static void setOpenBLASDir(const std::filesystem::path &path) {
+        openBLASDir_ = path;
+    }
+    static const std::filesystem::path &openBLASDir() {
+        return openBLASDir_;
+    }
+    static void setBLISDir(const std::filesystem::path &path) {
+        blisDir_ = path;
+    }
+    static const std::filesystem::path &blisDir() { return blisDir_; }
+    /** @} */
 };
 
 } // namespace freetensor
@@ -17,13 +17,19 @@ enum class DataType : size_t {
     Int64,
     Bool,
     Custom,
+    Float16,
+    BFloat16,
+    Int8,
+    UInt8,
+    PackedBool, // Booleans stored as bits, see `storageBytes`
     // ------
     NumTypes,
     Invalid,
 };
 
 constexpr std::array dataTypeNames = {
-    "void", "float32", "float64", "int32", "int64", "bool", "custom",
+    "void",   "float32", "float64",  "int32", "int64", "bool",
+    "custom", "float16", "bfloat16", "int8",  "uint8", "packed_bool",
 };
 static_assert(dataTypeNames.size() == (size_t)DataType::NumTypes);
 
@@ -55,10 +61,18 @@ inline size_t sizeOf(DataType dtype) {
     case DataType::Float32:
     case DataType::Int32:
         return 4;
+    case DataType::Float16:
+    case DataType::BFloat16:
+        return 2;
+    case DataType::Int8:
+    case DataType::UInt8:
     case DataType::Bool:
         return 1;
     case DataType::Custom:
         ERROR("Cannot get size of a customized data type");
+    case DataType::PackedBool:
+        ERROR("Elements of packed_bool are not addressable. Use storageBytes "
+              "instead");
     case DataType::Void:
         return 0;
     default:
@@ -70,6 +84,8 @@ inline bool isInt(DataType dtype) {
     switch (dtype) {
     case DataType::Int32:
     case DataType::Int64:
+    case DataType::Int8:
+    case DataType::UInt8:
         return true;
     default:
         return false;
@@ -80,6 +96,8 @@ inline bool isFloat(DataType dtype) {
     switch (dtype) {
     case DataType::Float64:
     case DataType::Float32:
+    case DataType::Float16:
+    case DataType::BFloat16:
         return true;
     default:
         return false;
@@ -88,7 +106,63 @@ inline bool isFloat(DataType dtype) {
 
 inline bool isNumber(DataType dtype) { return isInt(dtype) || isFloat(dtype); }
 
-inline bool isBool(DataType dtype) { return dtype == DataType::Bool; }
+inline bool isBool(DataType dtype) {
+    return dtype == DataType::Bool || dtype == DataType::PackedBool;
+}
+
+/**
+ * Bytes to store `nElem` elements of `dtype`
+ *
+ * `PackedBool` stores element `i` of the flattened (row-major) tensor as bit
+ * `i % 64` of the `i / 64`-th 64-bit word, so the size is rounded up to whole
+ * words. A `PackedBool` scalar is stored like a `Bool`
+ */
+inline size_t storageBytes(DataType dtype, size_t nElem) {
+    if (dtype == DataType::PackedBool) {
+        return (nElem + 63) / 64 * 8;
+    }
+    return nElem * sizeOf(dtype);
+}
+
+/**
+ * Types narrower than 32 bits, used for storage to save bandwidth
+ */
+inline bool isReducedPrecision(DataType dtype) {
+    switch (dtype) {
+    case DataType::Float16:
+    case DataType::BFloat16:
+    case DataType::Int8:
+    case DataType::UInt8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Type in which reductions to a variable of `dtype` are computed
+ *
+ * A `ReduceTo` to a reduced-precision variable `x` is performed as `x = T(A(x)
+ * op A(y))`, where `T` is the type of `x` and `A` is its accumulation type.
+ * Caches of reductions (`Schedule::cacheReduction`) and partial results of
+ * parallel reductions are kept in the accumulation type, so the result is
+ * rounded only once when reduced back to `x`. Likewise, caches and partial
+ * results of `PackedBool` variables are plain `Bool`s
+ */
+inline DataType accumulateType(DataType dtype) {
+    switch (dtype) {
+    case DataType::Float16:
+    case DataType::BFloat16:
+        return DataType::Float32;
+    case DataType::Int8:
+    case DataType::UInt8:
+        return DataType::Int32;
+    case DataType::PackedBool:
+        return DataType::Bool;
+    default:
+        return dtype;
+    }
+}
 
 inline DataType upCast(DataType lhs, DataType rhs) {
     if (lhs == DataType::Custom || rhs == DataType::Custom) {
@@ -104,6 +178,11 @@ inline DataType upCast(DataType lhs, DataType rhs) {
         return lhs;
     }
     if ((isInt(lhs) && isInt(rhs)) || (isFloat(lhs) && isFloat(rhs))) {
+        if (sizeOf(lhs) == sizeOf(rhs)) {
+            // Float16 and BFloat16, or Int8 and UInt8: neither one can
+            // represent the other
+            return accumulateType(lhs);
+        }
         return sizeOf(rhs) > sizeOf(lhs) ? rhs : lhs;
     }
     throw InvalidProgram("Cannot operate between " + toString(lhs) + " and " +
@@ -1,11 +1,17 @@
 #ifndef FREE_TENSOR_DRIVER_H
 #define FREE_TENSOR_DRIVER_H
 
+#include <future>
+#include <optional>
+#include <sched.h> // cpu_set_t
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include <driver/array.h>
+#include <driver/benchmark.h>
+#include <driver/kernel_cache.h>
+#include <driver/roofline.h>
 #include <func.h>
 
 #include <../runtime/cpu_context.h>
@@ -15,31 +21,162 @@
 
 namespace freetensor {
 
+/**
+ * Results of `Driver::runBatch`
+ */
+struct BatchResult {
+    std::vector<std::vector<Ref<Array>>>
+        returns_; /// Return values of each invocation, in the same order as
+                  /// `collectReturns`
+    std::vector<double> latencies_; /// Time of each invocation in ms
+};
+
+/**
+ * Profile of a statement instrumented by codegen. See `Driver::profile`
+ */
+struct ProfileEntry {
+    ID id_;
+    Metadata metadata_; /// Including the history of transformations, which
+                        /// tells the original statement in the source
+    double time_ = 0; /// Total time in ms, summed over the threads
+    double maxThreadTime_ = 0; /// Total time in ms of the busiest thread
+    uint64_t count_ = 0; /// Number of executions, summed over the threads
+};
+
+/**
+ * Reference to an `Array` bound to a `DriverFrame` (or a batch), counted as a
+ * holder of the `Array`. See `Array::addHolder`
+ */
+class HeldArray {
+    Ref<Array> arr_;
+
+  public:
+    HeldArray(std::nullptr_t = nullptr) {}
+    HeldArray(const Ref<Array> &arr) : arr_(arr) {
+        if (arr_.isValid()) {
+            arr_->addHolder();
+        }
+    }
+    ~HeldArray() {
+        if (arr_.isValid()) {
+            arr_->removeHolder();
+        }
+    }
+
+    HeldArray(const HeldArray &other) : HeldArray(other.arr_) {}
+    HeldArray(HeldArray &&other) : arr_(std::move(other.arr_)) {
+        other.arr_ = nullptr;
+    }
+    HeldArray &operator=(HeldArray other) {
+        std::swap(arr_, other.arr_);
+        return *this;
+    }
+
+    bool isValid() const { return arr_.isValid(); }
+    const Ref<Array> &get() const { return arr_; }
+    Array *operator->() const { return arr_.get(); }
+};
+
+/**
+ * States of one invocation of a `Driver`
+ *
+ * A frame holds the arguments and return values of an invocation, and the
+ * context (e.g. the stack) of the native function. Different frames of one
+ * `Driver` can be used concurrently from different threads, sharing one loaded
+ * binary. Create frames with `Driver::newFrame`
+ */
+class DriverFrame {
+    friend class Driver;
+
+    std::vector<HeldArray> args_; /// Ref count holders
+    std::vector<void *> rawArgs_,
+        rawRets_; /// Raw arguments and return values passed to (from) the
+                  /// native function
+    std::vector<size_t *> retShapes_;
+    std::vector<size_t> retDims_;
+    std::unique_ptr<Context> ctx_;
+    bool aligned_ = false; /// Whether `rawArgs_` are aligned as assumed by the
+                           /// `run` entry of a CPU kernel
+
+  public:
+    DriverFrame() {}
+    ~DriverFrame() {
+        for (void *retVal : rawRets_) {
+            if (retVal != nullptr) {
+                WARNING("Return values must be collected, or there will be "
+                        "memory leaks");
+            }
+        }
+    }
+
+    DriverFrame(const DriverFrame &) = delete;
+    DriverFrame &operator=(const DriverFrame &) = delete;
+
+    DriverFrame(DriverFrame &&) = default;
+    DriverFrame &operator=(DriverFrame &&) = default;
+};
+
 class Driver {
-    void *dlHandle_ = nullptr;
+    Ref<LoadedKernel> kernel_; /// Maybe shared with other Drivers
     void (*func_)(void ** /* params */, void ** /* retRaw */,
                   size_t ** /* retShapes */, size_t * /* retDims */,
                   void * /* ctx */) = nullptr;
+    void (*funcUnaligned_)(void **, void **, size_t **, size_t *,
+                           void *) = nullptr; /// Same with `func_`, but
+                                              /// not assuming the alignment
+                                              /// of the parameters
+    size_t (*stackSize_)(CPUContext *) = nullptr; /// Stack size of a CPU
+                                                   /// kernel
+    size_t (*profileSize_)() = nullptr; /// Number of instrumented statements
+    const uint64_t *(*profileIds_)() = nullptr; /// IDs of the instrumented
+                                                /// statements
 
     Func f_;
     std::string src_;
-    std::vector<Ref<Array>> args_; /// Ref count holders
-    std::vector<void *> rawArgs,
-        rawRets; /// Raw arguments and return values passed to (from) the
-                 /// native function
-    std::vector<size_t *> retShapes_;
-    std::vector<size_t> retDims_;
     std::unordered_map<std::string, size_t> name2param_;
     std::unordered_map<std::string, Ref<Buffer>> name2buffer_;
+    std::vector<size_t> alignedParams_; /// Parameters whose alignment is
+                                        /// assumed by `func_`
     Ref<Device> dev_, hostDev_;
 
-    std::unique_ptr<Context> ctx_;
+    DriverFrame frame_; /// Used by the methods without a frame parameter
+
+    int numThreads_ = 0; /// As set by `setNumThreads`
+    int resolvedNumThreads_ = 0; /// `numThreads_` with `AUTO_NUM_THREADS`
+                                 /// resolved
+    std::optional<cpu_set_t> cpuAffinity_;
 
     bool verbose_ = false;
 
   private:
     void buildAndLoad();
 
+    std::unique_ptr<Context> newContext() const;
+
+    /**
+     * Maximum number of iterations of OpenMP loops (counting collapsed loops
+     * together) in the program, or `std::nullopt` if any of them is not a
+     * constant
+     */
+    std::optional<int64_t> maxParallelTripCount() const;
+
+    void resolveNumThreads();
+
+    void checkFrame(const DriverFrame &frame) const;
+
+    /**
+     * Check whether the parameters are aligned to `CPU_PARAM_ALIGNMENT`, as
+     * assumed by `func_`. Otherwise, `funcUnaligned_` should be called
+     */
+    bool paramsAligned(const std::vector<void *> &rawArgs) const;
+
+    /**
+     * Make an `Array` from a value returned by the native function, and free
+     * the returned shape
+     */
+    Ref<Array> moveReturn(size_t i, void *&rawRet, size_t *&retShape,
+                          size_t &retDim) const;
+
   public:
     /**
      * Compile a program using a backend compiler and load it into memory
@@ -62,15 +199,7 @@ class Driver {
                  verbose) {}
     /** @} */
 
-    ~Driver() {
-        for (void *retVal : rawRets) {
-            if (retVal != nullptr) {
-                WARNING("Return values must be collected, or there will be "
-                        "memory leaks");
-            }
-        }
-        unload();
-    }
+    ~Driver() { unload(); }
 
     Driver(const Driver &) = delete;
     Driver &operator=(const Driver &) = delete;
@@ -78,13 +207,107 @@ class Driver {
     Driver(Driver &&) = default;
     Driver &operator=(Driver &&) = default;
 
+    /**
+     * Use `setNumThreads(AUTO_NUM_THREADS)` to pick the number of threads from
+     * the trip counts of parallel loops
+     */
+    static constexpr int AUTO_NUM_THREADS = -1;
+
+    /**
+     * Set the number of OpenMP threads used by each invocation of a CPU
+     * program, instead of the global default of OpenMP
+     *
+     * Useful when multiple programs share one machine. It applies to all
+     * invocations afterwards, including the ones in existing frames
+     *
+     * @param numThreads : A positive number, 0 for the default of OpenMP, or
+     * `AUTO_NUM_THREADS` to use no more threads than the maximum number of
+     * iterations of the parallel loops, if they are all known after lowering,
+     * and no more than the available CPUs
+     */
+    void setNumThreads(int numThreads);
+    int numThreads() const { return numThreads_; }
+
+    /**
+     * Bind the threads of each invocation of a CPU program to a set of CPUs
+     *
+     * The thread invoking the program, and the OpenMP threads it uses, are
+     * bound to the CPUs during the invocation. The invoking thread is restored
+     * to its original CPUs afterwards. The OpenMP threads remain bound until a
+     * program bound to other CPUs, or a program without binding, is invoked
+     * from the same thread, so binding costs only one system call per
+     * invocation in the common case
+     *
+     * @param cpus : IDs of the CPUs. Empty to cancel the binding
+     */
+    void setCPUAffinity(const std::vector<int> &cpus);
+    std::vector<int> cpuAffinity() const;
+
+    /**
+     * Place an `Array` on the CPU device of this `Driver` by its NUMA policy,
+     * like `Array::placeOn`
+     *
+     * The data is copied by the OpenMP threads running this `Driver`, with its
+     * number of threads and CPU affinity, so the pages placed by
+     * `NUMAPolicy::FirstTouch` are on the nodes of the threads accessing them.
+     * `Array`s copied to CPU by `setArgs` are copied in the same way
+     */
+    void placeArray(const Ref<Array> &arr) const;
+
+    /**
+     * Create a frame for invoking this `Driver`
+     *
+     * Calling `setArgs`, `run` and `collectReturns` with different frames is
+     * thread-safe, as long as the threads do not write to the same `Array`s or
+     * closures
+     */
+    DriverFrame newFrame() const;
+
+    /**
+     * Set arguments, run and collect return values in a frame
+     *
+     * Views of `Array`s (see `Array::slice`) can be passed as arguments.
+     * Non-contiguous ones written by `run` are scattered back to the `Array`s
+     * they view in `collectReturns`
+     * @{
+     */
+    void setArgs(DriverFrame &frame, const std::vector<Ref<Array>> &args,
+                 const std::unordered_map<std::string, Ref<Array>> &kws = {})
+        const;
+    void run(DriverFrame &frame) const;
+    std::vector<Ref<Array>> collectReturns(DriverFrame &frame) const;
+    /** @} */
+
+    /**
+     * Set arguments, run and collect return values in a frame owned by this
+     * `Driver`. Not thread-safe
+     * @{
+     */
     void setArgs(const std::vector<Ref<Array>> &args,
-                 const std::unordered_map<std::string, Ref<Array>> &kws = {});
+                 const std::unordered_map<std::string, Ref<Array>> &kws = {}) {
+        setArgs(frame_, args, kws);
+    }
     void setArgs(const std::unordered_map<std::string, Ref<Array>> &kws) {
-        setArgs({}, kws);
+        setArgs(frame_, {}, kws);
     }
+    void run() { run(frame_); }
+    std::vector<Ref<Array>> collectReturns() { return collectReturns(frame_); }
+    /** @} */
 
-    void run();
+    /**
+     * Time of each statement instrumented by codegen, accumulated over the
+     * invocations in a frame (or the frame owned by this `Driver`) since the
+     * last `resetProfile`
+     *
+     * The program must be generated by `codeGen` with `profile` set. Entries
+     * are in the order of the program
+     * @{
+     */
+    std::vector<ProfileEntry> profile(const DriverFrame &frame) const;
+    std::vector<ProfileEntry> profile() const { return profile(frame_); }
+    void resetProfile(DriverFrame &frame) const;
+    void resetProfile() { resetProfile(frame_); }
+    /** @} */
 
     /**
      * Sync with the device
@@ -93,8 +316,6 @@ class Driver {
      */
     void sync();
 
-    std::vector<Ref<Array>> collectReturns();
-
     /**
      * Run the program and measure its time cost
      *
@@ -105,9 +326,88 @@ class Driver {
      */
     std::pair<double, double> time(int rounds = 10, int warmups = 3);
 
+    /**
+     * Run the program repeatedly with the arguments set by `setArgs`, and
+     * report statistics of its time cost
+     *
+     * Unlike `time`, the number of runs is adaptive. See `benchmark` for
+     * details
+     */
+    BenchmarkResult benchmark(const BenchmarkOptions &options = {});
+
+    /**
+     * Measure the program with the arguments set by `setArgs`, and compare the
+     * performance of each top-level loop nest with the peak performance of the
+     * machine
+     *
+     * The program must be generated by `codeGen` with `profile` selecting the
+     * top-level loop nests, i.e. `<For>&!(<<-<For>)`, to measure the time of
+     * each of them. FLOPs and bytes are counted by `structuralFeature`, and the
+     * peaks are measured by `machinePeak` with the same number of threads as
+     * the program
+     *
+     * @param options : Options to measure the program. See `benchmark`
+     */
+    RooflineReport roofline(const BenchmarkOptions &options = {});
+
+    /**
+     * Run the program on multiple sets of arguments, and collect all the
+     * return values
+     *
+     * The signature is resolved once for the whole batch, and then the
+     * invocations are run back to back. Each set contains positional arguments
+     * only, as in `setArgs`. Enclosed parameters take their values from the
+     * closures, and closures are not updated by the batch
+     *
+     * The batch does not use or affect arguments set by `setArgs`
+     *
+     * @param argSets : Arguments of each invocation
+     * @param parallelism : (CPU only) Run this number of invocations
+     * concurrently. The CPUs available to the process (or the ones set by
+     * `setCPUAffinity`) are split into this number of disjoint subsets, and
+     * each invocation runs with OpenMP threads bound to one of the subsets. An
+     * `Array` written by one invocation must not be accessed by another one
+     */
+    BatchResult runBatch(const std::vector<std::vector<Ref<Array>>> &argSets,
+                         size_t parallelism = 1);
+
     void unload();
+
+    /**
+     * Whether the `Driver` uses the same loaded kernel as another one, i.e.,
+     * they are built from identical programs and both loaded
+     */
+    bool sharesKernelWith(const Driver &other) const {
+        return kernel_.isValid() && kernel_.get() == other.kernel_.get();
+    }
 };
 
+/**
+ * Build a `Driver` in background
+ *
+ * The `Driver` is built in a `BuildQueue`, and the backend compiler counts
+ * towards `Config::backendCompilerJobs()` the same as in a synchronous build.
+ * The caller can do other work, e.g. measuring other `Driver`s, before waiting
+ * for the result. Exceptions from building are rethrown when getting the result
+ *
+ * Parameters are the same with the constructor of `Driver`
+ * @{
+ */
+std::shared_future<Ref<Driver>>
+buildDriverAsync(const Func &func, const std::string &src,
+                 const Ref<Device> &device, const Ref<Device> &hostDevice,
+                 bool verbose = false);
+inline std::shared_future<Ref<Driver>>
+buildDriverAsync(const Func &func, const std::string &src,
+                 const Ref<Device> &device, bool verbose = false) {
+    return buildDriverAsync(func, src, device,
+                            device->type() == TargetType::CPU
+                                ? device
+                                : Ref<Device>::make(TargetType::CPU),
+                            verbose);
+}
+/** @} */
+
 } // namespace freetensor
 
 #endif // FREE_TENSOR_DRIVER_H
@@ -1,12 +1,19 @@
 #ifndef FREE_TENSOR_ARRAY_H
 #define FREE_TENSOR_ARRAY_H
 
+#include <array>
 #include <cstdint>
+#include <iostream>
+#include <string>
 #include <vector>
 
+#include <container_utils.h>
 #include <driver/device.h>
+#include <except.h>
 #include <tensor.h>
 
+#include <../runtime/cpu_context.h>
+
 namespace freetensor {
 
 /**
@@ -16,9 +23,68 @@ struct ArrayCopy {
     Ref<Device> device_;
     uint8_t *ptr_ = nullptr;
     bool borrowed_ = false;
+    size_t align_ = 0; /// `ptr_` is known to be a multiple of this many bytes
+    size_t mappedBytes_ = 0; /// If not 0, `ptr_` is mapped by `mmap` of this
+                             /// length from the page containing `ptr_`,
+                             /// instead of from the memory pool
+    int numaNode_ = -1;      /// NUMA node of all the pages, or -1 if not bound
+    bool readOnly_ = false;  /// Never written, e.g. a read-only mapped file
+
+    ArrayCopy(const Ref<Device> &device, uint8_t *ptr, bool borrowed,
+              size_t align)
+        : device_(device), ptr_(ptr), borrowed_(borrowed), align_(align) {}
+};
+
+/**
+ * Hints of how a file mapped by `Array::mapFile` will be accessed, passed to
+ * `madvise`
+ */
+enum class MapAdvice : size_t {
+    Sequential = 0, /// Read ahead aggressively
+    Random,         /// Do not read ahead
+    WillNeed,       /// Start reading the whole file in background
+    HugePage,       /// Back with huge pages if the file system supports it
+    // ------
+    NumAdvice,
+};
+
+// First deduce array length, then assert, to ensure the length
+constexpr std::array mapAdviceNames = {
+    "sequential",
+    "random",
+    "willneed",
+    "hugepage",
+};
+static_assert(mapAdviceNames.size() == (size_t)MapAdvice::NumAdvice);
+
+inline std::ostream &operator<<(std::ostream &os, MapAdvice advice) {
+    return os << mapAdviceNames.at((size_t)advice);
+}
 
-    ArrayCopy(const Ref<Device> &device, uint8_t *ptr, bool borrowed)
-        : device_(device), ptr_(ptr), borrowed_(borrowed) {}
+inline MapAdvice parseMapAdvice(const std::string &_str) {
+    auto &&str = tolower(_str);
+    for (auto &&[i, s] : views::enumerate(mapAdviceNames)) {
+        if (s == str) {
+            return (MapAdvice)i;
+        }
+    }
+    std::string msg = "Unrecognized map advice \"" + _str +
+                      "\". Candidates are (case-insensitive): ";
+    for (auto &&[i, s] : views::enumerate(mapAdviceNames)) {
+        msg += (i > 0 ? ", " : "");
+        msg += s;
+    }
+    ERROR(msg);
+}
+
+/**
+ * A range of indices along one dimension of an `Array`, selected by
+ * `Array::slice`
+ */
+struct SliceRange {
+    size_t begin_ = 0, len_ = 1, step_ = 1;
+    bool keepDim_ = true; /// If false, the dimension is indexed by `begin_`
+                          /// only, and removed from the result
 };
 
 /**
@@ -38,6 +104,30 @@ struct ArrayCopy {
  * When an `Array` is requried for read-write, an `ArrayCopy` will be copied to
  * a specific device, if there isn't one, and copies on other devices will be
  * dropped
+ *
+ * `ArrayCopy`s allocated by an `Array` on CPU are aligned to `ALIGNMENT`
+ * bytes. If `Config::arrayHugePages` is set, the ones of at least
+ * `HUGE_PAGE_SIZE` bytes are aligned to `HUGE_PAGE_SIZE` instead, and backed by
+ * transparent huge pages. The alignment of a borrowed `ArrayCopy` is derived
+ * from its address
+ *
+ * `ArrayCopy`s on CPU are placed among NUMA nodes by the `Device::numaPolicy`
+ * of the device they are allocated for. Large copies between CPU `ArrayCopy`s
+ * run in parallel
+ *
+ * An `ArrayCopy` can also be a file mapped by `mapFile`. Like a borrowed one,
+ * it is not allocated by the `Array`, but the `Array` owns the mapping and
+ * unmaps it when it is dropped. A read-only mapping is never written: requiring
+ * it for writing is an error
+ *
+ * An `Array` can be a view of a sub-tensor of another `Array`, made by `slice`,
+ * sharing the data of the latter. A view is an offset plus a stride for each
+ * dimension, in elements of its base `Array`. If the elements of a view are
+ * contiguous in the base, the view requires the base in place of itself, and
+ * its pointers point into the base, so it costs no copy. Otherwise, the
+ * elements are gathered from the base on CPU into `ArrayCopy`s of the view
+ * when required, and those written are scattered back by `flush`. The gathered
+ * copies are reused until the base is required for writing
  */
 class Array {
     std::vector<ArrayCopy> ptrs_;
@@ -45,6 +135,21 @@ class Array {
     std::vector<size_t> shape_;
     DataType dtype_;
 
+    Ref<Array> base_;             /// The `Array` viewed, or null if not a view
+    size_t offset_ = 0;           /// Offset of a view in `base_`, in elements
+    std::vector<size_t> strides_; /// Strides of a view in `base_`, in elements
+    bool contiguous_ = true;      /// A view is a contiguous range of `base_`
+    bool dirty_ = false;          /// A non-contiguous view is written in
+                                  /// `ptrs_`, and not scattered back yet
+    size_t version_ = 0;         /// Bumped when required for writing
+    size_t gatheredVersion_ = 0; /// `version_` of `base_` when a non-contiguous
+                                 /// view is gathered into `ptrs_`
+    size_t holders_ = 0;         /// Number of `DriverFrame`s holding pointers
+
+  public:
+    static constexpr size_t ALIGNMENT = CPU_PARAM_ALIGNMENT;
+    static constexpr size_t HUGE_PAGE_SIZE = (size_t)2 << 20; // 2 MiB
+
   private:
     /**
      * Intialize an array on a specific device
@@ -56,9 +161,36 @@ class Array {
      */
     Array(const std::vector<size_t> &shape, DataType dtype);
 
+    /**
+     * `rawSharedTo`, `rawMovedTo` and `rawInitTo` of `ptrs_` only, regardless
+     * of `base_`
+     * @{
+     */
+    void *copySharedTo(const Ref<Device> &device);
+    void *copyMovedTo(const Ref<Device> &device);
+    void *copyInitTo(const Ref<Device> &device);
+    /** @} */
+
+    /**
+     * Gather a non-contiguous view from its base into a new `ArrayCopy` on
+     * CPU, replacing all the `ptrs_`
+     *
+     * @throw DriverError if the old `ptrs_` are held by another `DriverFrame`
+     */
+    void gather();
+
+    /**
+     * Whether a non-contiguous view is not gathered yet, or its base has been
+     * required for writing since then, and it is not written itself
+     */
+    bool gatherNeeded() const;
+
   public:
     /**
      * Move from raw pointer. Use with cautious
+     *
+     * The pointer must be allocated by `CPUMemoryPool` on CPU, or by
+     * `cudaMalloc` on GPU
      */
     static Array moveFromRaw(void *ptr, const std::vector<size_t> &shape,
                              DataType dtype, const Ref<Device> &device);
@@ -72,6 +204,51 @@ class Array {
     static Array borrowFromRaw(void *ptr, const std::vector<size_t> &shape,
                                DataType dtype, const Ref<Device> &device);
 
+    /**
+     * Map a file of raw data in row-major order into a new array on CPU
+     *
+     * Nothing is read until accessed, and then only the pages touched are read
+     * from the file, or from the page cache of the OS if the file is recently
+     * read, e.g. by a previous run of the program
+     *
+     * @param path : Path to the file
+     * @param offset : Position of the data in the file, in bytes
+     * @param copyOnWrite : If false, the mapping is read-only, and the array
+     * cannot be used as an output. If true, the array can be written, but the
+     * modifications are private to the array, and are not saved to the file
+     * @param advice : Hints to the OS of how the data will be accessed
+     */
+    static Array mapFile(const std::string &path,
+                         const std::vector<size_t> &shape, DataType dtype,
+                         size_t offset = 0, bool copyOnWrite = false,
+                         const std::vector<MapAdvice> &advice = {});
+
+    /**
+     * Make a view of a sub-tensor of an array, without copying
+     *
+     * A view of a view is a view of the original array
+     *
+     * @param base : The array to view
+     * @param ranges : One range for each leading dimension of `base`. The
+     * remaining dimensions are kept whole
+     */
+    static Array slice(const Ref<Array> &base,
+                       const std::vector<SliceRange> &ranges);
+
+    /**
+     * Pack booleans into a new `PackedBool` array on CPU
+     *
+     * @param data : One byte per element, in row-major order
+     */
+    static Array packBools(const bool *data, const std::vector<size_t> &shape);
+
+    /**
+     * Unpack a `PackedBool` array into one byte per element
+     *
+     * @param data : Output buffer of `nElem()` bytes on CPU
+     */
+    void unpackBools(bool *data);
+
     ~Array();
 
     Array(Array &&);
@@ -85,9 +262,80 @@ class Array {
     const std::vector<size_t> &shape() const { return shape_; }
     DataType dtype() const { return dtype_; }
 
+    bool isView() const { return base_.isValid(); }
+    const Ref<Array> &base() const { return base_; }
+    size_t offset() const { return offset_; }
+    const std::vector<size_t> &strides() const { return strides_; }
+    bool contiguous() const { return contiguous_; }
+
+    /**
+     * Get a pointer to the data on a device, for reading, writing or both
+     *
+     * For a contiguous view, the pointer points into its base. Requiring it
+     * for writing only requires the base for both reading and writing,
+     * because the elements out of the view are kept
+     * @{
+     */
     void *rawSharedTo(const Ref<Device> &device);
     void *rawMovedTo(const Ref<Device> &device);
     void *rawInitTo(const Ref<Device> &device);
+    /** @} */
+
+    /**
+     * Scatter the data written to a non-contiguous view back to its base. Do
+     * nothing for other arrays
+     *
+     * `Driver` flushes its arguments when collecting the returns
+     */
+    void flush();
+
+    /**
+     * Count the `DriverFrame`s (or batches) holding pointers to this `Array`
+     *
+     * The holder requesting a pointer is counted before the request. A
+     * non-contiguous view held by other holders can't be gathered again, which
+     * would free the pointers they hold
+     * @{
+     */
+    void addHolder() { holders_++; }
+    void removeHolder() { holders_--; }
+    /** @} */
+
+    /**
+     * Alignment in bytes of the `ArrayCopy` on a device, or 0 if there is no
+     * copy on the device
+     */
+    size_t alignmentOn(const Ref<Device> &device) const;
+
+    /**
+     * NUMA node of the `ArrayCopy` on a CPU device, or -1 if there is no copy
+     * on the device, or it is not bound to a node
+     */
+    int numaNodeOn(const Ref<Device> &device) const;
+
+    /**
+     * Node where a page of the `ArrayCopy` on a CPU device actually resides,
+     * as reported by the OS, or -1 if there is no copy on the device, or it is
+     * not supported
+     *
+     * @param offset : Any byte in the page, counted from the beginning of the
+     * array
+     */
+    int residentNodeOn(const Ref<Device> &device, size_t offset = 0) const;
+
+    /**
+     * Whether the `ArrayCopy` on a device must not be written
+     */
+    bool readOnlyOn(const Ref<Device> &device) const;
+
+    /**
+     * Move the data to a new `ArrayCopy` on a CPU device, placed by the NUMA
+     * policy of the device, and drop other copies
+     *
+     * The data is copied in parallel. Like `makePrivateCopy`, the `Array` no
+     * longer borrows from user data afterwards
+     */
+    void placeOn(const Ref<Device> &device);
 
     /**
      * Somethings we can't keep track of user objects, so we need to ensure we
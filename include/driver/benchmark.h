@@ -0,0 +1,93 @@
+#ifndef FREE_TENSOR_BENCHMARK_H
+#define FREE_TENSOR_BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <driver/device.h>
+#include <driver/perf_counters.h>
+
+namespace freetensor {
+
+/**
+ * Options of `benchmark`
+ */
+struct BenchmarkOptions {
+    int warmups_ = 3;     /// Unmeasured runs before measuring
+    int minRounds_ = 5;   /// Measure at least this number of runs
+    int maxRounds_ = 1000; /// Measure at most this number of runs
+
+    /// Stop once the half width of the 95% confidence interval of the mean is
+    /// no larger than this fraction of the mean. 0 to always run `maxRounds_`
+    double targetRelCI_ = 0.01;
+
+    /// Stop once measuring has taken this long in ms, including the time
+    /// spent on flushing the caches. 0 for no limit
+    double timeBudget_ = 1000;
+
+    /// Evict data of the program from the caches before each run, to measure
+    /// a cold run instead of a warm one
+    bool flushCache_ = false;
+
+    /// Exclude outliers from the mean and the confidence interval
+    bool rejectOutliers_ = true;
+
+    /// (CPU only) Read hardware performance counters during the measured
+    /// runs. See `PerfCounters`
+    bool perfCounters_ = false;
+};
+
+/**
+ * Results of `benchmark`. All times are in ms
+ */
+struct BenchmarkResult {
+    std::vector<double> times_; /// Time of each measured run, in order
+
+    double mean_ = 0; /// Mean excluding the outliers
+    double stddev_ = 0; /// Estimated standard deviation of `mean_`, i.e.
+                        /// the standard error
+    double relCI_ = 0; /// Half width of the 95% confidence interval of
+                       /// `mean_`, relative to `mean_`
+    double min_ = 0, max_ = 0, median_ = 0;
+    size_t outliers_ = 0; /// Number of runs excluded from `mean_`
+    bool converged_ = false; /// Whether `targetRelCI_` is reached
+
+    /// Average counts per run of hardware performance counters, keyed by the
+    /// names in `PerfCounters::read`. Empty if not requested or not available
+    std::unordered_map<std::string, double> counters_;
+
+    /**
+     * The `q`-th percentile (`0 <= q <= 100`) of all the measured times,
+     * interpolated linearly
+     */
+    double percentile(double q) const;
+};
+
+/**
+ * Measure a program by running it repeatedly
+ *
+ * Runs are repeated until the confidence interval of the mean is tight enough,
+ * the time budget runs out, or the maximum number of runs is reached,
+ * whichever comes first. A run is considered an outlier if it is slower than
+ * the median by more than 3 times the scaled median absolute deviation, which
+ * is usually caused by interrupts or other processes
+ *
+ * To reduce the noise, consider binding the threads with
+ * `Driver::setCPUAffinity`
+ *
+ * @param run : Run the program once. Whether it has finished is determined by
+ * `device->sync()`
+ * @param device : The device the program runs on, for synchronizing and
+ * flushing the caches
+ * @param counters : If not null, enabled during each measured run
+ */
+BenchmarkResult benchmark(const std::function<void()> &run,
+                          const Ref<Device> &device,
+                          const BenchmarkOptions &options = {},
+                          PerfCounters *counters = nullptr);
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_BENCHMARK_H
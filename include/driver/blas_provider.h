@@ -0,0 +1,59 @@
+#ifndef FREE_TENSOR_BLAS_PROVIDER_H
+#define FREE_TENSOR_BLAS_PROVIDER_H
+
+#include <array>
+#include <iostream>
+#include <string>
+
+#include <container_utils.h>
+#include <except.h>
+
+namespace freetensor {
+
+/**
+ * BLAS library called for `MatMul` on CPU
+ */
+enum class BLASProvider : size_t {
+    Default = 0, /// MKL if FreeTensor is built with it, or Builtin otherwise
+    Builtin,     /// The built-in GEMM in runtime/cpu_gemm.h
+    MKL,         /// Intel MKL. FreeTensor has to be built with it
+    OpenBLAS,    /// OpenBLAS, in `Config::openBLASDir` or the system paths
+    BLIS,        /// BLIS, in `Config::blisDir` or the system paths
+    // ------
+    NumProviders,
+};
+
+// First deduce array length, then assert, to ensure the length
+constexpr std::array blasProviderNames = {
+    "default", "builtin", "mkl", "openblas", "blis",
+};
+static_assert(blasProviderNames.size() == (size_t)BLASProvider::NumProviders);
+
+inline std::ostream &operator<<(std::ostream &os, BLASProvider provider) {
+    return os << blasProviderNames.at((size_t)provider);
+}
+
+inline BLASProvider parseBLASProvider(const std::string &_str) {
+    auto &&str = tolower(_str);
+    for (auto &&[i, s] : views::enumerate(blasProviderNames)) {
+        if (s == str) {
+            return (BLASProvider)i;
+        }
+    }
+    std::string msg = "Unrecognized BLAS provider \"" + _str +
+                      "\". Candidates are (case-insensitive): ";
+    for (auto &&[i, s] : views::enumerate(blasProviderNames)) {
+        msg += (i > 0 ? ", " : "");
+        msg += s;
+    }
+    ERROR(msg);
+}
+
+/**
+ * Resolve `BLASProvider::Default` to the actual provider
+ */
+BLASProvider resolveBLASProvider(BLASProvider provider);
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_BLAS_PROVIDER_H
@@ -0,0 +1,68 @@
+#ifndef FREE_TENSOR_BUILD_QUEUE_H
+#define FREE_TENSOR_BUILD_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace freetensor {
+
+/**
+ * A slot to run one backend compiler
+ *
+ * Construct one before starting a compiler process, and destruct it after the
+ * process exits. At most `Config::backendCompilerJobs()` slots can be held at
+ * the same time, like the jobserver of `make`, no matter how many threads are
+ * building `Driver`s. Besides, a new compiler is not started when the system is
+ * low on memory, unless no compiler is running
+ */
+class CompileJobSlot {
+  public:
+    CompileJobSlot();
+    ~CompileJobSlot();
+
+    CompileJobSlot(const CompileJobSlot &) = delete;
+    CompileJobSlot &operator=(const CompileJobSlot &) = delete;
+};
+
+/**
+ * Background threads running build jobs in FIFO order
+ *
+ * Threads are started on demand, up to `Config::backendCompilerJobs()`
+ */
+class BuildQueue {
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    std::vector<std::thread> workers_;
+    size_t idle_ = 0;
+    bool stopped_ = false;
+
+  private:
+    BuildQueue() {}
+
+    void work();
+
+  public:
+    ~BuildQueue();
+
+    BuildQueue(const BuildQueue &) = delete;
+    BuildQueue &operator=(const BuildQueue &) = delete;
+
+    static BuildQueue &instance();
+
+    /**
+     * Run a job in background
+     *
+     * The job should handle its own exceptions, e.g. by wrapping it in a
+     * `std::packaged_task`
+     */
+    void submit(std::function<void()> job);
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_BUILD_QUEUE_H
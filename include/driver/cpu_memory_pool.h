@@ -0,0 +1,90 @@
+#ifndef FREE_TENSOR_CPU_MEMORY_POOL_H
+#define FREE_TENSOR_CPU_MEMORY_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <../runtime/cpu_context.h>
+
+namespace freetensor {
+
+struct CPUMemoryPoolThreadCache;
+
+/**
+ * Size-class caching allocator for memory on CPU
+ *
+ * It serves `Array`s on CPU, and heap-allocated variables and returned tensors
+ * in CPU kernels through `CPUContext`. Freed blocks are cached by size classes
+ * (four classes per power of two), and reused by later allocations of the same
+ * class. Each thread caches up to `THREAD_CACHE_SIZE` bytes of blocks on its
+ * own, behind a lock that only `trim` and `cachedBytes` contend for, so
+ * allocations inside OpenMP regions do not contend with each other. Thread
+ * caches are registered in the pool, so `trim` also drains the caches of idle
+ * threads (e.g. OpenMP workers). The rest are cached in a global pool of up to
+ * `GLOBAL_CACHE_SIZE` bytes. Blocks larger than `MAX_POOLED_SIZE` are always
+ * allocated from and freed to the system
+ *
+ * Every block is aligned to 64 bytes, with a 64-byte header in front of it
+ * recording its size class, so `free` does not need the size
+ */
+class CPUMemoryPool : public CPUAllocator {
+  public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t MAX_POOLED_SIZE = (size_t)64 << 20; // 64 MiB
+    static constexpr size_t THREAD_CACHE_SIZE = (size_t)16 << 20;
+    static constexpr size_t GLOBAL_CACHE_SIZE = (size_t)1 << 30;
+
+  private:
+    std::mutex lock_;
+    std::vector<std::vector<void *>> freeLists_; /// Indexed by size class
+    size_t cachedBytes_ = 0; /// In `freeLists_`, guarded by `lock_`
+    std::atomic<size_t> liveBytes_ = 0, peakBytes_ = 0;
+
+    std::mutex threadCachesLock_; /// Acquire before the lock of any cache
+    std::unordered_set<CPUMemoryPoolThreadCache *> threadCaches_;
+
+    friend struct CPUMemoryPoolThreadCache;
+
+  private:
+    CPUMemoryPool();
+
+    /**
+     * Move a free block to the global pool, or free it to the system if the
+     * pool is full
+     */
+    void release(void *block, size_t cls);
+
+  public:
+    /**
+     * The process-wide pool
+     *
+     * It is never destructed, so `Array`s destructed late during the exit of
+     * the process can still be freed
+     */
+    static CPUMemoryPool &instance();
+
+    void *alloc(size_t size) override;
+    void free(void *ptr) override;
+
+    /**
+     * Statistics in bytes, including the alignment overhead but not the headers
+     * @{
+     */
+    size_t liveBytes() const { return liveBytes_; } /// Allocated and not freed
+    size_t peakBytes() const { return peakBytes_; } /// Max `liveBytes()`
+    size_t cachedBytes(); /// Freed but cached, in any thread or globally
+    void resetPeakBytes() { peakBytes_ = liveBytes_.load(); }
+    /** @} */
+
+    /**
+     * Return blocks cached in the global pool and in all the threads to the
+     * system
+     */
+    void trim();
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_CPU_MEMORY_POOL_H
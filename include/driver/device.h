@@ -1,6 +1,7 @@
 #ifndef FREE_TENSOR_DEVICE_H
 #define FREE_TENSOR_DEVICE_H
 
+#include <driver/numa.h>
 #include <driver/target.h>
 #include <ref.h>
 
@@ -20,6 +21,8 @@ namespace freetensor {
 class Device {
     Ref<Target> target_;
     int num_; // not size_t, cuda function takes ints as args
+    NUMAPolicy numaPolicy_ = NUMAPolicy::Default;
+    int numaNode_ = -1;
 
   public:
     Device(const TargetType &targetType, int num = 0);
@@ -32,6 +35,21 @@ class Device {
     int num() const { return num_; }
     const Ref<Target> &target() const { return target_; }
 
+    /**
+     * (CPU only) Placement of `ArrayCopy`s allocated on this device among NUMA
+     * nodes. See `NUMAPolicy`
+     *
+     * It does not affect the equality of devices, so an `ArrayCopy` already
+     * on CPU is used as is, wherever its pages are
+     *
+     * @param node : The node for `NUMAPolicy::Bind`
+     * @{
+     */
+    void setNUMAPolicy(NUMAPolicy policy, int node = -1);
+    NUMAPolicy numaPolicy() const { return numaPolicy_; }
+    int numaNode() const { return numaNode_; }
+    /** @} */
+
     void sync();
 
     friend bool operator==(const Device &lhs, const Device &rhs) {
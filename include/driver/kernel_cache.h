@@ -0,0 +1,119 @@
+#ifndef FREE_TENSOR_KERNEL_CACHE_H
+#define FREE_TENSOR_KERNEL_CACHE_H
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ref.h>
+
+namespace freetensor {
+
+/**
+ * A kernel loaded with `dlopen`, which is unloaded when the last reference is
+ * dropped
+ */
+class LoadedKernel {
+    void *dlHandle_ = nullptr;
+
+  public:
+    LoadedKernel(void *dlHandle) : dlHandle_(dlHandle) {}
+    ~LoadedKernel();
+
+    LoadedKernel(const LoadedKernel &) = delete;
+    LoadedKernel &operator=(const LoadedKernel &) = delete;
+
+    void *dlHandle() const { return dlHandle_; }
+};
+
+/**
+ * Make a key for the kernel cache
+ *
+ * The key covers everything that affects the compiled binary: the generated
+ * source, the identity of the backend compiler (resolved path and output of
+ * `--version`), the host ISA if compiling with `-march=native` (output of
+ * `-march=native -Q --help=target`), the compiler arguments, and the content
+ * of the runtime headers
+ *
+ * @param src : Generated source code
+ * @param compiler : Path to the backend compiler
+ * @param args : Arguments to the backend compiler, where paths of the
+ * temporary source and binary files should already be replaced by placeholders
+ */
+std::string makeKernelCacheKey(const std::string &src,
+                               const std::filesystem::path &compiler,
+                               const std::vector<std::string> &args);
+
+/**
+ * Get a compiled kernel from the persistent cache in `Config::kernelCacheDir`,
+ * or build and insert it if it is not cached
+ *
+ * Each entry is stored as `<hash>.so`, together with its full key in
+ * `<hash>.key` to guard against hash collisions. An entry is populated by
+ * writing a temporary file and then renaming it, so a reader never sees a
+ * partial file. Concurrent populations of the same entry from multiple threads
+ * or processes are serialized by a file lock, so only one compilation is done.
+ * When the total size of the cache exceeds `Config::kernelCacheSizeLimit`,
+ * least recently used entries are evicted
+ *
+ * The cached binary is hard-linked (or copied, if not possible) to `dst`, so
+ * the caller can load and delete `dst` on its own, and eviction will never
+ * remove a binary being loaded
+ *
+ * @param key : Key returned by `makeKernelCacheKey`
+ * @param dst : Where to place the binary
+ * @param build : Callback to compile the binary to `dst` in case of a miss
+ */
+void lookupOrBuildKernel(const std::string &key,
+                         const std::filesystem::path &dst,
+                         const std::function<void()> &build);
+
+/**
+ * Get a loaded kernel shared in the process, or build and load it
+ *
+ * Kernels are registered by their keys in a process-wide registry, so
+ * `Driver`s of identical programs share one compilation and one loaded binary.
+ * The registry only holds weak references, so a kernel is still unloaded once
+ * no `Driver` uses it. Concurrent requests of the same key are coalesced: only
+ * one of them calls `load`, and the others wait for its result (or its
+ * exception)
+ *
+ * @param key : Key returned by `makeKernelCacheKey`
+ * @param load : Callback to build and load the kernel if it is not in the
+ * registry
+ */
+Ref<LoadedKernel>
+loadKernelShared(const std::string &key,
+                 const std::function<Ref<LoadedKernel>()> &load);
+
+/**
+ * Get a directory containing `cpu_runtime.h.gch`, a precompiled header of the
+ * CPU runtime, or build it if not existing
+ *
+ * When the directory is put in front of the include paths, GCC picks the
+ * precompiled header up for `#include <cpu_runtime.h>` in the generated code,
+ * and saves parsing the runtime and the standard headers for every kernel. If
+ * the precompiled header is incompatible with the flags of a kernel, GCC falls
+ * back to the plain header silently
+ *
+ * Precompiled headers are stored in `pch` under `Config::kernelCacheDir`, or
+ * `~/.freetensor/pch` if the kernel cache is disabled, one sub-directory for
+ * each combination of the compiler, the flags and the runtime headers. A
+ * sub-directory is populated by renaming a temporary one, under a file lock
+ *
+ * @param compiler : Path to the backend compiler
+ * @param flags : Flags used to compile (but not link) kernels
+ * @param compile : Callback to run the compiler with given arguments
+ * @return : The directory, or nullopt if the header can not be precompiled. A
+ * failure is remembered in the process, and not retried
+ */
+std::optional<std::filesystem::path> precompiledRuntimeDir(
+    const std::filesystem::path &compiler,
+    const std::vector<std::string> &flags,
+    const std::function<void(const std::vector<std::string> &)> &compile);
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_KERNEL_CACHE_H
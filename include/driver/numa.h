@@ -0,0 +1,134 @@
+#ifndef FREE_TENSOR_NUMA_H
+#define FREE_TENSOR_NUMA_H
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <container_utils.h>
+#include <except.h>
+
+namespace freetensor {
+
+/**
+ * Placement of the pages of `Array`s on a CPU `Device` among NUMA nodes
+ */
+enum class NUMAPolicy : size_t {
+    Default = 0, /// Allocated from the memory pool, and placed by the OS, i.e.
+                 /// usually on the node of the thread initializing the data
+    Interleave,  /// Interleaved page by page among all the allowed nodes
+    Bind,        /// All on one node
+    FirstTouch,  /// Left untouched after allocation, and initialized by
+                 /// multiple threads in static partitions, so they are placed
+                 /// on the nodes of the threads processing them in an
+                 /// OpenMP-parallel loop of the same partition
+    // ------
+    NumPolicies,
+};
+
+// First deduce array length, then assert, to ensure the length
+constexpr std::array numaPolicyNames = {
+    "default",
+    "interleave",
+    "bind",
+    "first_touch",
+};
+static_assert(numaPolicyNames.size() == (size_t)NUMAPolicy::NumPolicies);
+
+inline std::ostream &operator<<(std::ostream &os, NUMAPolicy policy) {
+    return os << numaPolicyNames.at((size_t)policy);
+}
+
+inline NUMAPolicy parseNUMAPolicy(const std::string &_str) {
+    auto &&str = tolower(_str);
+    for (auto &&[i, s] : views::enumerate(numaPolicyNames)) {
+        if (s == str) {
+            return (NUMAPolicy)i;
+        }
+    }
+    std::string msg = "Unrecognized NUMA policy \"" + _str +
+                      "\". Candidates are (case-insensitive): ";
+    for (auto &&[i, s] : views::enumerate(numaPolicyNames)) {
+        msg += (i > 0 ? ", " : "");
+        msg += s;
+    }
+    ERROR(msg);
+}
+
+/**
+ * Size of a base page, from `sysconf`
+ */
+size_t systemPageSize();
+
+/**
+ * Number of NUMA nodes in the system. 1 if NUMA is not supported
+ */
+int numaNodes();
+
+/**
+ * Whether a node exists and is allowed for the process
+ */
+bool numaNodeAvailable(int node);
+
+/**
+ * IDs of the nodes allowed for the process, in ascending order. They are not
+ * necessarily contiguous. `{0}` if NUMA is not supported
+ */
+std::vector<int> numaAllowedNodes();
+
+/**
+ * Node where the page containing an address actually resides, as reported by
+ * the OS. The page is faulted in if not touched yet. -1 if not supported
+ */
+int numaNodeOfAddress(const void *ptr);
+
+/**
+ * Set the NUMA policy of pages not touched yet
+ *
+ * Only `Interleave` and `Bind` need a system call. It is only a hint: it has no
+ * effect if not supported, e.g. on a system with a single node, or if the node
+ * is not available
+ *
+ * @param ptr : Page-aligned address
+ * @param size : Length in bytes
+ * @param node : The node for `Bind`
+ */
+void numaApplyPolicy(void *ptr, size_t size, NUMAPolicy policy, int node);
+
+/**
+ * Copy or zero-initialize memory on CPU by all OpenMP threads, each for a
+ * static partition of the bytes. It runs in one thread if the data is small
+ *
+ * The number of threads is set by the innermost `ParallelCopyThreadsGuard` of
+ * the calling thread, or the default of OpenMP
+ * @{
+ */
+void parallelMemcpy(void *dst, const void *src, size_t size);
+void parallelMemset0(void *ptr, size_t size);
+/** @} */
+
+/**
+ * Set the number of OpenMP threads of `parallelMemcpy` and `parallelMemset0`
+ * in the current thread during its lifetime
+ *
+ * A `Driver` sets it to its own number of threads when copying its arguments,
+ * so pages placed by `NUMAPolicy::FirstTouch` are touched by the same threads
+ * running the program
+ */
+class ParallelCopyThreadsGuard {
+    int old_;
+
+  public:
+    ParallelCopyThreadsGuard(int numThreads); /// 0 for the default of OpenMP
+    ~ParallelCopyThreadsGuard();
+
+    ParallelCopyThreadsGuard(const ParallelCopyThreadsGuard &) = delete;
+    ParallelCopyThreadsGuard &
+    operator=(const ParallelCopyThreadsGuard &) = delete;
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_NUMA_H
@@ -0,0 +1,71 @@
+#ifndef FREE_TENSOR_PERF_COUNTERS_H
+#define FREE_TENSOR_PERF_COUNTERS_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace freetensor {
+
+/**
+ * Hardware performance counters of a CPU program, through `perf_event_open`
+ *
+ * Counts cycles, instructions, last-level cache misses, L1 data cache misses
+ * and branch misses in user space. Counters are opened on the calling thread
+ * and the threads of its OpenMP team, which are the threads running a program
+ * invoked from the calling thread, and summed up over the threads
+ *
+ * If counters are not permitted (see `/proc/sys/kernel/perf_event_paranoid`)
+ * or not supported, a warning is issued once and `available()` is false. Events
+ * not supported by the CPU are skipped individually
+ */
+class PerfCounters {
+    struct Group {
+        int leader_ = -1;
+        std::vector<std::pair<size_t, int>> fds_; /// (event, fd), leader first
+    };
+    std::vector<Group> groups_; /// One per thread
+    bool available_ = false;
+
+  public:
+    /**
+     * Open the counters
+     *
+     * @param numThreads : Size of the OpenMP team to count, which should be
+     * the number of threads the program is run with
+     */
+    explicit PerfCounters(int numThreads);
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available() const { return available_; }
+
+    /**
+     * Start or stop counting. Counters are opened stopped
+     * @{
+     */
+    void enable();
+    void disable();
+    /** @} */
+
+    /**
+     * Set all the counters to 0
+     */
+    void reset();
+
+    /**
+     * Counts since the last `reset`, keyed by "cycles", "instructions",
+     * "llc_misses", "l1d_misses" and "branch_misses"
+     *
+     * If there are more events than hardware counters, the kernel multiplexes
+     * them, and the counts are scaled by the fraction of time they are
+     * actually counted. Events not supported are absent
+     */
+    std::unordered_map<std::string, double> read() const;
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_PERF_COUNTERS_H
@@ -0,0 +1,110 @@
+#ifndef FREE_TENSOR_ROOFLINE_H
+#define FREE_TENSOR_ROOFLINE_H
+
+#include <vector>
+
+#include <data_type.h>
+#include <driver/benchmark.h>
+#include <driver/device.h>
+#include <id.h>
+#include <metadata.h>
+
+namespace freetensor {
+
+struct NodeFeature;
+
+/**
+ * Peak performance of a machine, as the roofs of a roofline model
+ */
+struct MachinePeak {
+    double gflops32_ = 0; /// Peak GFLOP/s in 32-bit floating point
+    double gflops64_ = 0; /// Peak GFLOP/s in 64-bit floating point
+    double bandwidth_ = 0; /// Peak main memory bandwidth in GB/s
+
+    /**
+     * Peak GFLOP/s of operations in a data type. Types other than `Float64`
+     * are assumed to be as fast as `Float32`
+     */
+    double gflops(DataType dtype) const {
+        return dtype == DataType::Float64 ? gflops64_ : gflops32_;
+    }
+};
+
+/**
+ * Measure the peak performance of a device with built-in microbenchmarks
+ *
+ * The bandwidth is measured with a STREAM triad (`a[i] = b[i] + s * c[i]`) on
+ * arrays 4 times larger than the last-level cache, counting 24 bytes per
+ * iteration as STREAM does. The compute throughput is measured with
+ * independent chains of vector FMAs, counting 2 FLOPs per FMA. The
+ * microbenchmarks are compiled for the target of the device in the same way as
+ * generated programs
+ *
+ * Results are cached per target, device and number of threads, so only the
+ * first call is slow
+ *
+ * @param device : The device to measure. Only CPUs are supported
+ * @param numThreads : Number of OpenMP threads to use, 0 for the default of
+ * OpenMP
+ */
+MachinePeak machinePeak(const Ref<Device> &device, int numThreads = 0);
+
+/**
+ * Roofline analysis of a top-level loop nest, or of a whole program. See
+ * `Driver::roofline`
+ *
+ * FLOPs and bytes are -1, and the rates derived from them are NaN, if they
+ * cannot be counted statically (e.g. for loops of dynamic lengths)
+ */
+struct RooflineEntry {
+    ID id_; /// Invalid for the whole program
+    Metadata metadata_;
+    double time_ = 0; /// Average time per run in ms
+
+    double flop_ = 0; /// Floating point operations per run
+    double bytes_ = 0; /// Footprint in the main memory per run in bytes,
+                       /// which is the least traffic to the main memory
+    DataType dtype_ = DataType::Float32; /// The type of most of the FLOPs
+
+    double gflops_ = 0; /// Achieved GFLOP/s
+    double bandwidth_ = 0; /// Achieved GB/s
+    double intensity_ = 0; /// Arithmetic intensity in FLOPs per byte
+
+    /// Attainable GFLOP/s under the roofline model at `intensity_`, i.e.
+    /// `min(peak GFLOP/s, intensity_ * peak GB/s)`
+    double attainableGFlops_ = 0;
+
+    /// Whether the attainable performance is limited by the memory bandwidth
+    /// instead of the compute throughput
+    bool memoryBound_ = false;
+
+    /// `gflops_ / attainableGFlops_`. Close to 1 means there is little room
+    /// for further scheduling without reducing the memory traffic
+    double efficiency_ = 0;
+};
+
+/**
+ * Result of `Driver::roofline`
+ */
+struct RooflineReport {
+    MachinePeak peak_;
+    BenchmarkResult benchmark_; /// Time of the whole program
+    RooflineEntry total_;       /// The whole program
+    std::vector<RooflineEntry> nests_; /// Each top-level loop nest
+};
+
+/**
+ * Roofline analysis of a statement
+ *
+ * @param feature : Result of `structuralFeature` of the statement. FLOPs are
+ * floating point operations in it, and bytes are its footprint in the main
+ * memory
+ * @param time : Measured time of the statement in ms
+ * @param peak : The roofs
+ */
+RooflineEntry analyzeRoofline(const NodeFeature &feature, double time,
+                              const MachinePeak &peak);
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_ROOFLINE_H
@@ -8,6 +8,7 @@
 #endif
 
 #include <buffer.h>
+#include <driver/blas_provider.h>
 #include <driver/target_type.h>
 #include <ref.h>
 
@@ -30,15 +31,66 @@ class Target {
 
 class CPUTarget : public Target {
     bool useNativeArch_;
+    int vectorBytes_ = 0; /// 0 = detect
+    bool streamingStores_ = false;
+    BLASProvider blas_ = BLASProvider::Default;
     // TODO: infoArch
 
   public:
-    CPUTarget(bool useNativeArch = true) : useNativeArch_(useNativeArch) {}
+    CPUTarget(bool useNativeArch = true, int vectorBytes = 0,
+              bool streamingStores = false,
+              BLASProvider blas = BLASProvider::Default)
+        : useNativeArch_(useNativeArch), vectorBytes_(vectorBytes),
+          streamingStores_(streamingStores), blas_(blas) {}
 
     void setUseNativeArch(bool useNativeArch = true) {
         useNativeArch_ = useNativeArch;
     }
     bool useNativeArch() const override { return useNativeArch_; }
+
+    /**
+     * Width in bytes of SIMD vectors generated for vectorized loops
+     *
+     * If not set, it is detected from the CPU running FreeTensor when using the
+     * native architecture (64 for AVX-512, 32 for AVX, and 16 otherwise), or 16
+     * (SSE or NEON) when not
+     *
+     * @{
+     */
+    void setVectorBytes(int vectorBytes = 0) { vectorBytes_ = vectorBytes; }
+    int vectorBytes() const;
+    /** @} */
+
+    /**
+     * Whether to write output tensors with non-temporal (streaming) stores,
+     * which bypass the cache
+     *
+     * When enabled, full-vector contiguous stores to `output` tensors that are
+     * never read in the program are lowered to streaming stores in loops
+     * vectorized with explicit SIMD. This saves the read-for-ownership traffic
+     * of the cache lines, but is harmful if the output is read again soon
+     * while still in cache, so it is disabled by default
+     *
+     * @{
+     */
+    void setStreamingStores(bool streamingStores = true) {
+        streamingStores_ = streamingStores;
+    }
+    bool streamingStores() const { return streamingStores_; }
+    /** @} */
+
+    /**
+     * BLAS library called for `MatMul`
+     *
+     * `MatMul` of integers always uses the built-in GEMM, which BLAS libraries
+     * do not support. `blas()` returns the provider with `Default` resolved
+     *
+     * @{
+     */
+    void setBLAS(BLASProvider blas = BLASProvider::Default);
+    BLASProvider blas() const { return resolveBLASProvider(blas_); }
+    /** @} */
+
     TargetType type() const override { return TargetType::CPU; }
     std::string toString() const override { return "CPU"; }
     MemType mainMemType() const override { return MemType::CPU; }
@@ -567,6 +567,9 @@ class IntrinsicNode : public ExprNode {
     SubTreeList<ExprNode> params_ = ChildOf{this};
     DataType retType_;
     bool hasSideEffect_;
+    bool isHint_; /// Only a hint (e.g. prefetching) that never accesses
+                  /// memory. Loads in params_ are ignored by dependence
+                  /// analysis
     void compHash() override;
     void inferDType() override;
     DEFINE_NODE_TRAIT(Intrinsic);
@@ -575,22 +578,24 @@ typedef Ref<IntrinsicNode> Intrinsic;
 #define makeIntrinsic(...) makeNode(Intrinsic, __VA_ARGS__)
 template <class T>
 Expr _makeIntrinsic(const std::string &format, T &&params, DataType retType,
-                    bool hasSideEffect) {
+                    bool hasSideEffect, bool isHint = false) {
     Intrinsic i = Intrinsic::make();
     i->format_ = format;
     i->params_ = std::forward<T>(params);
     i->retType_ = retType;
     i->hasSideEffect_ = hasSideEffect;
+    i->isHint_ = isHint;
     return i;
 }
 inline Expr _makeIntrinsic(const std::string &format,
                            std::initializer_list<Expr> params, DataType retType,
-                           bool hasSideEffect) {
+                           bool hasSideEffect, bool isHint = false) {
     Intrinsic i = Intrinsic::make();
     i->format_ = format;
     i->params_ = params;
     i->retType_ = retType;
     i->hasSideEffect_ = hasSideEffect;
+    i->isHint_ = isHint;
     return i;
 }
 
@@ -119,6 +119,9 @@ T lower(const T &_ast, const Ref<Target> &_target = nullptr,
     case TargetType::CPU:
         ast = APPLY("cpu_lower_parallel_reduction", cpu::lowerParallelReduction,
                     ast);
+        // Vectorized loops are lowered to SIMD code by `codeGen` instead, so
+        // analyses on the result (e.g. `structuralFeature`) still count their
+        // operations and accesses in every lane
         ast = APPLY("use_builtin_div", useBuiltinDiv, ast);
         break;
 
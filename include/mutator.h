@@ -335,7 +335,8 @@ class Mutator {
             params.emplace_back((*this)(param));
         }
         return COPY_DEBUG_INFO(makeIntrinsic(op->format_, std::move(params),
-                                             op->retType_, op->hasSideEffect_),
+                                             op->retType_, op->hasSideEffect_,
+                                             op->isHint_),
                                op);
     }
 
@@ -118,10 +118,17 @@ class ConstFold : public Mutator {
             case DataType::Int32:
             case DataType::Int64:
                 return wrap(int64_t(v));
+            case DataType::Int8:
+                return wrap(int64_t(int8_t(int64_t(v))));
+            case DataType::UInt8:
+                return wrap(int64_t(uint8_t(int64_t(v))));
             case DataType::Float32:
             case DataType::Float64:
+            case DataType::Float16:
+            case DataType::BFloat16:
                 return wrap(double(v));
             case DataType::Bool:
+            case DataType::PackedBool:
                 return wrap(bool(v));
             default:
                 ASSERT(false && "Unrecognized variable type assigned");
@@ -20,6 +20,12 @@ class LowerParallelReduction : public SymbolTable<Mutator> {
   private:
     std::vector<std::pair<For, int>> reducedBy(const ReduceTo &op);
 
+    /**
+     * Whether to reduce into explicit per-thread partials instead of using
+     * OpenMP's reduction clause
+     */
+    bool privatize(const ReductionItem &r);
+
   protected:
     using BaseClass::visit;
     Stmt visit(const For &op) override;
@@ -30,6 +36,11 @@ class LowerParallelReduction : public SymbolTable<Mutator> {
  * Although parallel reduction enjoys a native support by OpenMP, it does not
  * support using parallel reduction and atomic reduction simulteneously.
  * Therefore, we need to make some transformations
+ *
+ * Small reduced sections are reduced by OpenMP's reduction clauses, one for
+ * each operator. Large or dynamically sized sections, whose private copies may
+ * not fit in the stack of each thread, are reduced into heap-allocated
+ * per-thread partials, which are combined in parallel after the loop
  */
 Stmt lowerParallelReduction(const Stmt &op);
 
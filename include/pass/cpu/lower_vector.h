@@ -0,0 +1,175 @@
+#ifndef FREE_TENSOR_CPU_LOWER_VECTOR_H
+#define FREE_TENSOR_CPU_LOWER_VECTOR_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <analyze/symbol_table.h>
+#include <driver/target.h>
+#include <func.h>
+#include <mutator.h>
+
+namespace freetensor {
+
+namespace cpu {
+
+class LowerVector : public SymbolTable<Mutator> {
+    typedef SymbolTable<Mutator> BaseClass;
+
+    /**
+     * Value of an expression in all the lanes
+     */
+    struct VecVal {
+        enum Kind {
+            Scalar, /// Same in all lanes. `expr_` is the original expression
+            Vec,    /// `simd_t<dtype_, W>`
+            Mask,   /// `simd_mask_t<W>`, for boolean values
+        } kind_;
+        Expr expr_;
+        DataType dtype_; /// Type of each lane
+    };
+
+    int vectorBytes_;
+
+    /// Variables to write with streaming stores
+    std::unordered_set<std::string> streamVars_;
+    bool streamed_ = false; /// Streaming stores emitted but not fenced yet
+    int loopDepth_ = 0;
+    int parallelDepth_ = 0; /// Number of enclosing OpenMP-parallel loops
+
+    // States of the loop being lowered
+    std::string iter_;
+    Stmt body_;
+    Expr base_;       /// Value of `iter_` in the first lane
+    Expr count_;      /// Number of active lanes in the tail, or null
+    Expr mask_;       /// Mask of active lanes under conditions, or null
+    bool aligned_;    /// Whether `base_` is a multiple of `width_`
+    int width_;
+
+    /// Vector accumulators of horizontal reductions, by IDs of the `ReduceTo`s
+    std::unordered_map<ID, std::string> accs_;
+
+  public:
+    LowerVector(int vectorBytes,
+                const std::unordered_set<std::string> &streamVars = {})
+        : vectorBytes_(vectorBytes), streamVars_(streamVars) {}
+
+  private:
+    std::string lanes(DataType dtype) const;
+
+    Expr broadcast(const VecVal &val, DataType dtype) const;
+    Expr toMask(const VecVal &val) const;
+    Expr activeMask() const;
+
+    VecVal vec(const Expr &expr);
+    VecVal vecBinary(const std::string &format, const Expr &lhs,
+                     const Expr &rhs, DataType dtype, bool isMask = false);
+    VecVal vecMap(const std::string &func, const Expr &expr,
+                  DataType dtype);
+    VecVal vecMap2(const std::string &func, const Expr &lhs, const Expr &rhs,
+                   DataType dtype);
+
+    /**
+     * Address of the first lane of a contiguous access, or offsets of each lane
+     * from the beginning of the buffer otherwise
+     *
+     * For a `PackedBool` buffer, which must be accessed contiguously, it is the
+     * element of the first lane instead, whose reference points to its bit
+     *
+     * @return : (address or offsets, whether it is contiguous, whether it is
+     * aligned to the vector)
+     */
+    std::tuple<Expr, bool, bool> address(const std::string &var,
+                                         const std::vector<Expr> &indices);
+
+    /**
+     * Name of an aligned vector load or store, e.g. `simd_load_aligned<float,
+     * 8>`. Accesses to I/O tensors are only aligned in the `run` entry of the
+     * kernel, as reflected by its template parameter `ALIGNED`
+     *
+     * @param func : "simd_load" or "simd_store"
+     */
+    std::string alignedFunc(const std::string &func, const std::string &var,
+                            DataType dtype);
+
+    VecVal vecLoad(const Load &op);
+    VecVal vecPackedLoad(const Load &op);
+    Stmt vecWrite(const std::string &var, const std::vector<Expr> &indices,
+                  const Expr &value);
+    Stmt vecPackedWrite(const std::string &var,
+                        const std::vector<Expr> &indices, const Expr &value);
+    Stmt vecStmt(const Stmt &op);
+
+    /**
+     * Reductions in the loop that can be reduced horizontally: non-atomic
+     * reductions with `+=`, `-=`, `*=`, `min=` or `max=` to a location
+     * invariant in the loop, where the variable is not otherwise accessed in
+     * the loop than by reductions of the same operation
+     */
+    std::vector<ReduceTo> horizontalReductions() const;
+    Expr neutral(ReduceOp op, DataType dtype) const;
+
+    Stmt lowerLoop(const For &op, int width);
+    Stmt visitLoop(const For &op);
+
+    /**
+     * Leave a loop failed to be lowered to the backend compiler
+     */
+    Stmt visitScalarLoop(const For &op);
+
+  protected:
+    using BaseClass::visit;
+    Stmt visit(const For &op) override;
+};
+
+/**
+ * Lower loops marked by `Schedule::vectorize` into explicit SIMD code
+ *
+ * It is run by `codeGen` on the result of `lower`, so analyses on lowered ASTs
+ * still see the vectorized loops as scalar loops
+ *
+ * Each vectorized loop is split into a main loop, which processes a vector of
+ * lanes per iteration, and a masked tail for the remaining iterations. The
+ * width of the vector is determined by the vector register size of the target
+ * and the widest data type accessed in the loop. Contiguous memory accesses are
+ * lowered to vector loads and stores (aligned if provable), and other accesses,
+ * including indirect ones, to gathers and scatters. See runtime/cpu_simd.h for
+ * the helpers used
+ *
+ * Heap-allocated tensors are always aligned. I/O tensors are aligned only if
+ * the Driver finds the `Array`s aligned, so their aligned accesses are
+ * instantiated both ways by `codeGenCPU`
+ *
+ * A reduction to a location invariant in the loop is accumulated in a vector,
+ * which is reduced horizontally after the loop, and combined into the location.
+ * See `horizontalReductions` for the conditions
+ *
+ * Contiguous accesses to `packed_bool` tensors are lowered to loading or
+ * storing the bits of all lanes at once from their words, and logical
+ * reductions to them to bit-wise operations on masks. Words at the boundaries
+ * are updated atomically inside OpenMP-parallel loops, since they may be
+ * shared with other threads. See runtime/cpu_packed_bool.h
+ *
+ * A loop that cannot be lowered, e.g. containing a nested loop, is left as is
+ * with a warning, and is vectorized by the backend compiler as a hint, unless
+ * it contains horizontal reductions, which are not expressed in the hint
+ *
+ * If `CPUTarget::streamingStores` is enabled, full-vector contiguous stores to
+ * `output` tensors never read in the program are lowered to streaming stores.
+ * A fence is inserted at the end of the body of each OpenMP-parallel loop (run
+ * by `codeGenCPU` once per thread after the loop), or after the outermost loop,
+ * containing them
+ *
+ * @param op : The AST to lower
+ * @param target : The target, to determine the vector width
+ */
+Stmt lowerVector(const Stmt &op, const Ref<CPUTarget> &target);
+
+DEFINE_PASS_FOR_FUNC(lowerVector)
+
+} // namespace cpu
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_CPU_LOWER_VECTOR_H
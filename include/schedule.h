@@ -635,12 +635,42 @@ class Schedule {
      * achitecture, the scheduler may or may not postpone it to the backend
      * compiler. The vectorization is a best-effort schedule
      *
+     * On CPU, reductions to a location invariant in the loop (e.g. a sum) are
+     * allowed, and are accumulated in vectors and reduced horizontally after
+     * the loop
+     *
      * @param loop : ID of the loop
      * @throw InvalidSchedule if the ID or name is not found, or the dependency
      * requirement is not met
      */
     void vectorize(const ID &loop);
 
+    /**
+     * Prefetch accesses to a variable some iterations ahead in a loop
+     *
+     * For each statement in the loop accessing `var`, a CPU prefetch
+     * (`__builtin_prefetch`) is inserted before the statement, to the address
+     * it will access `distance` iterations later. The future address is
+     * computed by substituting the iterator, so indirect accesses like
+     * `x[idx[i]]` can be prefetched, which neither the hardware prefetcher nor
+     * the backend compiler can predict. Indices are loaded only if they are in
+     * bounds, and only for iterations that exist
+     *
+     * Accesses whose addresses do not depend on the loop, or depend on
+     * variables defined inside the loop, are not prefetched
+     *
+     * Prefetching does not change the semantics of the program. Only CPU
+     * targets are supported
+     *
+     * @param loop : ID of the loop
+     * @param var : Name of the variable to prefetch
+     * @param distance : Number of iterations to prefetch ahead
+     * @throw InvalidSchedule if the loop is not found, its step is not a
+     * constant, `distance` is not positive, or no access to `var` can be
+     * prefetched
+     */
+    void prefetch(const ID &loop, const std::string &var, int distance);
+
     /**
      * Seperate main iterations and tail iterations of a loop
      *
@@ -12,13 +12,15 @@ class MakeCacheVar : public Mutator {
     std::string oldVar_, newVar_;
     ID oldDef_, newDef_;
     MemType mtype_;
+    bool isReduction_;
     VarDef def_;
     bool inStmt_ = false;
 
   public:
     MakeCacheVar(const ID &stmt, const std::string &oldVar, MemType mtype,
                  bool isReduction)
-        : stmt_(stmt), oldVar_(oldVar), mtype_(mtype) {
+        : stmt_(stmt), oldVar_(oldVar), mtype_(mtype),
+          isReduction_(isReduction) {
         newVar_ = oldVar_ + (isReduction ? ".r" : ".c");
         switch (mtype) {
         case MemType::GPULocal:
@@ -0,0 +1,55 @@
+#ifndef FREE_TENSOR_PREFETCH_H
+#define FREE_TENSOR_PREFETCH_H
+
+#include <unordered_set>
+
+#include <analyze/symbol_table.h>
+#include <mutator.h>
+
+namespace freetensor {
+
+/**
+ * Insert software prefetches for accesses to a variable a fixed number of
+ * iterations ahead in a loop
+ */
+class Prefetch : public SymbolTable<Mutator> {
+    typedef SymbolTable<Mutator> BaseClass;
+
+    ID loop_;
+    std::string var_;
+    int distance_;
+
+    For loopNode_; /// Set when visiting inside the loop
+    int64_t step_ = 0;
+    std::unordered_set<std::string> defsInLoop_;
+    bool found_ = false;
+    int inserted_ = 0;
+
+  public:
+    Prefetch(const ID &loop, const std::string &var, int distance)
+        : loop_(loop), var_(var), distance_(distance) {}
+
+    bool found() const { return found_; }
+    int inserted() const { return inserted_; }
+
+  private:
+    /**
+     * Build the prefetch of an access of `var_` `distance_` iterations ahead,
+     * or return null if the future address cannot be computed
+     */
+    Stmt makePrefetch(const std::vector<Expr> &indices, bool isWrite,
+                      const Stmt &from);
+
+  protected:
+    using BaseClass::visit;
+    Stmt visitStmt(const Stmt &op) override;
+    Stmt visit(const For &op) override;
+    Stmt visit(const VarDef &op) override;
+};
+
+Stmt prefetch(const Stmt &ast, const ID &loop, const std::string &var,
+              int distance);
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_PREFETCH_H
@@ -36,6 +36,7 @@ enum class ScheduleType : int {
     Permute,
     PlutoFuse,
     PlutoPermute,
+    Prefetch,
     // ------
     NumTypes,
 };
@@ -48,7 +49,7 @@ constexpr std::array scheduleTypeNames = {
     "var_reorder",   "inline",    "parallelize",
     "unroll",        "vectorize", "separate_tail",
     "as_matmul",     "permute",   "pluto_fuse",
-    "pluto_permute",
+    "pluto_permute", "prefetch",
 };
 static_assert(scheduleTypeNames.size() == (size_t)ScheduleType::NumTypes);
 
@@ -18,7 +18,8 @@ class AutoSchedule(ffi.AutoSchedule):
                  continue_training=False,
                  random_seed=None,
                  rule_set=None,
-                 verbose=0):
+                 verbose=0,
+                 perf_counters=False):
         '''
         Automatic scheduler
 
@@ -46,6 +47,11 @@ class AutoSchedule(ffi.AutoSchedule):
         verbose : int
             Verbosity level. 0 = print nothing, 1 = print tuning progress, 2 = print
             extra info mation of each rule
+        perf_counters : bool
+            (CPU only) Also read hardware performance counters when measuring.
+            The counters of the programs passed to `update` are available from
+            `get_last_counters()` in the same order, as an extra training
+            signal
         '''
 
         self.population = population
@@ -68,7 +74,7 @@ class AutoSchedule(ffi.AutoSchedule):
         super(AutoSchedule,
               self).__init__(schedule, target, device, predict_func,
                              update_func, tag, min_block_size, random_seed,
-                             rule_set, verbose)
+                             rule_set, verbose, perf_counters)
 
     def set_params(self, *args, **kws):
         super(AutoSchedule, self).set_params(args, kws)
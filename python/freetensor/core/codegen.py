@@ -5,7 +5,7 @@ import functools
 from . import config
 from .. import debug
 
-from typing import Optional
+from typing import Optional, Union
 
 
 class NativeCode:
@@ -21,7 +21,8 @@ class NativeCode:
 
 def codegen(ast=None,
             target: Optional[ffi.Target] = None,
-            verbose: Optional[bool] = None) -> NativeCode:
+            verbose: Optional[bool] = None,
+            profile: Union[bool, str, None] = None) -> NativeCode:
     '''
     Generate native code
 
@@ -33,13 +34,21 @@ def codegen(ast=None,
         returned, which can be used as a decorator
     target : Target (Optional)
         The target architecture. If omitted, use the default one in config
+    profile : bool or str (Optional)
+        (CPU only) Instrument statements to measure their time. Set to a
+        selector to choose the statements, or True for the outermost loops.
+        Get the results with `Driver.profile` after running
     '''
 
     if ast is not None:
 
         if target is None:
             target = config.default_target()
-        raw_code = ffi.code_gen(ast, target)
+        if profile is True:
+            profile = "<For>&!(<<-<For>)"  # Outermost loops
+        elif profile is False:
+            profile = None
+        raw_code = ffi.code_gen(ast, target, profile)
         if verbose:
             print(debug.with_line_no(raw_code), file=sys.stderr)
 
@@ -52,4 +61,6 @@ def codegen(ast=None,
             f = functools.partial(f, target=target)
         if verbose is not None:
             f = functools.partial(f, verbose=verbose)
+        if profile is not None:
+            f = functools.partial(f, profile=profile)
         return f
@@ -41,6 +41,34 @@ backend_compiler_cxx = _import_func(ffi.backend_compiler_cxx)
 set_backend_compiler_nvcc = _import_func(ffi.set_backend_compiler_nvcc)
 backend_compiler_nvcc = _import_func(ffi.backend_compiler_nvcc)
 
+set_backend_compiler_jobs = _import_func(ffi.set_backend_compiler_jobs)
+backend_compiler_jobs = _import_func(ffi.backend_compiler_jobs)
+
+set_backend_compiler_timeout = _import_func(ffi.set_backend_compiler_timeout)
+backend_compiler_timeout = _import_func(ffi.backend_compiler_timeout)
+
+set_backend_pch = _import_func(ffi.set_backend_pch)
+backend_pch = _import_func(ffi.backend_pch)
+
+set_array_huge_pages = _import_func(ffi.set_array_huge_pages)
+array_huge_pages = _import_func(ffi.array_huge_pages)
+
+set_kernel_cache_dir = _import_func(ffi.set_kernel_cache_dir)
+kernel_cache_dir = _import_func(ffi.kernel_cache_dir)
+
+set_kernel_cache_size_limit = _import_func(ffi.set_kernel_cache_size_limit)
+kernel_cache_size_limit = _import_func(ffi.kernel_cache_size_limit)
+
+kernel_cache_hits = _import_func(ffi.kernel_cache_hits)
+kernel_cache_misses = _import_func(ffi.kernel_cache_misses)
+reset_kernel_cache_stats = _import_func(ffi.reset_kernel_cache_stats)
+
+set_openblas_dir = _import_func(ffi.set_openblas_dir)
+openblas_dir = _import_func(ffi.openblas_dir)
+
+set_blis_dir = _import_func(ffi.set_blis_dir)
+blis_dir = _import_func(ffi.blis_dir)
+
 set_default_target = _import_func(ffi.set_default_target)
 default_target = _import_func(ffi.default_target)
 
@@ -1,24 +1,44 @@
 import freetensor_ffi as ffi
 import functools
+import sys
 import numpy as np
 
-from typing import Optional, Sequence
-from freetensor_ffi import Target, Array
+from typing import Optional, Sequence, Union
+from freetensor_ffi import (Target, Array, BenchmarkResult, MachinePeak,
+                            RooflineReport, cpu_memory_pool_stats,
+                            reset_cpu_memory_pool_peak, trim_cpu_memory_pool,
+                            numa_nodes, numa_allowed_nodes)
 
 from . import config
-from .codegen import NativeCode
+from .codegen import NativeCode, codegen
 
 
-def array(data):
+def array(data, packed: bool = False):
     '''
     Factory function for Array
 
     It converts more data format to Array
+
+    Parameters
+    ----------
+    data : Array, numpy.ndarray or torch.Tensor
+        The data
+    packed : bool
+        If True, pack a boolean NumPy array into a new "packed_bool" Array, which
+        stores 8 elements per byte. Otherwise, the Array shares memory with `data`
+        if possible
     '''
 
     if type(data) is Array:
         return data
 
+    if packed:
+        data = np.asarray(data)
+        if data.dtype != np.bool_:
+            raise ffi.DriverError(
+                f"Only booleans can be packed, but got {data.dtype}")
+        return Array.pack_bools(np.ascontiguousarray(data))
+
     # For NumPy, Although Pybind11's `array_t` type provides a flag `forcecast` to
     # cast from a strided array to a contiguous one. But it always casts to a specific
     # type, e.g. float64. I have no idea how to support multiple types. Therfore,
@@ -44,6 +64,69 @@ def array(data):
     raise ffi.DriverError(f"Unsupported data type {type(data)} for Array")
 
 
+def map_file(path: str,
+             shape: Optional[Sequence[int]] = None,
+             dtype=None,
+             offset: int = 0,
+             mode: str = 'r',
+             advice: Union[str, Sequence[str]] = ()):
+    '''
+    Map a file into an Array on CPU, without reading it
+
+    Pages of the file are read only when they are accessed, e.g. by a program
+    that reads only part of the Array. The file stays mapped as long as the
+    Array lives
+
+    Parameters
+    ----------
+    path : str
+        Path to the file. It is either a NumPy ".npy" file, or a file of raw data
+        in row-major order
+    shape : Sequence[int], optional
+        Shape of the raw data. Leave it None for a ".npy" file, whose shape and
+        data type are read from its header
+    dtype : str or DataType, optional
+        Data type of the raw data
+    offset : int
+        Position of the raw data in the file, in bytes
+    mode : str
+        "r" to map read-only, so the Array can't be written, or "c" to map
+        copy-on-write, so the Array can be written, but the file is unchanged
+    advice : str or Sequence[str]
+        Hints of the access pattern. Candidates are "sequential", "random",
+        "willneed" and "hugepage"
+    '''
+
+    if mode not in ('r', 'c'):
+        raise ffi.DriverError(
+            f"Unsupported mode \"{mode}\" to map a file. Candidates are "
+            "\"r\" (read-only) and \"c\" (copy-on-write)")
+    if isinstance(advice, str):
+        advice = [advice]
+
+    if shape is None:
+        with open(path, 'rb') as f:
+            version = np.lib.format.read_magic(f)
+            if version == (1, 0):
+                shape, fortran_order, np_dtype = \
+                        np.lib.format.read_array_header_1_0(f)
+            else:
+                shape, fortran_order, np_dtype = \
+                        np.lib.format.read_array_header_2_0(f)
+            offset = f.tell()
+        if fortran_order:
+            raise ffi.DriverError(
+                f"Cannot map {path} stored in Fortran order. Only row-major "
+                "data is supported")
+        if dtype is None:
+            dtype = str(np_dtype)
+    if dtype is None:
+        raise ffi.DriverError("dtype is required to map a raw file")
+
+    return Array.map_file(path, list(shape), str(dtype), offset, mode == 'c',
+                          list(advice))
+
+
 _old_target_device_stack = []
 
 
@@ -202,6 +285,13 @@ class Driver(ffi.Driver):
                                          verbose)
         self.func = func
 
+    @staticmethod
+    def _from_future(func: ffi.Func, future: ffi.DriverFuture):
+        self = Driver.__new__(Driver)
+        super(Driver, self).__init__(future)
+        self.func = func
+        return self
+
     def set_args(self, *args, **kws):
         ''' Set argument for an invocation '''
         args = list(args)
@@ -221,7 +311,9 @@ class Driver(ffi.Driver):
         If there is only one return value, it is returned directly. Otherwise,
         the return values are packed in a ReturnValuesPack
         '''
-        values = super(Driver, self).collect_returns()
+        return self._pack_returns(super(Driver, self).collect_returns())
+
+    def _pack_returns(self, values):
         if len(values) == 0:
             return None
         elif len(values) == 1:
@@ -248,6 +340,271 @@ class Driver(ffi.Driver):
         self.run()
         return self.collect_returns()
 
+    def benchmark(self,
+                  warmups: int = 3,
+                  min_rounds: int = 5,
+                  max_rounds: int = 1000,
+                  target_rel_ci: float = 0.01,
+                  time_budget: float = 1000,
+                  flush_cache: bool = False,
+                  reject_outliers: bool = True,
+                  perf_counters: bool = False) -> BenchmarkResult:
+        '''
+        Run the program repeatedly with the arguments set by `set_args`, and
+        report statistics of its time cost
+
+        Runs are repeated until the 95% confidence interval of the mean is
+        tight enough, the time budget runs out, or `max_rounds` is reached
+
+        Parameters
+        ----------
+        warmups : int
+            Unmeasured runs before measuring
+        min_rounds : int
+            Measure at least this number of runs
+        max_rounds : int
+            Measure at most this number of runs
+        target_rel_ci : float
+            Stop once the half width of the confidence interval is no larger
+            than this fraction of the mean. 0 to always run `max_rounds`
+        time_budget : float
+            Stop once measuring has taken this long in ms. 0 for no limit
+        flush_cache : bool
+            Evict the caches before each run, to measure cold runs
+        reject_outliers : bool
+            Exclude runs slower than the median by more than 3 scaled median
+            absolute deviations from the mean
+        perf_counters : bool
+            (CPU only) Also count cycles, instructions, LLC misses, L1D misses
+            and branch misses with hardware performance counters. If they are
+            not permitted, a warning is issued and `counters` of the result is
+            empty
+
+        Returns
+        -------
+        BenchmarkResult
+            With `mean`, `stddev` (of the mean), `rel_ci`, `min`, `max`,
+            `median`, `percentile(q)`, and all the measured `times` in ms. If
+            `perf_counters` is set, `counters` is a dict of average counts per
+            run
+        '''
+        return super(Driver, self).benchmark(warmups, min_rounds, max_rounds,
+                                             target_rel_ci, time_budget,
+                                             flush_cache, reject_outliers,
+                                             perf_counters)
+
+    def roofline(self,
+                 warmups: int = 3,
+                 min_rounds: int = 5,
+                 max_rounds: int = 1000,
+                 target_rel_ci: float = 0.01,
+                 time_budget: float = 1000) -> RooflineReport:
+        '''
+        Measure the program with the arguments set by `set_args`, and compare
+        each top-level loop nest with the peak performance of the machine
+
+        The program must be generated by `codegen(..., profile=True)`. FLOPs
+        and bytes are counted statically from the AST, and the peaks are
+        measured by `machine_peak`. Consider using the `roofline` function,
+        which does all of these
+
+        Parameters are the same as `benchmark`
+
+        Returns
+        -------
+        RooflineReport
+            With `peak` (a `MachinePeak`), `benchmark` (a `BenchmarkResult` of
+            the whole program), `total` (a `RooflineEntry` of the whole
+            program), and `nests` (a `RooflineEntry` for each loop nest). See
+            `print_roofline`
+        '''
+        return super(Driver, self).roofline(warmups, min_rounds, max_rounds,
+                                            target_rel_ci, time_budget)
+
+    def set_num_threads(self, num_threads: Union[int, str, None]):
+        '''
+        Set the number of OpenMP threads used by each invocation of a CPU
+        program
+
+        Parameters
+        ----------
+        num_threads : int, str or None
+            A positive number of threads. "auto" to use no more threads than
+            the maximum trip count of parallel loops, if known after lowering,
+            and no more than the available CPUs. None to use the default of
+            OpenMP
+        '''
+        if num_threads is None:
+            num_threads = 0
+        elif num_threads == "auto":
+            num_threads = ffi.Driver.AUTO_NUM_THREADS
+        super(Driver, self).set_num_threads(num_threads)
+
+    def set_cpu_affinity(self, cpus: Optional[Sequence[int]]):
+        '''
+        Bind the threads of each invocation of a CPU program to a set of CPUs
+
+        The invoking thread and the OpenMP threads it uses are bound to the
+        CPUs. The invoking thread is restored after each invocation. Useful
+        when running multiple programs on one machine, with disjoint CPU sets
+
+        Parameters
+        ----------
+        cpus : Sequence[int] or None
+            IDs of the CPUs. None or empty to cancel the binding
+        '''
+        super(Driver, self).set_cpu_affinity(list(cpus or []))
+
+    def profile(self, frame: Optional['DriverFrame'] = None):
+        '''
+        Time of each statement instrumented by `codegen(..., profile=...)`
+
+        Times are accumulated over invocations since the last `reset_profile`.
+        Print the AST with `config.set_print_all_id(True)` (or print the
+        `metadata` of the entries, which include the history of
+        transformations) to find the statements
+
+        Parameters
+        ----------
+        frame : DriverFrame (Optional)
+            Profile invocations in this frame instead of the default one
+
+        Returns
+        -------
+        List[ffi.ProfileEntry]
+            In the order of the program, with `id`, `metadata`, `time` (ms,
+            summed over threads), `max_thread_time` (ms) and `count`
+        '''
+        if frame is None:
+            return super(Driver, self).profile()
+        return super(Driver, self).profile(frame.frame)
+
+    def reset_profile(self, frame: Optional['DriverFrame'] = None):
+        ''' Clear the profile accumulated in the default frame or `frame` '''
+        if frame is None:
+            super(Driver, self).reset_profile()
+        else:
+            super(Driver, self).reset_profile(frame.frame)
+
+    def print_profile(self,
+                      frame: Optional['DriverFrame'] = None,
+                      file=sys.stderr):
+        ''' Print `profile()` as a table, from the most time-consuming '''
+        entries = sorted(self.profile(frame), key=lambda e: -e.time)
+        total = sum(e.time for e in entries)
+        print(f"{'ID':>8} {'Time (ms)':>12} {'%':>6} {'Count':>10}  Metadata",
+              file=file)
+        for e in entries:
+            percent = e.time / total * 100 if total > 0 else 0
+            metadata = "" if e.metadata is None else str(e.metadata)
+            metadata = metadata.replace("\n", " ")
+            print(
+                f"{'#' + str(e.id):>8} {e.time:>12.3f} {percent:>6.1f} "
+                f"{e.count:>10}  {metadata}",
+                file=file)
+
+    def new_frame(self):
+        '''
+        Create a frame to invoke this Driver
+
+        Different frames of one Driver can be invoked concurrently from
+        different threads, sharing one compiled binary
+        '''
+        return DriverFrame(self, super(Driver, self).new_frame())
+
+    def run_batch(self, arg_sets: Sequence[Sequence], parallelism: int = 1):
+        '''
+        Run the program on multiple sets of arguments
+
+        The signature is resolved only once for the whole batch, which saves
+        the overhead of calling the Driver many times. Closures are not updated
+        by a batch
+
+        Parameters
+        ----------
+        arg_sets : Sequence[Sequence]
+            Positional arguments of each invocation
+        parallelism : int
+            (CPU only) Run this number of invocations concurrently, each on a
+            disjoint subset of CPUs. An Array written by one invocation must
+            not be accessed by another one
+
+        Returns
+        -------
+        (list, list)
+            Return values of each invocation, packed in the same way as
+            `collect_returns`, and the time of each invocation in ms
+        '''
+        arg_sets = [[array(arg) for arg in args] for args in arg_sets]
+        returns, latencies = super(Driver, self).run_batch(
+            arg_sets, parallelism)
+        return [self._pack_returns(values) for values in returns], latencies
+
+
+class DriverFrame:
+    '''
+    States of one invocation of a Driver. Created by `Driver.new_frame`
+
+    Arguments and return values live in the frame instead of the Driver. Using
+    different frames from different threads is thread-safe, as long as the
+    threads do not write to the same Arrays or closures. `run` releases the
+    GIL, so the invocations can actually run in parallel
+    '''
+
+    def __init__(self, driver: Driver, frame: ffi.DriverFrame):
+        self.driver = driver
+        self.frame = frame
+
+    def set_args(self, *args, **kws):
+        ''' Set argument for an invocation in this frame '''
+        args = [array(arg) for arg in args]
+        kws = {key: array(value) for key, value in kws.items()}
+        ffi.Driver.set_args(self.driver, self.frame, args, kws)
+
+    def run(self):
+        ''' Run the binary code in this frame '''
+        ffi.Driver.run(self.driver, self.frame)
+
+    def collect_returns(self):
+        '''
+        Collect return values from an invocation in this frame
+
+        Return values are packed in the same way as `Driver.collect_returns`
+        '''
+        return self.driver._pack_returns(
+            ffi.Driver.collect_returns(self.driver, self.frame))
+
+    def __call__(self, *args, **kws):
+        ''' Set argument, execute the binary code, and collect the returns '''
+        self.set_args(*args, **kws)
+        self.run()
+        return self.collect_returns()
+
+
+class DriverFuture:
+    '''
+    A Driver being built in background. Returned by `build_binary_async`
+    '''
+
+    def __init__(self, func: ffi.Func, future: ffi.DriverFuture):
+        self.func = func
+        self.future = future
+        self.driver = None
+
+    def ready(self) -> bool:
+        ''' Check whether the Driver is built, without blocking '''
+        return self.future.ready()
+
+    def get(self) -> Driver:
+        '''
+        Wait for the Driver to be built and return it
+
+        Errors from building are raised here
+        '''
+        if self.driver is None:
+            self.driver = Driver._from_future(self.func, self.future)
+        return self.driver
+
 
 def build_binary(code: Optional[NativeCode] = None,
                  device: Optional[Device] = None,
@@ -283,3 +640,143 @@ def build_binary(code: Optional[NativeCode] = None,
         if verbose is not None:
             f = functools.partial(f, verbose=verbose)
         return f
+
+
+def build_binary_async(code: NativeCode,
+                       device: Optional[Device] = None,
+                       host_device: Optional[Device] = None,
+                       verbose: Optional[bool] = None) -> DriverFuture:
+    '''
+    Compile a program using a backend compiler in background, and load it into
+    memory
+
+    The number of concurrently running backend compilers is limited by
+    `config.backend_compiler_jobs`, shared with `build_binary`. Use this
+    function to overlap compiling with other work, e.g. running other programs
+
+    Parameters
+    ----------
+    code : NativeCode
+        Native code generated by `codegen`
+    device : Device (Optional)
+        The device to run the program. If omitted, use the default device
+        in config
+
+    Returns
+    -------
+    DriverFuture
+        Call `.get()` on it to wait for and get the Driver
+    '''
+
+    if device is None:
+        device = config.default_device()
+    if device.target() != code.target:
+        raise ffi.DriverError(
+            f"Codegen target ({code.target}) is inconsistent with device target ({device.target()})"
+        )
+    if verbose is None:
+        verbose = False
+    if host_device is None:
+        future = ffi.build_driver_async(code.func, str(code.code), device,
+                                        verbose)
+    else:
+        future = ffi.build_driver_async(code.func, str(code.code), device,
+                                        host_device, verbose)
+    return DriverFuture(code.func, future)
+
+
+def machine_peak(device: Optional[Device] = None,
+                 num_threads: Optional[int] = None) -> MachinePeak:
+    '''
+    Measure the peak performance of a device with built-in microbenchmarks
+
+    The bandwidth is measured by a STREAM triad, and the compute throughput by
+    independent chains of vector FMAs, both compiled for the target of the
+    device. Results are cached, so only the first call is slow
+
+    Parameters
+    ----------
+    device : Device (Optional)
+        The device to measure. If omitted, use the default device in config.
+        Only CPUs are supported
+    num_threads : int (Optional)
+        Number of threads to use. If omitted, use the default of OpenMP
+
+    Returns
+    -------
+    MachinePeak
+        With `gflops32`, `gflops64` (GFLOP/s) and `bandwidth` (GB/s)
+    '''
+    if device is None:
+        device = config.default_device()
+    return ffi.machine_peak(device, num_threads or 0)
+
+
+def roofline(func: ffi.Func,
+             *args,
+             device: Optional[Device] = None,
+             num_threads: Union[int, str, None] = None,
+             verbose: Optional[bool] = None,
+             **kws) -> RooflineReport:
+    '''
+    Run a lowered function with given arguments, and report the achieved
+    GFLOP/s and GB/s of each top-level loop nest, compared with the peaks of
+    the machine
+
+    The function is compiled with each top-level loop nest instrumented for
+    profiling. Print the result with `print_roofline`. A loop nest far below
+    its attainable performance may be improved by further scheduling, while
+    one close to the memory roof can only be improved by reducing its memory
+    traffic
+
+    Parameters
+    ----------
+    func : Func
+        A lowered function
+    args, kws :
+        Arguments to the function
+    device : Device (Optional)
+        The device to run on. If omitted, use the default device in config.
+        Only CPUs are supported
+    num_threads : int, str or None
+        See `Driver.set_num_threads`
+    '''
+    if device is None:
+        device = config.default_device()
+    code = codegen(func, device.target(), verbose=verbose, profile=True)
+    driver = build_binary(code, device, verbose=verbose)
+    driver.set_num_threads(num_threads)
+    driver.set_args(*args, **kws)
+    report = driver.roofline()
+    driver.collect_returns()
+    return report
+
+
+def print_roofline(report: RooflineReport, file=sys.stderr):
+    '''
+    Print a `RooflineReport` as a table, from the most time-consuming nest
+
+    "Eff" is the achieved fraction of the attainable performance, and "Bound"
+    tells which roof limits the attainable performance
+    '''
+    peak = report.peak
+    print(
+        f"Peak: {peak.gflops32:.1f} GFLOP/s (float32), "
+        f"{peak.gflops64:.1f} GFLOP/s (float64), {peak.bandwidth:.1f} GB/s",
+        file=file)
+    print(
+        f"{'ID':>8} {'Time (ms)':>10} {'GFLOP/s':>9} {'GB/s':>8} "
+        f"{'FLOP/B':>8} {'Eff':>6} {'Bound':>7}  Metadata",
+        file=file)
+    rows = [(f"#{e.id}", e)
+            for e in sorted(report.nests, key=lambda e: -e.time)]
+    rows.append(("total", report.total))
+    for name, e in rows:
+        bound = "memory" if e.memory_bound else "compute"
+        metadata = "" if e.metadata is None else str(e.metadata)
+        metadata = metadata.replace("\n", " ")
+        print(
+            f"{name:>8} {e.time:>10.3f} {e.gflops:>9.2f} {e.bandwidth:>8.2f} "
+            f"{e.intensity:>8.3f} {e.efficiency * 100:>5.1f}% {bound:>7}  "
+            f"{metadata}",
+            file=file)
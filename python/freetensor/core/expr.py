@@ -1076,17 +1076,23 @@ def intrinsic(fmt, *params, **kws):
         (Keyword argument only) The return type. Void for no return type. Defaults to Void
     has_side_effect: bool
         (Keyword argument only) True to indicate the intrinsic modifes something other than the return value. Defaults to false
+    is_hint: bool
+        (Keyword argument only) True to indicate the intrinsic is only a hint (e.g. prefetching) that never accesses memory, so accesses in its parameters are ignored by dependence analysis. Defaults to false
     """
     ret_type = ffi.DataType("void")
     has_side_effect = False
+    is_hint = False
     if "ret_type" in kws:
         ret_type = ffi.DataType(kws["ret_type"])
         del kws["ret_type"]
     if "has_side_effect" in kws:
         has_side_effect = kws["has_side_effect"]
         del kws["has_side_effect"]
+    if "is_hint" in kws:
+        is_hint = kws["is_hint"]
+        del kws["is_hint"]
     assert len(kws) == 0, "Unrecognized keyword arguments: %s" % kws
-    return ffi.makeIntrinsic(fmt, params, ret_type, has_side_effect)
+    return ffi.makeIntrinsic(fmt, params, ret_type, has_side_effect, is_hint)
 
 
 def any():
@@ -10,6 +10,10 @@ def min_value(dtype):
         return 0x80000000
     elif dtype == DataType("int64"):
         return 0x8000000000000000
+    elif dtype == DataType("int8"):
+        return -0x80
+    elif dtype == DataType("uint8"):
+        return 0
     else:
         assert False, "Unrecognized data type %s" % dtype
 
@@ -22,6 +26,10 @@ def max_value(dtype):
         return 0x7fffffff
     elif dtype == DataType("int64"):
         return 0x7fffffffffffffff
+    elif dtype == DataType("int8"):
+        return 0x7f
+    elif dtype == DataType("uint8"):
+        return 0xff
     else:
         assert False, "Unrecognized data type %s" % dtype
 
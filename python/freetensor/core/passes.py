@@ -24,6 +24,7 @@ from freetensor_ffi import make_const_shape
 from freetensor_ffi import use_builtin_div
 from freetensor_ffi import hoist_var_over_stmt_seq
 from freetensor_ffi import cpu_lower_parallel_reduction
+from freetensor_ffi import cpu_lower_vector
 
 if config.with_cuda():
     from freetensor_ffi import gpu_lower_parallel_reduction
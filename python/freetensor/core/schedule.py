@@ -684,6 +684,10 @@ class Schedule(ffi.Schedule):
         achitecture, the scheduler may or may not postpone it to the backend
         compiler. The vectorization is a best-effort schedule
 
+        On CPU, reductions to a location invariant in the loop (e.g. a sum) are
+        allowed, and are accumulated in vectors and reduced horizontally after
+        the loop
+
         Parameters
         ----------
         loop : str, ID or Stmt
@@ -697,6 +701,43 @@ class Schedule(ffi.Schedule):
         """
         super().vectorize(self._lookup(loop))
 
+    def prefetch(self, loop, var: str, distance: int):
+        """
+        Prefetch accesses to a variable some iterations ahead in a loop
+
+        For each statement in the loop accessing `var`, a CPU prefetch
+        (`__builtin_prefetch`) is inserted before the statement, to the address
+        it will access `distance` iterations later. The future address is
+        computed by substituting the iterator, so indirect accesses like
+        `x[idx[i]]` can be prefetched, which neither the hardware prefetcher nor
+        the backend compiler can predict. Indices are loaded only if they are in
+        bounds, and only for iterations that exist
+
+        Accesses whose addresses do not depend on the loop, or depend on
+        variables defined inside the loop, are not prefetched
+
+        Prefetching does not change the semantics of the program. Only CPU
+        targets are supported. A prefetch is not an access to the prefetched
+        address in dependence analysis, so it does not restrict schedules
+        applied after it, but the indices loaded to compute the address are
+
+        Parameters
+        ----------
+        loop : str, ID or Stmt
+            ID of the loop
+        var : str
+            Name of the variable to prefetch
+        distance : int
+            Number of iterations to prefetch ahead
+
+        Raises
+        ------
+        InvalidSchedule
+            if the loop is not found, its step is not a constant, `distance` is
+            not positive, or no access to `var` can be prefetched
+        """
+        super().prefetch(self._lookup(loop), var, distance)
+
     def separate_tail(self, noDuplicateVarDefs=False):
         """
         Seperate main iterations and tail iterations of a loop
@@ -0,0 +1,141 @@
+#ifndef FREE_TENSOR_CPU_BLAS_H
+#define FREE_TENSOR_CPU_BLAS_H
+
+/**
+ * GEMM of OpenBLAS or BLIS, used for `MatMul` when selected by
+ * `CPUTarget::setBLAS`. The Driver defines `FT_BLAS_OPENBLAS` or `FT_BLAS_BLIS`
+ * and links the library accordingly
+ *
+ * MKL is called directly in the generated code. The other libraries do not
+ * provide strided-batched GEMM, so it is emulated here with a loop
+ */
+
+#if defined(FT_BLAS_OPENBLAS) || defined(FT_BLAS_BLIS)
+
+#include <algorithm>
+#include <cstdint>
+
+#include <omp.h>
+
+#ifdef FT_BLAS_OPENBLAS
+#include <cblas.h>
+#else
+#include <blis/blis.h>
+#endif
+
+/**
+ * Get the number of threads used by the library
+ */
+inline int blas_get_num_threads() {
+#ifdef FT_BLAS_OPENBLAS
+    return openblas_get_num_threads();
+#else
+    return bli_thread_get_num_threads();
+#endif
+}
+
+/**
+ * Set the number of threads used by the library for following calls. The
+ * setting is global to the process. Not thread-safe
+ */
+inline void blas_set_num_threads(int n) {
+#ifdef FT_BLAS_OPENBLAS
+    openblas_set_num_threads(n);
+#else
+    bli_thread_set_num_threads(n);
+#endif
+}
+
+/**
+ * C = alpha * op(A) * op(B) + beta * C on row-major matrices, where op
+ * transposes the matrix if `trans` is set
+ * @{
+ */
+inline void blas_gemm(bool transA, bool transB, int m, int n, int k,
+                      float alpha, const float *a, int lda, const float *b,
+                      int ldb, float beta, float *c, int ldc) {
+#ifdef FT_BLAS_OPENBLAS
+    cblas_sgemm(CblasRowMajor, transA ? CblasTrans : CblasNoTrans,
+                transB ? CblasTrans : CblasNoTrans, m, n, k, alpha, a, lda, b,
+                ldb, beta, c, ldc);
+#else
+    bli_sgemm(transA ? BLIS_TRANSPOSE : BLIS_NO_TRANSPOSE,
+              transB ? BLIS_TRANSPOSE : BLIS_NO_TRANSPOSE, m, n, k, &alpha,
+              const_cast<float *>(a), lda, 1, const_cast<float *>(b), ldb, 1,
+              &beta, c, ldc, 1);
+#endif
+}
+inline void blas_gemm(bool transA, bool transB, int m, int n, int k,
+                      double alpha, const double *a, int lda, const double *b,
+                      int ldb, double beta, double *c, int ldc) {
+#ifdef FT_BLAS_OPENBLAS
+    cblas_dgemm(CblasRowMajor, transA ? CblasTrans : CblasNoTrans,
+                transB ? CblasTrans : CblasNoTrans, m, n, k, alpha, a, lda, b,
+                ldb, beta, c, ldc);
+#else
+    bli_dgemm(transA ? BLIS_TRANSPOSE : BLIS_NO_TRANSPOSE,
+              transB ? BLIS_TRANSPOSE : BLIS_NO_TRANSPOSE, m, n, k, &alpha,
+              const_cast<double *>(a), lda, 1, const_cast<double *>(b), ldb, 1,
+              &beta, c, ldc, 1);
+#endif
+}
+/** @} */
+
+/**
+ * Strided-batched GEMM on row-major matrices, with the same interface as
+ * `runtime_gemm_batch_strided` in cpu_gemm.h
+ *
+ * If there are at least as many batches as threads, batches are distributed to
+ * threads, each calling the library single-threaded. Otherwise, batches are
+ * computed one by one, each by the library with all threads. The number of
+ * threads of the library is restored afterwards, since it is global to the
+ * process and may be used by the user's own calls
+ *
+ * Inside an OpenMP parallel region, the number of threads of the library is
+ * left untouched, because setting it there would race with other threads.
+ * OpenMP builds of the libraries run single-threaded in a parallel region, but
+ * pthread builds of OpenBLAS still use their own threads and may oversubscribe
+ * the cores
+ */
+template <class T>
+void runtime_blas_gemm_batch_strided(bool transA, bool transB, int m, int n,
+                                     int k, T alpha, const T *a, int lda,
+                                     int64_t strideA, const T *b, int ldb,
+                                     int64_t strideB, T beta, T *c, int ldc,
+                                     int64_t strideC, int batchSize,
+                                     int numThreads) {
+    if (m <= 0 || n <= 0 || batchSize <= 0) {
+        return;
+    }
+    auto one = [&](int bt) {
+        blas_gemm(transA, transB, m, n, k, alpha, a + bt * strideA, lda,
+                  b + bt * strideB, ldb, beta, c + bt * strideC, ldc);
+    };
+
+    if (omp_in_parallel()) {
+        for (int bt = 0; bt < batchSize; bt++) {
+            one(bt);
+        }
+        return;
+    }
+
+    int oldNumThreads = blas_get_num_threads();
+    if (int nThreads = std::max(numThreads, 1);
+        batchSize >= nThreads && nThreads > 1) {
+        blas_set_num_threads(1);
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+        for (int bt = 0; bt < batchSize; bt++) {
+            one(bt);
+        }
+    } else {
+        blas_set_num_threads(nThreads);
+        for (int bt = 0; bt < batchSize; bt++) {
+            one(bt);
+        }
+    }
+    blas_set_num_threads(oldNumThreads);
+}
+
+#endif // defined(FT_BLAS_OPENBLAS) || defined(FT_BLAS_BLIS)
+
+#endif // FREE_TENSOR_CPU_BLAS_H
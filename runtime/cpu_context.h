@@ -1,9 +1,178 @@
 #ifndef FREE_TENSOR_CPU_CONTEXT_H
 #define FREE_TENSOR_CPU_CONTEXT_H
 
+#include <algorithm> // max
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> // aligned_alloc, free
+#include <cstring> // memset, memcpy
+#include <new>     // bad_alloc
+#include <omp.h>
+
 #include "context.h"
 
-class CPUContext : public Context {};
+/**
+ * Alignment in bytes of the data of `Array`s allocated by FreeTensor
+ *
+ * The `run` entry of a CPU kernel assumes every tensor parameter is aligned to
+ * it. The Driver checks the parameters before each call, and calls
+ * `run_unaligned` instead if any of them, e.g. borrowed from a user object, is
+ * not aligned
+ */
+constexpr size_t CPU_PARAM_ALIGNMENT = 64;
+
+/**
+ * Allocator for heap-allocated variables and returned tensors in CPU kernels
+ *
+ * It is implemented in FreeTensor's library and passed to kernels through
+ * `CPUContext`, so memory allocated in a kernel can be freed by FreeTensor
+ * after the kernel is unloaded, and vice versa
+ */
+class CPUAllocator {
+  public:
+    virtual ~CPUAllocator() {}
+
+    /**
+     * Allocate a 64-byte-aligned block of at least `size` bytes
+     */
+    virtual void *alloc(size_t size) = 0;
+
+    /**
+     * Free a block from `alloc`. Nothing is done for a null pointer
+     */
+    virtual void free(void *ptr) = 0;
+};
+
+class CPUContext : public Context {
+    CPUAllocator *allocator_;
+    uint8_t *stack_ = nullptr;
+    size_t stackSize_ = 0;
+    int numThreads_ = 0;
+    uint64_t *profile_ = nullptr;
+    size_t profileStmts_ = 0, profileThreads_ = 0, profileStride_ = 0;
+
+  public:
+    CPUContext(CPUAllocator *allocator) : allocator_(allocator) {}
+    ~CPUContext() {
+        std::free(stack_);
+        std::free(profile_);
+    }
+
+    CPUContext(const CPUContext &) = delete;
+    CPUContext &operator=(const CPUContext &) = delete;
+
+    /**
+     * Number of OpenMP threads used by parallel loops in the kernel. 0 means
+     * the default of OpenMP
+     *
+     * Set by the `Driver` before each call
+     * @{
+     */
+    int numThreads() const {
+        return numThreads_ > 0 ? numThreads_ : omp_get_max_threads();
+    }
+    void setNumThreads(int numThreads) { numThreads_ = numThreads; }
+    /** @} */
+
+    void *alloc(size_t size) { return allocator_->alloc(size); }
+    void free(void *ptr) { allocator_->free(ptr); }
+
+    /**
+     * Get a 64-byte-aligned buffer of at least `size` bytes, as the stack of
+     * a kernel
+     *
+     * The buffer is reused across calls, and is only reallocated when a larger
+     * one is requested, e.g. when running with more threads. Contents are not
+     * preserved across calls
+     */
+    uint8_t *stack(size_t size) {
+        if (size > stackSize_) {
+            reserveStack(size);
+        }
+        return stack_;
+    }
+
+    /**
+     * Allocate the stack buffer of at least `size` bytes in advance, and touch
+     * every page of it, so the first call will not pay for the page faults
+     */
+    void reserveStack(size_t size) {
+        if (size <= stackSize_) {
+            return;
+        }
+        size = (size + 63) / 64 * 64; // Required by aligned_alloc
+        auto ptr = (uint8_t *)std::aligned_alloc(64, size);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::memset(ptr, 0, size);
+        std::free(stack_);
+        stack_ = ptr;
+        stackSize_ = size;
+    }
+
+    /**
+     * Profiling counters of statements instrumented by codegen
+     *
+     * There are a total time in ns and an execution count for each statement
+     * and each thread. Counters of different threads are in different cache
+     * lines. They are accumulated across calls until `resetProfile`
+     * @{
+     */
+    static uint64_t profileClock() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * Allocate counters for `numStmts` statements and `numThreads()` threads.
+     * Existing counters are kept
+     */
+    void reserveProfile(size_t numStmts) {
+        size_t threads = numThreads();
+        if (numStmts == profileStmts_ && threads <= profileThreads_) {
+            return;
+        }
+        size_t stride = (numStmts * 2 + 7) / 8 * 8; // Multiple of 64 bytes
+        size_t bytes = std::max<size_t>(threads * stride * 8, 64);
+        auto ptr = (uint64_t *)std::aligned_alloc(64, bytes);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::memset(ptr, 0, bytes);
+        if (numStmts == profileStmts_) {
+            for (size_t i = 0; i < profileThreads_; i++) {
+                std::memcpy(ptr + i * stride, profile_ + i * profileStride_,
+                            numStmts * 2 * 8);
+            }
+        }
+        std::free(profile_);
+        profile_ = ptr;
+        profileStmts_ = numStmts;
+        profileThreads_ = threads;
+        profileStride_ = stride;
+    }
+
+    void profileAdd(size_t stmt, uint64_t ns) {
+        auto counter = profile_ + omp_get_thread_num() * profileStride_ +
+                       stmt * 2;
+        counter[0] += ns;
+        counter[1]++;
+    }
+
+    size_t profileThreads() const { return profileThreads_; }
+    const uint64_t *profile(size_t thread) const {
+        return profile_ + thread * profileStride_;
+    }
+
+    void resetProfile() {
+        if (profile_ != nullptr) {
+            std::memset(profile_, 0, profileThreads_ * profileStride_ * 8);
+        }
+    }
+    /** @} */
+};
 
 extern "C" typedef CPUContext *CPUContext_t;
 
@@ -0,0 +1,280 @@
+#ifndef FREE_TENSOR_CPU_GEMM_H
+#define FREE_TENSOR_CPU_GEMM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include <omp.h>
+
+#include "cpu_simd.h"
+
+/**
+ * Built-in GEMM, used for `MatMul` when FreeTensor is built without a BLAS
+ * library
+ *
+ * The algorithm follows GotoBLAS / BLIS. For each `KC`-deep slice of the
+ * reduction dimension, a `KC x NC` block of B is packed into panels of `NR`
+ * columns, shared by all threads, and each thread packs an `MC x KC` block of
+ * A into panels of `MR` rows, which stays in its L2 cache. A register-blocked
+ * micro-kernel then computes each `MR x NR` tile of C from a pair of panels,
+ * streaming the packed data contiguously. Tiles on the edges are handled by
+ * zero-padding the panels
+ *
+ * The micro-kernel keeps `MR x 2` vectors of accumulators in registers. Its
+ * shape is chosen at compile time from the element type and the vector width
+ * of the target, so that the accumulators, two vectors of B and a broadcast
+ * element of A fit in the vector registers
+ */
+
+#if defined(__AVX512F__)
+#define FT_GEMM_VEC_BYTES 64
+#elif defined(__AVX__)
+#define FT_GEMM_VEC_BYTES 32
+#else
+#define FT_GEMM_VEC_BYTES 16
+#endif
+
+template <class T> struct GemmShape {
+    static constexpr int LANES = FT_GEMM_VEC_BYTES / sizeof(T);
+    static constexpr int MR = FT_GEMM_VEC_BYTES >= 64 ? 14 : 6;
+    static constexpr int NR = 2 * LANES;
+    static constexpr int KC = 256;     // A micro-panel of B fits in L1
+    static constexpr int MC = MR * 16; // A block of A fits in L2
+    static constexpr int NC = NR * 128;
+};
+
+/**
+ * Thread-local 64-byte-aligned scratch buffers, reused across calls
+ */
+inline void *gemm_buffer(int which, size_t bytes) {
+    struct Buffer {
+        void *ptr = nullptr;
+        size_t bytes = 0;
+        ~Buffer() { std::free(ptr); }
+    };
+    static thread_local Buffer buffers[2];
+    auto &buf = buffers[which];
+    if (buf.bytes < bytes) {
+        std::free(buf.ptr);
+        buf.bytes = (bytes + 63) / 64 * 64;
+        buf.ptr = std::aligned_alloc(64, buf.bytes);
+    }
+    return buf.ptr;
+}
+
+/**
+ * Pack an `mc x kc` block of A, whose element `(i, p)` is at
+ * `a[i * rs + p * cs]`, into panels of `MR` rows
+ */
+template <class T>
+void gemm_pack_a(int mc, int kc, const T *a, int64_t rs, int64_t cs, T *pa) {
+    constexpr int MR = GemmShape<T>::MR;
+    for (int ir = 0; ir < mc; ir += MR) {
+        int mr = std::min(MR, mc - ir);
+        for (int p = 0; p < kc; p++) {
+            for (int i = 0; i < MR; i++) {
+                *pa++ = i < mr ? a[(ir + i) * rs + p * cs] : T(0);
+            }
+        }
+    }
+}
+
+/**
+ * Pack a `kc x nr` panel of B, whose element `(p, j)` is at
+ * `b[p * rs + j * cs]`, into `NR` columns
+ */
+template <class T>
+void gemm_pack_b(int nr, int kc, const T *b, int64_t rs, int64_t cs, T *pb) {
+    constexpr int NR = GemmShape<T>::NR;
+    for (int p = 0; p < kc; p++) {
+        for (int j = 0; j < NR; j++) {
+            *pb++ = j < nr ? b[p * rs + j * cs] : T(0);
+        }
+    }
+}
+
+/**
+ * C[:mr, :nr] = alpha * A_panel * B_panel + beta * C[:mr, :nr]
+ *
+ * C is not read if `readC` is false
+ */
+template <class T>
+void gemm_micro_kernel(int kc, const T *__restrict__ pa,
+                       const T *__restrict__ pb, T *__restrict__ c, int ldc,
+                       int mr, int nr, T alpha, T beta, bool readC) {
+    constexpr int L = GemmShape<T>::LANES;
+    constexpr int MR = GemmShape<T>::MR;
+    constexpr int NR = GemmShape<T>::NR;
+    typedef simd_t<T, L> V;
+
+    V acc[MR][2];
+#pragma GCC unroll 16
+    for (int i = 0; i < MR; i++) {
+        acc[i][0] = acc[i][1] = V{};
+    }
+    for (int p = 0; p < kc; p++, pa += MR, pb += NR) {
+        V b0 = simd_load_aligned<T, L>(pb);
+        V b1 = simd_load_aligned<T, L>(pb + L);
+#pragma GCC unroll 16
+        for (int i = 0; i < MR; i++) {
+            V a = simd_broadcast<T, L>(pa[i]);
+            acc[i][0] += a * b0;
+            acc[i][1] += a * b1;
+        }
+    }
+
+    V va = simd_broadcast<T, L>(alpha), vb = simd_broadcast<T, L>(beta);
+    if (mr == MR && nr == NR) {
+#pragma GCC unroll 16
+        for (int i = 0; i < MR; i++) {
+            for (int h = 0; h < 2; h++) {
+                T *p = c + (int64_t)i * ldc + h * L;
+                V r = va * acc[i][h];
+                if (readC) {
+                    r += vb * simd_load<T, L>(p);
+                }
+                simd_store<T, L>(p, r);
+            }
+        }
+    } else {
+        alignas(64) T tmp[MR][NR];
+        for (int i = 0; i < MR; i++) {
+            simd_store_aligned<T, L>(&tmp[i][0], acc[i][0]);
+            simd_store_aligned<T, L>(&tmp[i][L], acc[i][1]);
+        }
+        for (int i = 0; i < mr; i++) {
+            for (int j = 0; j < nr; j++) {
+                T &r = c[(int64_t)i * ldc + j];
+                r = readC ? alpha * tmp[i][j] + beta * r : alpha * tmp[i][j];
+            }
+        }
+    }
+}
+
+/**
+ * One GEMM computed by a team of `nThreads` threads, which are all calling
+ * this function with their own `tid`. `pb` is the buffer for packed B, shared
+ * by the team
+ */
+template <class T>
+void gemm_one(int m, int n, int k, T alpha, const T *a, int64_t rsA,
+              int64_t csA, const T *b, int64_t rsB, int64_t csB, T beta, T *c,
+              int ldc, T *pb, int tid, int nThreads) {
+    typedef GemmShape<T> S;
+    auto ceilDiv = [](int x, int y) { return (x + y - 1) / y; };
+
+    T *pa = (T *)gemm_buffer(0, sizeof(T) * S::MC * S::KC);
+
+    // Split M into at least `nThreads` blocks if possible, and then split N
+    // if there are still idle threads
+    int mcEff = std::min(S::MC, ceilDiv(ceilDiv(m, nThreads), S::MR) * S::MR);
+    int icBlocks = ceilDiv(m, mcEff);
+
+    for (int jc = 0; jc < n; jc += S::NC) {
+        int nc = std::min(S::NC, n - jc);
+        int jPanels = ceilDiv(nc, S::NR);
+        int jGroups = std::clamp(nThreads / icBlocks, 1, jPanels);
+        int panelsPerGroup = ceilDiv(jPanels, jGroups);
+        int items = icBlocks * jGroups;
+
+        for (int pc = 0; pc < k; pc += S::KC) {
+            int kc = std::min(S::KC, k - pc);
+            bool first = pc == 0;
+
+            for (int jp = tid; jp < jPanels; jp += nThreads) {
+                int jr = jp * S::NR;
+                gemm_pack_b(std::min(S::NR, nc - jr), kc,
+                            b + pc * rsB + (jc + jr) * csB, rsB, csB,
+                            pb + (int64_t)jp * S::NR * kc);
+            }
+            if (nThreads > 1) {
+#pragma omp barrier
+            }
+
+            int itemBegin = (int64_t)items * tid / nThreads;
+            int itemEnd = (int64_t)items * (tid + 1) / nThreads;
+            for (int item = itemBegin; item < itemEnd; item++) {
+                int ic = item / jGroups * mcEff, jg = item % jGroups;
+                int mc = std::min(mcEff, m - ic);
+                gemm_pack_a(mc, kc, a + ic * rsA + pc * csA, rsA, csA, pa);
+                int jpEnd = std::min(jPanels, (jg + 1) * panelsPerGroup);
+                for (int jp = jg * panelsPerGroup; jp < jpEnd; jp++) {
+                    int jr = jp * S::NR;
+                    for (int ir = 0; ir < mc; ir += S::MR) {
+                        gemm_micro_kernel(
+                            kc, pa + ir * kc, pb + (int64_t)jp * S::NR * kc,
+                            c + (int64_t)(ic + ir) * ldc + jc + jr, ldc,
+                            std::min(S::MR, mc - ir), std::min(S::NR, nc - jr),
+                            alpha, first ? beta : T(1), !first || beta != T(0));
+                    }
+                }
+            }
+            if (nThreads > 1) {
+#pragma omp barrier
+            }
+        }
+    }
+}
+
+/**
+ * Strided-batched GEMM on row-major matrices, with the same interface as
+ * `cblas_?gemm_batch_strided` of MKL with `CblasRowMajor`
+ *
+ * Batches are distributed to threads if there are enough of them, or each
+ * GEMM is computed by all threads otherwise. Only one thread is used inside
+ * an OpenMP parallel region, or if the problem is too small to benefit from
+ * threads
+ */
+template <class T>
+void runtime_gemm_batch_strided(bool transA, bool transB, int m, int n, int k,
+                                T alpha, const T *a, int lda, int64_t strideA,
+                                const T *b, int ldb, int64_t strideB, T beta,
+                                T *c, int ldc, int64_t strideC, int batchSize,
+                                int numThreads) {
+    if (m <= 0 || n <= 0 || batchSize <= 0) {
+        return;
+    }
+    if (k <= 0 || alpha == T(0)) {
+        for (int bt = 0; bt < batchSize; bt++) {
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) {
+                    T &r = c[bt * strideC + (int64_t)i * ldc + j];
+                    r = beta == T(0) ? T(0) : beta * r;
+                }
+            }
+        }
+        return;
+    }
+
+    typedef GemmShape<T> S;
+    int64_t rsA = transA ? 1 : lda, csA = transA ? lda : 1;
+    int64_t rsB = transB ? 1 : ldb, csB = transB ? ldb : 1;
+    size_t pbBytes = sizeof(T) * S::KC * S::NC;
+
+    int64_t flops = 2 * (int64_t)m * n * k * batchSize;
+    int nThreads = omp_in_parallel() ? 1 : std::max(numThreads, 1);
+    nThreads = std::clamp<int64_t>(flops >> 20, 1, nThreads);
+
+    if (batchSize >= nThreads && nThreads > 1) {
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+        for (int bt = 0; bt < batchSize; bt++) {
+            gemm_one(m, n, k, alpha, a + bt * strideA, rsA, csA,
+                     b + bt * strideB, rsB, csB, beta, c + bt * strideC, ldc,
+                     (T *)gemm_buffer(1, pbBytes), 0, 1);
+        }
+    } else {
+        T *pb = (T *)gemm_buffer(1, pbBytes);
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+        {
+            int tid = omp_get_thread_num(), team = omp_get_num_threads();
+            for (int bt = 0; bt < batchSize; bt++) {
+                gemm_one(m, n, k, alpha, a + bt * strideA, rsA, csA,
+                         b + bt * strideB, rsB, csB, beta, c + bt * strideC,
+                         ldc, pb, tid, team);
+            }
+        }
+    }
+}
+
+#endif // FREE_TENSOR_CPU_GEMM_H
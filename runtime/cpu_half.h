@@ -0,0 +1,128 @@
+#ifndef FREE_TENSOR_CPU_HALF_H
+#define FREE_TENSOR_CPU_HALF_H
+
+#include <cstdint>
+#include <cstring> // memcpy
+#include <type_traits>
+
+/**
+ * 16-bit floating-point types for storage: `float16_t` (IEEE 754 binary16) and
+ * `bfloat16_t` (the upper half of a float32)
+ *
+ * They are the compiler's native types (`_Float16` and `__bf16`) if supported.
+ * Otherwise, they are implemented in software, which only converts from and
+ * to `float`, and computes in `float`
+ */
+
+inline float runtime_float_from_bits(uint32_t bits) {
+    float ret;
+    memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+}
+
+inline uint32_t runtime_float_to_bits(float x) {
+    uint32_t ret;
+    memcpy(&ret, &x, sizeof(ret));
+    return ret;
+}
+
+/**
+ * A software 16-bit floating-point type, whose conversions from and to `float`
+ * are defined by `Codec`
+ */
+template <class Codec> struct SoftFloat16 {
+    uint16_t bits_;
+
+    SoftFloat16() = default;
+    template <class T>
+    requires std::is_arithmetic_v<T> SoftFloat16(T x)
+        : bits_(Codec::encode((float)x)) {}
+
+    operator float() const { return Codec::decode(bits_); }
+
+    template <class T> SoftFloat16 &operator+=(T y) {
+        return *this = float(*this) + y;
+    }
+    template <class T> SoftFloat16 &operator-=(T y) {
+        return *this = float(*this) - y;
+    }
+    template <class T> SoftFloat16 &operator*=(T y) {
+        return *this = float(*this) * y;
+    }
+    template <class T> SoftFloat16 &operator/=(T y) {
+        return *this = float(*this) / y;
+    }
+    SoftFloat16 operator-() const { return -float(*this); }
+};
+
+/**
+ * binary16 <-> float, rounding to nearest even
+ */
+struct Float16Codec {
+    static uint16_t encode(float x) {
+        uint32_t u = runtime_float_to_bits(x);
+        uint32_t sign = (u >> 16) & 0x8000;
+        uint32_t abs = u & 0x7fffffff;
+        if (abs >= 0x7f800000) { // Inf or NaN
+            return sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0);
+        }
+        if (abs >= 0x477ff000) { // Rounds to >= 65520, overflow
+            return sign | 0x7c00;
+        }
+        if (abs < 0x38800000) { // Subnormal in binary16
+            // Let the FPU round: adding 0.5 aligns the mantissa so that the
+            // low bits are the binary16 subnormal
+            float f = runtime_float_from_bits(abs) + 0.5f;
+            return sign | (runtime_float_to_bits(f) - 0x3f000000);
+        }
+        uint32_t odd = (abs >> 13) & 1;
+        abs += 0xc8000fff + odd; // Rebias exponent, and round
+        return sign | (abs >> 13);
+    }
+
+    static float decode(uint16_t h) {
+        uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+        uint32_t abs = h & 0x7fff;
+        if (abs >= 0x7c00) { // Inf or NaN
+            return runtime_float_from_bits(sign | 0x7f800000 |
+                                           ((abs & 0x3ff) << 13));
+        }
+        if (abs < 0x400) { // Subnormal or zero
+            float f = runtime_float_from_bits(0x3f000000 | abs) - 0.5f;
+            return runtime_float_from_bits(sign | runtime_float_to_bits(f));
+        }
+        return runtime_float_from_bits(sign | ((abs << 13) + 0x38000000));
+    }
+};
+
+/**
+ * bfloat16 <-> float, rounding to nearest even
+ */
+struct BFloat16Codec {
+    static uint16_t encode(float x) {
+        uint32_t u = runtime_float_to_bits(x);
+        if ((u & 0x7fffffff) > 0x7f800000) { // NaN, keep it quiet
+            return (u >> 16) | 0x40;
+        }
+        u += 0x7fff + ((u >> 16) & 1);
+        return u >> 16;
+    }
+
+    static float decode(uint16_t h) {
+        return runtime_float_from_bits((uint32_t)h << 16);
+    }
+};
+
+#ifdef __FLT16_MANT_DIG__
+typedef _Float16 float16_t;
+#else
+typedef SoftFloat16<Float16Codec> float16_t;
+#endif
+
+#ifdef __BFLT16_MANT_DIG__
+typedef __bf16 bfloat16_t;
+#else
+typedef SoftFloat16<BFloat16Codec> bfloat16_t;
+#endif
+
+#endif // FREE_TENSOR_CPU_HALF_H
@@ -0,0 +1,252 @@
+#ifndef FREE_TENSOR_CPU_PACKED_BOOL_H
+#define FREE_TENSOR_CPU_PACKED_BOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "cpu_simd.h"
+#include "mdspan.h"
+
+/**
+ * Tensors of `packed_bool` store element `i` of the flattened (row-major)
+ * tensor as bit `i % 64` of the `i / 64`-th 64-bit word
+ *
+ * They are accessed via `mdspan_packed`, whose references are proxies of a
+ * single bit. Reading a proxy extracts the bit, and writing to it updates the
+ * bit in its word without branches. The `atomic_*` members update the bit
+ * atomically, which is required when other threads may write other bits of the
+ * same word
+ */
+
+/**
+ * Element type of `mdspan_packed`. It is only a tag: elements are always read
+ * as `bool`
+ */
+struct packed_bool {};
+
+inline size_t runtime_packed_bool_bytes(size_t n) { return (n + 63) / 64 * 8; }
+
+/**
+ * Reference to one bit. `Word` is `uint64_t`, or `const uint64_t` for read-only
+ * tensors
+ */
+template <class Word> class packed_bool_ref {
+    Word *word_;
+    int bit_;
+
+  public:
+    packed_bool_ref(Word *word, int bit) : word_(word), bit_(bit) {}
+
+    Word *word() const { return word_; }
+    int bit() const { return bit_; }
+
+    operator bool() const { return (*word_ >> bit_) & 1; }
+
+    const packed_bool_ref &operator=(bool x) const
+        requires(!std::is_const_v<Word>) {
+        *word_ = (*word_ & ~((uint64_t)1 << bit_)) | ((uint64_t)x << bit_);
+        return *this;
+    }
+    const packed_bool_ref &operator=(const packed_bool_ref &other) const
+        requires(!std::is_const_v<Word>) {
+        return *this = (bool)other;
+    }
+    const packed_bool_ref &operator&=(bool x) const
+        requires(!std::is_const_v<Word>) {
+        *word_ &= ~((uint64_t)!x << bit_);
+        return *this;
+    }
+    const packed_bool_ref &operator|=(bool x) const
+        requires(!std::is_const_v<Word>) {
+        *word_ |= (uint64_t)x << bit_;
+        return *this;
+    }
+
+    void atomic_store(bool x) const requires(!std::is_const_v<Word>) {
+        if (x) {
+            __atomic_fetch_or(word_, (uint64_t)1 << bit_, __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_and(word_, ~((uint64_t)1 << bit_),
+                               __ATOMIC_RELAXED);
+        }
+    }
+    void atomic_and(bool x) const requires(!std::is_const_v<Word>) {
+        if (!x) {
+            __atomic_fetch_and(word_, ~((uint64_t)1 << bit_),
+                               __ATOMIC_RELAXED);
+        }
+    }
+    void atomic_or(bool x) const requires(!std::is_const_v<Word>) {
+        if (x) {
+            __atomic_fetch_or(word_, (uint64_t)1 << bit_, __ATOMIC_RELAXED);
+        }
+    }
+};
+
+template <class ElementType> struct packed_bool_accessor {
+    using word_type = std::conditional_t<std::is_const_v<ElementType>,
+                                         const uint64_t, uint64_t>;
+    using offset_policy = packed_bool_accessor;
+    using element_type = ElementType;
+    using reference = packed_bool_ref<word_type>;
+    using data_handle_type = word_type *;
+
+    FUNC_ATTR constexpr packed_bool_accessor() noexcept = default;
+
+    template <class OtherElementType>
+    requires(std::is_convertible_v<OtherElementType (*)[], element_type (*)[]>)
+        FUNC_ATTR constexpr packed_bool_accessor(
+            packed_bool_accessor<OtherElementType>) noexcept {}
+
+    FUNC_ATTR constexpr reference access(data_handle_type p,
+                                         size_t i) const noexcept {
+        return reference(p + i / 64, i % 64);
+    }
+
+    // Only valid if `i` is a multiple of 64
+    FUNC_ATTR constexpr data_handle_type offset(data_handle_type p,
+                                                size_t i) const noexcept {
+        return p + i / 64;
+    }
+};
+
+template <class ElementType, class Extents>
+using mdspan_packed = stdex::mdspan<ElementType, Extents, stdex::layout_right,
+                                    packed_bool_accessor<ElementType>>;
+
+/**
+ * Read or write `n <= 64` contiguous bits starting at a bit. Bits beyond `n`
+ * are neither accessed in memory, nor returned
+ * @{
+ */
+template <class Word>
+uint64_t runtime_packed_bool_get_bits(const packed_bool_ref<Word> &r, int n) {
+    auto p = r.word();
+    int bit = r.bit();
+    uint64_t ret = p[0] >> bit;
+    if (bit + n > 64) {
+        ret |= p[1] << (64 - bit);
+    }
+    return n < 64 ? ret & (((uint64_t)1 << n) - 1) : ret;
+}
+
+template <bool ATOMIC>
+void runtime_packed_bool_put_word(uint64_t *p, uint64_t bits, uint64_t mask) {
+    if (mask == ~(uint64_t)0) {
+        *p = bits;
+    } else if constexpr (ATOMIC) {
+        if (auto clr = mask & ~bits) {
+            __atomic_fetch_and(p, ~clr, __ATOMIC_RELAXED);
+        }
+        if (auto set = mask & bits) {
+            __atomic_fetch_or(p, set, __ATOMIC_RELAXED);
+        }
+    } else {
+        *p = (*p & ~mask) | (bits & mask);
+    }
+}
+
+/**
+ * @param ATOMIC : Update partially written words atomically. Words fully
+ * written are owned by the caller, and are stored directly
+ */
+template <bool ATOMIC>
+void runtime_packed_bool_set_bits(const packed_bool_ref<uint64_t> &r, int n,
+                                  uint64_t bits) {
+    auto p = r.word();
+    int bit = r.bit();
+    uint64_t mask = n < 64 ? ((uint64_t)1 << n) - 1 : ~(uint64_t)0;
+    bits &= mask;
+    runtime_packed_bool_put_word<ATOMIC>(p, bits << bit, mask << bit);
+    if (bit + n > 64) {
+        runtime_packed_bool_put_word<ATOMIC>(p + 1, bits >> (64 - bit),
+                                             mask >> (64 - bit));
+    }
+}
+/** @} */
+
+/**
+ * Bits <-> SIMD masks, where lane `l` corresponds to bit `l`
+ * @{
+ */
+template <int W> simd_mask_t<W> simd_mask_from_bits(uint64_t bits) {
+    auto lanes = simd_broadcast<uint64_t, W>(bits) >> simd_iota<uint64_t, W>(0);
+    return simd_mask<W>((lanes & 1) != 0);
+}
+
+template <int W> uint64_t simd_mask_to_bits(simd_mask_t<W> mask) {
+    uint64_t ret = 0;
+    for (int l = 0; l < W; l++) {
+        ret |= (uint64_t)(mask[l] & 1) << l;
+    }
+    return ret;
+}
+/** @} */
+
+/**
+ * Load `W` contiguous elements of a `packed_bool` tensor as a mask
+ *
+ * `simd_packed_load_partial` loads only the first `n` lanes.
+ * `simd_packed_load_masked` loads only the active lanes. Other lanes are false
+ * @{
+ */
+template <int W, class Word>
+simd_mask_t<W> simd_packed_load(const packed_bool_ref<Word> &r) {
+    return simd_mask_from_bits<W>(runtime_packed_bool_get_bits(r, W));
+}
+template <int W, class Word>
+simd_mask_t<W> simd_packed_load_partial(const packed_bool_ref<Word> &r,
+                                        int n) {
+    return simd_mask_from_bits<W>(runtime_packed_bool_get_bits(r, n));
+}
+template <int W, class Word>
+simd_mask_t<W> simd_packed_load_masked(const packed_bool_ref<Word> &r,
+                                       simd_mask_t<W> mask) {
+    uint64_t bits = 0;
+    for (int l = 0; l < W; l++) {
+        if (mask[l]) {
+            int i = r.bit() + l;
+            bits |= ((r.word()[i / 64] >> (i % 64)) & 1) << l;
+        }
+    }
+    return simd_mask_from_bits<W>(bits);
+}
+/** @} */
+
+/**
+ * Store a mask to `W` contiguous elements of a `packed_bool` tensor
+ *
+ * `simd_packed_store_partial` stores only the first `n` lanes.
+ * `simd_packed_store_masked` stores only the active lanes
+ *
+ * @param ATOMIC : Update words shared with other threads atomically
+ * @{
+ */
+template <int W, bool ATOMIC = false>
+void simd_packed_store(const packed_bool_ref<uint64_t> &r, simd_mask_t<W> v) {
+    runtime_packed_bool_set_bits<ATOMIC>(r, W, simd_mask_to_bits<W>(v));
+}
+template <int W, bool ATOMIC = false>
+void simd_packed_store_partial(const packed_bool_ref<uint64_t> &r,
+                               simd_mask_t<W> v, int n) {
+    runtime_packed_bool_set_bits<ATOMIC>(r, n, simd_mask_to_bits<W>(v));
+}
+template <int W, bool ATOMIC = false>
+void simd_packed_store_masked(const packed_bool_ref<uint64_t> &r,
+                              simd_mask_t<W> v, simd_mask_t<W> mask) {
+    for (int l = 0; l < W; l++) {
+        if (mask[l]) {
+            int i = r.bit() + l;
+            packed_bool_ref<uint64_t> lane(r.word() + i / 64, i % 64);
+            if constexpr (ATOMIC) {
+                lane.atomic_store(v[l]);
+            } else {
+                lane = (bool)v[l];
+            }
+        }
+    }
+}
+/** @} */
+
+#endif // FREE_TENSOR_CPU_PACKED_BOOL_H
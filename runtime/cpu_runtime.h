@@ -3,6 +3,7 @@
 
 #include <algorithm> // min, max
 #include <array>     // ByValue
+#include <atomic>    // atomic_ref
 #include <cassert>
 #include <cmath> // INFINITY, sqrt, exp
 #include <cstdint>
@@ -14,7 +15,12 @@
 #include <mkl.h>
 #endif
 
+#include "cpu_blas.h"
 #include "cpu_context.h"
+#include "cpu_gemm.h"
+#include "cpu_half.h"
+#include "cpu_packed_bool.h"
+#include "cpu_simd.h"
 #include "mdspan.h"
 #include "unchecked_opt.h"
 
@@ -43,6 +49,57 @@ requires std::integral<T> T runtime_mod(T a, T b) {
 
 template <class T> T runtime_square(T x) { return x * x; }
 
+/**
+ * Tell the compiler that a tensor parameter is aligned to
+ * `CPU_PARAM_ALIGNMENT`, if `ALIGNED`
+ */
+template <bool ALIGNED> void *runtime_assume_aligned(void *p) {
+    if constexpr (ALIGNED) {
+        return __builtin_assume_aligned(p, CPU_PARAM_ALIGNMENT);
+    } else {
+        return p;
+    }
+}
+
 template <class T> T runtime_sigmoid(T x) { return 1.0 / (1.0 + std::exp(-x)); }
 
+/**
+ * Atomic min and max, by compare-and-swap loops, because OpenMP supports them
+ * only for Fortran. Consistent with `std::min` and `std::max`, a NaN `y` does
+ * not modify `x`
+ * @{
+ */
+template <class T, class U> void runtime_atomic_min(T &x, U _y) {
+    T y = _y;
+    std::atomic_ref<T> ref(x);
+    T old = ref.load(std::memory_order_relaxed);
+    while (y < old &&
+           !ref.compare_exchange_weak(old, y, std::memory_order_relaxed)) {
+    }
+}
+template <class T, class U> void runtime_atomic_max(T &x, U _y) {
+    T y = _y;
+    std::atomic_ref<T> ref(x);
+    T old = ref.load(std::memory_order_relaxed);
+    while (old < y &&
+           !ref.compare_exchange_weak(old, y, std::memory_order_relaxed)) {
+    }
+}
+/** @} */
+
+/**
+ * Atomically `x = T(f(A(x), A(y)))`, where `T` is the type of `x` and `A` is
+ * its accumulation type. Used for reduced-precision types, which have no native
+ * atomic operations
+ */
+template <class A, class T, class U, class F>
+void runtime_atomic_update(T &x, U _y, F f) {
+    A y = _y;
+    std::atomic_ref<T> ref(x);
+    T old = ref.load(std::memory_order_relaxed);
+    while (!ref.compare_exchange_weak(old, T(f(A(old), y)),
+                                      std::memory_order_relaxed)) {
+    }
+}
+
 #endif // FREE_TENSOR_CPU_RUNTIME_H
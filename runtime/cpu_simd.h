@@ -0,0 +1,343 @@
+#ifndef FREE_TENSOR_CPU_SIMD_H
+#define FREE_TENSOR_CPU_SIMD_H
+
+#include <cstdint>
+#include <cstring>    // memcpy
+#include <functional> // std::modulus, used by generated code
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * SIMD helpers for loops vectorized by `cpu::lowerVector`
+ *
+ * Vectors are GCC vector extensions of `W` lanes. The backend compiler splits
+ * them if they are wider than the hardware supports. Masks are vectors of
+ * `int32_t` of the same number of lanes, where -1 means active and 0 means
+ * inactive, regardless of the element type they apply to
+ *
+ * Inactive lanes of masked loads are 0. Inactive lanes of masked stores are not
+ * written, and their addresses are never accessed
+ */
+
+// GCC ignores vector attributes applied to a dependent type in an alias
+// template, so wrap it in a class template
+template <class T, int W> struct SimdType {
+    typedef T type __attribute__((vector_size(W * sizeof(T))));
+};
+
+template <class T, int W> using simd_t = typename SimdType<T, W>::type;
+
+template <int W> using simd_mask_t = simd_t<int32_t, W>;
+
+/**
+ * Signed integer type with the same size as T, as the lanes of a condition
+ * selecting vectors of T
+ */
+template <class T>
+using simd_cond_lane_t = std::conditional_t<
+    sizeof(T) == 8, int64_t,
+    std::conditional_t<sizeof(T) == 4, int32_t,
+                       std::conditional_t<sizeof(T) == 2, int16_t, int8_t>>>;
+
+template <class T, int W, class U> simd_t<T, W> simd_broadcast(U x) {
+    return simd_t<T, W>{} + (T)x;
+}
+
+template <class T, int W, class U> simd_t<T, W> simd_iota(U base) {
+    simd_t<T, W> ret;
+    for (int l = 0; l < W; l++) {
+        ret[l] = (T)base + l;
+    }
+    return ret;
+}
+
+template <class T, int W, class V> simd_t<T, W> simd_convert(V v) {
+    return __builtin_convertvector(v, simd_t<T, W>);
+}
+
+/**
+ * Make a mask from the result of a vector comparison
+ */
+template <int W, class V> simd_mask_t<W> simd_mask(V cmp) {
+    return __builtin_convertvector(cmp, simd_mask_t<W>);
+}
+
+template <int W> simd_mask_t<W> simd_mask_broadcast(bool x) {
+    return simd_mask_t<W>{} + (x ? -1 : 0);
+}
+
+/**
+ * Mask of the first `n` lanes
+ */
+template <int W> simd_mask_t<W> simd_prefix_mask(int n) {
+    return simd_mask<W>(simd_iota<int32_t, W>(0) < n);
+}
+
+template <class T, int W, class V> simd_mask_t<W> simd_to_mask(V v) {
+    return simd_mask<W>(v != (T)0);
+}
+
+template <class T, int W, class A, class B>
+simd_t<T, W> simd_select(simd_mask_t<W> mask, A a, B b) {
+    auto cond =
+        __builtin_convertvector(mask, simd_t<simd_cond_lane_t<T>, W>);
+    return cond ? a : b;
+}
+
+template <class T, int W> simd_t<T, W> simd_from_mask(simd_mask_t<W> mask) {
+    return simd_select<T, W>(mask, simd_broadcast<T, W>(1),
+                             simd_broadcast<T, W>(0));
+}
+
+template <class T, int W, class A, class B>
+simd_t<T, W> simd_min(A a, B b) {
+    return a < b ? a : b;
+}
+
+template <class T, int W, class A, class B>
+simd_t<T, W> simd_max(A a, B b) {
+    return a > b ? a : b;
+}
+
+/**
+ * Reduce all the lanes of a vector, for reductions accumulated in vectors
+ * @{
+ */
+template <class T, int W, class V> T simd_reduce_add(V v) {
+    T ret = v[0];
+    for (int l = 1; l < W; l++) {
+        ret += v[l];
+    }
+    return ret;
+}
+template <class T, int W, class V> T simd_reduce_mul(V v) {
+    T ret = v[0];
+    for (int l = 1; l < W; l++) {
+        ret *= v[l];
+    }
+    return ret;
+}
+template <class T, int W, class V> T simd_reduce_min(V v) {
+    T ret = v[0];
+    for (int l = 1; l < W; l++) {
+        ret = v[l] < ret ? v[l] : ret;
+    }
+    return ret;
+}
+template <class T, int W, class V> T simd_reduce_max(V v) {
+    T ret = v[0];
+    for (int l = 1; l < W; l++) {
+        ret = v[l] > ret ? v[l] : ret;
+    }
+    return ret;
+}
+/** @} */
+
+/**
+ * Apply a scalar function to each lane
+ * @{
+ */
+template <class T, int W, class V, class F> simd_t<T, W> simd_map(V v, F f) {
+    simd_t<T, W> ret;
+    for (int l = 0; l < W; l++) {
+        ret[l] = f(v[l]);
+    }
+    return ret;
+}
+template <class T, int W, class A, class B, class F>
+simd_t<T, W> simd_map2(A a, B b, F f) {
+    simd_t<T, W> ret;
+    for (int l = 0; l < W; l++) {
+        ret[l] = f(a[l], b[l]);
+    }
+    return ret;
+}
+/** @} */
+
+/**
+ * Load contiguous lanes from `p`
+ *
+ * `simd_load_aligned` requires `p` to be aligned to the size of the vector.
+ * `simd_load_aligned_if<ALIGNED, ...>` is `simd_load_aligned` if `ALIGNED`, or
+ * `simd_load` otherwise
+ * @{
+ */
+template <class T, int W> simd_t<T, W> simd_load(const T *p) {
+    simd_t<T, W> ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+template <class T, int W> simd_t<T, W> simd_load_aligned(const T *p) {
+    return *(const simd_t<T, W> *)__builtin_assume_aligned(
+        p, sizeof(simd_t<T, W>));
+}
+template <bool ALIGNED, class T, int W>
+simd_t<T, W> simd_load_aligned_if(const T *p) {
+    if constexpr (ALIGNED) {
+        return simd_load_aligned<T, W>(p);
+    } else {
+        return simd_load<T, W>(p);
+    }
+}
+template <class T, int W> simd_t<T, W> simd_load_partial(const T *p, int n) {
+    simd_t<T, W> ret{};
+    memcpy(&ret, p, n * sizeof(T));
+    return ret;
+}
+template <class T, int W>
+simd_t<T, W> simd_load_masked(const T *p, simd_mask_t<W> mask) {
+    simd_t<T, W> ret{};
+    for (int l = 0; l < W; l++) {
+        if (mask[l]) {
+            ret[l] = p[l];
+        }
+    }
+    return ret;
+}
+/** @} */
+
+/**
+ * Store contiguous lanes to `p`
+ *
+ * `simd_store_aligned` requires `p` to be aligned to the size of the vector.
+ * `simd_store_aligned_if<ALIGNED, ...>` is `simd_store_aligned` if `ALIGNED`,
+ * or `simd_store` otherwise
+ * @{
+ */
+template <class T, int W, class V> void simd_store(T *p, V v) {
+    memcpy(p, &v, sizeof(simd_t<T, W>));
+}
+template <class T, int W, class V> void simd_store_aligned(T *p, V v) {
+    *(simd_t<T, W> *)__builtin_assume_aligned(p, sizeof(simd_t<T, W>)) = v;
+}
+template <bool ALIGNED, class T, int W, class V>
+void simd_store_aligned_if(T *p, V v) {
+    if constexpr (ALIGNED) {
+        simd_store_aligned<T, W>(p, v);
+    } else {
+        simd_store<T, W>(p, v);
+    }
+}
+template <class T, int W, class V> void simd_store_partial(T *p, V v, int n) {
+    memcpy(p, &v, n * sizeof(T));
+}
+template <class T, int W, class V>
+void simd_store_masked(T *p, V v, simd_mask_t<W> mask) {
+    for (int l = 0; l < W; l++) {
+        if (mask[l]) {
+            p[l] = v[l];
+        }
+    }
+}
+/** @} */
+
+/**
+ * Store contiguous lanes to `p` with non-temporal (streaming) stores, which
+ * write to memory without reading the cache lines first. Falls back to normal
+ * stores if `p` is not aligned to 16 bytes or the ISA has no such stores
+ *
+ * Streaming stores are weakly ordered. Call `simd_stream_fence` before the
+ * data is read by another thread
+ */
+template <class T, int W, class V> void simd_store_stream(T *p, V v) {
+#if defined(__x86_64__) || defined(__i386__)
+    constexpr int bytes = W * sizeof(T);
+    auto addr = (uintptr_t)p;
+#ifdef __AVX512F__
+    if constexpr (bytes % 64 == 0) {
+        if (addr % 64 == 0) {
+            for (int i = 0; i < bytes; i += 64) {
+                __m512i x;
+                memcpy(&x, (const char *)&v + i, 64);
+                _mm512_stream_si512((__m512i *)((char *)p + i), x);
+            }
+            return;
+        }
+    }
+#endif // __AVX512F__
+#ifdef __AVX__
+    if constexpr (bytes % 32 == 0) {
+        if (addr % 32 == 0) {
+            for (int i = 0; i < bytes; i += 32) {
+                __m256i x;
+                memcpy(&x, (const char *)&v + i, 32);
+                _mm256_stream_si256((__m256i *)((char *)p + i), x);
+            }
+            return;
+        }
+    }
+#endif // __AVX__
+    if constexpr (bytes % 16 == 0) {
+        if (addr % 16 == 0) {
+            for (int i = 0; i < bytes; i += 16) {
+                __m128i x;
+                memcpy(&x, (const char *)&v + i, 16);
+                _mm_stream_si128((__m128i *)((char *)p + i), x);
+            }
+            return;
+        }
+    }
+#endif // x86
+    simd_store<T, W>(p, v);
+}
+
+/**
+ * Order streaming stores before all subsequent stores
+ */
+inline void simd_stream_fence() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_sfence();
+#else
+    __sync_synchronize();
+#endif
+}
+
+/**
+ * Load lanes from `base[offsets[l]]`
+ * @{
+ */
+template <class T, int W, class O>
+simd_t<T, W> simd_gather(const T *base, O offsets) {
+    simd_t<T, W> ret;
+    for (int l = 0; l < W; l++) {
+        ret[l] = base[offsets[l]];
+    }
+    return ret;
+}
+template <class T, int W, class O>
+simd_t<T, W> simd_gather_masked(const T *base, O offsets,
+                                simd_mask_t<W> mask) {
+    simd_t<T, W> ret{};
+    for (int l = 0; l < W; l++) {
+        if (mask[l]) {
+            ret[l] = base[offsets[l]];
+        }
+    }
+    return ret;
+}
+/** @} */
+
+/**
+ * Store lanes to `base[offsets[l]]`
+ * @{
+ */
+template <class T, int W, class O, class V>
+void simd_scatter(T *base, O offsets, V v) {
+    for (int l = 0; l < W; l++) {
+        base[offsets[l]] = v[l];
+    }
+}
+template <class T, int W, class O, class V>
+void simd_scatter_masked(T *base, O offsets, V v, simd_mask_t<W> mask) {
+    for (int l = 0; l < W; l++) {
+        if (mask[l]) {
+            base[offsets[l]] = v[l];
+        }
+    }
+}
+/** @} */
+
+#endif // FREE_TENSOR_CPU_SIMD_H
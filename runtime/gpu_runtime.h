@@ -8,6 +8,9 @@
 #include <stdexcept>
 #include <type_traits>
 
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
 #include "gpu_context.h"
 
 #include "mdspan.h"
@@ -17,6 +20,9 @@
 
 #define restrict __restrict__
 
+typedef __half float16_t;
+typedef __nv_bfloat16 bfloat16_t;
+
 #define checkCudaError(call)                                                   \
     {                                                                          \
         auto err = (call);                                                     \
@@ -88,6 +88,12 @@ void StructuralFeature::updAreaInfo(const AST &parent, const AST &child) {
     for (auto &&item : info_[child].innerAccessArea_) {
         info_[parent].innerAccessArea_[item.first] += item.second;
     }
+    for (auto &&item : info_[child].innerLoadBytes_) {
+        info_[parent].innerLoadBytes_[item.first] += item.second;
+    }
+    for (auto &&item : info_[child].innerStoreBytes_) {
+        info_[parent].innerStoreBytes_[item.first] += item.second;
+    }
 }
 
 void StructuralFeature::updInfo(const AST &parent, const AST &child,
@@ -160,6 +166,11 @@ int64_t StructuralFeature::calcArea(
     return area;
 }
 
+static int64_t bytesOf(int64_t area, DataType dtype) {
+    // The size of a custom type is unknown to us
+    return dtype == DataType::Custom ? 0 : storageBytes(dtype, area);
+}
+
 void StructuralFeature::calcAreaFeatures(const Stmt &node) {
     for (auto &&item : info_[node].innerLoadArea_) {
         features_[node->id()].loadArea_[item.first] = item.second;
@@ -170,14 +181,24 @@ void StructuralFeature::calcAreaFeatures(const Stmt &node) {
     for (auto &&item : info_[node].innerAccessArea_) {
         features_[node->id()].accessArea_[item.first] = item.second;
     }
+    for (auto &&item : info_[node].innerLoadBytes_) {
+        features_[node->id()].loadBytes_[item.first] = item.second;
+    }
+    for (auto &&item : info_[node].innerStoreBytes_) {
+        features_[node->id()].storeBytes_[item.first] = item.second;
+    }
 
     for (auto &&[var, accesses] : info_[node].loads_) {
-        features_[node->id()].loadArea_[buffer(var)->mtype()] +=
-            calcArea(var, accesses);
+        auto area = calcArea(var, accesses);
+        features_[node->id()].loadArea_[buffer(var)->mtype()] += area;
+        features_[node->id()].loadBytes_[buffer(var)->mtype()] +=
+            bytesOf(area, buffer(var)->tensor()->dtype());
     }
     for (auto &&[var, accesses] : info_[node].stores_) {
-        features_[node->id()].storeArea_[buffer(var)->mtype()] +=
-            calcArea(var, accesses);
+        auto area = calcArea(var, accesses);
+        features_[node->id()].storeArea_[buffer(var)->mtype()] += area;
+        features_[node->id()].storeBytes_[buffer(var)->mtype()] +=
+            bytesOf(area, buffer(var)->tensor()->dtype());
     }
     for (auto &&[var, accesses] : info_[node].accesses_) {
         features_[node->id()].accessArea_[buffer(var)->mtype()] +=
@@ -320,14 +341,19 @@ void StructuralFeature::visit(const VarDef &op) {
     }
     updInfo(op, op->body_);
 
+    auto dtype = op->buffer_->tensor()->dtype();
     if (info_[op].loads_.count(op->name_)) {
-        info_[op].innerLoadArea_[op->buffer_->mtype()] +=
-            calcArea(op->name_, info_[op].loads_[op->name_]);
+        auto area = calcArea(op->name_, info_[op].loads_[op->name_]);
+        info_[op].innerLoadArea_[op->buffer_->mtype()] += area;
+        info_[op].innerLoadBytes_[op->buffer_->mtype()] +=
+            bytesOf(area, dtype);
         info_[op].loads_.erase(op->name_);
     }
     if (info_[op].stores_.count(op->name_)) {
-        info_[op].innerStoreArea_[op->buffer_->mtype()] +=
-            calcArea(op->name_, info_[op].stores_[op->name_]);
+        auto area = calcArea(op->name_, info_[op].stores_[op->name_]);
+        info_[op].innerStoreArea_[op->buffer_->mtype()] += area;
+        info_[op].innerStoreBytes_[op->buffer_->mtype()] +=
+            bytesOf(area, dtype);
         info_[op].stores_.erase(op->name_);
     }
     if (info_[op].accesses_.count(op->name_)) {
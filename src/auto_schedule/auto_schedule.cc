@@ -9,6 +9,7 @@
 #include <auto_schedule/rules/multi_level_tiling.h>
 #include <auto_schedule/rules/multi_level_tiling_with_fusion.h>
 #include <auto_schedule/rules/parallelize.h>
+#include <auto_schedule/rules/prefetch.h>
 #include <auto_schedule/rules/skip.h>
 #include <auto_schedule/rules/thread_bind.h>
 #include <auto_schedule/rules/unroll.h>
@@ -40,11 +41,13 @@ AutoSchedule::AutoSchedule(
     const std::function<Predicts(const Features &)> &predictFunc,
     const std::function<void(const Features &, const Predicts &)> &updateFunc,
     std::string tag, int minBlockSize, std::optional<size_t> randomSeed,
-    const std::optional<std::unordered_set<std::string>> &ruleSet, int verbose)
+    const std::optional<std::unordered_set<std::string>> &ruleSet, int verbose,
+    bool perfCounters)
     : original_(schedule.fork()), target_(target), device_(device),
       paramsSet_(false), rng_(decideSeed(randomSeed, verbose)),
       predictFunc_(std::move(predictFunc)), updateFunc_(std::move(updateFunc)),
-      tag_(std::move(tag)), minBlockSize_(minBlockSize), verbose_(verbose) {
+      tag_(std::move(tag)), minBlockSize_(minBlockSize), verbose_(verbose),
+      perfCounters_(perfCounters) {
     flop_ = 0;
     auto opCnt =
         structuralFeature(original_.ast())[original_.ast()->id()].opCnt_;
@@ -64,6 +67,7 @@ AutoSchedule::AutoSchedule(
         ADD_RULE("multi_level_tiling", MultiLevelTilingRule, target->type());
         ADD_RULE("parallelize", ParallelizeRule);
         ADD_RULE("unroll", UnrollRule, target->type());
+        ADD_RULE("prefetch", PrefetchRule);
     } else {
         ADD_RULE("cache_write", CacheWriteRule, target->type(), verbose_);
         ADD_RULE("multi_level_tiling_with_fusion",
@@ -85,55 +89,68 @@ void AutoSchedule::setParams(
     paramsSet_ = true;
 }
 
-std::pair<std::vector<double>, std::vector<double>>
+std::vector<BenchmarkResult>
 AutoSchedule::measure(const std::vector<Ref<Sketch>> &sketches) {
-    // Compile in parallel, and measure sequentially
+    // Lower in parallel, compile in background, and measure sequentially.
+    // Measuring a Driver overlaps with compiling the following ones. The
+    // number of concurrent compilers is bounded by
+    // Config::backendCompilerJobs(), which can be lowered to reduce the noise
+    // in measurement
     // TODO: Parallel among computing nodes
 
     if (verbose_ >= 1) {
-        logger() << "Compiling code" << std::endl;
+        logger() << "Compiling and measuring code" << std::endl;
     }
     size_t n = sketches.size();
-    std::vector<Ref<Driver>> drivers(n);
+    std::vector<Func> lowereds(n);
+    std::vector<std::string> codes(n);
 #pragma omp parallel for schedule(dynamic)
     for (size_t i = 0; i < n; i++) {
         try {
-            auto lowered = sketches[i]->lowered();
-            auto code = codeGen(lowered, target_);
-            drivers[i] = Ref<Driver>::make(lowered, code, device_);
+            lowereds[i] = sketches[i]->lowered();
+            codes[i] = codeGen(lowereds[i], target_);
         } catch (const std::exception &e) {
             // OpenMP threads won't report an exception message
             std::cerr << "ERROR measure: " << e.what() << std::endl;
-            drivers[i] = nullptr;
+            lowereds[i] = nullptr;
         }
     }
-
-    if (verbose_ >= 1) {
-        logger() << "Measuring time" << std::endl;
+    std::vector<std::shared_future<Ref<Driver>>> drivers(n);
+    for (size_t i = 0; i < n; i++) {
+        if (lowereds[i].isValid()) {
+            drivers[i] = buildDriverAsync(lowereds[i], codes[i], device_);
+        }
     }
-    std::vector<double> times, stddevs;
-    times.reserve(n);
-    stddevs.reserve(n);
+
+    std::vector<BenchmarkResult> results(n);
     for (size_t i = 0; i < n; i++) {
         ASSERT(paramsSet_);
+        results[i].mean_ = INFINITY;
         try {
-            if (!drivers[i].isValid()) {
-                times.emplace_back(INFINITY);
-                stddevs.emplace_back(0);
+            if (!drivers[i].valid()) {
                 continue;
             }
-            drivers[i]->setArgs(args_, kws_);
-            auto [avg, stddev] = drivers[i]->time(100, 10);
-            times.emplace_back(avg);
-            stddevs.emplace_back(stddev);
+            auto driver = drivers[i].get(); // Rethrows compiling errors
+            drivers[i] = {};                // Unload after measured
+            driver->setArgs(args_, kws_);
+            // Stop early for a stable candidate, and don't let outliers from
+            // other processes mislead the search
+            BenchmarkOptions options;
+            options.warmups_ = 10;
+            options.minRounds_ = 10;
+            options.maxRounds_ = 100;
+            options.targetRelCI_ = 0.01;
+            options.timeBudget_ = 0;
+            options.perfCounters_ = perfCounters_;
+            results[i] = driver->benchmark(options);
+            driver->collectReturns();
         } catch (const std::exception &e) {
-            // OpenMP threads won't report an exception message
             std::cerr << "ERROR measure: " << e.what() << std::endl;
-            times.emplace_back(INFINITY);
-            stddevs.emplace_back(0);
+            results[i] = BenchmarkResult{};
+            results[i].mean_ = INFINITY;
         }
     }
-    return std::make_pair(times, stddevs);
+    return results;
 }
 
 void AutoSchedule::searchOneRound(size_t n, size_t nExploit, size_t nExplore) {
@@ -175,11 +192,18 @@ AutoSchedule::testAndAdd(const std::vector<Ref<Sketch>> &sketches) {
     auto features = genFeatures(sketches);
     size_t n = sketches.size();
     ASSERT(features.size() == n);
-    auto &&[times, stddevs] = measure(sketches);
+    auto results = measure(sketches);
+    std::vector<double> times, stddevs;
+    for (auto &&result : results) {
+        times.emplace_back(result.mean_);
+        stddevs.emplace_back(result.stddev_);
+    }
     std::vector<double> flopsList;
-    for (auto [t, stddev] : views::zip(times, stddevs)) {
-        if (t < 1e20) {
-            flopsList.emplace_back(flop_ / t);
+    lastCounters_.clear();
+    for (auto &&result : results) {
+        if (result.mean_ < 1e20) {
+            flopsList.emplace_back(flop_ / result.mean_);
+            lastCounters_.emplace_back(result.counters_);
         }
     }
     updateFunc_(features, flopsList);
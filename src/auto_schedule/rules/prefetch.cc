@@ -0,0 +1,109 @@
+#include <auto_schedule/rules/parallelize.h>
+#include <auto_schedule/rules/prefetch.h>
+#include <auto_schedule/utils.h>
+#include <visitor.h>
+
+namespace freetensor {
+
+static std::vector<int> prefetchDistances = {0, 4, 8, 16, 32, 64};
+
+namespace {
+
+/**
+ * Variables read with indices loaded from memory
+ */
+class FindIndirectReads : public Visitor {
+    std::vector<std::string> vars_;
+    int nLoads_ = 0;
+
+  public:
+    const std::vector<std::string> &vars() const { return vars_; }
+
+  protected:
+    void visit(const Load &op) override {
+        int before = nLoads_;
+        Visitor::visit(op);
+        if (nLoads_ > before &&
+            std::find(vars_.begin(), vars_.end(), op->var_) == vars_.end()) {
+            vars_.emplace_back(op->var_);
+        }
+        nLoads_++;
+    }
+};
+
+std::vector<std::string> indirectReads(const Stmt &op) {
+    FindIndirectReads visitor;
+    visitor(op);
+    return visitor.vars();
+}
+
+} // Anonymous namespace
+
+void PrefetchPart::apply(Schedule &schedule, SubSketch &subSketch) {
+    if (distance_ == 0) {
+        return;
+    }
+    SketchPart part = subSketch.getPart(SketchPartType::Parallelize);
+    if (!part.isValid()) {
+        return;
+    }
+    auto lastParallelizedID = part.as<ParallelizePart>()->lastParallelizedID();
+    if (!lastParallelizedID.isValid()) {
+        return;
+    }
+    auto root = schedule.find(lastParallelizedID);
+    for (auto &&loop : findAllStmt(root, "<For>")) {
+        if (!findAllStmt(loop.as<ForNode>()->body_, "<For>").empty()) {
+            continue; // Only innermost loops
+        }
+        for (auto &&var : indirectReads(loop.as<ForNode>()->body_)) {
+            try {
+                schedule.prefetch(loop->id(), var, distance_);
+            } catch (const InvalidSchedule &e) {
+                // Addresses not predictable. Leave it
+            }
+        }
+    }
+}
+
+void PrefetchPart::genRandAnnotation(RNG &gen) {
+    distance_ = prefetchDistances[randomInt(prefetchDistances.size() - 1, gen)];
+}
+
+void PrefetchPart::genFakeAnnotation(RNG &gen) { distance_ = 16; }
+
+bool PrefetchPart::mutate(RNG &gen) {
+    distance_ = prefetchDistances[randomInt(prefetchDistances.size() - 1, gen)];
+    return true;
+}
+
+bool PrefetchPart::crossover(const SketchPart &part, RNG &gen) {
+    if (auto p = part.as<PrefetchPart>(); p.isValid()) {
+        distance_ = p->distance_;
+        return true;
+    }
+    return false;
+}
+
+std::vector<Ref<Sketch>> PrefetchRule::genPart(const Sketch &sketch) {
+    auto newSketch = sketch.clone();
+    newSketch->addPart(Ref<PrefetchPart>::make());
+    newSketch->addLog("prefetch");
+    return {newSketch};
+}
+
+RuleStatus PrefetchRule::analyze(const Sketch &sketch) {
+    auto &&sub = sketch.nowSubSketch();
+    if (sub.hasPart(SketchPartType::Prefetch) ||
+        (!sub.hasPart(SketchPartType::MultiLevelTiling) &&
+         !sub.hasPart(SketchPartType::MultiLevelTilingWithFusion))) {
+        return RuleStatus::Skip;
+    }
+    auto nest = findAllStmt(sketch.schedule().ast(), sub.target.outermost);
+    if (nest.empty() || indirectReads(nest.front()).empty()) {
+        return RuleStatus::Skip;
+    }
+    return RuleStatus::ApplyAndSkipRest;
+}
+
+} // namespace freetensor
@@ -1,14 +1,25 @@
 #include <codegen/code_gen.h>
 #include <codegen/code_gen_cpu.h>
 #include <codegen/code_gen_cuda.h>
+#include <driver/target.h>
+#include <pass/cpu/lower_vector.h>
+#include <pass/use_builtin_div.h>
 
 namespace freetensor {
 
-std::string codeGen(const Func &func, const Ref<Target> &target) {
+std::string codeGen(const Func &func, const Ref<Target> &target,
+                    const Ref<Selector> &profile) {
     switch (target->type()) {
-    case TargetType::CPU:
-        return codeGenCPU(func);
+    case TargetType::CPU: {
+        auto t = target.as<CPUTarget>();
+        // After `lower`. See the comments there
+        auto lowered = useBuiltinDiv(cpu::lowerVector(func, t));
+        return codeGenCPU(lowered, profile, t->blas());
+    }
     case TargetType::GPU:
+        if (profile.isValid()) {
+            ERROR("Profiling is only supported on CPU");
+        }
         return codeGenCUDA(func);
     default:
         ERROR("Unrecognized target " + target->toString());
@@ -8,8 +8,6 @@
 
 namespace freetensor {
 
-#ifdef FT_WITH_MKL
-
 static char genMKLTypeMark(DataType dtype) {
     switch (dtype) {
     case DataType::Float64:
@@ -21,23 +19,104 @@ static char genMKLTypeMark(DataType dtype) {
     }
 }
 
-#endif
+/**
+ * The fence of streaming stores that `cpu::lowerVector` puts at the end of the
+ * body of an OpenMP loop, if any
+ */
+static Stmt streamFenceAtEnd(const Stmt &body) {
+    Stmt last = body;
+    while (last->nodeType() == ASTNodeType::StmtSeq &&
+           !last.as<StmtSeqNode>()->stmts_.empty()) {
+        last = last.as<StmtSeqNode>()->stmts_.back();
+    }
+    if (last->nodeType() == ASTNodeType::Eval) {
+        auto &&expr = last.as<EvalNode>()->expr_;
+        if (expr->nodeType() == ASTNodeType::Intrinsic &&
+            expr.as<IntrinsicNode>()->format_ == "simd_stream_fence()") {
+            return last;
+        }
+    }
+    return nullptr;
+}
 
 void CodeGenCPU::genAlloc(const Ref<Tensor> &tensor, const std::string &rawPtr,
                           const std::string &shapePtr,
                           const std::string &dimPtr) {
     auto ndim = tensor->shape().size();
     makeIndent();
-    os() << shapePtr << " = " << ndim << " > 0 ? (size_t*)malloc((" << dimPtr
-         << " = " << ndim << ") * sizeof(size_t)) : NULL;" << std::endl;
+    os() << shapePtr << " = " << ndim << " > 0 ? (size_t*)_ctx->alloc(("
+         << dimPtr << " = " << ndim << ") * sizeof(size_t)) : NULL;"
+         << std::endl;
     makeIndent();
-    os() << rawPtr << " = malloc(";
+    os() << rawPtr << " = _ctx->alloc(";
+    if (tensor->dtype() == DataType::PackedBool) {
+        // Scalars are also allocated in words, to match `Array::size`
+        os() << "runtime_packed_bool_bytes(";
+    }
     for (auto &&[i, dim] : views::enumerate(tensor->shape())) {
         os() << "(" << shapePtr << "[" << i << "] = ";
         (*this)(dim);
         os() << ") * ";
     }
-    os() << "sizeof(" << gen(tensor->dtype()) << "));" << std::endl;
+    if (tensor->dtype() == DataType::PackedBool) {
+        os() << "1));" << std::endl;
+    } else {
+        os() << "sizeof(" << gen(tensor->dtype()) << "));" << std::endl;
+    }
+}
+
+void CodeGenCPU::visit(const Alloc &op) {
+    markUse(op->var_);
+    auto &&vardef = def(op->var_);
+    auto &&tensor = vardef->buffer_->tensor();
+    ASSERT(vardef->buffer_->mtype() == MemType::CPUHeap);
+
+    // e.g.
+    // x_opt = mdspan_r<int, extents<5, 5>>(_ctx->alloc(5 * 5 * sizeof(int)));
+    makeIndent();
+    os() << mangle(op->var_) << "_opt = ";
+    if (isPacked(vardef)) {
+        // e.g. x_opt = mdspan_packed<packed_bool, extents<5, 5>>(
+        //          (uint64_t*)(_ctx->alloc(runtime_packed_bool_bytes(5 * 5))));
+        genMdPtrDef(vardef, [&]() {
+            os() << "_ctx->alloc(runtime_packed_bool_bytes(";
+            for (auto &&[i, dim] : views::enumerate(tensor->shape())) {
+                os() << (i > 0 ? " * " : "");
+                (*this)(dim);
+            }
+            os() << "))";
+        });
+        os() << ";" << std::endl;
+        return;
+    }
+    genMdPtrDef(vardef, [&]() {
+        os() << "(" << gen(tensor->dtype()) << "*)_ctx->alloc(";
+        for (auto &&dim : tensor->shape()) {
+            (*this)(dim);
+            os() << " * ";
+        }
+        os() << "sizeof(" << gen(tensor->dtype()) << "))";
+    });
+    os() << ";" << std::endl;
+}
+
+void CodeGenCPU::visit(const Free &op) {
+    ASSERT(buffer(op->var_)->mtype() == MemType::CPUHeap);
+
+    // e.g. auto x_ptr = x.data_handle();
+    //      x_opt.drop();
+    //      x_opt = std::nullopt;
+    //      _ctx->free(x_ptr);
+    auto &&name = mangle(op->var_);
+    makeIndent();
+    os() << "auto " << name << "_ptr = " << name << ".data_handle();"
+         << std::endl;
+    makeIndent();
+    os() << name << "_opt.drop();" << std::endl;
+    makeIndent();
+    os() << name << "_opt = std::nullopt;" << std::endl;
+    makeIndent();
+    os() << "_ctx->free(" << name << "_ptr);" << std::endl;
 }
 
 void CodeGenCPU::genScalar(const VarDef &def,
@@ -54,10 +133,24 @@ void CodeGenCPU::genScalar(const VarDef &def,
     }
 }
 
+std::string CodeGenCPU::paramPtr(const VarDef &def, int nthParam) {
+    auto ret = CodeGenC::paramPtr(def, nthParam);
+    // Consistent with `Driver::alignedParams_`
+    if (def->buffer_->mtype() == MemType::CPU &&
+        !def->buffer_->tensor()->shape().empty()) {
+        ret = "runtime_assume_aligned<ALIGNED>(" + ret + ")";
+    }
+    return ret;
+}
+
 void CodeGenCPU::visit(const VarDef &op) {
     auto &&tensor = op->buffer_->tensor();
     auto &&shape = tensor->shape();
 
+    if (inParallel_) {
+        threadLocal_.insert(op->name_);
+    }
+
     if (op->buffer_->atype() != AccessType::Cache || op->viewOf_.has_value() ||
         shape.empty()) {
         CodeGenC::visit(op);
@@ -98,10 +191,10 @@ void CodeGenCPU::visit(const VarDef &op) {
             this->genMdPtrDef(op, rawPtr);
             this->os() << ";" << std::endl;
 
-            int64_t size = sizeOf(tensor->dtype());
+            int64_t nElem = 1;
             for (auto &&dim : shape) {
                 if (dim->nodeType() == ASTNodeType::IntConst) {
-                    size *= dim.as<IntConstNode>()->val_;
+                    nElem *= dim.as<IntConstNode>()->val_;
                 } else {
                     ERROR("BUG: Dyanmic sized variables cannot be allocated on "
                           "stack. Should be transformed to heap-allocated in "
@@ -109,6 +202,8 @@ void CodeGenCPU::visit(const VarDef &op) {
                 }
             }
 
+            int64_t size = storageBytes(tensor->dtype(), nElem);
+
             // Align to 64 bytes (TODO: look up cache line size from Target)
             size = ceilDiv<int64_t>(size, 64) * 64;
 
@@ -137,12 +232,136 @@ void CodeGenCPU::visit(const VarDef &op) {
             break;
         }
     }
+
+    threadLocal_.erase(op->name_);
+}
+
+bool CodeGenCPU::sharedPackedWords(const std::string &var) {
+    return isPacked(def(var)) && inParallel_ && !threadLocal_.count(var);
+}
+
+void CodeGenCPU::visitStmt(const Stmt &stmt) {
+    // A loop collapsed into its outer loop should directly follow the outer
+    // loop, so it is not instrumented
+    if (profile_.isValid() &&
+        !(stmt->nodeType() == ASTNodeType::For &&
+          collapsed_.count(stmt.as<ForNode>())) &&
+        profile_->match(stmt)) {
+        // e.g.
+        // { // Profiling #12
+        //   uint64_t __profBegin0 = CPUContext::profileClock();
+        //   ...
+        //   _ctx->profileAdd(0, CPUContext::profileClock() - __profBegin0);
+        // }
+        auto i = profiledIds_.size();
+        profiledIds_.emplace_back(stmt->id());
+        auto begin = "__profBegin" + std::to_string(i);
+        makeIndent();
+        os() << "{ // Profiling " << stmt->id() << std::endl;
+        nIndent()++;
+        makeIndent();
+        os() << "uint64_t " << begin << " = CPUContext::profileClock();"
+             << std::endl;
+        CodeGenC::visitStmt(stmt);
+        makeIndent();
+        os() << "_ctx->profileAdd(" << i << ", CPUContext::profileClock() - "
+             << begin << ");" << std::endl;
+        nIndent()--;
+        makeIndent();
+        os() << "}" << std::endl;
+    } else {
+        CodeGenC::visitStmt(stmt);
+    }
+}
+
+void CodeGenCPU::visit(const Store &op) {
+    if (sharedPackedWords(op->var_)) {
+        // e.g. x(i).atomic_store(y(i));
+        markUse(op->var_);
+        makeIndent();
+        genScalar(def(op->var_), op->indices_);
+        os() << ".atomic_store(";
+        (*this)(op->expr_);
+        os() << ");" << std::endl;
+        return;
+    }
+    CodeGenC::visit(op);
 }
 
 void CodeGenCPU::visit(const ReduceTo &op) {
+    if (isPacked(def(op->var_)) &&
+        (op->atomic_ || sharedPackedWords(op->var_))) {
+        // Bit-wise atomic operations on the word. On booleans, min is "and",
+        // and max is "or"
+        // e.g. x(i).atomic_or((bool)(y(i)));
+        markUse(op->var_);
+        makeIndent();
+        genScalar(def(op->var_), op->indices_);
+        switch (op->op_) {
+        case ReduceOp::LAnd:
+        case ReduceOp::Min:
+            os() << ".atomic_and((bool)(";
+            break;
+        case ReduceOp::LOr:
+        case ReduceOp::Max:
+            os() << ".atomic_or((bool)(";
+            break;
+        default:
+            throw InvalidProgram("Only logical, min or max reductions to "
+                                 "packed_bool variable " +
+                                 op->var_ + " are supported");
+        }
+        (*this)(op->expr_);
+        os() << "));" << std::endl;
+        return;
+    }
     if (op->atomic_) {
+        auto dtype = buffer(op->var_)->tensor()->dtype();
+        if (isReducedPrecision(dtype)) {
+            // `x = T(A(x) op A(y))` is not a valid form of `omp atomic`
+            auto acc = gen(accumulateType(dtype));
+            markUse(op->var_);
+            makeIndent();
+            os() << "runtime_atomic_update<" << acc << ">(";
+            genScalar(def(op->var_), op->indices_);
+            os() << ", ";
+            (*this)(op->expr_);
+            os() << ", [](" << acc << " a, " << acc << " b) { return ";
+            switch (op->op_) {
+            case ReduceOp::Add:
+                os() << "a + b";
+                break;
+            case ReduceOp::Sub:
+                os() << "a - b";
+                break;
+            case ReduceOp::Mul:
+                os() << "a * b";
+                break;
+            case ReduceOp::Min:
+                os() << "std::min(a, b)";
+                break;
+            case ReduceOp::Max:
+                os() << "std::max(a, b)";
+                break;
+            default:
+                ASSERT(false);
+            }
+            os() << "; });" << std::endl;
+            return;
+        }
+        if (op->op_ == ReduceOp::Min || op->op_ == ReduceOp::Max) {
+            // OpenMP supports atomic min and max only for FORTRAN
+            markUse(op->var_);
+            makeIndent();
+            os() << (op->op_ == ReduceOp::Min ? "runtime_atomic_min("
+                                              : "runtime_atomic_max(");
+            genScalar(def(op->var_), op->indices_);
+            os() << ", ";
+            (*this)(op->expr_);
+            os() << ");" << std::endl;
+            return;
+        }
         os() << "#pragma omp atomic" << std::endl;
-        // FIXME: OpenMP supports atomic min and max only for FORTRAN
     }
     CodeGenC::visit(op);
 }
@@ -151,6 +370,7 @@ void CodeGenCPU::visit(const For &op) {
     if (std::holds_alternative<OpenMPScope>(op->property_->parallel_) &&
         !collapsed_.count(op)) {
         int collapse = 1;
+        For innermost = op;
         for (Stmt inner = op->body_;
              inner->nodeType() == ASTNodeType::For &&
              std::holds_alternative<OpenMPScope>(
@@ -158,8 +378,14 @@ void CodeGenCPU::visit(const For &op) {
              inner = inner.as<ForNode>()->body_) {
             collapse++;
             collapsed_.insert(inner.as<ForNode>());
+            innermost = inner.as<ForNode>();
         }
 
+        // The fence only needs to run once in each thread after its
+        // iterations, before the barrier at the end of the parallel region. Use
+        // a `nowait` loop in a parallel region, and fence after the loop
+        auto fence = streamFenceAtEnd(innermost->body_);
+
         for (auto &&r : op->property_->reductions_) {
             if (!buffer(r->var_)->tensor()->shape().empty()) {
                 usedAsReduction_.insert(def(r->var_));
@@ -169,22 +395,29 @@ void CodeGenCPU::visit(const For &op) {
                      << std::endl;
             }
         }
-        os() << "#pragma omp parallel for";
+        if (fence.isValid()) {
+            os() << "#pragma omp parallel num_threads(_ctx->numThreads())"
+                 << std::endl;
+            makeIndent();
+            beginBlock();
+            os() << "#pragma omp for nowait";
+        } else {
+            os() << "#pragma omp parallel for";
+        }
         if (collapse > 1) {
             os() << " collapse(" << collapse << ")";
         }
-        if (!op->property_->reductions_.empty()) {
-            for (size_t i = 1, n = op->property_->reductions_.size(); i < n;
-                 i++) {
-                if (op->property_->reductions_[i]->op_ !=
-                    op->property_->reductions_.front()->op_) {
-                    throw InvalidProgram(
-                        "Reduction operators of each parallel reduction "
-                        "variables should be the same in a single OpenMP loop");
-                }
+        // One reduction clause for each operator
+        std::vector<ReduceOp> redOps;
+        for (auto &&r : op->property_->reductions_) {
+            if (std::find(redOps.begin(), redOps.end(), r->op_) ==
+                redOps.end()) {
+                redOps.emplace_back(r->op_);
             }
+        }
+        for (auto redOp : redOps) {
             os() << " reduction(";
-            switch (op->property_->reductions_.front()->op_) {
+            switch (redOp) {
             case ReduceOp::Add:
                 os() << "+: ";
                 break;
@@ -211,6 +444,9 @@ void CodeGenCPU::visit(const For &op) {
             }
             bool first = true;
             for (auto &&r : op->property_->reductions_) {
+                if (r->op_ != redOp) {
+                    continue;
+                }
                 if (!first) {
                     os() << ", ";
                 }
@@ -233,11 +469,22 @@ void CodeGenCPU::visit(const For &op) {
             }
             os() << ")";
         }
+        if (!fence.isValid()) {
+            os() << " num_threads(_ctx->numThreads())";
+        }
         os() << std::endl;
         bool oldInParallel = inParallel_;
+        auto oldHoistedFence = hoistedFence_;
         inParallel_ = true;
+        hoistedFence_ = fence;
         CodeGenC::visit(op);
         inParallel_ = oldInParallel;
+        hoistedFence_ = oldHoistedFence;
+        if (fence.isValid()) {
+            makeIndent();
+            os() << "simd_stream_fence();" << std::endl;
+            endBlock();
+        }
         for (auto &&r : op->property_->reductions_) {
             if (!buffer(r->var_)->tensor()->shape().empty()) {
                 usedAsReduction_.erase(def(r->var_));
@@ -252,20 +499,18 @@ void CodeGenCPU::visit(const For &op) {
     CodeGenC::visit(op);
 }
 
-void CodeGenCPU::visit(const MatMul &op) {
-#ifdef FT_WITH_MKL
-    makeIndent();
-    if (inParallel_) {
-        os() << "mkl_set_num_threads_local(1);" << std::endl;
-        // TODO: set it to max(1, cpu_count / outer_threads_count)
-    } else {
-        os() << "mkl_set_num_threads_local(0); // 0 == reset" << std::endl;
+void CodeGenCPU::visit(const Eval &op) {
+    if (op.get() == hoistedFence_.get()) {
+        return; // Emitted after the loop
     }
+    CodeGenC::visit(op);
+}
 
+void CodeGenCPU::visit(const MatMul &op) {
     auto d = op->c_->dtype();
     if (op->a_->dtype() != d || op->b_->dtype() != d) {
-        throw InvalidProgram(
-            "MKL requires all matrices have the same data type");
+        throw InvalidProgram("MatMul requires all matrices have the same data "
+                             "type");
     }
 
     bool transA = !op->aIsRowMajor_, transB = !op->bIsRowMajor_;
@@ -283,48 +528,80 @@ void CodeGenCPU::visit(const MatMul &op) {
         std::swap(n, m);
     }
 
+    auto blas = blas_;
+    switch (d) {
+    case DataType::Float64:
+    case DataType::Float32:
+        break;
+    case DataType::Int64:
+    case DataType::Int32:
+        // Not supported by BLAS libraries
+        blas = BLASProvider::Builtin;
+        break;
+    default:
+        throw InvalidProgram("MatMul of " + freetensor::toString(d) +
+                             " is not supported");
+    }
+
     makeIndent();
-    os() << "cblas_" << genMKLTypeMark(d)
-         << "gemm_batch_strided(CblasRowMajor, "
-         << (transA ? "CblasTrans" : "CblasNoTrans") << ", "
-         << (transB ? "CblasTrans" : "CblasNoTrans") << ", ";
-    (*this)(m);
-    os() << ", ";
-    (*this)(n);
-    os() << ", ";
-    (*this)(k);
-    os() << ", ";
-    (*this)(op->alpha_);
-    os() << ", &";
-    (*this)(a);
-    os() << ", ";
-    (*this)(lda);
-    os() << ", ";
-    (*this)(stridea);
-    os() << ", &";
-    (*this)(b);
-    os() << ", ";
-    (*this)(ldb);
-    os() << ", ";
-    (*this)(strideb);
-    os() << ", ";
-    (*this)(op->beta_);
-    os() << ", &";
-    (*this)(c);
-    os() << ", ";
-    (*this)(ldc);
-    os() << ", ";
-    (*this)(stridec);
-    os() << ", ";
-    (*this)(op->batchSize_);
+    switch (blas) {
+    case BLASProvider::MKL:
+        if (inParallel_) {
+            os() << "mkl_set_num_threads_local(1);" << std::endl;
+            // TODO: set it to max(1, cpu_count / outer_threads_count)
+        } else {
+            os() << "mkl_set_num_threads_local(_ctx->numThreads());"
+                 << std::endl;
+        }
+        makeIndent();
+        os() << "cblas_" << genMKLTypeMark(d)
+             << "gemm_batch_strided(CblasRowMajor, "
+             << (transA ? "CblasTrans" : "CblasNoTrans") << ", "
+             << (transB ? "CblasTrans" : "CblasNoTrans");
+        break;
+    case BLASProvider::OpenBLAS:
+    case BLASProvider::BLIS:
+        // Strided batch emulated in runtime/cpu_blas.h
+        os() << "runtime_blas_gemm_batch_strided<" << gen(d) << ">("
+             << (transA ? "true" : "false") << ", "
+             << (transB ? "true" : "false");
+        break;
+    default:
+        // The built-in GEMM in runtime/cpu_gemm.h
+        os() << "runtime_gemm_batch_strided<" << gen(d) << ">("
+             << (transA ? "true" : "false") << ", "
+             << (transB ? "true" : "false");
+    }
+    for (auto &&[arg, isAddr] : std::vector<std::pair<Expr, bool>>{
+             {m, false},
+             {n, false},
+             {k, false},
+             {op->alpha_, false},
+             {a, true},
+             {lda, false},
+             {stridea, false},
+             {b, true},
+             {ldb, false},
+             {strideb, false},
+             {op->beta_, false},
+             {c, true},
+             {ldc, false},
+             {stridec, false},
+             {op->batchSize_, false}}) {
+        os() << (isAddr ? ", &" : ", ");
+        (*this)(arg);
+    }
+    if (blas != BLASProvider::MKL) {
+        // Nested parallelism is not worth it
+        os() << ", " << (inParallel_ ? "1" : "_ctx->numThreads()");
+    }
     os() << ");" << std::endl;
-#else
-    ERROR("Configuring with MKL is needed");
-#endif
 }
 
-std::string codeGenCPU(const Func &func) {
-    CodeGenCPU visitor(func->params_, func->returns_);
+std::string codeGenCPU(const Func &func, const Ref<Selector> &profile,
+                       BLASProvider blas) {
+    CodeGenCPU visitor(func->params_, func->returns_, profile,
+                       resolveBLASProvider(blas));
     auto &&op = func->body_;
     visitor.beginBlock();
     visitor(op);
@@ -333,28 +610,60 @@ std::string codeGenCPU(const Func &func) {
     const char *header = R"~~~(
 #include <cpu_runtime.h>
 
-extern "C" {
-)~~~";
-    const char *tailer = R"~~~(
-}
 )~~~";
+    const char *signature = "(void **_params, void **_returns, size_t "
+                            "**_retShapes, size_t *_retDims, "
+                            "CPUContext_t _ctx)";
 
     auto body = visitor.toString([&](const CodeGenStream &stream) {
-        std::string s =
-            "void run(void **_params, void **_returns, size_t **_retShapes, "
-            "size_t *_retDims, CPUContext_t _ctx) {\n";
-        s += "  size_t _sharedStackSize = " +
-             std::to_string(visitor.sharedStackSize()) + ";\n";
+        auto stackSize = std::to_string(visitor.sharedStackSize()) +
+                         " + _ctx->numThreads() * " +
+                         std::to_string(visitor.threadStackSize());
+        // The stack is a buffer reused across calls in the CPUContext. The
+        // Driver queries its size with run_stack_size to allocate it in
+        // advance
+        std::string s = "extern \"C\" {\n\n";
+        s += "size_t run_stack_size(CPUContext_t _ctx) { return " +
+             stackSize + "; }\n\n";
+        auto &&profiled = visitor.profiledIds();
+        if (profile.isValid()) {
+            // The Driver maps the counters back to the statements by IDs
+            s += "size_t run_profile_size() { return " +
+                 std::to_string(profiled.size()) + "; }\n";
+            s += "const uint64_t *run_profile_ids() {\n";
+            s += "  static const uint64_t ids[] = {0"; // Avoid empty arrays
+            for (auto &&id : profiled) {
+                s += ", " + std::to_string((uint64_t)id);
+            }
+            s += "};\n  return ids + 1;\n}\n\n";
+        }
+        s += "}\n\n";
+
+        // `ALIGNED` is also referred by aligned vector loads and stores from
+        // `lowerVector`
+        s += "template <bool ALIGNED>\n";
+        s += std::string("static void run_impl") + signature + " {\n";
         s += "  size_t _threadStackSize = " +
              std::to_string(visitor.threadStackSize()) + ";\n";
-        s += "  auto __stack = new uint8_t[_sharedStackSize + "
-             "omp_get_max_threads() * _threadStackSize];\n";
+        s += "  auto __stack = _ctx->stack(" + stackSize + ");\n";
+        if (!profiled.empty()) {
+            s += "  _ctx->reserveProfile(" + std::to_string(profiled.size()) +
+                 ");\n";
+        }
         s += stream.os_.str();
-        s += "  delete[] __stack;\n";
-        s += "}";
+        s += "}\n\n";
+
+        s += "extern \"C\" {\n\n";
+        s += std::string("void run") + signature + " {\n";
+        s += "  run_impl<true>(_params, _returns, _retShapes, _retDims, "
+             "_ctx);\n}\n\n";
+        s += std::string("void run_unaligned") + signature + " {\n";
+        s += "  run_impl<false>(_params, _returns, _retShapes, _retDims, "
+             "_ctx);\n}\n\n";
+        s += "}\n";
         return s;
     });
-    return header + body + tailer;
+    return header + body;
 }
 
 } // namespace freetensor
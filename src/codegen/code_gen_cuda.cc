@@ -481,6 +481,10 @@ void CodeGenCUDA::visit(const For &op) {
 }
 
 void CodeGenCUDA::visit(const VarDef &op) {
+    if (isPacked(op)) {
+        throw InvalidProgram("Variable " + op->name_ +
+                             " of packed_bool is not supported on GPU");
+    }
     if (op->buffer_->atype() != AccessType::Cache || op->viewOf_.has_value()) {
         CodeGenC::visit(op);
 
@@ -14,6 +14,11 @@
 
 namespace freetensor {
 
+template <class Stream> bool CodeGenC<Stream>::isPacked(const VarDef &def) {
+    auto &&tensor = def->buffer_->tensor();
+    return tensor->dtype() == DataType::PackedBool && !tensor->shape().empty();
+}
+
 template <class Stream>
 void CodeGenC<Stream>::genMdPtrType(std::ostream &os, const VarDef &def,
                                     bool isConst) {
@@ -37,11 +42,17 @@ void CodeGenC<Stream>::genMdPtrType(std::ostream &os, const VarDef &def,
         isRestricted = false;
     }
 
-    os << (isRestricted ? "mdspan_r<" : "mdspan<");
-    if (isConst) {
-        os << "const ";
+    if (isPacked(def)) {
+        // e.g. mdspan_packed<const packed_bool, extents<5, 5>>
+        os << "mdspan_packed<" << (isConst ? "const " : "") << "packed_bool";
+    } else {
+        os << (isRestricted ? "mdspan_r<" : "mdspan<");
+        if (isConst) {
+            os << "const ";
+        }
+        os << gen(buf->tensor()->dtype());
     }
-    os << gen(buf->tensor()->dtype()) << ", extents<";
+    os << ", extents<";
     for (auto &&[i, dim] : views::enumerate(buf->tensor()->shape())) {
         os << (i > 0 ? ", " : "");
         if (dim->nodeType() == ASTNodeType::IntConst) {
@@ -72,7 +83,8 @@ void CodeGenC<Stream>::genMdPtrDef(const VarDef &def,
     if (isConst) {
         this->os() << "const ";
     }
-    this->os() << gen(buf->tensor()->dtype()) << "*)(";
+    this->os() << (isPacked(def) ? "uint64_t" : gen(buf->tensor()->dtype()))
+               << "*)(";
     genRawPtr();
     this->os() << ")";
     for (auto &&dim : buf->tensor()->shape()) {
@@ -123,6 +135,14 @@ template <class Stream> void CodeGenC<Stream>::visit(const StmtSeq &op) {
 }
 
 template <class Stream> void CodeGenC<Stream>::visit(const VarDef &op) {
+    if (isPacked(op) && op->buffer_->mtype() != MemType::CPU &&
+        op->buffer_->mtype() != MemType::CPUHeap) {
+        throw InvalidProgram("Variable " + op->name_ + " of packed_bool in " +
+                             toString(op->buffer_->mtype()) +
+                             " is not supported. Only cpu and cpu/heap are "
+                             "supported");
+    }
+
     this->makeIndent();
     auto &&tensor = op->buffer_->tensor();
     auto &&shape = tensor->shape();
@@ -165,8 +185,7 @@ template <class Stream> void CodeGenC<Stream>::visit(const VarDef &op) {
         }
         std::string rawPtr;
         if (isParam) {
-            int nthParam = nthParamIter - params_.begin();
-            rawPtr = "_params[" + std::to_string(nthParam) + "]";
+            rawPtr = paramPtr(op, nthParamIter - params_.begin());
         } else {
             if (op->buffer_->atype() != AccessType::Output) {
                 throw InvalidProgram(
@@ -342,6 +361,43 @@ template <class Stream> void CodeGenC<Stream>::visit(const ReduceTo &op) {
     auto genAddr = [&]() { this->genScalar(op); };
     auto genExpr = [&]() { (*this)(op->expr_); };
 
+    auto dtype = this->buffer(op->var_)->tensor()->dtype();
+    if (isReducedPrecision(dtype)) {
+        // Compute explicitly in the accumulation type, and round only once.
+        // See `accumulateType`
+        auto acc = this->gen(accumulateType(dtype));
+        auto genAccAddr = [&]() {
+            this->os() << acc << "(", genAddr(), this->os() << ")";
+        };
+        auto genAccExpr = [&]() {
+            this->os() << acc << "(", genExpr(), this->os() << ")";
+        };
+        genAddr(), this->os() << " = " << this->gen(dtype) << "(";
+        switch (op->op_) {
+        case ReduceOp::Add:
+            genAccAddr(), this->os() << " + ", genAccExpr();
+            break;
+        case ReduceOp::Sub:
+            genAccAddr(), this->os() << " - ", genAccExpr();
+            break;
+        case ReduceOp::Mul:
+            genAccAddr(), this->os() << " * ", genAccExpr();
+            break;
+        case ReduceOp::Min:
+            this->os() << "std::min<" << acc << ">(", genAccAddr(),
+                this->os() << ", ", genAccExpr(), this->os() << ")";
+            break;
+        case ReduceOp::Max:
+            this->os() << "std::max<" << acc << ">(", genAccAddr(),
+                this->os() << ", ", genAccExpr(), this->os() << ")";
+            break;
+        default:
+            ASSERT(false);
+        }
+        this->os() << ");" << std::endl;
+        return;
+    }
+
     switch (op->op_) {
     case ReduceOp::Add:
         genAddr(), this->os() << " += ", genExpr();
@@ -353,17 +409,11 @@ template <class Stream> void CodeGenC<Stream>::visit(const ReduceTo &op) {
         genAddr(), this->os() << " *= ", genExpr();
         break;
     case ReduceOp::Min:
-        genAddr(), this->os()
-                       << " = std::min<"
-                       << this->gen(this->buffer(op->var_)->tensor()->dtype())
-                       << ">(";
+        genAddr(), this->os() << " = std::min<" << this->gen(dtype) << ">(";
         genAddr(), this->os() << ", ", genExpr(), this->os() << ")";
         break;
     case ReduceOp::Max:
-        genAddr(), this->os()
-                       << " = std::max<"
-                       << this->gen(this->buffer(op->var_)->tensor()->dtype())
-                       << ">(";
+        genAddr(), this->os() << " = std::max<" << this->gen(dtype) << ">(";
         genAddr(), this->os() << ", ", genExpr(), this->os() << ")";
         break;
     case ReduceOp::LAnd:
@@ -379,6 +429,18 @@ template <class Stream> void CodeGenC<Stream>::visit(const ReduceTo &op) {
     this->os() << ";" << std::endl;
 }
 
+template <class Stream>
+void CodeGenC<Stream>::genMathOperand(const Expr &expr) {
+    auto dtype = expr->dtype();
+    if (dtype == DataType::Float16 || dtype == DataType::BFloat16) {
+        this->os() << "float(";
+        (*this)(expr);
+        this->os() << ")";
+    } else {
+        (*this)(expr);
+    }
+}
+
 template <class Stream> void CodeGenC<Stream>::visit(const IntConst &op) {
     this->os() << std::to_string(op->val_);
 }
@@ -569,13 +631,13 @@ template <class Stream> void CodeGenC<Stream>::visit(const LNot &op) {
 
 template <class Stream> void CodeGenC<Stream>::visit(const Sqrt &op) {
     this->os() << "sqrt(";
-    (*this)(op->expr_);
+    genMathOperand(op->expr_);
     this->os() << ")";
 }
 
 template <class Stream> void CodeGenC<Stream>::visit(const Exp &op) {
     this->os() << "exp(";
-    (*this)(op->expr_);
+    genMathOperand(op->expr_);
     this->os() << ")";
 }
 
@@ -587,31 +649,31 @@ template <class Stream> void CodeGenC<Stream>::visit(const Square &op) {
 
 template <class Stream> void CodeGenC<Stream>::visit(const Sigmoid &op) {
     this->os() << "runtime_sigmoid(";
-    (*this)(op->expr_);
+    genMathOperand(op->expr_);
     this->os() << ")";
 }
 
 template <class Stream> void CodeGenC<Stream>::visit(const Tanh &op) {
     this->os() << "std::tanh(";
-    (*this)(op->expr_);
+    genMathOperand(op->expr_);
     this->os() << ")";
 }
 
 template <class Stream> void CodeGenC<Stream>::visit(const Abs &op) {
     this->os() << "std::abs(";
-    (*this)(op->expr_);
+    genMathOperand(op->expr_);
     this->os() << ")";
 }
 
 template <class Stream> void CodeGenC<Stream>::visit(const Floor &op) {
     this->os() << "std::floor(";
-    (*this)(op->expr_);
+    genMathOperand(op->expr_);
     this->os() << ")";
 }
 
 template <class Stream> void CodeGenC<Stream>::visit(const Ceil &op) {
     this->os() << "std::ceil(";
-    (*this)(op->expr_);
+    genMathOperand(op->expr_);
     this->os() << ")";
 }
 
@@ -720,7 +782,16 @@ template <class Stream> std::string CodeGenC<Stream>::gen(DataType dtype) {
     case DataType::Int32:
         return "int32_t";
     case DataType::Bool:
+    case DataType::PackedBool: // Only used for values and scalars
         return "bool";
+    case DataType::Float16:
+        return "float16_t";
+    case DataType::BFloat16:
+        return "bfloat16_t";
+    case DataType::Int8:
+        return "int8_t";
+    case DataType::UInt8:
+        return "uint8_t";
     default:
         ASSERT(false);
     }
@@ -1,7 +1,11 @@
+#include <cctype>
 #include <cstdio>
 #include <cstdlib>
 #include <mutex>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <unistd.h>
 
 #include <config.h>
@@ -78,15 +82,46 @@ static std::optional<bool> getBoolEnv(const char *name) {
     }
 }
 
+static std::optional<size_t> getSizeEnv(const char *name) {
+    if (auto env = getStrEnv(name); env.has_value()) {
+        try {
+            // std::stoull accepts and wraps a negative number
+            if (!env->empty() && isdigit((*env)[0])) {
+                size_t pos;
+                auto ret = std::stoull(*env, &pos);
+                if (pos == env->size()) {
+                    return ret;
+                }
+            }
+        } catch (const std::logic_error &) {
+            // Fall through
+        }
+        ERROR((std::string) "Value of " + name +
+              " must be a non-negative integer");
+    } else {
+        return std::nullopt;
+    }
+}
+
 bool Config::prettyPrint_ = false;
 bool Config::printAllId_ = false;
 bool Config::werror_ = false;
 bool Config::debugBinary_ = false;
 std::vector<fs::path> Config::backendCompilerCXX_;
 std::vector<fs::path> Config::backendCompilerNVCC_;
+size_t Config::backendCompilerJobs_ = 0;
+size_t Config::backendCompilerTimeout_ = 0;
+bool Config::backendPCH_ = true;
+bool Config::arrayHugePages_ = false;
 Ref<Target> Config::defaultTarget_;
 Ref<Device> Config::defaultDevice_;
 std::vector<fs::path> Config::runtimeDir_;
+fs::path Config::kernelCacheDir_;
+size_t Config::kernelCacheSizeLimit_ = (size_t)4 << 30; // 4 GiB
+std::atomic<size_t> Config::kernelCacheHits_ = 0,
+                    Config::kernelCacheMisses_ = 0;
+fs::path Config::openBLASDir_;
+fs::path Config::blisDir_;
 
 std::vector<fs::path>
 Config::checkValidPaths(const std::vector<fs::path> &paths, bool required) {
@@ -139,6 +174,32 @@ void Config::init() {
         Config::setBackendCompilerNVCC(makePaths(*path));
     }
 #endif // FT_WITH_CUDA
+    if (auto jobs = getSizeEnv("FT_BACKEND_COMPILER_JOBS"); jobs.has_value()) {
+        Config::setBackendCompilerJobs(*jobs);
+    }
+    if (auto timeout = getSizeEnv("FT_BACKEND_COMPILER_TIMEOUT");
+        timeout.has_value()) {
+        Config::setBackendCompilerTimeout(*timeout);
+    }
+    if (auto flag = getBoolEnv("FT_BACKEND_PCH"); flag.has_value()) {
+        Config::setBackendPCH(*flag);
+    }
+    if (auto flag = getBoolEnv("FT_ARRAY_HUGE_PAGES"); flag.has_value()) {
+        Config::setArrayHugePages(*flag);
+    }
+    if (auto path = getStrEnv("FT_KERNEL_CACHE_DIR"); path.has_value()) {
+        Config::setKernelCacheDir(*path);
+    }
+    if (auto size = getSizeEnv("FT_KERNEL_CACHE_SIZE_LIMIT");
+        size.has_value()) {
+        Config::setKernelCacheSizeLimit(*size);
+    }
+    if (auto path = getStrEnv("FT_OPENBLAS_DIR"); path.has_value()) {
+        Config::setOpenBLASDir(*path);
+    }
+    if (auto path = getStrEnv("FT_BLIS_DIR"); path.has_value()) {
+        Config::setBLISDir(*path);
+    }
     auto device = Ref<Device>::make(TargetType::CPU);
     Config::setDefaultDevice(device);
     Config::setDefaultTarget(device->target());
@@ -150,6 +211,13 @@ void Config::init() {
 #endif
 }
 
+size_t Config::backendCompilerJobs() {
+    if (backendCompilerJobs_ == 0) {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+    return backendCompilerJobs_;
+}
+
 std::string Config::withMKL() {
 #ifdef FT_WITH_MKL
     return FT_WITH_MKL;
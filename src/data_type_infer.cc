@@ -14,7 +14,11 @@ DataType DataTypeInfer::infer(const VarNode &op) {
     return DataType::Int32;
 }
 
-DataType DataTypeInfer::infer(const LoadNode &op) { return op.loadType_; }
+DataType DataTypeInfer::infer(const LoadNode &op) {
+    // Bits loaded from a packed tensor are plain booleans
+    return op.loadType_ == DataType::PackedBool ? DataType::Bool
+                                                : op.loadType_;
+}
 
 DataType DataTypeInfer::infer(const IntConstNode &op) {
     // TODO: Able to configure this to other types
@@ -483,6 +483,7 @@ void MatchVisitor::visit(const Intrinsic &op) {
     }
     CHECK(op->retType_ == instance->retType_);
     CHECK(op->hasSideEffect_ == instance->hasSideEffect_);
+    CHECK(op->isHint_ == instance->isHint_);
 }
 
 void MatchVisitor::visit(const Eval &op) {
@@ -1,21 +1,36 @@
+#include <atomic>
 #include <chrono>
 #include <cmath>   // sqrt
 #include <cstdio>  // remove
 #include <cstdlib> // mkdtemp, system
 #include <cstring> // memset
 #include <dlfcn.h> // dlopen
+#include <exception>
 #include <fstream>
+#include <iterator> // size
+#include <mutex>
+#include <omp.h>
+#include <pthread.h>     // pthread_setaffinity_np
+#include <sched.h>       // sched_getaffinity
+#include <signal.h>      // kill
 #include <sys/stat.h>    // mkdir
 #include <sys/syscall.h> // SYS_fork
 #include <sys/wait.h>    // waitpid
+#include <thread>
 #include <unistd.h>      // rmdir
 
 #include <analyze/find_stmt.h>
+#include <analyze/structural_feature.h>
 #include <config.h>
 #include <container_utils.h>
 #include <debug.h>
 #include <driver.h>
+#include <driver/build_queue.h>
+#include <driver/cpu_memory_pool.h>
+#include <driver/kernel_cache.h>
+#include <driver/numa.h>
 #include <except.h>
+#include <serialize/to_string.h>
 #ifdef FT_WITH_CUDA
 #include <driver/gpu.h>
 #endif
@@ -58,12 +73,149 @@ static void *requestPtr(const Ref<Array> &arr, const Ref<Device> &device,
     }
 }
 
+/**
+ * Process groups of running backend compilers that are not in the foreground
+ * process group of the terminal. Only lock-free atomics are accessed in the
+ * signal handler
+ */
+static std::atomic<pid_t> compilerGroups[256];
+static struct sigaction prevSigIntAction;
+
+/**
+ * Forward SIGINT (Ctrl+C) to the compilers in `compilerGroups`, and then handle
+ * it as before, e.g. with the handler of Python
+ */
+static void forwardSigInt(int sig, siginfo_t *info, void *ucontext) {
+    for (auto &&group : compilerGroups) {
+        if (pid_t pgid = group.load(); pgid > 0) {
+            kill(-pgid, SIGINT);
+        }
+    }
+    if (prevSigIntAction.sa_flags & SA_SIGINFO) {
+        prevSigIntAction.sa_sigaction(sig, info, ucontext);
+    } else if (prevSigIntAction.sa_handler == SIG_DFL) {
+        signal(SIGINT, SIG_DFL);
+        raise(SIGINT);
+    } else if (prevSigIntAction.sa_handler != SIG_IGN) {
+        prevSigIntAction.sa_handler(sig);
+    }
+}
+
+/**
+ * Register a process group to receive SIGINT of the terminal
+ *
+ * The handler is (re-)installed if someone else has replaced it. If SIGINT is
+ * ignored, it is not installed, and the compiler ignores SIGINT as well
+ *
+ * @return : The slot to pass to `unregisterCompilerGroup`, or -1 if not
+ * registered
+ */
+static int registerCompilerGroup(pid_t pgid) {
+    static std::mutex lock;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        struct sigaction cur;
+        sigaction(SIGINT, nullptr, &cur);
+        if (!(cur.sa_flags & SA_SIGINFO) && cur.sa_handler == SIG_IGN) {
+            return -1;
+        }
+        if (!(cur.sa_flags & SA_SIGINFO) || cur.sa_sigaction != forwardSigInt) {
+            struct sigaction act;
+            memset(&act, 0, sizeof(act));
+            act.sa_sigaction = forwardSigInt;
+            act.sa_flags = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&act.sa_mask);
+            sigaction(SIGINT, &act, &prevSigIntAction);
+        }
+    }
+    for (int i = 0, n = std::size(compilerGroups); i < n; i++) {
+        pid_t expected = 0;
+        if (compilerGroups[i].compare_exchange_strong(expected, pgid)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void unregisterCompilerGroup(int slot) {
+    if (slot != -1) {
+        compilerGroups[slot].store(0);
+    }
+}
+
+/**
+ * Run the backend compiler with fork + execv
+ *
+ * The number of concurrent compilers is limited by `CompileJobSlot`, and a
+ * compiler is killed if it runs longer than `Config::backendCompilerTimeout()`
+ *
+ * A compiler with a timeout runs in its own process group, so it can be killed
+ * together with its subprocesses. The group is not the foreground one of the
+ * terminal, so SIGINT (Ctrl+C) is forwarded to it by `forwardSigInt`
+ */
+static void runBackendCompiler(const char *executable,
+                               const std::vector<std::string> &args) {
+    // construct the argv array
+    std::vector<const char *> argv;
+    argv.push_back(executable);
+    for (auto &s : args) {
+        argv.push_back(s.c_str());
+    }
+    argv.push_back(nullptr);
+
+    CompileJobSlot slot;
+    auto timeout = Config::backendCompilerTimeout();
+
+    // We use the raw syscall instead of libc fork() here.
+    // This is because libc fork() processes the pthread_atfork() handlers,
+    // in which handlers from like OpenMP implementations will do something
+    // against potential broken states (e.g. mutexes) due to the fork().
+    // With raw syscall, we can avoid this.
+    int pid = syscall(SYS_fork);
+    if (pid == 0) {
+        if (timeout > 0) {
+            // Run in a new process group, so we can kill the compiler
+            // together with its subprocesses (cc1plus, as, ld, etc.)
+            setpgid(0, 0);
+        }
+        execv(executable, const_cast<char *const *>(argv.data()));
+        std::cerr << "Failed to execute " << executable << ": "
+                  << strerror(errno);
+        exit(-1);
+    } else {
+        int status;
+        if (timeout > 0) {
+            setpgid(pid, pid); // Also set in the parent to avoid racing
+            int groupSlot = registerCompilerGroup(pid);
+            namespace ch = std::chrono;
+            auto deadline = ch::steady_clock::now() + ch::seconds(timeout);
+            while (waitpid(pid, &status, WNOHANG) != pid) {
+                if (ch::steady_clock::now() >= deadline) {
+                    kill(-pid, SIGKILL);
+                    waitpid(pid, &status, 0);
+                    unregisterCompilerGroup(groupSlot);
+                    throw DriverError("Backend compiler timed out after " +
+                                      std::to_string(timeout) + " seconds");
+                }
+                std::this_thread::sleep_for(ch::milliseconds(10));
+            }
+            unregisterCompilerGroup(groupSlot);
+        } else {
+            waitpid(pid, &status, 0);
+        }
+        if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) {
+            // Interrupted (Ctrl+C). Interrupt FreeTensor as well
+            // Do not directly raise SIGINT. See the doc of InterruptExcept
+            throw InterruptExcept();
+        }
+        if (status != 0)
+            throw DriverError("Backend compiler reports error");
+    }
+}
+
 Driver::Driver(const Func &f, const std::string &src, const Ref<Device> &dev,
                const Ref<Device> &hostDev, bool verbose)
-    : f_(f), src_(src), args_(f->params_.size(), nullptr),
-      rawArgs(f->params_.size(), nullptr), rawRets(f->returns_.size(), nullptr),
-      retShapes_(f->returns_.size(), nullptr), retDims_(f->returns_.size(), 0),
-      dev_(dev), hostDev_(hostDev), verbose_(verbose) {
+    : f_(f), src_(src), dev_(dev), hostDev_(hostDev), verbose_(verbose) {
     auto nParams = f->params_.size();
     name2param_.reserve(nParams);
     name2buffer_.reserve(nParams);
@@ -74,7 +226,13 @@ Driver::Driver(const Func &f, const std::string &src, const Ref<Device> &dev,
                 return s->nodeType() == ASTNodeType::VarDef &&
                        s.as<VarDefNode>()->name_ == f->params_[i].name_;
             });
-            name2buffer_[f->params_[i].name_] = node.as<VarDefNode>()->buffer_;
+            auto &&buffer = node.as<VarDefNode>()->buffer_;
+            name2buffer_[f->params_[i].name_] = buffer;
+            // Consistent with `codeGenCPU`
+            if (buffer->mtype() == MemType::CPU &&
+                !buffer->tensor()->shape().empty()) {
+                alignedParams_.emplace_back(i);
+            }
         } catch (const UnexpectedQueryResult &e) {
             throw DriverError(
                 "Name " + f->params_[i].name_ +
@@ -82,18 +240,10 @@ Driver::Driver(const Func &f, const std::string &src, const Ref<Device> &dev,
         }
     }
     buildAndLoad();
+    frame_ = newFrame();
 }
 
 void Driver::buildAndLoad() {
-    std::string home = getenv("HOME");
-    mkdir((home + "/.freetensor").c_str(), 0755);
-    std::string path_string = home + "/.freetensor/XXXXXX";
-    char path[64];
-    ASSERT(path_string.size() < 64);
-    strncpy(path, path_string.c_str(), 63);
-    auto mkdtempPtr = mkdtemp(path);
-    ASSERT(mkdtempPtr != nullptr);
-
     std::string srcSuffix;
     switch (dev_->type()) {
     case TargetType::CPU:
@@ -106,21 +256,20 @@ void Driver::buildAndLoad() {
         ASSERT(false);
     }
 
-    auto cpp = (std::string)path + "/run" + srcSuffix;
-    auto so = (std::string)path + "/run.so";
-    {
-        std::ofstream f(cpp);
-        f << src_;
-    }
+    // Paths to the source and binary files are placeholders here, which will
+    // be replaced by paths in a temporary directory when compiling. This keeps
+    // `args` usable as a part of the key of the kernel cache
+    const std::string cppHolder = "<source>", soHolder = "<binary>";
     const char *executable;
     std::vector<std::string> args;
+    std::vector<std::string> compileFlags; // Flags to precompile the runtime
     auto addArgs = [&](auto... s) {
         args.insert(args.end(), {std::string(s)...});
     };
     // We enable fast-math because our own transformations do not preserve
     // strict floating point rounding order either
     switch (dev_->type()) {
-    case TargetType::CPU:
+    case TargetType::CPU: {
         ASSERT(!Config::backendCompilerCXX().empty());
         executable = Config::backendCompilerCXX().front().c_str();
         for (auto &&path : Config::runtimeDir()) {
@@ -130,25 +279,62 @@ void Driver::buildAndLoad() {
             // be split into multiple arguments.
             addArgs("-I" + (std::string)path);
         }
-        addArgs("-std=c++20", "-shared", "-O3", "-fPIC", "-Wall", "-fopenmp",
+        addArgs("-std=c++20", "-O3", "-fPIC", "-Wall", "-fopenmp",
                 "-ffast-math");
-        addArgs("-o", so, cpp);
+        auto blas = dev_->target().as<CPUTarget>()->blas();
+        std::string blasDir;
+        switch (blas) {
+        case BLASProvider::MKL:
 #ifdef FT_WITH_MKL
-        addArgs("-I" FT_WITH_MKL "/include", "-Wl,--start-group",
-                FT_WITH_MKL "/lib/intel64/libmkl_intel_lp64.a",
-                FT_WITH_MKL "/lib/intel64/libmkl_gnu_thread.a",
-                FT_WITH_MKL "/lib/intel64/libmkl_core.a", "-Wl,--end-group",
-                "-DFT_WITH_MKL=" FT_WITH_MKL);
-        // Link statically, or there will be dlopen issues
-        // Generated with MKL Link Line Advisor
+            addArgs("-I" FT_WITH_MKL "/include", "-DFT_WITH_MKL=" FT_WITH_MKL);
 #endif // FT_WITH_MKL
+            break;
+        case BLASProvider::OpenBLAS:
+            blasDir = Config::openBLASDir().string();
+            addArgs("-DFT_BLAS_OPENBLAS");
+            break;
+        case BLASProvider::BLIS:
+            blasDir = Config::blisDir().string();
+            addArgs("-DFT_BLAS_BLIS");
+            break;
+        default:;
+        }
+        if (!blasDir.empty()) {
+            addArgs("-I" + blasDir + "/include");
+        }
         if (dev_->target()->useNativeArch()) {
             addArgs("-march=native");
         }
         if (Config::debugBinary()) {
             addArgs("-g");
         }
+        compileFlags = args;
+        addArgs("-shared", "-o", soHolder, cppHolder);
+        if (!blasDir.empty()) {
+            addArgs("-L" + blasDir + "/lib", "-Wl,-rpath," + blasDir + "/lib");
+        }
+        switch (blas) {
+        case BLASProvider::MKL:
+#ifdef FT_WITH_MKL
+            addArgs("-Wl,--start-group",
+                    FT_WITH_MKL "/lib/intel64/libmkl_intel_lp64.a",
+                    FT_WITH_MKL "/lib/intel64/libmkl_gnu_thread.a",
+                    FT_WITH_MKL "/lib/intel64/libmkl_core.a",
+                    "-Wl,--end-group");
+            // Link statically, or there will be dlopen issues
+            // Generated with MKL Link Line Advisor
+#endif // FT_WITH_MKL
+            break;
+        case BLASProvider::OpenBLAS:
+            addArgs("-lopenblas");
+            break;
+        case BLASProvider::BLIS:
+            addArgs("-lblis");
+            break;
+        default:;
+        }
         break;
+    }
 #ifdef FT_WITH_CUDA
     case TargetType::GPU: {
         ASSERT(!Config::backendCompilerNVCC().empty());
@@ -159,7 +345,7 @@ void Driver::buildAndLoad() {
         addArgs("-std=c++17", "-shared", "-Xcompiler", "-fPIC,-Wall,-O3",
                 "--use_fast_math",
                 "--expt-relaxed-constexpr" /* required by mdspan */);
-        addArgs("-o", so, cpp);
+        addArgs("-o", soHolder, cppHolder);
         addArgs("-lcublas");
         auto cc = dev_->target().as<GPUTarget>()->computeCapability();
         addArgs("-arch",
@@ -174,101 +360,376 @@ void Driver::buildAndLoad() {
         ASSERT(false);
     }
 
-    if (Config::debugBinary() || verbose_) {
-        std::stringstream cmdStream;
-        cmdStream << "\"" << executable << "\" ";
-        for (auto &s : args) {
-            cmdStream << "\"" << s << "\" ";
+    auto key = makeKernelCacheKey(src_, executable, args);
+
+    auto load = [&]() {
+        std::string home = getenv("HOME");
+        mkdir((home + "/.freetensor").c_str(), 0755);
+        std::string path_string = home + "/.freetensor/XXXXXX";
+        char path[64];
+        ASSERT(path_string.size() < 64);
+        strncpy(path, path_string.c_str(), 63);
+        auto mkdtempPtr = mkdtemp(path);
+        ASSERT(mkdtempPtr != nullptr);
+
+        auto cpp = (std::string)path + "/run" + srcSuffix;
+        auto so = (std::string)path + "/run.so";
+        auto realArgs = args;
+        for (auto &arg : realArgs) {
+            if (arg == cppHolder) {
+                arg = cpp;
+            } else if (arg == soHolder) {
+                arg = so;
+            }
         }
-        auto cmd = cmdStream.str();
 
-        if (Config::debugBinary()) {
-            WARNING("debug-binary mode on. Compiling with " + cmd);
+        auto build = [&]() {
+            if (dev_->type() == TargetType::CPU && Config::backendPCH()) {
+                // The precompiled header is found before the runtime
+                // directories, and does not affect the compiled binary, so it
+                // is not a part of the key
+                auto pchDir = precompiledRuntimeDir(
+                    executable, compileFlags,
+                    [&](const std::vector<std::string> &pchArgs) {
+                        if (verbose_) {
+                            logger() << "Precompiling runtime headers"
+                                     << std::endl;
+                        }
+                        runBackendCompiler(executable, pchArgs);
+                    });
+                if (pchDir.has_value()) {
+                    realArgs.insert(realArgs.begin(), "-I" + pchDir->string());
+                }
+            }
+
+            if (Config::debugBinary() || verbose_) {
+                std::stringstream cmdStream;
+                cmdStream << "\"" << executable << "\" ";
+                for (auto &s : realArgs) {
+                    cmdStream << "\"" << s << "\" ";
+                }
+                auto cmd = cmdStream.str();
+
+                if (Config::debugBinary()) {
+                    WARNING("debug-binary mode on. Compiling with " + cmd);
+                }
+                if (verbose_) {
+                    logger() << "Running " << cmd << std::endl;
+                }
+            }
+
+            {
+                std::ofstream f(cpp);
+                f << src_;
+            }
+            auto begin = std::chrono::steady_clock::now();
+            runBackendCompiler(executable, realArgs);
+            if (verbose_) {
+                std::chrono::duration<double, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - begin;
+                logger() << "Backend compiler finished in " << elapsed.count()
+                         << " ms" << std::endl;
+            }
+        };
+        if (!Config::kernelCacheDir().empty() && !Config::debugBinary()) {
+            lookupOrBuildKernel(key, so, build);
+        } else {
+            build();
         }
-        if (verbose_) {
-            logger() << "Running " << cmd << std::endl;
+
+        auto dlHandle = dlopen(so.c_str(), RTLD_NOW);
+        if (!dlHandle) {
+            throw DriverError((std::string) "Unable to load target code: " +
+                              dlerror());
         }
-    }
+        auto kernel = Ref<LoadedKernel>::make(dlHandle);
 
-    // fork + execv to execute the compiler
-    {
-        // construct the argv array
-        std::vector<const char *> argv;
-        argv.push_back(executable);
-        for (auto &s : args) {
-            argv.push_back(s.c_str());
-        }
-        argv.push_back(nullptr);
-
-        // We use the raw syscall instead of libc fork() here.
-        // This is because libc fork() processes the pthread_atfork() handlers,
-        // in which handlers from like OpenMP implementations will do something
-        // against potential broken states (e.g. mutexes) due to the fork().
-        // With raw syscall, we can avoid this.
-        int pid = syscall(SYS_fork);
-        if (pid == 0) {
-            execv(executable, const_cast<char *const *>(argv.data()));
-            std::cerr << "Failed to execute " << executable << ": "
-                      << strerror(errno);
-            exit(-1);
+        if (!Config::debugBinary()) {
+            remove(cpp.c_str());
+            remove(so.c_str());
+            rmdir(path);
         } else {
-            int status;
-            waitpid(pid, &status, 0);
-            if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) {
-                // Interrupted (Ctrl+C). Interrupt FreeTensor as well
-                // Do not directly raise SIGINT. See the doc of InterruptExcept
-                throw InterruptExcept();
-            }
-            if (status != 0)
-                throw DriverError("Backend compiler reports error");
+            WARNING((std::string) "debug-binary mode on. The produced files "
+                                  "are saved in " +
+                    path);
         }
-    }
+        return kernel;
+    };
 
-    dlHandle_ = dlopen(so.c_str(), RTLD_NOW);
-    if (!dlHandle_) {
-        throw DriverError((std::string) "Unable to load target code: " +
-                          dlerror());
+    if (Config::debugBinary()) {
+        // Keep one copy of the produced files for each Driver
+        kernel_ = load();
+    } else {
+        kernel_ = loadKernelShared(key, load);
     }
 
     func_ = (void (*)(void **, void **, size_t **, size_t *, void *))dlsym(
-        dlHandle_, "run");
+        kernel_->dlHandle(), "run");
     if (!func_) {
         throw DriverError((std::string) "Target function not found: " +
                           dlerror());
     }
+    // Only CPU kernels have the unaligned version
+    funcUnaligned_ =
+        (void (*)(void **, void **, size_t **, size_t *, void *))dlsym(
+            kernel_->dlHandle(), "run_unaligned");
+    if (!funcUnaligned_) {
+        funcUnaligned_ = func_;
+    }
 
-    if (!Config::debugBinary()) {
-        remove(cpp.c_str());
-        remove(so.c_str());
-        rmdir(path);
-    } else {
-        WARNING((std::string) "debug-binary mode on. The produced files are "
-                              "saved in " +
-                path);
+    if (dev_->type() == TargetType::CPU) {
+        stackSize_ = (size_t(*)(CPUContext *))dlsym(kernel_->dlHandle(),
+                                                    "run_stack_size");
+        // Only present when instrumented for profiling
+        profileSize_ =
+            (size_t(*)())dlsym(kernel_->dlHandle(), "run_profile_size");
+        profileIds_ = (const uint64_t *(*)())dlsym(kernel_->dlHandle(),
+                                                   "run_profile_ids");
     }
+}
 
+std::unique_ptr<Context> Driver::newContext() const {
     switch (dev_->type()) {
-    case TargetType::CPU:
-        ctx_ = std::make_unique<CPUContext>();
-        break;
+    case TargetType::CPU: {
+        auto ctx = std::make_unique<CPUContext>(&CPUMemoryPool::instance());
+        ctx->setNumThreads(resolvedNumThreads_);
+        if (stackSize_ != nullptr) {
+            ctx->reserveStack(stackSize_(ctx.get()));
+        }
+        return ctx;
+    }
 #ifdef FT_WITH_CUDA
     case TargetType::GPU:
-        ctx_ = std::make_unique<GPUContext>();
-        break;
+        return std::make_unique<GPUContext>();
 #endif // FT_WITH_CUDA
     default:
         ASSERT(false);
     }
 }
 
-void Driver::setArgs(const std::vector<Ref<Array>> &args,
-                     const std::unordered_map<std::string, Ref<Array>> &kws) {
+std::optional<int64_t> Driver::maxParallelTripCount() const {
+    auto isOpenMPLoop = [](const Stmt &s) {
+        return s->nodeType() == ASTNodeType::For &&
+               std::holds_alternative<OpenMPScope>(
+                   s.as<ForNode>()->property_->parallel_);
+    };
+    int64_t ret = 0;
+    for (auto &&loop : findAllStmt(f_->body_, isOpenMPLoop)) {
+        // Perfectly nested OpenMP loops are collapsed by codegen
+        int64_t trip = 1;
+        for (Stmt inner = loop; isOpenMPLoop(inner);
+             inner = inner.as<ForNode>()->body_) {
+            auto &&len = inner.as<ForNode>()->len_;
+            if (len->nodeType() != ASTNodeType::IntConst) {
+                return std::nullopt;
+            }
+            trip *= len.as<IntConstNode>()->val_;
+        }
+        ret = std::max(ret, trip);
+    }
+    return ret;
+}
+
+void Driver::resolveNumThreads() {
+    int available = cpuAffinity_.has_value() ? CPU_COUNT(&*cpuAffinity_)
+                                             : omp_get_max_threads();
+    if (numThreads_ == AUTO_NUM_THREADS) {
+        auto trip = maxParallelTripCount();
+        resolvedNumThreads_ =
+            trip.has_value()
+                ? std::max<int64_t>(1, std::min<int64_t>(*trip, available))
+                : available;
+    } else if (numThreads_ == 0 && cpuAffinity_.has_value()) {
+        // Don't oversubscribe the CPUs bound to
+        resolvedNumThreads_ = available;
+    } else {
+        resolvedNumThreads_ = numThreads_;
+    }
+    if (verbose_ && numThreads_ != 0) {
+        logger() << "Running with " << resolvedNumThreads_ << " threads"
+                 << std::endl;
+    }
+}
+
+void Driver::setNumThreads(int numThreads) {
+    if (numThreads < 0 && numThreads != AUTO_NUM_THREADS) {
+        throw DriverError("Invalid number of threads: " +
+                          std::to_string(numThreads));
+    }
+    if (numThreads != 0 && dev_->type() != TargetType::CPU) {
+        throw DriverError("Setting the number of threads is only supported "
+                          "on CPU");
+    }
+    numThreads_ = numThreads;
+    resolveNumThreads();
+}
+
+void Driver::setCPUAffinity(const std::vector<int> &cpus) {
+    if (cpus.empty()) {
+        cpuAffinity_ = std::nullopt;
+    } else {
+        if (dev_->type() != TargetType::CPU) {
+            throw DriverError("Setting CPU affinity is only supported on CPU");
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                throw DriverError("Invalid CPU ID: " + std::to_string(cpu));
+            }
+            CPU_SET(cpu, &set);
+        }
+        cpuAffinity_ = set;
+    }
+    resolveNumThreads();
+}
+
+std::vector<int> Driver::cpuAffinity() const {
+    std::vector<int> ret;
+    if (cpuAffinity_.has_value()) {
+        for (int i = 0; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &*cpuAffinity_)) {
+                ret.emplace_back(i);
+            }
+        }
+    }
+    return ret;
+}
+
+namespace {
+
+/**
+ * CPUs that the OpenMP threads used by the current thread are bound to
+ *
+ * OpenMP threads are kept in a pool per invoking thread and reused across
+ * parallel regions, including the ones of different programs. We record the
+ * binding, so we only need to bind them again when it changes
+ */
+struct OpenMPThreadsBinding {
+    bool bound_ = false;
+    cpu_set_t cpus_, original_;
+    int numThreads_ = 0;
+};
+
+thread_local OpenMPThreadsBinding ompBinding;
+
+void setAffinityOfOpenMPThreads(const cpu_set_t &cpus, int numThreads) {
+#pragma omp parallel num_threads(numThreads)
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+}
+
+/**
+ * Bind the current thread and its OpenMP threads to a set of CPUs during an
+ * invocation, or unbind them if the set is empty
+ */
+class OpenMPBindingGuard {
+    bool bound_;
+
+  public:
+    OpenMPBindingGuard(const std::optional<cpu_set_t> &cpus, int numThreads)
+        : bound_(cpus.has_value()) {
+        auto &&b = ompBinding;
+        if (bound_) {
+            if (!b.bound_) {
+                pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                       &b.original_);
+            }
+            if (!b.bound_ || !CPU_EQUAL(&b.cpus_, &*cpus) ||
+                b.numThreads_ < numThreads) {
+                numThreads = std::max(numThreads, b.bound_ ? b.numThreads_ : 0);
+                setAffinityOfOpenMPThreads(*cpus, numThreads);
+                b.bound_ = true;
+                b.cpus_ = *cpus;
+                b.numThreads_ = numThreads;
+            } else {
+                // Only the current thread has been restored
+                pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                       &*cpus);
+            }
+        } else if (b.bound_) {
+            setAffinityOfOpenMPThreads(b.original_, b.numThreads_);
+            b.bound_ = false;
+        }
+    }
+
+    ~OpenMPBindingGuard() {
+        if (bound_) {
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                   &ompBinding.original_);
+        }
+    }
+};
+
+/**
+ * Copy the `Array`s to CPU by the OpenMP threads running the program when
+ * requesting their pointers, so the pages placed by first touch are on the
+ * nodes of the threads accessing them
+ */
+class FirstTouchGuard {
+    std::optional<OpenMPBindingGuard> binding_;
+    std::optional<ParallelCopyThreadsGuard> copyThreads_;
+
+  public:
+    FirstTouchGuard(const Ref<Device> &dev, const Ref<Device> &hostDev,
+                    const std::optional<cpu_set_t> &cpus, int numThreads) {
+        if (dev->type() == TargetType::CPU &&
+            hostDev->numaPolicy() == NUMAPolicy::FirstTouch) {
+            // The same as `CPUContext::numThreads`
+            numThreads = numThreads > 0 ? numThreads : omp_get_max_threads();
+            binding_.emplace(cpus, numThreads);
+            copyThreads_.emplace(numThreads);
+        }
+    }
+};
+
+} // Anonymous namespace
+
+void Driver::placeArray(const Ref<Array> &arr) const {
+    FirstTouchGuard firstTouch(dev_, hostDev_, cpuAffinity_,
+                               resolvedNumThreads_);
+    arr->placeOn(hostDev_);
+}
+
+DriverFrame Driver::newFrame() const {
+    DriverFrame frame;
+    frame.args_.resize(f_->params_.size(), nullptr);
+    frame.rawArgs_.resize(f_->params_.size(), nullptr);
+    frame.rawRets_.resize(f_->returns_.size(), nullptr);
+    frame.retShapes_.resize(f_->returns_.size(), nullptr);
+    frame.retDims_.resize(f_->returns_.size(), 0);
+    frame.ctx_ = newContext();
+    return frame;
+}
+
+void Driver::checkFrame(const DriverFrame &frame) const {
+    if (frame.ctx_ == nullptr || frame.rawArgs_.size() != f_->params_.size() ||
+        frame.rawRets_.size() != f_->returns_.size()) {
+        throw DriverError("The frame is not created by Driver::newFrame of "
+                          "this Driver");
+    }
+}
+
+bool Driver::paramsAligned(const std::vector<void *> &rawArgs) const {
+    for (size_t i : alignedParams_) {
+        if ((uintptr_t)rawArgs[i] % CPU_PARAM_ALIGNMENT != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Driver::setArgs(DriverFrame &frame, const std::vector<Ref<Array>> &args,
+                     const std::unordered_map<std::string, Ref<Array>> &kws)
+    const {
+    checkFrame(frame);
+    FirstTouchGuard firstTouch(dev_, hostDev_, cpuAffinity_,
+                               resolvedNumThreads_);
     for (size_t i = 0, iEnd = args.size(), j = 0; i < iEnd; i++) {
-        while (j < rawArgs.size() && f_->params_[j].isInClosure() &&
+        while (j < frame.rawArgs_.size() && f_->params_[j].isInClosure() &&
                !f_->params_[j].updateClosure_) {
             j++;
         }
-        if (j >= rawArgs.size()) {
+        if (j >= frame.rawArgs_.size()) {
             throw DriverError("More arguments are given than required");
         }
         auto &&buffer = name2buffer_.at(f_->params_[j].name_);
@@ -280,9 +741,9 @@ void Driver::setArgs(const std::vector<Ref<Array>> &args,
                 toString(
                     name2buffer_.at(f_->params_[j].name_)->tensor()->dtype()));
         }
-        args_[j] = args[i];
-        rawArgs[j] = requestPtr(args[i], dev_, hostDev_, buffer->mtype(),
-                                buffer->atype());
+        frame.args_[j] = args[i];
+        frame.rawArgs_[j] = requestPtr(args[i], dev_, hostDev_,
+                                       buffer->mtype(), buffer->atype());
         if (f_->params_[j].isInClosure() && f_->params_[j].updateClosure_) {
             *f_->params_[j].closure_ = args[j];
         }
@@ -296,13 +757,13 @@ void Driver::setArgs(const std::vector<Ref<Array>> &args,
         if (buffer->tensor()->dtype() != value->dtype()) {
             throw DriverError(
                 "Cannnot pass a " + toString(value->dtype()) +
-                " Array to the " + std::to_string(name2param_[key]) +
+                " Array to the " + std::to_string(name2param_.at(key)) +
                 "-th parameter " + key + " of type " +
                 toString(name2buffer_.at(key)->tensor()->dtype()));
         }
-        auto paramId = name2param_[key];
-        args_[paramId] = value;
-        rawArgs[paramId] =
+        auto paramId = name2param_.at(key);
+        frame.args_[paramId] = value;
+        frame.rawArgs_[paramId] =
             requestPtr(value, dev_, hostDev_, buffer->mtype(), buffer->atype());
         if (f_->params_[paramId].isInClosure()) {
             if (f_->params_[paramId].updateClosure_) {
@@ -313,8 +774,9 @@ void Driver::setArgs(const std::vector<Ref<Array>> &args,
             }
         }
     }
-    for (auto &&[i, rawArg, param] : views::zip(
-             views::ints(0, ranges::unreachable), rawArgs, f_->params_)) {
+    for (auto &&[i, rawArg, param] :
+         views::zip(views::ints(0, ranges::unreachable), frame.rawArgs_,
+                    f_->params_)) {
         auto &&buffer = name2buffer_.at(param.name_);
         if (rawArg == nullptr && param.isInClosure()) {
             if (!param.closure_->isValid()) {
@@ -329,39 +791,98 @@ void Driver::setArgs(const std::vector<Ref<Array>> &args,
                               param.name_ + " is missing");
         }
     }
+    // Borrowed `Array`s may be unaligned. Fall back to the conservative
+    // version of the kernel for them
+    frame.aligned_ = paramsAligned(frame.rawArgs_);
 }
 
-void Driver::run() {
+void Driver::run(DriverFrame &frame) const {
+    checkFrame(frame);
 #ifdef FT_WITH_CUDA
     if (dev_->type() == TargetType::GPU) {
         checkCudaError(cudaSetDevice(dev_->num()));
     }
 #endif // FT_WITH_CUDA
-    func_(rawArgs.data(), rawRets.data(), retShapes_.data(), retDims_.data(),
-          ctx_.get());
+    std::optional<OpenMPBindingGuard> binding;
+    if (dev_->type() == TargetType::CPU) {
+        auto &&ctx = static_cast<CPUContext &>(*frame.ctx_);
+        ctx.setNumThreads(resolvedNumThreads_);
+        binding.emplace(cpuAffinity_, ctx.numThreads());
+    }
+    (frame.aligned_ ? func_ : funcUnaligned_)(
+        frame.rawArgs_.data(), frame.rawRets_.data(), frame.retShapes_.data(),
+        frame.retDims_.data(), frame.ctx_.get());
+}
+
+std::vector<ProfileEntry> Driver::profile(const DriverFrame &frame) const {
+    checkFrame(frame);
+    if (profileSize_ == nullptr || profileIds_ == nullptr) {
+        throw DriverError("The program is not instrumented for profiling. "
+                          "Please set `profile` in codegen");
+    }
+    auto &&ctx = static_cast<const CPUContext &>(*frame.ctx_);
+    size_t n = profileSize_();
+    auto ids = profileIds_();
+    std::vector<ProfileEntry> ret(n);
+    for (size_t i = 0; i < n; i++) {
+        auto &&entry = ret[i];
+        entry.id_ = ID::make(ids[i]);
+        try {
+            entry.metadata_ = findStmt(f_->body_, entry.id_)->metadata();
+        } catch (const UnexpectedQueryResult &e) {
+            // Not found in case of a mismatching AST. Leave it empty
+        }
+        for (size_t t = 0, nThreads = ctx.profileThreads(); t < nThreads;
+             t++) {
+            auto counters = ctx.profile(t) + i * 2;
+            double time = counters[0] / 1e6; // ns -> ms
+            entry.time_ += time;
+            entry.maxThreadTime_ = std::max(entry.maxThreadTime_, time);
+            entry.count_ += counters[1];
+        }
+    }
+    return ret;
+}
+
+void Driver::resetProfile(DriverFrame &frame) const {
+    checkFrame(frame);
+    if (dev_->type() == TargetType::CPU) {
+        static_cast<CPUContext &>(*frame.ctx_).resetProfile();
+    }
 }
 
 void Driver::sync() { dev_->sync(); }
 
-std::vector<Ref<Array>> Driver::collectReturns() {
+Ref<Array> Driver::moveReturn(size_t i, void *&rawRet, size_t *&retShape,
+                              size_t &retDim) const {
+    std::vector<size_t> shape(retShape, retShape + retDim);
+    auto val = Ref<Array>::make(
+        Array::moveFromRaw(rawRet, shape, f_->returns_[i].dtype_, dev_));
+    if (retShape != nullptr) {
+        if (dev_->type() == TargetType::CPU) {
+            CPUMemoryPool::instance().free(retShape);
+        } else {
+            free(retShape);
+        }
+    }
+    rawRet = nullptr;
+    retShape = nullptr;
+    retDim = 0;
+    return val;
+}
+
+std::vector<Ref<Array>> Driver::collectReturns(DriverFrame &frame) const {
+    checkFrame(frame);
     std::vector<Ref<Array>> ret;
     for (size_t i = 0, n = f_->returns_.size(); i < n; i++) {
         auto &&[name, dtype, closure, returnClosure] = f_->returns_[i];
         Ref<Array> val;
         if (name2param_.count(name)) {
             // Returning an argument
-            val = args_.at(name2param_.at(name));
+            val = frame.args_.at(name2param_.at(name)).get();
         } else {
-            std::vector<size_t> shape(retShapes_[i],
-                                      retShapes_[i] + retDims_[i]);
-            val = Ref<Array>::make(
-                Array::moveFromRaw(rawRets[i], shape, dtype, dev_));
-            if (retShapes_[i] != nullptr) {
-                free(retShapes_[i]);
-            }
-            rawRets[i] = nullptr;
-            retShapes_[i] = nullptr;
-            retDims_[i] = 0;
+            val = moveReturn(i, frame.rawRets_[i], frame.retShapes_[i],
+                             frame.retDims_[i]);
         }
         if (closure.isValid()) {
             *closure = val;
@@ -373,9 +894,16 @@ std::vector<Ref<Array>> Driver::collectReturns() {
         }
     }
 
+    // Write non-contiguous views back to the Arrays they view
+    for (auto &&arg : frame.args_) {
+        if (arg.isValid()) {
+            arg->flush();
+        }
+    }
+
     // Free reference count holders
-    std::fill(args_.begin(), args_.end(), nullptr);
-    std::fill(rawArgs.begin(), rawArgs.end(), nullptr);
+    std::fill(frame.args_.begin(), frame.args_.end(), nullptr);
+    std::fill(frame.rawArgs_.begin(), frame.rawArgs_.end(), nullptr);
 
     return ret;
 }
@@ -440,14 +968,284 @@ std::pair<double, double> Driver::time(int rounds, int warmups) {
     return std::make_pair(avg, sqrt(varAvgX));
 }
 
-void Driver::unload() {
-    func_ = nullptr;
-    if (dlHandle_) {
-        auto err = dlclose(dlHandle_);
-        if (err) {
-            WARNING("Unable to unload target code");
+BenchmarkResult Driver::benchmark(const BenchmarkOptions &options) {
+#ifdef FT_WITH_CUDA
+    if (dev_->type() == TargetType::GPU) {
+        checkCudaError(cudaSetDevice(dev_->num()));
+    }
+#endif // FT_WITH_CUDA
+    std::optional<PerfCounters> counters;
+    if (options.perfCounters_) {
+        if (dev_->type() != TargetType::CPU) {
+            throw DriverError(
+                "Performance counters are only supported on CPU");
         }
+        // The same team size as `run` will use, so the same threads are
+        // counted
+        counters.emplace(resolvedNumThreads_ > 0 ? resolvedNumThreads_
+                                                 : omp_get_max_threads());
+    }
+    return freetensor::benchmark([this]() { run(); }, dev_, options,
+                                 counters.has_value() ? &*counters : nullptr);
+}
+
+RooflineReport Driver::roofline(const BenchmarkOptions &options) {
+    if (dev_->type() != TargetType::CPU) {
+        throw DriverError("Roofline analysis is only supported on CPU");
+    }
+    if (profileSize_ == nullptr || profileIds_ == nullptr) {
+        throw DriverError("The program is not instrumented for profiling. "
+                          "Please set `profile` in codegen");
+    }
+
+    RooflineReport report;
+    report.peak_ = machinePeak(dev_, resolvedNumThreads_);
+
+    // Warm up before resetting the profile, so the profile covers exactly the
+    // measured runs
+    for (int i = 0; i < options.warmups_; i++) {
+        run();
+    }
+    resetProfile();
+    auto measureOptions = options;
+    measureOptions.warmups_ = 0;
+    report.benchmark_ = benchmark(measureOptions);
+    auto rounds = report.benchmark_.times_.size();
+
+    auto features = structuralFeature(f_->body_);
+    report.total_ = analyzeRoofline(features.at(f_->body_->id()),
+                                    report.benchmark_.mean_, report.peak_);
+    for (auto &&item : profile()) {
+        auto it = features.find(item.id_);
+        if (it == features.end()) {
+            throw DriverError("Statement " + toString(item.id_) +
+                              " is instrumented but not found in the AST");
+        }
+        auto &&entry = report.nests_.emplace_back(
+            analyzeRoofline(it->second, item.time_ / rounds, report.peak_));
+        entry.id_ = item.id_;
+        entry.metadata_ = item.metadata_;
+    }
+    return report;
+}
+
+/**
+ * Split CPUs in `within`, or the ones available to the process if it is not
+ * set, into `n` disjoint subsets of contiguous CPU IDs. Fewer subsets are
+ * returned if there are not enough CPUs
+ */
+static std::vector<cpu_set_t>
+splitCPUs(size_t n, const std::optional<cpu_set_t> &within) {
+    cpu_set_t all;
+    CPU_ZERO(&all);
+    std::vector<int> cpus;
+    if (within.has_value()) {
+        all = *within;
+    } else if (sched_getaffinity(0, sizeof(all), &all) != 0) {
+        CPU_ZERO(&all);
     }
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &all)) {
+            cpus.emplace_back(i);
+        }
+    }
+    n = std::max<size_t>(1, std::min(n, cpus.size()));
+    std::vector<cpu_set_t> ret(n);
+    for (size_t i = 0; i < n; i++) {
+        CPU_ZERO(&ret[i]);
+        for (size_t j = cpus.size() * i / n, jEnd = cpus.size() * (i + 1) / n;
+             j < jEnd; j++) {
+            CPU_SET(cpus[j], &ret[i]);
+        }
+    }
+    return ret;
+}
+
+BatchResult
+Driver::runBatch(const std::vector<std::vector<Ref<Array>>> &argSets,
+                 size_t parallelism) {
+    namespace ch = std::chrono;
+
+    std::optional<FirstTouchGuard> firstTouch;
+    firstTouch.emplace(dev_, hostDev_, cpuAffinity_, resolvedNumThreads_);
+
+    // Resolve the signature once for all invocations
+    std::vector<size_t> slots; // Positional argument -> parameter
+    std::vector<void *> closureArgs(f_->params_.size(), nullptr);
+    for (auto &&[i, param] : views::enumerate(f_->params_)) {
+        if (param.isInClosure() && !param.updateClosure_) {
+            if (!param.closure_->isValid()) {
+                throw DriverError("Closure variable " + param.name_ +
+                                  " is not set");
+            }
+            auto &&buffer = name2buffer_.at(param.name_);
+            closureArgs[i] = requestPtr(*param.closure_, dev_, hostDev_,
+                                        buffer->mtype(), buffer->atype());
+        } else {
+            slots.emplace_back(i);
+        }
+    }
+
+    size_t n = argSets.size(), nRets = f_->returns_.size();
+    std::vector<std::vector<void *>> rawArgSets(n, closureArgs);
+    std::vector<std::vector<void *>> rawRetSets(
+        n, std::vector<void *>(nRets, nullptr));
+    std::vector<std::vector<size_t *>> retShapeSets(
+        n, std::vector<size_t *>(nRets, nullptr));
+    std::vector<std::vector<size_t>> retDimSets(n,
+                                                std::vector<size_t>(nRets, 0));
+
+    // Request all the pointers before running, because an `Array` may be
+    // shared by multiple invocations and it is not thread-safe. Each
+    // invocation holds its `Array`s like a frame
+    std::vector<HeldArray> held;
+    for (size_t k = 0; k < n; k++) {
+        auto &&args = argSets[k];
+        if (args.size() != slots.size()) {
+            throw DriverError(std::to_string(slots.size()) +
+                              " arguments are required, but " +
+                              std::to_string(args.size()) +
+                              " are given in the " + std::to_string(k) +
+                              "-th invocation");
+        }
+        for (auto &&[arg, slot] : views::zip(args, slots)) {
+            auto &&name = f_->params_[slot].name_;
+            auto &&buffer = name2buffer_.at(name);
+            if (buffer->tensor()->dtype() != arg->dtype()) {
+                throw DriverError("Cannnot pass a " + toString(arg->dtype()) +
+                                  " Array to the " + std::to_string(slot) +
+                                  "-th parameter " + name + " of type " +
+                                  toString(buffer->tensor()->dtype()) +
+                                  " in the " + std::to_string(k) +
+                                  "-th invocation");
+            }
+            held.emplace_back(arg);
+            rawArgSets[k][slot] = requestPtr(arg, dev_, hostDev_,
+                                             buffer->mtype(), buffer->atype());
+        }
+    }
+    firstTouch.reset();
+
+    BatchResult result;
+    result.latencies_.resize(n);
+    auto invoke = [&](size_t k, Context *ctx) {
+        auto begin = ch::steady_clock::now();
+        (paramsAligned(rawArgSets[k]) ? func_ : funcUnaligned_)(
+            rawArgSets[k].data(), rawRetSets[k].data(), retShapeSets[k].data(),
+            retDimSets[k].data(), ctx);
+        if (dev_->type() != TargetType::CPU) {
+            dev_->sync();
+        }
+        result.latencies_[k] =
+            ch::duration<double, std::milli>(ch::steady_clock::now() - begin)
+                .count();
+    };
+
+    if (parallelism <= 1 || n <= 1) {
+#ifdef FT_WITH_CUDA
+        if (dev_->type() == TargetType::GPU) {
+            checkCudaError(cudaSetDevice(dev_->num()));
+        }
+#endif // FT_WITH_CUDA
+        auto ctx = newContext();
+        std::optional<OpenMPBindingGuard> binding;
+        if (dev_->type() == TargetType::CPU) {
+            binding.emplace(cpuAffinity_,
+                            static_cast<CPUContext &>(*ctx).numThreads());
+        }
+        for (size_t k = 0; k < n; k++) {
+            invoke(k, ctx.get());
+        }
+    } else {
+        if (dev_->type() != TargetType::CPU) {
+            throw DriverError(
+                "Parallel batched execution is only supported on CPU");
+        }
+
+        // Each lane is a thread with its own OpenMP thread pool, bound to a
+        // disjoint subset of CPUs, which will be inherited by its OpenMP
+        // threads. Each lane also has its own context, for its own stack
+        auto cpuSets = splitCPUs(std::min(parallelism, n), cpuAffinity_);
+        size_t nLanes = cpuSets.size();
+        int nThreads = std::max<int>(
+            1, (resolvedNumThreads_ > 0 ? resolvedNumThreads_
+                                        : omp_get_max_threads()) /
+                   nLanes);
+        std::atomic<size_t> next = 0;
+        std::vector<std::exception_ptr> errors(nLanes);
+        std::vector<std::thread> lanes;
+        lanes.reserve(nLanes);
+        for (size_t l = 0; l < nLanes; l++) {
+            lanes.emplace_back([&, l]() {
+                try {
+                    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                           &cpuSets[l]);
+                    auto ctx = newContext();
+                    static_cast<CPUContext &>(*ctx).setNumThreads(
+                        std::min(nThreads, CPU_COUNT(&cpuSets[l])));
+                    for (size_t k; (k = next++) < n;) {
+                        invoke(k, ctx.get());
+                    }
+                } catch (...) {
+                    errors[l] = std::current_exception();
+                }
+            });
+        }
+        for (auto &&lane : lanes) {
+            lane.join();
+        }
+        for (auto &&error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // Write non-contiguous views back to the Arrays they view
+    for (auto &&args : argSets) {
+        for (auto &&arg : args) {
+            arg->flush();
+        }
+    }
+
+    result.returns_.reserve(n);
+    for (size_t k = 0; k < n; k++) {
+        auto &&ret = result.returns_.emplace_back();
+        for (auto &&[i, r] : views::enumerate(f_->returns_)) {
+            Ref<Array> val;
+            if (name2param_.count(r.name_)) {
+                // Returning an argument
+                auto param = name2param_.at(r.name_);
+                auto it = std::find(slots.begin(), slots.end(), param);
+                val = it != slots.end() ? argSets[k][it - slots.begin()]
+                                        : *f_->params_[param].closure_;
+            } else {
+                val = moveReturn(i, rawRetSets[k][i], retShapeSets[k][i],
+                                 retDimSets[k][i]);
+            }
+            if (!r.isInClosure() || r.returnClosure_) {
+                ret.emplace_back(val);
+            }
+        }
+    }
+    return result;
+}
+
+std::shared_future<Ref<Driver>>
+buildDriverAsync(const Func &func, const std::string &src,
+                 const Ref<Device> &device, const Ref<Device> &hostDevice,
+                 bool verbose) {
+    auto task = std::make_shared<std::packaged_task<Ref<Driver>()>>([=]() {
+        return Ref<Driver>::make(func, src, device, hostDevice, verbose);
+    });
+    auto ret = task->get_future().share();
+    BuildQueue::instance().submit([task]() { (*task)(); });
+    return ret;
+}
+
+void Driver::unload() {
+    func_ = funcUnaligned_ = nullptr;
+    kernel_ = nullptr; // Unloaded if no other Driver is sharing it
 }
 
 } // namespace freetensor
@@ -1,8 +1,18 @@
+#include <algorithm>
+#include <bit>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>    // open
+#include <new>        // bad_alloc
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
 
 #include <config.h>
 #include <debug.h>
 #include <driver/array.h>
+#include <driver/cpu_memory_pool.h>
+#include <driver/numa.h>
 #include <except.h>
 #ifdef FT_WITH_CUDA
 #include <driver/gpu.h>
@@ -10,41 +20,102 @@
 
 namespace freetensor {
 
-static uint8_t *allocOn(size_t size, const Ref<Device> &device) {
-    uint8_t *ptr = nullptr;
+#ifdef FT_WITH_CUDA
+constexpr size_t CUDA_MALLOC_ALIGNMENT = 256;
+#endif // FT_WITH_CUDA
+
+static size_t alignmentOf(const void *ptr) {
+    auto addr = (uintptr_t)ptr;
+    return addr == 0 ? 0 : (size_t)1 << std::countr_zero(addr);
+}
+
+/**
+ * Map fresh pages of at least `size` bytes, aligned to `align` bytes, which is
+ * a multiple of the page size
+ *
+ * @return : (address, mapped length)
+ */
+static std::pair<uint8_t *, size_t> mapPages(size_t size, size_t align) {
+    size_t bytes = (size + align - 1) / align * align;
+    // mmap only aligns to a base page
+    size_t extra = align - systemPageSize();
+    auto base = (uint8_t *)mmap(nullptr, bytes + extra, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    auto ptr = (uint8_t *)(((uintptr_t)base + align - 1) / align * align);
+    if (ptr > base) {
+        munmap(base, ptr - base);
+    }
+    if (auto tail = base + bytes + extra - (ptr + bytes); tail > 0) {
+        munmap(ptr + bytes, tail);
+    }
+    return {ptr, bytes};
+}
+
+static ArrayCopy allocOn(size_t size, const Ref<Device> &device) {
     switch (device->type()) {
-    case TargetType::CPU:
-        ptr = new uint8_t[size];
-        break;
+    case TargetType::CPU: {
+        auto policy = device->numaPolicy();
+        bool huge = Config::arrayHugePages() && size >= Array::HUGE_PAGE_SIZE;
+        if (policy == NUMAPolicy::Default && !huge) {
+            return ArrayCopy(device,
+                             (uint8_t *)CPUMemoryPool::instance().alloc(size),
+                             false, Array::ALIGNMENT);
+        }
+        // Pages not shared with other allocations, so they can be aligned to
+        // huge pages, and placed on their own. They are not touched here,
+        // which would decide their placement
+        size_t align = huge ? std::max(Array::HUGE_PAGE_SIZE, systemPageSize())
+                            : systemPageSize();
+        auto [ptr, bytes] = mapPages(std::max<size_t>(size, 1), align);
+        if (huge) {
+            // Only a hint. Ignore the error if THP is disabled
+            madvise(ptr, bytes, MADV_HUGEPAGE);
+        }
+        numaApplyPolicy(ptr, bytes, policy, device->numaNode());
+        ArrayCopy ret(device, ptr, false, align);
+        ret.mappedBytes_ = bytes;
+        if (policy == NUMAPolicy::Bind) {
+            ret.numaNode_ = device->numaNode();
+        }
+        return ret;
+    }
 #ifdef FT_WITH_CUDA
-    case TargetType::GPU:
+    case TargetType::GPU: {
+        uint8_t *ptr = nullptr;
         checkCudaError(cudaMalloc(&ptr, size));
-        break;
+        return ArrayCopy(device, ptr, false, CUDA_MALLOC_ALIGNMENT);
+    }
 #endif // FT_WITH_CUDA
     default:
         ASSERT(false);
     }
-    return ptr;
 }
 
-static void freeFrom(uint8_t *&ptr, const Ref<Device> &device) {
-    if (ptr != nullptr) {
-        switch (device->type()) {
+static void freeFrom(ArrayCopy &copy) {
+    if (copy.ptr_ != nullptr && !copy.borrowed_) {
+        switch (copy.device_->type()) {
         case TargetType::CPU:
-            delete[] ptr;
-            ptr = nullptr;
+            if (copy.mappedBytes_ > 0) {
+                // A mapped file may start in the middle of a page
+                auto base = (uintptr_t)copy.ptr_ & ~(systemPageSize() - 1);
+                munmap((void *)base, copy.mappedBytes_);
+            } else {
+                CPUMemoryPool::instance().free(copy.ptr_);
+            }
             break;
 #ifdef FT_WITH_CUDA
         case TargetType::GPU:
-            cudaFree(ptr);
-            ptr = nullptr;
+            cudaFree(copy.ptr_);
             break;
 #endif // FT_WITH_CUDA
         default:;
             // Do nothing. We can't throw error in a destructor
         }
-        ptr = nullptr;
     }
+    copy.ptr_ = nullptr;
 }
 
 static void copyFromCPU(void *dst /* Any device */, const void *src /* CPU */,
@@ -53,7 +124,7 @@ static void copyFromCPU(void *dst /* Any device */, const void *src /* CPU */,
     ASSERT(src != nullptr);
     switch (device->type()) {
     case TargetType::CPU:
-        memcpy(dst, src, size);
+        parallelMemcpy(dst, src, size);
         break;
 #ifdef FT_WITH_CUDA
     case TargetType::GPU:
@@ -65,17 +136,22 @@ static void copyFromCPU(void *dst /* Any device */, const void *src /* CPU */,
     }
 }
 
-static void copyToCPU(void *dst /* CPU */, const void *src /* Any device */,
-                      size_t size, const Ref<Device> &device) {
-    ASSERT(dst != nullptr);
-    ASSERT(src != nullptr);
-    switch (device->type()) {
+static void copyToCPU(const ArrayCopy &dst /* CPU */,
+                      const ArrayCopy &src /* Any device */, size_t size) {
+    ASSERT(dst.ptr_ != nullptr);
+    ASSERT(src.ptr_ != nullptr);
+    switch (src.device_->type()) {
     case TargetType::CPU:
-        memcpy(dst, src, size);
+        parallelMemcpy(dst.ptr_, src.ptr_, size);
         break;
 #ifdef FT_WITH_CUDA
     case TargetType::GPU:
-        checkCudaError(cudaMemcpy(dst, src, size, cudaMemcpyDefault));
+        if (dst.device_->numaPolicy() == NUMAPolicy::FirstTouch) {
+            // Place the pages before they are touched by cudaMemcpy in one
+            // thread
+            parallelMemset0(dst.ptr_, size);
+        }
+        checkCudaError(cudaMemcpy(dst.ptr_, src.ptr_, size, cudaMemcpyDefault));
         break;
 #endif // FT_WITH_CUDA
     default:
@@ -83,40 +159,262 @@ static void copyToCPU(void *dst /* CPU */, const void *src /* Any device */,
     }
 }
 
+/**
+ * Copy between a contiguous buffer and a strided view of another buffer on CPU
+ *
+ * @param view : Address of the first element of the view
+ * @param strides : Strides of the view, in elements
+ * @param scatter : If true, copy from `packed` to `view`. Otherwise, from
+ * `view` to `packed`
+ */
+static void stridedCopy(uint8_t *packed, uint8_t *view,
+                        const std::vector<size_t> &shape,
+                        const std::vector<size_t> &strides, size_t elemBytes,
+                        bool scatter) {
+    size_t n = shape.size();
+    // Copy the innermost dimension in one `memcpy` if it is contiguous
+    size_t run = elemBytes;
+    size_t outer = n;
+    if (n > 0 && strides[n - 1] == 1) {
+        run *= shape[n - 1];
+        outer = n - 1;
+    }
+    size_t total = 1;
+    for (size_t i = 0; i < n; i++) {
+        total *= shape[i];
+    }
+    if (total == 0) {
+        return;
+    }
+    std::vector<size_t> idx(outer, 0);
+    for (size_t offset = 0, done = 0; done < total;
+         done += run / elemBytes, packed += run) {
+        auto ptr = view + offset * elemBytes;
+        if (scatter) {
+            memcpy(ptr, packed, run);
+        } else {
+            memcpy(packed, ptr, run);
+        }
+        // Advance the index like an odometer
+        for (size_t i = outer; i-- > 0;) {
+            offset += strides[i];
+            if (++idx[i] < shape[i]) {
+                break;
+            }
+            offset -= strides[i] * shape[i];
+            idx[i] = 0;
+        }
+    }
+}
+
 Array::Array(const std::vector<size_t> &shape, DataType dtype)
     : shape_(shape), dtype_(dtype) {
     nElem_ = 1;
     for (size_t dim : shape_) {
         nElem_ *= dim;
     }
-    size_ = nElem_ * sizeOf(dtype_);
+    size_ = storageBytes(dtype_, nElem_);
 }
 
 Array Array::moveFromRaw(void *ptr, const std::vector<size_t> &shape,
                          DataType dtype, const Ref<Device> &device) {
     Array ret(shape, dtype);
-    ret.ptrs_ = {{device, (uint8_t *)ptr, false}};
+    size_t align = Array::ALIGNMENT;
+#ifdef FT_WITH_CUDA
+    if (device->type() == TargetType::GPU) {
+        align = CUDA_MALLOC_ALIGNMENT;
+    }
+#endif // FT_WITH_CUDA
+    ret.ptrs_ = {{device, (uint8_t *)ptr, false, align}};
     return ret;
 }
 
 Array Array::borrowFromRaw(void *ptr, const std::vector<size_t> &shape,
                            DataType dtype, const Ref<Device> &device) {
     Array ret(shape, dtype);
-    ret.ptrs_ = {{device, (uint8_t *)ptr, true}};
+    ret.ptrs_ = {{device, (uint8_t *)ptr, true, alignmentOf(ptr)}};
     return ret;
 }
 
-Array::~Array() {
-    for (auto &&[device, ptr, borrowed] : ptrs_) {
-        if (!borrowed) {
-            freeFrom(ptr, device);
+Array Array::mapFile(const std::string &path,
+                     const std::vector<size_t> &shape, DataType dtype,
+                     size_t offset, bool copyOnWrite,
+                     const std::vector<MapAdvice> &advice) {
+    Array ret(shape, dtype);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw DriverError("Cannot open " + path + ": " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        auto err = errno;
+        close(fd);
+        throw DriverError("Cannot stat " + path + ": " + strerror(err));
+    }
+    if ((size_t)st.st_size < offset + ret.size_) {
+        close(fd);
+        throw DriverError(path + " has " + std::to_string(st.st_size) +
+                          " bytes, but " + std::to_string(ret.size_) +
+                          " bytes are required from offset " +
+                          std::to_string(offset));
+    }
+
+    // mmap only maps from a page boundary
+    size_t head = offset % systemPageSize();
+    size_t bytes = head + std::max<size_t>(ret.size_, 1);
+    // Copy-on-write pages are private, and the file is never written even if
+    // they are. Read-only pages are shared with the page cache, so no memory
+    // is used besides the cache
+    auto base = (uint8_t *)mmap(
+        nullptr, bytes, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ,
+        copyOnWrite ? MAP_PRIVATE : MAP_SHARED, fd, offset - head);
+    auto err = errno;
+    close(fd); // The mapping holds its own reference to the file
+    if (base == MAP_FAILED) {
+        throw DriverError("Cannot map " + path + ": " + strerror(err));
+    }
+
+    for (auto item : advice) {
+        int hint;
+        switch (item) {
+        case MapAdvice::Sequential:
+            hint = MADV_SEQUENTIAL;
+            break;
+        case MapAdvice::Random:
+            hint = MADV_RANDOM;
+            break;
+        case MapAdvice::WillNeed:
+            hint = MADV_WILLNEED;
+            break;
+        case MapAdvice::HugePage:
+            hint = MADV_HUGEPAGE;
+            break;
+        default:
+            ASSERT(false);
+        }
+        // Only hints. Ignore the error if not supported, e.g. huge pages of
+        // a file system without THP support
+        madvise(base, bytes, hint);
+    }
+
+    ArrayCopy copy(Ref<Device>::make(TargetType::CPU), base + head, false,
+                   alignmentOf(base + head));
+    copy.mappedBytes_ = bytes;
+    copy.readOnly_ = !copyOnWrite;
+    ret.ptrs_ = {std::move(copy)};
+    return ret;
+}
+
+Array Array::slice(const Ref<Array> &base,
+                   const std::vector<SliceRange> &ranges) {
+    if (base->dtype() == DataType::PackedBool) {
+        throw DriverError("Elements of packed_bool are not addressable, so a "
+                          "packed_bool Array cannot be sliced");
+    }
+    if (ranges.size() > base->shape().size()) {
+        throw DriverError("Cannot slice " + std::to_string(ranges.size()) +
+                          " dimensions of a " +
+                          std::to_string(base->shape().size()) +
+                          "-D Array");
+    }
+
+    // Strides of the base in its own base
+    auto root = base->isView() ? base->base_ : base;
+    size_t offset = base->offset_;
+    auto baseStrides = base->strides_;
+    if (!base->isView()) {
+        baseStrides.resize(base->shape().size());
+        for (size_t i = baseStrides.size(), s = 1; i-- > 0;) {
+            baseStrides[i] = s;
+            s *= base->shape()[i];
+        }
+    }
+
+    std::vector<size_t> shape, strides;
+    for (size_t i = 0, n = base->shape().size(); i < n; i++) {
+        size_t dim = base->shape()[i];
+        if (i >= ranges.size()) {
+            shape.emplace_back(dim);
+            strides.emplace_back(baseStrides[i]);
+            continue;
+        }
+        auto &&r = ranges[i];
+        size_t len = r.keepDim_ ? r.len_ : 1;
+        if (len > 0 && (r.step_ == 0 || r.begin_ >= dim ||
+                        (len - 1) * r.step_ >= dim - r.begin_)) {
+            throw DriverError("Slice out of range in dimension " +
+                              std::to_string(i) + " of length " +
+                              std::to_string(dim));
+        }
+        if (len > 0) {
+            offset += r.begin_ * baseStrides[i];
+        }
+        if (r.keepDim_) {
+            shape.emplace_back(len);
+            strides.emplace_back(baseStrides[i] * r.step_);
+        }
+    }
+
+    Array ret(shape, base->dtype());
+    ret.base_ = root;
+    ret.offset_ = offset;
+    ret.strides_ = strides;
+    // Dimensions of length 1 do not break contiguity
+    for (size_t i = shape.size(), s = 1; i-- > 0;) {
+        if (shape[i] != 1 && strides[i] != s) {
+            ret.contiguous_ = false;
+            break;
+        }
+        s *= shape[i];
+    }
+    return ret;
+}
+
+Array Array::packBools(const bool *data, const std::vector<size_t> &shape) {
+    Array ret(shape, DataType::PackedBool);
+    auto copy = allocOn(ret.size_, Ref<Device>::make(TargetType::CPU));
+    auto words = (uint64_t *)copy.ptr_;
+    parallelMemset0(words, ret.size_);
+    if (shape.empty()) {
+        // Scalars are stored like `Bool`
+        *(bool *)words = data[0];
+    } else {
+        for (size_t i = 0; i < ret.nElem_; i++) {
+            words[i / 64] |= (uint64_t)data[i] << (i % 64);
+        }
+    }
+    ret.ptrs_ = {std::move(copy)};
+    return ret;
+}
+
+void Array::unpackBools(bool *data) {
+    if (dtype_ != DataType::PackedBool) {
+        throw DriverError("Cannot unpack an Array of " + toString(dtype_));
+    }
+    auto words =
+        (const uint64_t *)rawSharedTo(Ref<Device>::make(TargetType::CPU));
+    if (shape_.empty()) {
+        data[0] = *(const bool *)words;
+    } else {
+        for (size_t i = 0; i < nElem_; i++) {
+            data[i] = (words[i / 64] >> (i % 64)) & 1;
         }
     }
 }
 
+Array::~Array() {
+    for (auto &&copy : ptrs_) {
+        freeFrom(copy);
+    }
+}
+
 Array::Array(Array &&other)
     : ptrs_(std::move(other.ptrs_)), size_(other.size_), nElem_(other.nElem_),
-      shape_(std::move(other.shape_)), dtype_(other.dtype_) {
+      shape_(std::move(other.shape_)), dtype_(other.dtype_),
+      base_(std::move(other.base_)), offset_(other.offset_),
+      strides_(std::move(other.strides_)), contiguous_(other.contiguous_),
+      dirty_(other.dirty_), version_(other.version_),
+      gatheredVersion_(other.gatheredVersion_), holders_(other.holders_) {
     other.ptrs_.clear(); // MUST!
     other.size_ = 0;
 }
@@ -126,104 +424,299 @@ Array &Array::operator=(Array &&other) {
     size_ = other.size_;
     nElem_ = other.nElem_;
     dtype_ = other.dtype_;
+    base_ = std::move(other.base_);
+    offset_ = other.offset_;
+    strides_ = std::move(other.strides_);
+    contiguous_ = other.contiguous_;
+    dirty_ = other.dirty_;
+    version_ = other.version_;
+    gatheredVersion_ = other.gatheredVersion_;
+    holders_ = other.holders_;
     other.ptrs_.clear(); // MUST!
     other.size_ = 0;
     return *this;
 }
 
+void Array::gather() {
+    if (!ptrs_.empty() && holders_ > 1) {
+        throw DriverError(
+            "A non-contiguous view of an Array is bound to multiple frames, "
+            "and the Array it views is written in between. Gathering the view "
+            "again would free the data still used by the other frames. Please "
+            "collect the returns of the other frames first, or make a copy of "
+            "the view");
+    }
+    auto cpu = Ref<Device>::make(TargetType::CPU);
+    auto src = (uint8_t *)base_->rawSharedTo(cpu);
+    auto copy = allocOn(size_, cpu);
+    size_t elemBytes = sizeOf(dtype_);
+    stridedCopy(copy.ptr_, src + offset_ * elemBytes, shape_, strides_,
+                elemBytes, false);
+    for (auto &&other : ptrs_) {
+        freeFrom(other);
+    }
+    ptrs_ = {std::move(copy)};
+    gatheredVersion_ = base_->version_;
+}
+
+bool Array::gatherNeeded() const {
+    return !dirty_ && (ptrs_.empty() || gatheredVersion_ != base_->version_);
+}
+
+void Array::flush() {
+    if (!dirty_) {
+        return;
+    }
+    auto cpu = Ref<Device>::make(TargetType::CPU);
+    auto src = (uint8_t *)copySharedTo(cpu);
+    auto dst = (uint8_t *)base_->rawMovedTo(cpu);
+    size_t elemBytes = sizeOf(dtype_);
+    stridedCopy(src, dst + offset_ * elemBytes, shape_, strides_, elemBytes,
+                true);
+    // The view is the same as the base now. Keep it for later reads, and don't
+    // free it, which may still be held by other frames
+    gatheredVersion_ = base_->version_;
+    dirty_ = false;
+}
+
 void *Array::rawSharedTo(const Ref<Device> &device) {
-    for (auto &&[d, p, _] : ptrs_) {
-        if (*d == *device) {
-            return p;
+    if (isView()) {
+        if (contiguous_) {
+            return (uint8_t *)base_->rawSharedTo(device) +
+                   offset_ * sizeOf(dtype_);
+        }
+        if (gatherNeeded()) {
+            gather();
+        }
+    }
+    return copySharedTo(device);
+}
+
+void *Array::rawMovedTo(const Ref<Device> &device) {
+    version_++;
+    if (isView()) {
+        if (contiguous_) {
+            return (uint8_t *)base_->rawMovedTo(device) +
+                   offset_ * sizeOf(dtype_);
+        }
+        if (base_->readOnlyOn(Ref<Device>::make(TargetType::CPU))) {
+            throw DriverError(
+                "Cannot write to a view of an Array mapped read-only");
+        }
+        if (gatherNeeded()) {
+            gather();
+        }
+        dirty_ = true;
+    }
+    return copyMovedTo(device);
+}
+
+void *Array::rawInitTo(const Ref<Device> &device) {
+    version_++;
+    if (isView()) {
+        if (contiguous_) {
+            // Keep the elements out of the view
+            return (uint8_t *)base_->rawMovedTo(device) +
+                   offset_ * sizeOf(dtype_);
+        }
+        if (base_->readOnlyOn(Ref<Device>::make(TargetType::CPU))) {
+            throw DriverError(
+                "Cannot write to a view of an Array mapped read-only");
+        }
+        dirty_ = true;
+    }
+    return copyInitTo(device);
+}
+
+void *Array::copySharedTo(const Ref<Device> &device) {
+    for (auto &&copy : ptrs_) {
+        if (*copy.device_ == *device) {
+            return copy.ptr_;
         }
     }
-    auto ptr = allocOn(size_, device);
+    auto copy = allocOn(size_, device);
     if (device->type() == TargetType::CPU) {
-        for (auto &&[d, p, _] : ptrs_) {
-            copyToCPU(ptr, p, size_, d);
+        for (auto &&src : ptrs_) {
+            copyToCPU(copy, src, size_);
             goto done;
         }
     } else {
-        for (auto &&[d, p, _] : ptrs_) {
-            if (d->type() == TargetType::CPU) {
-                copyFromCPU(ptr, p, size_, device);
+        for (auto &&src : ptrs_) {
+            if (src.device_->type() == TargetType::CPU) {
+                copyFromCPU(copy.ptr_, src.ptr_, size_, device);
                 goto done;
             }
         }
-        copyFromCPU(ptr, rawSharedTo(Ref<Device>::make(TargetType::CPU)), size_,
+        copyFromCPU(copy.ptr_,
+                    copySharedTo(Ref<Device>::make(TargetType::CPU)), size_,
                     device);
     }
 done:
-    ptrs_.emplace_back(device, ptr, false);
-    return ptr;
+    ptrs_.emplace_back(std::move(copy));
+    return ptrs_.back().ptr_;
 }
 
-void *Array::rawMovedTo(const Ref<Device> &device) {
-    for (auto [d, p, borrowed] : ptrs_) {
-        if (*d == *device) {
-            for (auto &&[_d, _p, _borrowed] : ptrs_) {
-                if (_p != p && !_borrowed) {
-                    freeFrom(_p, _d);
+void *Array::copyMovedTo(const Ref<Device> &device) {
+    for (auto &&copy : ptrs_) {
+        if (*copy.device_ == *device) {
+            if (copy.readOnly_) {
+                throw DriverError(
+                    "Cannot write to an Array mapped read-only from a file. "
+                    "Map it copy-on-write instead");
+            }
+            auto kept = std::move(copy);
+            for (auto &&other : ptrs_) {
+                if (other.ptr_ != kept.ptr_) {
+                    freeFrom(other);
                 }
             }
-            ptrs_ = {{d, p, borrowed}};
-            return p;
+            ptrs_ = {std::move(kept)};
+            return ptrs_.front().ptr_;
         }
     }
-    auto ptr = allocOn(size_, device);
+    auto copy = allocOn(size_, device);
     if (device->type() == TargetType::CPU) {
-        for (auto &&[d, p, _] : ptrs_) {
-            copyToCPU(ptr, p, size_, d);
+        for (auto &&src : ptrs_) {
+            copyToCPU(copy, src, size_);
             goto done;
         }
     } else {
-        for (auto &&[d, p, _] : ptrs_) {
-            if (d->type() == TargetType::CPU) {
-                copyFromCPU(ptr, p, size_, device);
+        for (auto &&src : ptrs_) {
+            if (src.device_->type() == TargetType::CPU) {
+                copyFromCPU(copy.ptr_, src.ptr_, size_, device);
                 goto done;
             }
         }
-        copyFromCPU(ptr, rawSharedTo(Ref<Device>::make(TargetType::CPU)), size_,
+        copyFromCPU(copy.ptr_,
+                    copySharedTo(Ref<Device>::make(TargetType::CPU)), size_,
                     device);
     }
 done:
-    for (auto &&[d, p, borrowed] : ptrs_) {
-        if (!borrowed) {
-            freeFrom(p, d);
-        }
+    for (auto &&other : ptrs_) {
+        freeFrom(other);
     }
-    ptrs_ = {{device, ptr, false}};
-    return ptr;
+    ptrs_ = {std::move(copy)};
+    return ptrs_.front().ptr_;
 }
 
-void *Array::rawInitTo(const Ref<Device> &device) {
-    for (auto [d, p, borrowed] : ptrs_) {
-        if (*d == *device) {
-            for (auto &&[_d, _p, _borrowed] : ptrs_) {
-                if (_p != p && !_borrowed) {
-                    freeFrom(_p, _d);
+void *Array::copyInitTo(const Ref<Device> &device) {
+    for (auto &&copy : ptrs_) {
+        if (*copy.device_ == *device) {
+            if (copy.readOnly_) {
+                throw DriverError(
+                    "Cannot write to an Array mapped read-only from a file. "
+                    "Map it copy-on-write instead");
+            }
+            auto kept = std::move(copy);
+            for (auto &&other : ptrs_) {
+                if (other.ptr_ != kept.ptr_) {
+                    freeFrom(other);
                 }
             }
-            ptrs_ = {{d, p, borrowed}};
-            return p;
+            ptrs_ = {std::move(kept)};
+            return ptrs_.front().ptr_;
         }
     }
-    auto ptr = allocOn(size_, device);
-    for (auto &&[d, p, borrowed] : ptrs_) {
-        if (!borrowed) {
-            freeFrom(p, d);
+    auto copy = allocOn(size_, device);
+    for (auto &&other : ptrs_) {
+        freeFrom(other);
+    }
+    ptrs_ = {std::move(copy)};
+    return ptrs_.front().ptr_;
+}
+
+size_t Array::alignmentOn(const Ref<Device> &device) const {
+    if (isView() && contiguous_) {
+        size_t align = base_->alignmentOn(device);
+        size_t offset = offset_ * sizeOf(dtype_);
+        // Lowest set bit of both
+        return align == 0 ? 0 : alignmentOf((void *)(align | offset));
+    }
+    for (auto &&copy : ptrs_) {
+        if (*copy.device_ == *device) {
+            return copy.align_;
         }
     }
-    ptrs_ = {{device, ptr, false}};
-    return ptr;
+    return 0;
+}
+
+int Array::numaNodeOn(const Ref<Device> &device) const {
+    if (isView() && contiguous_) {
+        return base_->numaNodeOn(device);
+    }
+    for (auto &&copy : ptrs_) {
+        if (*copy.device_ == *device) {
+            return copy.numaNode_;
+        }
+    }
+    return -1;
+}
+
+int Array::residentNodeOn(const Ref<Device> &device, size_t offset) const {
+    if (isView() && contiguous_) {
+        return base_->residentNodeOn(device, offset_ * sizeOf(dtype_) + offset);
+    }
+    if (device->type() != TargetType::CPU || offset >= size_) {
+        return -1;
+    }
+    for (auto &&copy : ptrs_) {
+        if (*copy.device_ == *device) {
+            return numaNodeOfAddress(copy.ptr_ + offset);
+        }
+    }
+    return -1;
+}
+
+bool Array::readOnlyOn(const Ref<Device> &device) const {
+    if (isView()) {
+        // Non-contiguous views are written back to the base on CPU
+        return base_->readOnlyOn(
+            contiguous_ ? device : Ref<Device>::make(TargetType::CPU));
+    }
+    for (auto &&copy : ptrs_) {
+        if (*copy.device_ == *device) {
+            return copy.readOnly_;
+        }
+    }
+    return false;
+}
+
+void Array::placeOn(const Ref<Device> &device) {
+    if (device->type() != TargetType::CPU) {
+        throw DriverError("Only Arrays on CPU can be placed among NUMA nodes");
+    }
+    if (isView()) {
+        throw DriverError("A view of an Array cannot be placed on its own. "
+                          "Please place the Array it views instead");
+    }
+    auto copy = allocOn(size_, device);
+    // Prefer copying from CPU, or there will be an extra copy
+    auto src = std::find_if(ptrs_.begin(), ptrs_.end(), [](auto &&c) {
+        return c.device_->type() == TargetType::CPU;
+    });
+    if (src == ptrs_.end()) {
+        src = ptrs_.begin();
+    }
+    if (src != ptrs_.end()) {
+        copyToCPU(copy, *src, size_);
+    }
+    for (auto &&other : ptrs_) {
+        freeFrom(other);
+    }
+    ptrs_ = {std::move(copy)};
 }
 
 void Array::makePrivateCopy() {
+    if (isView()) {
+        // Copies of a non-contiguous view are always private
+        base_->makePrivateCopy();
+        return;
+    }
     std::vector<ArrayCopy> newPtrs;
     newPtrs.reserve(ptrs_.size());
-    for (auto &&[d, p, borrowed] : ptrs_) {
-        if (!borrowed) {
-            newPtrs.emplace_back(d, p, borrowed);
+    for (auto &&copy : ptrs_) {
+        if (!copy.borrowed_) {
+            newPtrs.emplace_back(copy);
         }
     }
     if (!newPtrs.empty()) {
@@ -231,11 +724,10 @@ void Array::makePrivateCopy() {
         return;
     }
 
-    for (auto &&[d, p, _] : ptrs_) {
-        auto dev = Ref<Device>::make(TargetType::CPU);
-        auto ptr = allocOn(size_, dev);
-        copyToCPU(ptr, p, size_, d);
-        ptrs_ = {{dev, ptr, false}};
+    for (auto &&src : ptrs_) {
+        auto copy = allocOn(size_, Ref<Device>::make(TargetType::CPU));
+        copyToCPU(copy, src, size_);
+        ptrs_ = {std::move(copy)};
         return;
     }
 }
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring> // memset
+#include <unistd.h> // sysconf
+
+#include <driver/benchmark.h>
+#include <except.h>
+#ifdef FT_WITH_CUDA
+#include <driver/gpu.h>
+#endif
+
+namespace freetensor {
+
+/**
+ * 97.5% quantile of Student's t-distribution, for 95% two-sided confidence
+ * intervals
+ */
+static double tQuantile975(size_t df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+        2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+        2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+        2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+    constexpr size_t n = sizeof(table) / sizeof(table[0]);
+    ASSERT(df >= 1);
+    return df <= n ? table[df - 1] : 1.960;
+}
+
+static double percentileOfSorted(const std::vector<double> &sorted,
+                                 double q) {
+    ASSERT(!sorted.empty());
+    double pos = std::clamp(q, 0., 100.) / 100 * (sorted.size() - 1);
+    size_t lo = std::floor(pos), hi = std::ceil(pos);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+double BenchmarkResult::percentile(double q) const {
+    if (times_.empty()) {
+        throw DriverError("No time is measured");
+    }
+    auto sorted = times_;
+    std::sort(sorted.begin(), sorted.end());
+    return percentileOfSorted(sorted, q);
+}
+
+static void summarize(BenchmarkResult &result, bool rejectOutliers) {
+    auto sorted = result.times_;
+    std::sort(sorted.begin(), sorted.end());
+    result.min_ = sorted.front();
+    result.max_ = sorted.back();
+    result.median_ = percentileOfSorted(sorted, 50);
+
+    auto end = sorted.end();
+    if (rejectOutliers && sorted.size() >= 3) {
+        std::vector<double> deviations;
+        deviations.reserve(sorted.size());
+        for (double t : sorted) {
+            deviations.emplace_back(std::abs(t - result.median_));
+        }
+        std::sort(deviations.begin(), deviations.end());
+        // Scaled to be consistent with the standard deviation of a normal
+        // distribution
+        double mad = percentileOfSorted(deviations, 50) * 1.4826;
+        if (mad > 0) {
+            end = std::upper_bound(sorted.begin(), sorted.end(),
+                                   result.median_ + 3 * mad);
+        }
+    }
+    size_t n = end - sorted.begin();
+    result.outliers_ = sorted.size() - n;
+
+    double sum = 0;
+    for (auto it = sorted.begin(); it != end; it++) {
+        sum += *it;
+    }
+    result.mean_ = sum / n;
+    result.stddev_ = 0;
+    result.relCI_ = INFINITY;
+    if (n > 1) {
+        double varX = 0;
+        for (auto it = sorted.begin(); it != end; it++) {
+            varX += (*it - result.mean_) * (*it - result.mean_);
+        }
+        varX /= n - 1; // Var[X] = n/(n-1) sigma^2
+        result.stddev_ = std::sqrt(varX / n); // Var[avg X] = 1/n Var[X]
+        result.relCI_ = result.mean_ > 0 ? tQuantile975(n - 1) *
+                                               result.stddev_ / result.mean_
+                                         : 0;
+    }
+}
+
+/**
+ * Overwrite a buffer larger than the caches
+ */
+static void flushCache(const Ref<Device> &device) {
+    switch (device->type()) {
+    case TargetType::CPU: {
+        // Private caches of every core, and the shared LLC. Write from all
+        // threads to reach the private caches of all cores
+        static std::vector<uint8_t> buffer = []() {
+            long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+            long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+            long nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+            size_t size = 2 * (std::max(l3, 0l) + std::max(l2, 0l) *
+                                                       std::max(nCPUs, 1l));
+            return std::vector<uint8_t>(
+                std::max<size_t>(size, (size_t)64 << 20));
+        }();
+        static uint8_t value = 0;
+        value++;
+        size_t n = buffer.size(), chunk = (size_t)1 << 16;
+#pragma omp parallel for
+        for (size_t i = 0; i < n; i += chunk) {
+            std::memset(&buffer[i], value, std::min(chunk, n - i));
+        }
+        break;
+    }
+#ifdef FT_WITH_CUDA
+    case TargetType::GPU: {
+        int l2 = 0;
+        checkCudaError(
+            cudaDeviceGetAttribute(&l2, cudaDevAttrL2CacheSize, device->num()));
+        if (l2 > 0) {
+            void *buffer;
+            checkCudaError(cudaMalloc(&buffer, 2 * (size_t)l2));
+            checkCudaError(cudaMemset(buffer, 0, 2 * (size_t)l2));
+            checkCudaError(cudaFree(buffer));
+        }
+        break;
+    }
+#endif // FT_WITH_CUDA
+    default:
+        ASSERT(false);
+    }
+}
+
+BenchmarkResult benchmark(const std::function<void()> &run,
+                          const Ref<Device> &device,
+                          const BenchmarkOptions &options,
+                          PerfCounters *counters) {
+    namespace ch = std::chrono;
+
+    if (options.minRounds_ < 1 || options.maxRounds_ < options.minRounds_) {
+        throw DriverError("Invalid numbers of rounds to benchmark");
+    }
+
+    for (int i = 0; i < options.warmups_; i++) {
+        run();
+        device->sync();
+    }
+
+    BenchmarkResult result;
+    result.times_.reserve(options.minRounds_);
+    if (counters != nullptr) {
+        counters->reset();
+    }
+    auto begin = ch::steady_clock::now();
+    for (int i = 0; i < options.maxRounds_; i++) {
+        if (options.flushCache_) {
+            flushCache(device);
+            device->sync();
+        }
+        // Counters are only enabled around the runs, excluding flushing the
+        // caches and summarizing the results. The system calls to enable and
+        // disable them are not timed
+        if (counters != nullptr) {
+            counters->enable();
+        }
+        auto beg = ch::steady_clock::now();
+        run();
+        device->sync();
+        auto end = ch::steady_clock::now();
+        if (counters != nullptr) {
+            counters->disable();
+        }
+        result.times_.emplace_back(
+            ch::duration<double, std::milli>(end - beg).count());
+
+        if (i + 1 >= options.minRounds_) {
+            summarize(result, options.rejectOutliers_);
+            if (options.targetRelCI_ > 0 &&
+                result.relCI_ <= options.targetRelCI_) {
+                result.converged_ = true;
+                break;
+            }
+            double elapsed =
+                ch::duration<double, std::milli>(end - begin).count();
+            if (options.timeBudget_ > 0 && elapsed >= options.timeBudget_) {
+                break;
+            }
+        }
+    }
+    if (counters != nullptr) {
+        for (auto &&[name, count] : counters->read()) {
+            result.counters_[name] = count / result.times_.size();
+        }
+    }
+    return result;
+}
+
+} // namespace freetensor
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <fstream>
+#include <optional>
+#include <string>
+
+#include <config.h>
+#include <driver/build_queue.h>
+
+namespace freetensor {
+
+/**
+ * Don't start a new compiler if the system has less memory available than
+ * this, unless no compiler is running. Optimizing a large kernel with `-O3` may
+ * take hundreds of MiBs
+ */
+constexpr size_t MIN_AVAILABLE_MEMORY = (size_t)1 << 30; // 1 GiB
+
+static std::optional<size_t> availableMemory() {
+    std::ifstream f("/proc/meminfo");
+    std::string key;
+    size_t val;
+    std::string unit;
+    while (f >> key >> val >> unit) {
+        if (key == "MemAvailable:") {
+            return val * 1024; // in kB
+        }
+    }
+    return std::nullopt;
+}
+
+static std::mutex slotLock;
+static std::condition_variable slotCv;
+static size_t slotRunning = 0;
+
+CompileJobSlot::CompileJobSlot() {
+    std::unique_lock<std::mutex> guard(slotLock);
+    while (true) {
+        if (slotRunning == 0) {
+            break;
+        }
+        if (slotRunning < Config::backendCompilerJobs()) {
+            if (auto mem = availableMemory();
+                !mem.has_value() || *mem >= MIN_AVAILABLE_MEMORY) {
+                break;
+            }
+        }
+        // Memory may be freed by other processes without notifying us, so
+        // check again after a while
+        slotCv.wait_for(guard, std::chrono::milliseconds(100));
+    }
+    slotRunning++;
+}
+
+CompileJobSlot::~CompileJobSlot() {
+    {
+        std::lock_guard<std::mutex> guard(slotLock);
+        slotRunning--;
+    }
+    slotCv.notify_one();
+}
+
+BuildQueue::~BuildQueue() {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+    for (auto &&worker : workers_) {
+        worker.join();
+    }
+}
+
+BuildQueue &BuildQueue::instance() {
+    static BuildQueue queue;
+    return queue;
+}
+
+void BuildQueue::work() {
+    std::unique_lock<std::mutex> guard(lock_);
+    while (true) {
+        idle_++;
+        cv_.wait(guard, [this]() { return stopped_ || !jobs_.empty(); });
+        idle_--;
+        if (stopped_) {
+            return; // Drop pending jobs on exit
+        }
+        auto job = std::move(jobs_.front());
+        jobs_.pop_front();
+        guard.unlock();
+        job();
+        guard.lock();
+    }
+}
+
+void BuildQueue::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        jobs_.emplace_back(std::move(job));
+        if (idle_ < jobs_.size() &&
+            workers_.size() < Config::backendCompilerJobs()) {
+            workers_.emplace_back([this]() { work(); });
+        }
+    }
+    cv_.notify_one();
+}
+
+} // namespace freetensor
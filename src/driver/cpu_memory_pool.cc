@@ -0,0 +1,216 @@
+#include <bit>
+#include <cstdlib> // aligned_alloc, free
+#include <new>     // bad_alloc
+
+#include <driver/cpu_memory_pool.h>
+
+namespace freetensor {
+
+namespace {
+
+struct BlockHeader {
+    size_t cls_;   /// Size class, or NUM_CLASSES if not pooled
+    size_t bytes_; /// Usable bytes
+};
+static_assert(sizeof(BlockHeader) <= CPUMemoryPool::ALIGNMENT);
+
+} // Anonymous namespace
+
+/**
+ * Index of the size class of a block
+ *
+ * Up to 256 bytes, there is one class every 64 bytes. Above that, each power
+ * of two `p` is followed by classes of `1.25p`, `1.5p`, `1.75p` and `2p` bytes.
+ * All sizes are multiples of the alignment
+ */
+static constexpr size_t sizeClass(size_t size) {
+    if (size <= 256) {
+        return size <= 64 ? 0 : (size - 1) / 64;
+    }
+    size_t e = std::bit_width(size - 1) - 1; // 2^e < size <= 2^(e + 1)
+    size_t p = (size_t)1 << e, step = p / 4;
+    return 4 + (e - 8) * 4 + (size - p + step - 1) / step - 1;
+}
+
+static constexpr size_t classSize(size_t cls) {
+    if (cls < 4) {
+        return (cls + 1) * 64;
+    }
+    size_t p = (size_t)1 << (8 + (cls - 4) / 4);
+    return p + ((cls - 4) % 4 + 1) * (p / 4);
+}
+
+constexpr size_t NUM_CLASSES = sizeClass(CPUMemoryPool::MAX_POOLED_SIZE) + 1;
+static_assert(classSize(NUM_CLASSES - 1) == CPUMemoryPool::MAX_POOLED_SIZE);
+
+/**
+ * Blocks cached by one thread, returned to the global pool when the thread
+ * exits
+ *
+ * The cache is registered in the pool, so other threads can read its size or
+ * drain it. `lock_` guards against them, and is uncontended otherwise
+ */
+struct CPUMemoryPoolThreadCache {
+    std::mutex lock_;
+    std::vector<std::vector<void *>> freeLists_;
+    size_t cachedBytes_ = 0;
+
+    CPUMemoryPoolThreadCache() : freeLists_(NUM_CLASSES) {
+        auto &&pool = CPUMemoryPool::instance();
+        std::lock_guard<std::mutex> guard(pool.threadCachesLock_);
+        pool.threadCaches_.insert(this);
+    }
+    ~CPUMemoryPoolThreadCache() {
+        auto &&pool = CPUMemoryPool::instance();
+        {
+            std::lock_guard<std::mutex> guard(pool.threadCachesLock_);
+            pool.threadCaches_.erase(this);
+        }
+        std::lock_guard<std::mutex> guard(lock_);
+        for (size_t cls = 0; cls < NUM_CLASSES; cls++) {
+            for (void *block : freeLists_[cls]) {
+                pool.release(block, cls);
+            }
+        }
+    }
+
+    /**
+     * Take all the blocks out. Guarded by `lock_` by the caller
+     */
+    std::vector<void *> takeAll() {
+        std::vector<void *> ret;
+        for (auto &&list : freeLists_) {
+            ret.insert(ret.end(), list.begin(), list.end());
+            list.clear();
+        }
+        cachedBytes_ = 0;
+        return ret;
+    }
+};
+
+static CPUMemoryPoolThreadCache &threadCache() {
+    thread_local CPUMemoryPoolThreadCache cache;
+    return cache;
+}
+
+CPUMemoryPool::CPUMemoryPool() : freeLists_(NUM_CLASSES) {}
+
+CPUMemoryPool &CPUMemoryPool::instance() {
+    static auto pool = new CPUMemoryPool();
+    return *pool;
+}
+
+void CPUMemoryPool::release(void *block, size_t cls) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (cachedBytes_ + classSize(cls) <= GLOBAL_CACHE_SIZE) {
+            freeLists_[cls].emplace_back(block);
+            cachedBytes_ += classSize(cls);
+            return;
+        }
+    }
+    std::free(block);
+}
+
+void *CPUMemoryPool::alloc(size_t size) {
+    size_t cls = size <= MAX_POOLED_SIZE ? sizeClass(size) : NUM_CLASSES;
+    size_t bytes = cls < NUM_CLASSES
+                       ? classSize(cls)
+                       : (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    void *block = nullptr;
+    if (cls < NUM_CLASSES) {
+        auto &&cache = threadCache();
+        {
+            std::lock_guard<std::mutex> guard(cache.lock_);
+            if (auto &&list = cache.freeLists_[cls]; !list.empty()) {
+                block = list.back();
+                list.pop_back();
+                cache.cachedBytes_ -= bytes;
+            }
+        }
+        if (block == nullptr) {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (auto &&list = freeLists_[cls]; !list.empty()) {
+                block = list.back();
+                list.pop_back();
+                cachedBytes_ -= bytes;
+            }
+        }
+    }
+    if (block == nullptr) {
+        block = std::aligned_alloc(ALIGNMENT, ALIGNMENT + bytes);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        *(BlockHeader *)block = BlockHeader{cls, bytes};
+    }
+
+    auto live = liveBytes_ += bytes;
+    auto peak = peakBytes_.load();
+    while (live > peak && !peakBytes_.compare_exchange_weak(peak, live)) {
+    }
+    return (uint8_t *)block + ALIGNMENT;
+}
+
+void CPUMemoryPool::free(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    void *block = (uint8_t *)ptr - ALIGNMENT;
+    auto [cls, bytes] = *(BlockHeader *)block;
+    liveBytes_ -= bytes;
+
+    if (cls >= NUM_CLASSES) {
+        std::free(block);
+        return;
+    }
+    auto &&cache = threadCache();
+    {
+        std::lock_guard<std::mutex> guard(cache.lock_);
+        if (cache.cachedBytes_ + bytes <= THREAD_CACHE_SIZE) {
+            cache.freeLists_[cls].emplace_back(block);
+            cache.cachedBytes_ += bytes;
+            return;
+        }
+    }
+    release(block, cls);
+}
+
+size_t CPUMemoryPool::cachedBytes() {
+    size_t ret = 0;
+    {
+        std::lock_guard<std::mutex> guard(threadCachesLock_);
+        for (auto *cache : threadCaches_) {
+            std::lock_guard<std::mutex> cacheGuard(cache->lock_);
+            ret += cache->cachedBytes_;
+        }
+    }
+    std::lock_guard<std::mutex> guard(lock_);
+    return ret + cachedBytes_;
+}
+
+void CPUMemoryPool::trim() {
+    std::vector<void *> blocks;
+    {
+        std::lock_guard<std::mutex> guard(threadCachesLock_);
+        for (auto *cache : threadCaches_) {
+            std::lock_guard<std::mutex> cacheGuard(cache->lock_);
+            auto taken = cache->takeAll();
+            blocks.insert(blocks.end(), taken.begin(), taken.end());
+        }
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        for (auto &&list : freeLists_) {
+            blocks.insert(blocks.end(), list.begin(), list.end());
+            list.clear();
+        }
+        cachedBytes_ = 0;
+    }
+    for (void *block : blocks) {
+        std::free(block);
+    }
+}
+
+} // namespace freetensor
@@ -92,6 +92,22 @@ Device::Device(const TargetType &targetType,
     }
 }
 
+void Device::setNUMAPolicy(NUMAPolicy policy, int node) {
+    if (type() != TargetType::CPU && policy != NUMAPolicy::Default) {
+        throw DriverError("NUMA policies are only for CPU devices");
+    }
+    if (policy == NUMAPolicy::Bind) {
+        if (!numaNodeAvailable(node)) {
+            throw DriverError("NUMA node " + std::to_string(node) +
+                              " is not available");
+        }
+    } else {
+        node = -1;
+    }
+    numaPolicy_ = policy;
+    numaNode_ = node;
+}
+
 void Device::sync() {
     switch (type()) {
 #ifdef FT_WITH_CUDA
@@ -0,0 +1,562 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>  // popen
+#include <cstdlib> // getenv
+#include <dlfcn.h> // dlclose
+#include <fcntl.h> // open
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <sys/file.h> // flock
+#include <sys/stat.h> // fstat, stat
+#include <tuple>
+#include <unistd.h> // close, getpid, gethostname
+#include <unordered_map>
+
+#include <config.h>
+#include <driver/kernel_cache.h>
+#include <except.h>
+
+namespace freetensor {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * Exclusive advisory lock on a file, released on destruction
+ *
+ * `flock` locks are bound to open file descriptions, so it serializes both
+ * threads in the same process and different processes
+ *
+ * A lock file may be removed by its holder (see `evict`). A waiter that locks
+ * the removed file finds it no longer at `path`, and retries with a new one
+ */
+class FileLock {
+    int fd_ = -1;
+
+  public:
+    FileLock(const fs::path &path, bool blocking = true) {
+        while (true) {
+            fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (fd_ == -1) {
+                return;
+            }
+            if (flock(fd_, LOCK_EX | (blocking ? 0 : LOCK_NB)) != 0) {
+                close(fd_);
+                fd_ = -1;
+                return;
+            }
+            struct stat locked, current;
+            if (fstat(fd_, &locked) == 0 && stat(path.c_str(), &current) == 0 &&
+                locked.st_dev == current.st_dev &&
+                locked.st_ino == current.st_ino) {
+                return;
+            }
+            flock(fd_, LOCK_UN);
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+    ~FileLock() {
+        if (fd_ != -1) {
+            flock(fd_, LOCK_UN);
+            close(fd_);
+        }
+    }
+
+    FileLock(const FileLock &) = delete;
+    FileLock &operator=(const FileLock &) = delete;
+
+    bool locked() const { return fd_ != -1; }
+};
+
+} // Anonymous namespace
+
+/**
+ * 64-bit FNV-1a hash in hexadecimal
+ */
+static std::string hashHex(const std::string &str) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : str) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    std::ostringstream os;
+    os << std::hex << std::setw(16) << std::setfill('0') << h;
+    return os.str();
+}
+
+static std::optional<std::string> readFile(const fs::path &path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) {
+        return std::nullopt;
+    }
+    std::ostringstream os;
+    os << f.rdbuf();
+    return os.str();
+}
+
+/**
+ * Suffix for temporary files, unique among threads and processes
+ */
+static std::string uniqueSuffix() {
+    static std::atomic<size_t> cnt = 0;
+    return ".tmp." + std::to_string(getpid()) + "." + std::to_string(cnt++);
+}
+
+static void writeFileAtomic(const fs::path &path, const std::string &content) {
+    auto tmp = path;
+    tmp += uniqueSuffix();
+    {
+        std::ofstream f(tmp, std::ios::binary);
+        f << content;
+        if (!f.good()) {
+            throw fs::filesystem_error(
+                "Unable to write", tmp,
+                std::make_error_code(std::errc::io_error));
+        }
+    }
+    fs::rename(tmp, path);
+}
+
+static void copyFileAtomic(const fs::path &from, const fs::path &to) {
+    auto tmp = to;
+    tmp += uniqueSuffix();
+    fs::copy_file(from, tmp);
+    fs::rename(tmp, to);
+}
+
+static bool linkOrCopy(const fs::path &from, const fs::path &to) {
+    std::error_code ec;
+    fs::remove(to, ec);
+    fs::create_hard_link(from, to, ec);
+    if (ec) {
+        // Maybe on different file systems
+        ec.clear();
+        fs::copy_file(from, to, ec);
+    }
+    return !ec;
+}
+
+/**
+ * Digest of all files in the runtime directories, including the `mdspan`
+ * headers they refer to
+ *
+ * Cached per directory, because the runtime is not expected to change during a
+ * process
+ */
+static std::string runtimeDigest() {
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::string> cache;
+
+    std::vector<fs::path> dirs;
+    for (auto &&dir : Config::runtimeDir()) {
+        dirs.emplace_back(dir);
+        dirs.emplace_back(dir / ".." / "3rd-party" / "mdspan");
+    }
+
+    std::string ret;
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto &&dir : dirs) {
+        if (auto it = cache.find(dir.string()); it != cache.end()) {
+            ret += it->second;
+            continue;
+        }
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(dir, ec), end;
+             !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec)) {
+                files.emplace_back(it->path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        std::string digest;
+        for (auto &&file : files) {
+            digest += file.string() + ": " +
+                      hashHex(readFile(file).value_or("")) + "\n";
+        }
+        ret += cache[dir.string()] = digest;
+    }
+    return ret;
+}
+
+/**
+ * Run a command with the shell and return its standard output and standard
+ * error, or nullopt if it fails
+ */
+static std::optional<std::string> commandOutput(const fs::path &executable,
+                                                const std::string &args) {
+    std::string quoted = "'";
+    for (char c : executable.string()) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    quoted += "'";
+    auto pipe = popen((quoted + " " + args + " 2>&1").c_str(), "r");
+    if (pipe == nullptr) {
+        return std::nullopt;
+    }
+    std::string ret;
+    char buf[4096];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), pipe)) > 0;) {
+        ret.append(buf, n);
+    }
+    if (pclose(pipe) != 0) {
+        return std::nullopt;
+    }
+    return ret;
+}
+
+/**
+ * Identity of the backend compiler, and of the host ISA if the binary is built
+ * for it (`-march=native`)
+ *
+ * The cache directory may be shared by machines of different CPUs (e.g. on an
+ * NFS home), so `-march=native` must not be taken literally. We key on the
+ * target it resolves to, as reported by `-Q --help=target`. The version of the
+ * compiler is taken from `--version`. If the compiler does not support these
+ * options, fall back to the path, size and modification time of its executable
+ *
+ * Cached per compiler, because neither of them changes during a process
+ */
+static std::string compilerIdentity(const fs::path &compiler,
+                                    const std::vector<std::string> &args) {
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::string> cache;
+
+    bool native = std::find(args.begin(), args.end(), "-march=native") !=
+                  args.end();
+    auto id = compiler.string() + (native ? " native" : "");
+    std::lock_guard<std::mutex> guard(lock);
+    if (auto it = cache.find(id); it != cache.end()) {
+        return it->second;
+    }
+
+    std::ostringstream os;
+    std::error_code ec;
+    auto realCompiler = fs::canonical(compiler, ec);
+    if (ec) {
+        realCompiler = compiler;
+    }
+    os << "compiler: " << realCompiler.string() << std::endl;
+    if (auto version = commandOutput(realCompiler, "--version");
+        version.has_value()) {
+        os << "version:" << std::endl << *version;
+    } else {
+        os << "executable: " << fs::file_size(realCompiler, ec) << " "
+           << fs::last_write_time(realCompiler, ec).time_since_epoch().count()
+           << std::endl;
+    }
+    if (native) {
+        if (auto target =
+                commandOutput(realCompiler, "-march=native -Q --help=target");
+            target.has_value()) {
+            os << "target:" << std::endl << *target;
+        } else {
+            // Unable to resolve the host ISA. Never share the entry with
+            // other machines
+            char host[256] = {0};
+            gethostname(host, sizeof(host) - 1);
+            os << "host: " << host << std::endl;
+        }
+    }
+    return cache[id] = os.str();
+}
+
+std::string makeKernelCacheKey(const std::string &src,
+                               const fs::path &compiler,
+                               const std::vector<std::string> &args) {
+    std::ostringstream os;
+    os << compilerIdentity(compiler, args);
+    os << "args:";
+    for (auto &&arg : args) {
+        os << " \"" << arg << "\"";
+    }
+    os << std::endl;
+    os << "runtime:" << std::endl << runtimeDigest();
+    os << "source:" << std::endl << src;
+    return os.str();
+}
+
+/**
+ * Remove the lock file of an entry, if no one is holding it. Waiters of the
+ * removed file will retry with a new one. See `FileLock`
+ *
+ * @param remove : Callback to remove other files of the entry under the lock
+ * @return : Whether the entry is removed
+ */
+static bool removeUnderLock(const fs::path &lockFile,
+                            const std::function<void()> &remove = nullptr) {
+    FileLock guard(lockFile, false);
+    if (!guard.locked()) {
+        return false; // In use
+    }
+    if (remove) {
+        remove();
+    }
+    std::error_code ec;
+    fs::remove(lockFile, ec);
+    return true;
+}
+
+/**
+ * Evict least recently used entries until the cache fits in the size limit,
+ * together with their lock files. Lock files left by failed builds are removed
+ * as well
+ *
+ * An entry's modification time is refreshed on every hit, so it serves as the
+ * last used time
+ */
+static void evict(const fs::path &dir, const fs::path &keep) {
+    FileLock guard(dir / "evict.lock", false);
+    if (!guard.locked()) {
+        return; // Someone else is evicting
+    }
+
+    std::vector<std::tuple<fs::file_time_type, uintmax_t, fs::path>> entries;
+    std::vector<fs::path> orphanLocks;
+    uintmax_t total = 0;
+    for (auto &&entry : fs::directory_iterator(dir)) {
+        auto &&path = entry.path();
+        if (path.extension() == ".so" && entry.is_regular_file()) {
+            auto size = entry.file_size();
+            entries.emplace_back(entry.last_write_time(), size, path);
+            total += size;
+        } else if (path.extension() == ".lock" && path.stem() != "evict" &&
+                   !fs::exists(fs::path(path).replace_extension(".so"))) {
+            orphanLocks.emplace_back(path);
+        }
+    }
+    for (auto &&lockFile : orphanLocks) {
+        removeUnderLock(lockFile);
+    }
+    if (total <= Config::kernelCacheSizeLimit()) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end());
+    for (auto &&[time, size, path] : entries) {
+        if (total <= Config::kernelCacheSizeLimit()) {
+            break;
+        }
+        if (path == keep) {
+            continue;
+        }
+        // Remove the binary before the key, so an existing binary always has
+        // its key. Skip entries being populated, whose locks are held
+        if (removeUnderLock(fs::path(path).replace_extension(".lock"), [&]() {
+                std::error_code ec;
+                fs::remove(path, ec);
+                fs::remove(fs::path(path).replace_extension(".key"), ec);
+            })) {
+            total -= size;
+        }
+    }
+}
+
+void lookupOrBuildKernel(const std::string &key, const fs::path &dst,
+                         const std::function<void()> &build) {
+    auto &&dir = Config::kernelCacheDir();
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        WARNING("Unable to create kernel cache directory " + dir.string() +
+                ": " + ec.message());
+        Config::countKernelCacheMiss();
+        build();
+        return;
+    }
+
+    auto hash = hashHex(key);
+    auto so = dir / (hash + ".so");
+    auto keyFile = dir / (hash + ".key");
+
+    auto tryHit = [&]() {
+        if (readFile(keyFile) != key) {
+            return false;
+        }
+        if (!linkOrCopy(so, dst)) {
+            return false; // Maybe just evicted
+        }
+        std::error_code ec;
+        fs::last_write_time(so, fs::file_time_type::clock::now(), ec);
+        Config::countKernelCacheHit();
+        return true;
+    };
+
+    if (tryHit()) {
+        return;
+    }
+    FileLock guard(dir / (hash + ".lock"));
+    if (tryHit()) {
+        return; // Populated by someone else while we were waiting for the lock
+    }
+
+    Config::countKernelCacheMiss();
+    build();
+
+    if (auto oldKey = readFile(keyFile);
+        oldKey.has_value() && *oldKey != key && fs::exists(so, ec)) {
+        return; // Hash collision. Keep the existing entry
+    }
+    try {
+        // Write the key before the binary, so an existing binary always has
+        // its key
+        writeFileAtomic(keyFile, key);
+        copyFileAtomic(dst, so);
+        evict(dir, so);
+    } catch (const fs::filesystem_error &e) {
+        WARNING((std::string) "Unable to update kernel cache: " + e.what());
+    }
+}
+
+static std::optional<fs::path> buildPrecompiledRuntime(
+    const std::string &key, const fs::path &base,
+    const std::vector<std::string> &flags,
+    const std::function<void(const std::vector<std::string> &)> &compile) {
+    fs::path header;
+    for (auto &&dir : Config::runtimeDir()) {
+        if (fs::exists(dir / "cpu_runtime.h")) {
+            header = dir / "cpu_runtime.h";
+            break;
+        }
+    }
+    if (header.empty()) {
+        return std::nullopt;
+    }
+
+    auto hash = hashHex(key);
+    auto dir = base / hash;
+    auto isReady = [&]() {
+        std::error_code ec;
+        return readFile(dir / "key") == key &&
+               fs::exists(dir / "cpu_runtime.h.gch", ec);
+    };
+
+    if (isReady()) {
+        return dir;
+    }
+    std::error_code ec;
+    fs::create_directories(base, ec);
+    if (ec) {
+        WARNING("Unable to create directory " + base.string() + ": " +
+                ec.message());
+        return std::nullopt;
+    }
+    FileLock guard(base / (hash + ".lock"));
+    if (isReady()) {
+        return dir; // Built by someone else while we were waiting for the lock
+    }
+    if (fs::exists(dir, ec)) {
+        return std::nullopt; // Hash collision. Keep the existing one
+    }
+
+    auto tmp = base / (hash + uniqueSuffix());
+    try {
+        fs::create_directories(tmp);
+        auto args = flags;
+        args.insert(args.end(), {"-x", "c++-header", header.string(), "-o",
+                                 (tmp / "cpu_runtime.h.gch").string()});
+        compile(args);
+        writeFileAtomic(tmp / "key", key);
+        fs::rename(tmp, dir);
+    } catch (const InterruptExcept &e) {
+        fs::remove_all(tmp, ec);
+        throw;
+    } catch (const std::exception &e) {
+        WARNING((std::string) "Unable to precompile the runtime headers. "
+                              "Compiling without them: " +
+                e.what());
+        fs::remove_all(tmp, ec);
+        return std::nullopt;
+    }
+    return dir;
+}
+
+std::optional<fs::path> precompiledRuntimeDir(
+    const fs::path &compiler, const std::vector<std::string> &flags,
+    const std::function<void(const std::vector<std::string> &)> &compile) {
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::optional<fs::path>> results;
+
+    auto key = makeKernelCacheKey("", compiler, flags);
+    auto base = Config::kernelCacheDir().empty()
+                    ? fs::path(getenv("HOME")) / ".freetensor" / "pch"
+                    : Config::kernelCacheDir() / "pch";
+    // Kernels have to wait for the precompiled header anyway, so we simply
+    // serialize all the lookups in the process
+    std::lock_guard<std::mutex> guard(lock);
+    auto id = base.string() + "\n" + key;
+    if (auto it = results.find(id); it != results.end()) {
+        return it->second;
+    }
+    return results[id] = buildPrecompiledRuntime(key, base, flags, compile);
+}
+
+LoadedKernel::~LoadedKernel() {
+    if (dlHandle_ != nullptr) {
+        dlclose(dlHandle_);
+        // Ignore errors. We can't throw error in a destructor
+    }
+}
+
+Ref<LoadedKernel>
+loadKernelShared(const std::string &key,
+                 const std::function<Ref<LoadedKernel>()> &load) {
+    struct Entry {
+        Weak<LoadedKernel> loaded_;
+        std::shared_future<Ref<LoadedKernel>> loading_;
+    };
+    static std::mutex lock;
+    static std::unordered_map<std::string, Entry> registry;
+
+    std::promise<Ref<LoadedKernel>> promise;
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        if (auto it = registry.find(key); it != registry.end()) {
+            if (auto kernel = it->second.loaded_.lock(); kernel.isValid()) {
+                return kernel;
+            }
+            if (it->second.loading_.valid()) {
+                auto future = it->second.loading_;
+                guard.unlock();
+                return future.get(); // Rethrows if the loader fails
+            }
+        }
+
+        // Drop entries whose kernels have been unloaded
+        for (auto it = registry.begin(); it != registry.end();) {
+            if (!it->second.loading_.valid() &&
+                !it->second.loaded_.lock().isValid()) {
+                it = registry.erase(it);
+            } else {
+                it++;
+            }
+        }
+
+        registry[key] = Entry{nullptr, promise.get_future().share()};
+    }
+
+    Ref<LoadedKernel> kernel;
+    try {
+        kernel = load();
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            registry.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        registry[key] = Entry{kernel, {}};
+    }
+    promise.set_value(kernel);
+    return kernel;
+}
+
+} // namespace freetensor
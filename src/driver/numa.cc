@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstring>
+#include <linux/mempolicy.h> // MPOL_*
+#include <omp.h>
+#include <sys/syscall.h> // SYS_mbind, SYS_get_mempolicy
+#include <unistd.h>      // syscall, sysconf
+
+#include <driver/numa.h>
+
+namespace freetensor {
+
+// Enough for the nodes of any real machine. Larger nodes are ignored
+constexpr size_t MAX_NUMA_NODES = 64;
+
+/**
+ * Nodes allowed for the process, or 0 if unknown
+ */
+static unsigned long allowedNodeMask() {
+    static unsigned long mask = []() {
+        unsigned long ret = 0;
+        if (syscall(SYS_get_mempolicy, nullptr, &ret, MAX_NUMA_NODES, nullptr,
+                    MPOL_F_MEMS_ALLOWED) != 0) {
+            return 0ul;
+        }
+        return ret;
+    }();
+    return mask;
+}
+
+size_t systemPageSize() {
+    static size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+int numaNodes() { return std::max(1, __builtin_popcountl(allowedNodeMask())); }
+
+bool numaNodeAvailable(int node) {
+    if (node < 0 || (size_t)node >= MAX_NUMA_NODES) {
+        return false;
+    }
+    auto mask = allowedNodeMask();
+    // Without NUMA support, there is only node 0
+    return mask == 0 ? node == 0 : (mask >> node) & 1;
+}
+
+std::vector<int> numaAllowedNodes() {
+    std::vector<int> ret;
+    for (size_t i = 0; i < MAX_NUMA_NODES; i++) {
+        if (numaNodeAvailable(i)) {
+            ret.emplace_back(i);
+        }
+    }
+    return ret;
+}
+
+int numaNodeOfAddress(const void *ptr) {
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, ptr,
+                MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+void numaApplyPolicy(void *ptr, size_t size, NUMAPolicy policy, int node) {
+    unsigned long mask;
+    int mode;
+    switch (policy) {
+    case NUMAPolicy::Interleave:
+        mask = allowedNodeMask();
+        mode = MPOL_INTERLEAVE;
+        break;
+    case NUMAPolicy::Bind:
+        if (!numaNodeAvailable(node)) {
+            return;
+        }
+        mask = 1ul << node;
+        mode = MPOL_BIND;
+        break;
+    default:
+        return;
+    }
+    if (numaNodes() <= 1) {
+        return;
+    }
+    // Best effort. Pages are still usable if it fails
+    syscall(SYS_mbind, ptr, size, mode, &mask, MAX_NUMA_NODES, 0);
+}
+
+// Smaller copies are faster in one thread than waking up others
+constexpr size_t PARALLEL_COPY_THRESHOLD = (size_t)4 << 20; // 4 MiB
+
+static thread_local int parallelCopyThreads = 0;
+
+ParallelCopyThreadsGuard::ParallelCopyThreadsGuard(int numThreads)
+    : old_(parallelCopyThreads) {
+    parallelCopyThreads = numThreads;
+}
+
+ParallelCopyThreadsGuard::~ParallelCopyThreadsGuard() {
+    parallelCopyThreads = old_;
+}
+
+template <class F> static void parallelChunks(size_t size, const F &f) {
+    if (size < PARALLEL_COPY_THRESHOLD) {
+        f(0, size);
+        return;
+    }
+    int numThreads =
+        parallelCopyThreads > 0 ? parallelCopyThreads : omp_get_max_threads();
+#pragma omp parallel num_threads(numThreads)
+    {
+        size_t n = omp_get_num_threads(), i = omp_get_thread_num();
+        // Partitions are multiples of a page, so each page is touched by one
+        // thread
+        size_t page = systemPageSize();
+        size_t pages = (size + page - 1) / page;
+        size_t begin = std::min(size, pages * i / n * page);
+        size_t end = std::min(size, pages * (i + 1) / n * page);
+        if (begin < end) {
+            f(begin, end - begin);
+        }
+    }
+}
+
+void parallelMemcpy(void *dst, const void *src, size_t size) {
+    parallelChunks(size, [&](size_t offset, size_t len) {
+        memcpy((uint8_t *)dst + offset, (const uint8_t *)src + offset, len);
+    });
+}
+
+void parallelMemset0(void *ptr, size_t size) {
+    parallelChunks(size, [&](size_t offset, size_t len) {
+        memset((uint8_t *)ptr + offset, 0, len);
+    });
+}
+
+} // namespace freetensor
@@ -0,0 +1,162 @@
+#include <cerrno>
+#include <cstring> // memset, strerror
+#include <linux/perf_event.h>
+#include <mutex>
+#include <omp.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <driver/perf_counters.h>
+#include <except.h>
+
+namespace freetensor {
+
+namespace {
+
+struct EventDesc {
+    const char *name_;
+    uint32_t type_;
+    uint64_t config_;
+};
+
+constexpr uint64_t cacheReadMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Cycles is the group leader
+const EventDesc events[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"llc_misses", PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_LL)},
+    {"l1d_misses", PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_L1D)},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+constexpr size_t numEvents = sizeof(events) / sizeof(events[0]);
+
+int openEvent(const EventDesc &event, int groupFd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type_;
+    attr.config = event.config_;
+    attr.disabled = groupFd == -1; // The group is controlled by the leader
+    attr.exclude_kernel = 1;       // Permitted with perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // pid = 0, cpu = -1: the calling thread on any CPU
+    return syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+} // Anonymous namespace
+
+PerfCounters::PerfCounters(int numThreads) {
+    numThreads = std::max(numThreads, 1);
+    groups_.resize(numThreads);
+    std::vector<int> errors(numThreads, 0);
+
+    // perf_event_open counts a thread only, so open the counters in each
+    // thread of the team
+#pragma omp parallel num_threads(numThreads)
+    {
+        auto &&group = groups_[omp_get_thread_num()];
+        for (size_t i = 0; i < numEvents; i++) {
+            int fd = openEvent(events[i], group.leader_);
+            if (fd == -1) {
+                if (i == 0) {
+                    errors[omp_get_thread_num()] = errno;
+                    break;
+                }
+                continue; // Not supported by this CPU
+            }
+            if (i == 0) {
+                group.leader_ = fd;
+            }
+            group.fds_.emplace_back(i, fd);
+        }
+    }
+
+    for (int error : errors) {
+        if (error != 0) {
+            static std::once_flag warned;
+            std::call_once(warned, [&]() {
+                WARNING((std::string) "Performance counters are unavailable: " +
+                        strerror(error) +
+                        ". Try lowering /proc/sys/kernel/perf_event_paranoid");
+            });
+            return; // Leave available_ = false. Opened ones are closed in ~
+        }
+    }
+    // The team may be smaller than requested (e.g. limited by
+    // OMP_THREAD_LIMIT), and the program will not use more threads either
+    std::erase_if(groups_, [](const Group &g) { return g.leader_ == -1; });
+    available_ = true;
+}
+
+PerfCounters::~PerfCounters() {
+    for (auto &&group : groups_) {
+        for (auto &&[event, fd] : group.fds_) {
+            close(fd);
+        }
+    }
+}
+
+void PerfCounters::enable() {
+    if (available_) {
+        for (auto &&group : groups_) {
+            ioctl(group.leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+}
+
+void PerfCounters::disable() {
+    if (available_) {
+        for (auto &&group : groups_) {
+            ioctl(group.leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+}
+
+void PerfCounters::reset() {
+    if (available_) {
+        for (auto &&group : groups_) {
+            ioctl(group.leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        }
+    }
+}
+
+std::unordered_map<std::string, double> PerfCounters::read() const {
+    std::unordered_map<std::string, double> ret;
+    if (!available_) {
+        return ret;
+    }
+    std::vector<double> totals(numEvents, 0);
+    std::vector<bool> counted(numEvents, false);
+    for (auto &&group : groups_) {
+        // { nr, time_enabled, time_running, values[nr] }
+        std::vector<uint64_t> buf(3 + group.fds_.size());
+        auto size = buf.size() * sizeof(uint64_t);
+        if (::read(group.leader_, buf.data(), size) != (ssize_t)size) {
+            continue;
+        }
+        auto enabled = buf[1], running = buf[2];
+        if (running == 0) {
+            continue; // Never scheduled on a PMU
+        }
+        for (size_t i = 0; i < group.fds_.size(); i++) {
+            auto event = group.fds_[i].first;
+            totals[event] += (double)buf[3 + i] * enabled / running;
+            counted[event] = true;
+        }
+    }
+    for (size_t i = 0; i < numEvents; i++) {
+        if (counted[i]) {
+            ret[events[i].name_] = totals[i];
+        }
+    }
+    return ret;
+}
+
+} // namespace freetensor
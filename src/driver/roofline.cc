@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <omp.h>
+#include <tuple>
+#include <unistd.h> // sysconf
+
+#include <analyze/structural_feature.h>
+#include <driver.h>
+#include <driver/roofline.h>
+#include <except.h>
+
+namespace freetensor {
+
+namespace {
+
+/**
+ * STREAM triad. `N` is defined before this source
+ *
+ * The arrays are allocated and first touched in parallel by the first run,
+ * which is a warm-up run, so each thread accesses its local memory afterwards
+ */
+const char *streamSrc = R"~~~(
+#include <memory>
+
+#include <cpu_runtime.h>
+
+static std::unique_ptr<double[]> a, b, c;
+
+extern "C" {
+
+size_t run_stack_size(CPUContext_t _ctx) { return 0; }
+
+void run(void **_params, void **_returns, size_t **_retShapes,
+         size_t *_retDims, CPUContext_t _ctx) {
+    const size_t n = N;
+    if (a == nullptr) {
+        a.reset(new double[n]);
+        b.reset(new double[n]);
+        c.reset(new double[n]);
+#pragma omp parallel for schedule(static) num_threads(_ctx->numThreads())
+        for (size_t i = 0; i < n; i++) {
+            a[i] = 0, b[i] = 1, c[i] = 2;
+        }
+    }
+    double *__restrict__ pa = a.get();
+    const double *__restrict__ pb = b.get(), *__restrict__ pc = c.get();
+#pragma omp parallel for schedule(static) num_threads(_ctx->numThreads())
+    for (size_t i = 0; i < n; i++) {
+        pa[i] = pb[i] + 3 * pc[i];
+    }
+    if (_returns[0] == NULL) {
+        _returns[0] = _ctx->alloc(sizeof(double));
+        _retShapes[0] = NULL, _retDims[0] = 0;
+    }
+    *(double *)_returns[0] = 24. * n; // Bytes, counted as STREAM does
+}
+
+}
+)~~~";
+
+/**
+ * Independent chains of vector FMAs. `DTYPE` is defined before this source
+ *
+ * There are enough chains to hide the latency of FMA on all the FMA units, but
+ * not too many to spill the vector registers
+ */
+const char *fmaSrc = R"~~~(
+#include <cpu_runtime.h>
+
+#if defined(__AVX512F__)
+#define VEC_BYTES 64
+#define CHAINS 16
+#elif defined(__AVX__)
+#define VEC_BYTES 32
+#define CHAINS 10
+#else
+#define VEC_BYTES 16
+#define CHAINS 10
+#endif
+
+typedef DTYPE vec_t __attribute__((vector_size(VEC_BYTES)));
+constexpr int LANES = VEC_BYTES / sizeof(DTYPE);
+constexpr long ITERS = 1 << 20;
+
+static volatile DTYPE sink;
+
+extern "C" {
+
+size_t run_stack_size(CPUContext_t _ctx) { return 0; }
+
+void run(void **_params, void **_returns, size_t **_retShapes,
+         size_t *_retDims, CPUContext_t _ctx) {
+    int nThreads = 1;
+#pragma omp parallel num_threads(_ctx->numThreads())
+    {
+#pragma omp single
+        nThreads = omp_get_num_threads();
+
+        vec_t acc[CHAINS];
+        for (int j = 0; j < CHAINS; j++) {
+            acc[j] = vec_t{} + (DTYPE)(omp_get_thread_num() + j);
+        }
+        vec_t x = vec_t{} + (DTYPE)0.999, y = vec_t{} + (DTYPE)0.001;
+        for (long k = 0; k < ITERS; k++) {
+            for (int j = 0; j < CHAINS; j++) {
+                acc[j] = acc[j] * x + y;
+            }
+        }
+        vec_t s = acc[0];
+        for (int j = 1; j < CHAINS; j++) {
+            s += acc[j];
+        }
+        DTYPE t = 0;
+        for (int l = 0; l < LANES; l++) {
+            t += s[l];
+        }
+        if (t < 0) { // Never, but the compiler does not know
+            sink = t;
+        }
+    }
+    if (_returns[0] == NULL) {
+        _returns[0] = _ctx->alloc(sizeof(double));
+        _retShapes[0] = NULL, _retDims[0] = 0;
+    }
+    *(double *)_returns[0] = 2. * LANES * CHAINS * ITERS * nThreads; // FLOPs
+}
+
+}
+)~~~";
+
+/**
+ * Run a microbenchmark, which returns its amount of work per run as a scalar,
+ * and return the work done per second in the fastest run
+ */
+double runMicrobenchmark(const std::string &src, const Ref<Device> &device,
+                         int numThreads) {
+    auto func = makeFunc("microbenchmark", std::vector<FuncParam>{},
+                         std::vector<FuncRet>{{"work", DataType::Float64,
+                                               nullptr, false}},
+                         makeStmtSeq(std::vector<Stmt>{}));
+    Driver driver(func, src, device);
+    driver.setNumThreads(numThreads);
+
+    BenchmarkOptions options;
+    options.warmups_ = 1;
+    options.maxRounds_ = 20;
+    options.targetRelCI_ = 0.02;
+    auto result = driver.benchmark(options);
+
+    auto work = driver.collectReturns().at(0);
+    return *(double *)work->rawSharedTo(device) / (result.min_ / 1e3);
+}
+
+} // Anonymous namespace
+
+MachinePeak machinePeak(const Ref<Device> &device, int numThreads) {
+    if (device->type() != TargetType::CPU) {
+        throw DriverError("Measuring the peak performance is only supported "
+                          "on CPU");
+    }
+    if (numThreads <= 0) {
+        numThreads = omp_get_max_threads();
+    }
+
+    static std::mutex lock;
+    static std::map<std::tuple<std::string, bool, int, int>, MachinePeak>
+        cache;
+    std::lock_guard<std::mutex> guard(lock);
+    auto key = std::make_tuple(device->target()->toString(),
+                               device->target()->useNativeArch(),
+                               device->num(), numThreads);
+    if (auto it = cache.find(key); it != cache.end()) {
+        return it->second;
+    }
+
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc <= 0) {
+        llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+    size_t bytesPerArray = std::max<size_t>(4 * std::max(llc, 0l), 32 << 20);
+    auto n = std::to_string(bytesPerArray / sizeof(double));
+
+    MachinePeak peak;
+    peak.bandwidth_ = runMicrobenchmark("#define N " + n + "\n" + streamSrc,
+                                        device, numThreads) /
+                      1e9;
+    peak.gflops32_ = runMicrobenchmark(
+                         (std::string) "#define DTYPE float\n" + fmaSrc,
+                         device, numThreads) /
+                     1e9;
+    peak.gflops64_ = runMicrobenchmark(
+                         (std::string) "#define DTYPE double\n" + fmaSrc,
+                         device, numThreads) /
+                     1e9;
+    return cache[key] = peak;
+}
+
+RooflineEntry analyzeRoofline(const NodeFeature &feature, double time,
+                              const MachinePeak &peak) {
+    RooflineEntry entry;
+    entry.time_ = time;
+
+    int64_t maxCnt = -1;
+    for (auto &&[dtype, cnt] : feature.opCnt_) {
+        if (isFloat(dtype) && entry.flop_ >= 0) {
+            entry.flop_ = cnt >= 0 ? entry.flop_ + cnt : -1;
+            if (cnt > maxCnt) {
+                maxCnt = cnt, entry.dtype_ = dtype;
+            }
+        }
+    }
+    for (auto *bytes : {&feature.loadBytes_, &feature.storeBytes_}) {
+        for (auto mtype : {MemType::CPU, MemType::CPUHeap}) {
+            if (auto it = bytes->find(mtype);
+                it != bytes->end() && entry.bytes_ >= 0) {
+                entry.bytes_ = it->second >= 0 ? entry.bytes_ + it->second : -1;
+            }
+        }
+    }
+
+    double seconds = entry.time_ / 1e3;
+    entry.gflops_ = entry.flop_ >= 0 ? entry.flop_ / seconds / 1e9 : NAN;
+    entry.bandwidth_ = entry.bytes_ >= 0 ? entry.bytes_ / seconds / 1e9 : NAN;
+    entry.intensity_ = entry.flop_ >= 0 && entry.bytes_ >= 0
+                           ? entry.flop_ / entry.bytes_
+                           : NAN;
+
+    double computeRoof = peak.gflops(entry.dtype_);
+    double memoryRoof = entry.intensity_ * peak.bandwidth_;
+    entry.memoryBound_ = memoryRoof < computeRoof; // False if NaN
+    entry.attainableGFlops_ = std::isnan(memoryRoof)
+                                  ? NAN
+                                  : std::min(computeRoof, memoryRoof);
+    // Also defined when there is no FLOP, e.g. for a copy
+    entry.efficiency_ = entry.memoryBound_
+                            ? entry.bandwidth_ / peak.bandwidth_
+                            : entry.gflops_ / entry.attainableGFlops_;
+    return entry;
+}
+
+} // namespace freetensor
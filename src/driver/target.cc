@@ -1,8 +1,41 @@
+#include <config.h>
 #include <cstring>
 #include <driver/target.h>
 
 namespace freetensor {
 
+BLASProvider resolveBLASProvider(BLASProvider provider) {
+    if (provider == BLASProvider::Default) {
+        return Config::withMKL().empty() ? BLASProvider::Builtin
+                                         : BLASProvider::MKL;
+    }
+    return provider;
+}
+
+void CPUTarget::setBLAS(BLASProvider blas) {
+    if (blas == BLASProvider::MKL && Config::withMKL().empty()) {
+        throw DriverError("FreeTensor is not built with MKL");
+    }
+    blas_ = blas;
+}
+
+int CPUTarget::vectorBytes() const {
+    if (vectorBytes_ > 0) {
+        return vectorBytes_;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    if (useNativeArch_) {
+        if (__builtin_cpu_supports("avx512f")) {
+            return 64;
+        }
+        if (__builtin_cpu_supports("avx")) {
+            return 32;
+        }
+    }
+#endif
+    return 16;
+}
+
 bool isSameTarget(const Ref<Target> &lhs, const Ref<Target> &rhs) {
     if (lhs.isValid() != rhs.isValid()) {
         return false;
@@ -18,6 +51,12 @@ bool isSameTarget(const Ref<Target> &lhs, const Ref<Target> &rhs) {
         auto &&l = lhs.as<CPUTarget>(), &&r = rhs.as<CPUTarget>();
         if (l->useNativeArch() != r->useNativeArch())
             return false;
+        if (l->vectorBytes() != r->vectorBytes())
+            return false;
+        if (l->streamingStores() != r->streamingStores())
+            return false;
+        if (l->blas() != r->blas())
+            return false;
         return true;
     }
 #ifdef FT_WITH_CUDA
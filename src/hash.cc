@@ -234,6 +234,7 @@ size_t Hasher::compHash(const IntrinsicNode &op) {
     }
     h = ((h + std::hash<int>()(int(op.retType_))) * K2 + B2) % P;
     h = ((h + std::hash<bool>()(op.hasSideEffect_)) * K2 + B2) % P;
+    h = ((h + std::hash<bool>()(op.isHint_)) * K2 + B2) % P;
     return (h * K3 + B3) % P;
 }
 
@@ -476,6 +477,9 @@ bool HashComparator::compare(const Intrinsic &lhs, const Intrinsic &rhs) const {
     if (lhs->hasSideEffect_ != rhs->hasSideEffect_) {
         return false;
     }
+    if (lhs->isHint_ != rhs->isHint_) {
+        return false;
+    }
     return true;
 }
 
@@ -1,3 +1,4 @@
+#include <analyze/analyze_linear.h>
 #include <container_utils.h>
 #include <hash.h>
 #include <pass/cpu/lower_parallel_reduction.h>
@@ -14,8 +15,37 @@ template <class T, class U> std::vector<T> asVec(U &&adaptor) {
     return std::vector<T>(adaptor.begin(), adaptor.end());
 }
 
+/**
+ * Reduced sections up to this size are left to OpenMP's reduction clause.
+ * OpenMP keeps a private copy of the section on the stack of each thread, and
+ * combines the copies serially at the end of the loop, so larger sections are
+ * reduced into heap-allocated per-thread partials, which are combined in
+ * parallel
+ */
+constexpr int64_t MAX_CLAUSE_BYTES = 4096;
+
+Expr threadNum() {
+    return makeIntrinsic("omp_get_thread_num()", {}, DataType::Int32, false);
+}
+
+Expr numThreads() {
+    return makeIntrinsic("_ctx->numThreads()", {}, DataType::Int32, false);
+}
+
 } // namespace
 
+bool LowerParallelReduction::privatize(const ReductionItem &r) {
+    int64_t bytes = sizeOf(accumulateType(buffer(r.var_)->tensor()->dtype()));
+    for (auto &&[begin, end] : views::zip(r.begins_, r.ends_)) {
+        auto len = linear(makeSub(end, begin));
+        if (!len.coeff_.empty()) {
+            return true; // Unknown size, which may not fit in the stack
+        }
+        bytes *= len.bias_;
+    }
+    return bytes > MAX_CLAUSE_BYTES;
+}
+
 std::vector<std::pair<For, int>>
 LowerParallelReduction::reducedBy(const ReduceTo &op) {
     std::vector<std::pair<For, int>> ret;
@@ -47,9 +77,14 @@ Stmt LowerParallelReduction::visit(const For &_op) {
     std::vector<std::string> workspaces;
     std::vector<std::vector<Expr>> workspaceShapes;
     std::vector<DataType> dtypes;
+    std::vector<std::string> partials;
+    std::vector<std::vector<Expr>> partialShapes;
+    std::vector<DataType> partialDTypes;
+    std::vector<Ref<ReductionItem>> clauseReductions;
     for (size_t i = 0, n = op->property_->reductions_.size(); i < n; i++) {
         auto &&r = op->property_->reductions_[i];
-        auto dtype = buffer(r->var_)->tensor()->dtype();
+        // Partial results are kept in the accumulation type
+        auto dtype = accumulateType(buffer(r->var_)->tensor()->dtype());
         auto workspace =
             "__reduce_" + toString(op->id()) + "_" + std::to_string(i);
         std::vector<Expr> workspaceShape;
@@ -61,6 +96,49 @@ Stmt LowerParallelReduction::visit(const For &_op) {
         for (size_t j = 0, m = workspaceShape.size(); j < m; j++) {
             indices.emplace_back(makeVar(workspace + "." + std::to_string(j)));
         }
+
+        if (privatize(*_op->property_->reductions_[i])) {
+            // Each thread reduces into its own partial. Initialize them in
+            // parallel, and combine them over the threads for each element
+            // after the loop, in parallel over the elements
+            auto thread = makeVar(workspace + ".thread");
+            auto partialIndices = indices;
+            partialIndices.insert(partialIndices.begin(), thread);
+            auto partialShape = workspaceShape;
+            partialShape.insert(partialShape.begin(), numThreads());
+
+            auto initStmt = makeStore(workspace, partialIndices,
+                                      neutralVal(dtype, r->op_));
+            initStmt = makeNestedLoops(
+                partialIndices, views::repeat(makeIntConst(0)), partialShape,
+                views::repeat(makeIntConst(1)), partialShape,
+                views::repeat(
+                    Ref<ForProperty>::make()->withParallel(OpenMPScope{})),
+                initStmt);
+            Stmt flushStmt = makeReduceTo(
+                r->var_,
+                asVec<Expr>(views::zip_with(
+                    [](auto &&x, auto &&y) { return makeAdd(x, y); },
+                    r->begins_, indices)),
+                r->op_, makeLoad(workspace, partialIndices, dtype), false);
+            flushStmt =
+                makeFor(thread.as<VarNode>()->name_, makeIntConst(0),
+                        numThreads(), makeIntConst(1), numThreads(),
+                        Ref<ForProperty>::make(), flushStmt);
+            flushStmt = makeNestedLoops(
+                indices, views::repeat(makeIntConst(0)), workspaceShape,
+                views::repeat(makeIntConst(1)), workspaceShape,
+                views::repeat(
+                    Ref<ForProperty>::make()->withParallel(OpenMPScope{})),
+                flushStmt);
+            initStmts.emplace_back(std::move(initStmt));
+            flushStmts.emplace_back(std::move(flushStmt));
+
+            partials.emplace_back(std::move(workspace));
+            partialShapes.emplace_back(std::move(partialShape));
+            partialDTypes.emplace_back(dtype);
+            continue;
+        }
         auto initStmt =
             makeStore(workspace, indices, neutralVal(dtype, r->op_));
         auto flushStmt =
@@ -92,7 +170,10 @@ Stmt LowerParallelReduction::visit(const For &_op) {
         workspaces.emplace_back(std::move(workspace));
         workspaceShapes.emplace_back(std::move(workspaceShape));
         dtypes.emplace_back(dtype);
+        clauseReductions.emplace_back(r);
     }
+    // Partials are not reduced by OpenMP
+    op->property_->reductions_ = std::move(clauseReductions);
 
     std::vector<Stmt> stmts;
     stmts.insert(stmts.end(), initStmts.begin(), initStmts.end());
@@ -106,6 +187,14 @@ Stmt LowerParallelReduction::visit(const For &_op) {
                                     AccessType::Cache, MemType::CPU),
                          std::nullopt, ret, false);
     }
+    for (auto &&[partial, shape, dtype] :
+         views::zip(partials, partialShapes, partialDTypes)) {
+        ret = makeStmtSeq({makeAlloc(partial), ret, makeFree(partial)});
+        ret = makeVarDef(partial,
+                         makeBuffer(makeTensor(shape, dtype),
+                                    AccessType::Cache, MemType::CPUHeap),
+                         std::nullopt, ret, false);
+    }
 
     return ret;
 }
@@ -128,15 +217,16 @@ Stmt LowerParallelReduction::visit(const ReduceTo &_op) {
         auto &&redLoop = redLoops.front();
         auto workspace = "__reduce_" + toString(redLoop.first->id()) + "_" +
                          std::to_string(redLoop.second);
-        auto &&begins =
-            redLoop.first->property_->reductions_[redLoop.second]->begins_;
-        ASSERT(op->indices_.size() == begins.size());
-        return makeReduceTo(
-            workspace,
-            asVec<Expr>(views::zip_with(
-                [](auto &&x, auto &&y) { return makeSub(x, y); }, op->indices_,
-                begins)),
-            op->op_, op->expr_, false, op->metadata(), op->id());
+        auto &&r = redLoop.first->property_->reductions_[redLoop.second];
+        ASSERT(op->indices_.size() == r->begins_.size());
+        auto indices = asVec<Expr>(views::zip_with(
+            [](auto &&x, auto &&y) { return makeSub(x, y); }, op->indices_,
+            r->begins_));
+        if (privatize(*r)) {
+            indices.insert(indices.begin(), threadNum());
+        }
+        return makeReduceTo(workspace, std::move(indices), op->op_, op->expr_,
+                            false, op->metadata(), op->id());
     }
 
     return op;
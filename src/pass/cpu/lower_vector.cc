@@ -0,0 +1,997 @@
+#include <algorithm>
+
+#include <analyze/all_uses.h>
+#include <analyze/analyze_linear.h>
+#include <analyze/find_stmt.h>
+#include <container_utils.h>
+#include <hash.h>
+#include <pass/cpu/lower_vector.h>
+#include <pass/replace_iter.h>
+#include <pass/simplify.h>
+
+namespace freetensor {
+
+namespace cpu {
+
+namespace {
+
+class InvalidCPUVector : public InvalidProgram {
+  public:
+    InvalidCPUVector(const std::string &msg) : InvalidProgram(msg) {}
+};
+
+std::string ctype(DataType dtype) {
+    switch (dtype) {
+    case DataType::Float64:
+        return "double";
+    case DataType::Float32:
+        return "float";
+    case DataType::Int64:
+        return "int64_t";
+    case DataType::Int32:
+        return "int32_t";
+    case DataType::Int8:
+        return "int8_t";
+    case DataType::UInt8:
+        return "uint8_t";
+    default:
+        throw InvalidCPUVector("Vectors of " + toString(dtype) +
+                               " are not supported");
+    }
+}
+
+Expr intrinsic(const std::string &format, const std::vector<Expr> &params,
+               DataType retType = DataType::Custom) {
+    return makeIntrinsic(format, params, retType, false);
+}
+
+} // Anonymous namespace
+
+std::string LowerVector::lanes(DataType dtype) const {
+    return "<" + ctype(dtype) + ", " + std::to_string(width_) + ">";
+}
+
+Expr LowerVector::broadcast(const VecVal &val, DataType dtype) const {
+    switch (val.kind_) {
+    case VecVal::Scalar:
+        return intrinsic("simd_broadcast" + lanes(dtype) + "(%)", {val.expr_});
+    case VecVal::Vec:
+        return val.dtype_ == dtype
+                   ? val.expr_
+                   : intrinsic("simd_convert" + lanes(dtype) + "(%)",
+                               {val.expr_});
+    case VecVal::Mask:
+        return intrinsic("simd_from_mask" + lanes(dtype) + "(%)", {val.expr_});
+    default:
+        ASSERT(false);
+    }
+}
+
+Expr LowerVector::toMask(const VecVal &val) const {
+    auto w = std::to_string(width_);
+    switch (val.kind_) {
+    case VecVal::Scalar:
+        return intrinsic("simd_mask_broadcast<" + w + ">(%)", {val.expr_});
+    case VecVal::Vec:
+        return intrinsic("simd_to_mask" + lanes(val.dtype_) + "(%)",
+                         {val.expr_});
+    case VecVal::Mask:
+        return val.expr_;
+    default:
+        ASSERT(false);
+    }
+}
+
+Expr LowerVector::activeMask() const {
+    Expr ret;
+    if (count_.isValid()) {
+        ret = intrinsic("simd_prefix_mask<" + std::to_string(width_) + ">(%)",
+                        {deepCopy(count_)});
+    }
+    if (mask_.isValid()) {
+        ret = ret.isValid() ? intrinsic("% & %", {ret, deepCopy(mask_)})
+                            : deepCopy(mask_);
+    }
+    return ret;
+}
+
+LowerVector::VecVal LowerVector::vecBinary(const std::string &format,
+                                           const Expr &lhs, const Expr &rhs,
+                                           DataType dtype, bool isMask) {
+    auto l = vec(lhs), r = vec(rhs);
+    if (l.kind_ == VecVal::Scalar && r.kind_ == VecVal::Scalar) {
+        return {VecVal::Scalar, nullptr, dtype};
+    }
+    if (isMask) {
+        auto operandType = upCast(lhs->dtype(), rhs->dtype());
+        auto w = std::to_string(width_);
+        return {VecVal::Mask,
+                intrinsic("simd_mask<" + w + ">(" + format + ")",
+                          {broadcast(l, operandType),
+                           broadcast(r, operandType)}),
+                DataType::Bool};
+    }
+    return {VecVal::Vec,
+            intrinsic(format, {broadcast(l, dtype), broadcast(r, dtype)}),
+            dtype};
+}
+
+LowerVector::VecVal LowerVector::vecMap(const std::string &func,
+                                        const Expr &expr, DataType dtype) {
+    auto v = vec(expr);
+    if (v.kind_ == VecVal::Scalar) {
+        return {VecVal::Scalar, nullptr, dtype};
+    }
+    return {VecVal::Vec,
+            intrinsic("simd_map" + lanes(dtype) +
+                          "(%, [](auto _x) { return " + func + "(_x); })",
+                      {broadcast(v, expr->dtype())}),
+            dtype};
+}
+
+LowerVector::VecVal LowerVector::vecMap2(const std::string &func,
+                                         const Expr &lhs, const Expr &rhs,
+                                         DataType dtype) {
+    auto l = vec(lhs), r = vec(rhs);
+    if (l.kind_ == VecVal::Scalar && r.kind_ == VecVal::Scalar) {
+        return {VecVal::Scalar, nullptr, dtype};
+    }
+    return {VecVal::Vec,
+            intrinsic("simd_map2" + lanes(dtype) +
+                          "(%, %, [](auto _x, auto _y) { return " + func +
+                          "(_x, _y); })",
+                      {broadcast(l, dtype), broadcast(r, dtype)}),
+            dtype};
+}
+
+std::tuple<Expr, bool, bool>
+LowerVector::address(const std::string &var, const std::vector<Expr> &indices) {
+    auto &&tensor = buffer(var)->tensor();
+    auto &&shape = tensor->shape();
+
+    Expr flat;
+    for (auto &&[idx, dim] : views::zip(indices, shape)) {
+        flat = flat.isValid()
+                   ? makeAdd(makeMul(flat, deepCopy(dim)), deepCopy(idx))
+                   : deepCopy(idx);
+    }
+    ASSERT(flat.isValid());
+    auto lin = linear(flat);
+
+    bool contiguous = false, aligned = aligned_;
+    for (auto &&item : lin.coeff_) {
+        if (item.a_->nodeType() == ASTNodeType::Var &&
+            item.a_.as<VarNode>()->name_ == iter_) {
+            contiguous = item.k_ == 1;
+        } else if (allIters(item.a_).count(iter_)) {
+            contiguous = false;
+            break;
+        } else if (item.k_ % width_ != 0) {
+            aligned = false;
+        }
+    }
+    if (tensor->dtype() == DataType::PackedBool) {
+        if (!contiguous) {
+            throw InvalidCPUVector("Non-contiguous vectors of packed_bool are "
+                                   "not supported");
+        }
+        aligned = false;
+    }
+
+    // Heap buffers are allocated by `_ctx->alloc`, which aligns to 64 bytes.
+    // So are I/O buffers if `ALIGNED` is set. See `alignedFunc`
+    auto mtype = buffer(var)->mtype();
+    aligned = aligned && contiguous && lin.bias_ % width_ == 0 &&
+              (mtype == MemType::CPUHeap ||
+               (mtype == MemType::CPU &&
+                buffer(var)->atype() != AccessType::Cache)) &&
+              width_ * sizeOf(tensor->dtype()) <= 64;
+
+    if (contiguous) {
+        std::vector<Expr> first;
+        first.reserve(indices.size());
+        for (auto &&idx : indices) {
+            first.emplace_back(ReplaceIter(iter_, base_)(deepCopy(idx)));
+        }
+        if (tensor->dtype() == DataType::PackedBool) {
+            return {makeLoad(var, first, tensor->dtype()), true, false};
+        }
+        return {intrinsic("&(%)", {makeLoad(var, first, tensor->dtype())}),
+                true, aligned};
+    }
+
+    Expr offsets;
+    for (auto &&[idx, dim] : views::zip(indices, shape)) {
+        auto v = broadcast(vec(idx), DataType::Int64);
+        offsets = offsets.isValid()
+                      ? intrinsic("% * simd_broadcast" +
+                                      lanes(DataType::Int64) + "(%) + %",
+                                  {offsets, deepCopy(dim), v})
+                      : v;
+    }
+    return {offsets, false, false};
+}
+
+std::string LowerVector::alignedFunc(const std::string &func,
+                                     const std::string &var, DataType dtype) {
+    if (buffer(var)->mtype() == MemType::CPUHeap) {
+        return func + "_aligned" + lanes(dtype);
+    }
+    return func + "_aligned_if<ALIGNED, " + ctype(dtype) + ", " +
+           std::to_string(width_) + ">";
+}
+
+LowerVector::VecVal LowerVector::vecLoad(const Load &op) {
+    auto dtype = buffer(op->var_)->tensor()->dtype();
+    if (std::all_of(op->indices_.begin(), op->indices_.end(),
+                    [this](const Expr &idx) {
+                        return vec(idx).kind_ == VecVal::Scalar;
+                    })) {
+        return {VecVal::Scalar, nullptr, op->loadType_};
+    }
+
+    auto t = lanes(dtype);
+    auto mask = activeMask();
+    auto &&[addr, contiguous, aligned] = address(op->var_, op->indices_);
+    Expr ret;
+    if (contiguous) {
+        if (mask_.isValid()) {
+            ret = intrinsic("simd_load_masked" + t + "(%, %)", {addr, mask});
+        } else if (count_.isValid()) {
+            ret = intrinsic("simd_load_partial" + t + "(%, %)",
+                            {addr, deepCopy(count_)});
+        } else if (aligned) {
+            ret = intrinsic(alignedFunc("simd_load", op->var_, dtype) + "(%)",
+                            {addr});
+        } else {
+            ret = intrinsic("simd_load" + t + "(%)", {addr});
+        }
+    } else {
+        std::vector<Expr> zeros;
+        for (size_t i = 0, n = op->indices_.size(); i < n; i++) {
+            zeros.emplace_back(makeIntConst(0));
+        }
+        auto base = intrinsic("&(%)", {makeLoad(op->var_, zeros, dtype)});
+        ret = mask.isValid() ? intrinsic("simd_gather_masked" + t + "(%, %, %)",
+                                         {base, addr, mask})
+                             : intrinsic("simd_gather" + t + "(%, %)",
+                                         {base, addr});
+    }
+    VecVal val{VecVal::Vec, ret, dtype};
+    return dtype == op->loadType_
+               ? val
+               : VecVal{VecVal::Vec, broadcast(val, op->loadType_),
+                        op->loadType_};
+}
+
+LowerVector::VecVal LowerVector::vecPackedLoad(const Load &op) {
+    if (std::all_of(op->indices_.begin(), op->indices_.end(),
+                    [this](const Expr &idx) {
+                        return vec(idx).kind_ == VecVal::Scalar;
+                    })) {
+        return {VecVal::Scalar, nullptr, DataType::Bool};
+    }
+
+    auto w = std::to_string(width_);
+    auto mask = activeMask();
+    auto &&[elem, contiguous, aligned] = address(op->var_, op->indices_);
+    Expr ret;
+    if (mask_.isValid()) {
+        ret = intrinsic("simd_packed_load_masked<" + w + ">(%, %)",
+                        {elem, mask});
+    } else if (count_.isValid()) {
+        ret = intrinsic("simd_packed_load_partial<" + w + ">(%, %)",
+                        {elem, deepCopy(count_)});
+    } else {
+        ret = intrinsic("simd_packed_load<" + w + ">(%)", {elem});
+    }
+    return {VecVal::Mask, ret, DataType::Bool};
+}
+
+LowerVector::VecVal LowerVector::vec(const Expr &expr) {
+    auto dtype = expr->dtype();
+    VecVal ret;
+    switch (expr->nodeType()) {
+    case ASTNodeType::Var:
+        if (expr.as<VarNode>()->name_ == iter_) {
+            ret = {VecVal::Vec,
+                   intrinsic("simd_iota" + lanes(DataType::Int32) + "(%)",
+                             {deepCopy(base_)}),
+                   DataType::Int32};
+        } else {
+            ret = {VecVal::Scalar, nullptr, dtype};
+        }
+        break;
+    case ASTNodeType::IntConst:
+    case ASTNodeType::FloatConst:
+    case ASTNodeType::BoolConst:
+        ret = {VecVal::Scalar, nullptr, dtype};
+        break;
+    case ASTNodeType::Load: {
+        auto &&load = expr.as<LoadNode>();
+        if (buffer(load->var_)->tensor()->dtype() == DataType::PackedBool) {
+            ret = vecPackedLoad(load);
+            break;
+        }
+        if (isBool(load->loadType_)) {
+            throw InvalidCPUVector("Vectors of booleans in memory are not "
+                                   "supported");
+        }
+        ret = vecLoad(load);
+        break;
+    }
+
+#define BINARY(TYPE, FORMAT, IS_MASK)                                          \
+    case ASTNodeType::TYPE: {                                                  \
+        auto &&op = expr.as<BinaryExprNode>();                                 \
+        ret = vecBinary(FORMAT, op->lhs_, op->rhs_, dtype, IS_MASK);           \
+        break;                                                                 \
+    }
+        BINARY(Add, "% + %", false)
+        BINARY(Sub, "% - %", false)
+        BINARY(Mul, "% * %", false)
+        BINARY(RealDiv, "% / %", false)
+        BINARY(RoundTowards0Div, "% / %", false)
+        BINARY(LT, "% < %", true)
+        BINARY(LE, "% <= %", true)
+        BINARY(GT, "% > %", true)
+        BINARY(GE, "% >= %", true)
+        BINARY(EQ, "% == %", true)
+        BINARY(NE, "% != %", true)
+#undef BINARY
+
+#define BINARY_FUNC(TYPE, FUNC)                                                \
+    case ASTNodeType::TYPE: {                                                  \
+        auto &&op = expr.as<BinaryExprNode>();                                 \
+        ret = vecMap2(FUNC, op->lhs_, op->rhs_, dtype);                        \
+        break;                                                                 \
+    }
+        // The format of Intrinsic can not contain a literal "%", so use
+        // std::modulus for the C-style remainder
+        BINARY_FUNC(FloorDiv, "floorDiv")
+        BINARY_FUNC(CeilDiv, "ceilDiv")
+        BINARY_FUNC(Mod, "runtime_mod")
+        BINARY_FUNC(Remainder, "std::modulus<>()")
+#undef BINARY_FUNC
+
+    case ASTNodeType::Min:
+    case ASTNodeType::Max: {
+        auto &&op = expr.as<BinaryExprNode>();
+        auto l = vec(op->lhs_), r = vec(op->rhs_);
+        if (l.kind_ == VecVal::Scalar && r.kind_ == VecVal::Scalar) {
+            ret = {VecVal::Scalar, nullptr, dtype};
+        } else {
+            auto func = expr->nodeType() == ASTNodeType::Min ? "simd_min"
+                                                              : "simd_max";
+            ret = {VecVal::Vec,
+                   intrinsic(func + lanes(dtype) + "(%, %)",
+                             {broadcast(l, dtype), broadcast(r, dtype)}),
+                   dtype};
+        }
+        break;
+    }
+
+    case ASTNodeType::LAnd:
+    case ASTNodeType::LOr: {
+        auto &&op = expr.as<BinaryExprNode>();
+        auto l = vec(op->lhs_), r = vec(op->rhs_);
+        if (l.kind_ == VecVal::Scalar && r.kind_ == VecVal::Scalar) {
+            ret = {VecVal::Scalar, nullptr, dtype};
+        } else {
+            auto format =
+                expr->nodeType() == ASTNodeType::LAnd ? "% & %" : "% | %";
+            ret = {VecVal::Mask, intrinsic(format, {toMask(l), toMask(r)}),
+                   DataType::Bool};
+        }
+        break;
+    }
+    case ASTNodeType::LNot: {
+        auto v = vec(expr.as<LNotNode>()->expr_);
+        ret = v.kind_ == VecVal::Scalar
+                  ? VecVal{VecVal::Scalar, nullptr, dtype}
+                  : VecVal{VecVal::Mask, intrinsic("~%", {toMask(v)}),
+                           DataType::Bool};
+        break;
+    }
+
+    case ASTNodeType::Square: {
+        auto v = vec(expr.as<SquareNode>()->expr_);
+        ret = v.kind_ == VecVal::Scalar
+                  ? VecVal{VecVal::Scalar, nullptr, dtype}
+                  : VecVal{VecVal::Vec,
+                           intrinsic("% * %", {broadcast(v, dtype),
+                                               broadcast(v, dtype)}),
+                           dtype};
+        break;
+    }
+
+#define UNARY_FUNC(TYPE, FUNC)                                                 \
+    case ASTNodeType::TYPE:                                                    \
+        ret = vecMap(FUNC, expr.as<UnaryExprNode>()->expr_, dtype);            \
+        break;
+        UNARY_FUNC(Sqrt, "std::sqrt")
+        UNARY_FUNC(Exp, "std::exp")
+        UNARY_FUNC(Sigmoid, "runtime_sigmoid")
+        UNARY_FUNC(Tanh, "std::tanh")
+        UNARY_FUNC(Abs, "std::abs")
+        UNARY_FUNC(Floor, "std::floor")
+        UNARY_FUNC(Ceil, "std::ceil")
+#undef UNARY_FUNC
+
+    case ASTNodeType::Cast: {
+        auto &&op = expr.as<CastNode>();
+        auto v = vec(op->expr_);
+        if (v.kind_ == VecVal::Scalar) {
+            ret = {VecVal::Scalar, nullptr, dtype};
+        } else if (isBool(dtype)) {
+            ret = {VecVal::Mask, toMask(v), dtype};
+        } else {
+            ret = {VecVal::Vec, broadcast(v, dtype), dtype};
+        }
+        break;
+    }
+
+    case ASTNodeType::IfExpr: {
+        auto &&op = expr.as<IfExprNode>();
+        auto cond = vec(op->cond_);
+        if (cond.kind_ == VecVal::Scalar) {
+            auto thenCase = vec(op->thenCase_),
+                 elseCase = vec(op->elseCase_);
+            if (thenCase.kind_ == VecVal::Scalar &&
+                elseCase.kind_ == VecVal::Scalar) {
+                ret = {VecVal::Scalar, nullptr, dtype};
+            } else {
+                ret = {VecVal::Vec,
+                       intrinsic("% ? % : %",
+                                 {deepCopy(op->cond_),
+                                  broadcast(thenCase, dtype),
+                                  broadcast(elseCase, dtype)}),
+                       dtype};
+            }
+            break;
+        }
+        // Only access memory in the lanes selected by each branch
+        auto condMask = toMask(cond);
+        auto oldMask = mask_;
+        mask_ = oldMask.isValid()
+                    ? intrinsic("% & %", {deepCopy(oldMask), condMask})
+                    : condMask;
+        auto thenCase = vec(op->thenCase_);
+        mask_ = intrinsic("~%", {deepCopy(condMask)});
+        if (oldMask.isValid()) {
+            mask_ = intrinsic("% & %", {deepCopy(oldMask), mask_});
+        }
+        auto elseCase = vec(op->elseCase_);
+        mask_ = oldMask;
+        ret = {VecVal::Vec,
+               intrinsic("simd_select" + lanes(dtype) + "(%, %, %)",
+                         {deepCopy(condMask), broadcast(thenCase, dtype),
+                          broadcast(elseCase, dtype)}),
+               dtype};
+        break;
+    }
+
+    default:
+        throw InvalidCPUVector("Vectorizing " + toString(expr->nodeType()) +
+                               " is not supported");
+    }
+
+    if (ret.kind_ == VecVal::Scalar) {
+        ret.expr_ = deepCopy(expr);
+    }
+    return ret;
+}
+
+Stmt LowerVector::vecPackedWrite(const std::string &var,
+                                 const std::vector<Expr> &indices,
+                                 const Expr &value) {
+    // Other threads may write other bits in the words at the boundaries
+    auto t = "<" + std::to_string(width_) +
+             (parallelDepth_ > 0 ? ", true>" : ">");
+    auto mask = activeMask();
+    auto &&[elem, contiguous, aligned] = address(var, indices);
+    if (mask_.isValid()) {
+        return makeEval(intrinsic("simd_packed_store_masked" + t + "(%, %, %)",
+                                  {elem, value, mask}, DataType::Void));
+    } else if (count_.isValid()) {
+        return makeEval(
+            intrinsic("simd_packed_store_partial" + t + "(%, %, %)",
+                      {elem, value, deepCopy(count_)}, DataType::Void));
+    } else {
+        return makeEval(intrinsic("simd_packed_store" + t + "(%, %)",
+                                  {elem, value}, DataType::Void));
+    }
+}
+
+Stmt LowerVector::vecWrite(const std::string &var,
+                           const std::vector<Expr> &indices,
+                           const Expr &value) {
+    auto dtype = buffer(var)->tensor()->dtype();
+    if (dtype == DataType::PackedBool) {
+        if (std::all_of(indices.begin(), indices.end(),
+                        [this](const Expr &idx) {
+                            return vec(idx).kind_ == VecVal::Scalar;
+                        })) {
+            throw InvalidCPUVector("Writing to the same location from all "
+                                   "lanes is not supported");
+        }
+        return vecPackedWrite(var, indices, value);
+    }
+    if (isBool(dtype)) {
+        throw InvalidCPUVector("Vectors of booleans in memory are not "
+                               "supported");
+    }
+    if (std::all_of(indices.begin(), indices.end(), [this](const Expr &idx) {
+            return vec(idx).kind_ == VecVal::Scalar;
+        })) {
+        throw InvalidCPUVector("Writing to the same location from all lanes "
+                               "is not supported");
+    }
+
+    auto t = lanes(dtype);
+    auto mask = activeMask();
+    auto &&[addr, contiguous, aligned] = address(var, indices);
+    if (contiguous) {
+        if (mask_.isValid()) {
+            return makeEval(intrinsic("simd_store_masked" + t + "(%, %, %)",
+                                      {addr, value, mask}, DataType::Void));
+        } else if (count_.isValid()) {
+            return makeEval(intrinsic("simd_store_partial" + t + "(%, %, %)",
+                                      {addr, value, deepCopy(count_)},
+                                      DataType::Void));
+        } else if (streamVars_.count(var)) {
+            // Streaming stores check the alignment at run time
+            streamed_ = true;
+            return makeEval(intrinsic("simd_store_stream" + t + "(%, %)",
+                                      {addr, value}, DataType::Void));
+        } else if (aligned) {
+            return makeEval(
+                intrinsic(alignedFunc("simd_store", var, dtype) + "(%, %)",
+                          {addr, value}, DataType::Void));
+        } else {
+            return makeEval(intrinsic("simd_store" + t + "(%, %)",
+                                      {addr, value}, DataType::Void));
+        }
+    } else {
+        std::vector<Expr> zeros;
+        for (size_t i = 0, n = indices.size(); i < n; i++) {
+            zeros.emplace_back(makeIntConst(0));
+        }
+        auto base = intrinsic("&(%)", {makeLoad(var, zeros, dtype)});
+        return makeEval(
+            mask.isValid()
+                ? intrinsic("simd_scatter_masked" + t + "(%, %, %, %)",
+                            {base, addr, value, mask}, DataType::Void)
+                : intrinsic("simd_scatter" + t + "(%, %, %)",
+                            {base, addr, value}, DataType::Void));
+    }
+}
+
+Stmt LowerVector::vecStmt(const Stmt &op) {
+    switch (op->nodeType()) {
+    case ASTNodeType::StmtSeq: {
+        std::vector<Stmt> stmts;
+        for (auto &&stmt : op.as<StmtSeqNode>()->stmts_) {
+            stmts.emplace_back(vecStmt(stmt));
+        }
+        return makeStmtSeq(std::move(stmts), op->metadata(), op->id());
+    }
+
+    case ASTNodeType::Store: {
+        auto &&store = op.as<StoreNode>();
+        auto dtype = buffer(store->var_)->tensor()->dtype();
+        auto value = dtype == DataType::PackedBool
+                         ? toMask(vec(store->expr_))
+                         : broadcast(vec(store->expr_), dtype);
+        return vecWrite(store->var_, store->indices_, value);
+    }
+
+    case ASTNodeType::ReduceTo: {
+        auto &&reduce = op.as<ReduceToNode>();
+        if (accs_.count(reduce->id())) {
+            // Accumulate to the vector, with inactive lanes neutral
+            auto &&name = accs_.at(reduce->id());
+            auto accType =
+                accumulateType(buffer(reduce->var_)->tensor()->dtype());
+            auto t = lanes(accType);
+            auto acc = intrinsic(
+                "simd_load" + t + "(&(%))",
+                {makeLoad(name, {makeIntConst(0)}, accType)});
+            auto value = broadcast(vec(reduce->expr_), accType);
+            if (auto mask = activeMask(); mask.isValid()) {
+                value = intrinsic("simd_select" + t + "(%, %, simd_broadcast" +
+                                      t + "(%))",
+                                  {mask, value, neutral(reduce->op_, accType)});
+            }
+            Expr result;
+            switch (reduce->op_) {
+            case ReduceOp::Add:
+            case ReduceOp::Sub:
+                result = intrinsic("% + %", {acc, value});
+                break;
+            case ReduceOp::Mul:
+                result = intrinsic("% * %", {acc, value});
+                break;
+            case ReduceOp::Min:
+                result = intrinsic("simd_min" + t + "(%, %)", {acc, value});
+                break;
+            case ReduceOp::Max:
+                result = intrinsic("simd_max" + t + "(%, %)", {acc, value});
+                break;
+            default:
+                ASSERT(false);
+            }
+            return makeEval(intrinsic(
+                "simd_store" + t + "(&(%), %)",
+                {makeLoad(name, {makeIntConst(0)}, accType), result},
+                DataType::Void));
+        }
+        if (reduce->atomic_) {
+            throw InvalidCPUVector("Vectorizing atomic reductions is not "
+                                   "supported");
+        }
+        for (auto &&idx : reduce->indices_) {
+            if (!allReads(idx).empty()) {
+                // Lanes may reduce to the same location
+                throw InvalidCPUVector("Vectorizing indirect reductions is "
+                                       "not supported");
+            }
+        }
+        auto dtype = buffer(reduce->var_)->tensor()->dtype();
+        auto accType = accumulateType(dtype);
+        std::vector<Expr> indices;
+        for (auto &&idx : reduce->indices_) {
+            indices.emplace_back(deepCopy(idx));
+        }
+        if (dtype == DataType::PackedBool) {
+            // Bit-wise operations on masks. On booleans, min is "and", and max
+            // is "or"
+            auto old = toMask(vec(makeLoad(reduce->var_, indices, dtype)));
+            auto value = toMask(vec(reduce->expr_));
+            switch (reduce->op_) {
+            case ReduceOp::LAnd:
+            case ReduceOp::Min:
+                return vecWrite(reduce->var_, reduce->indices_,
+                                intrinsic("% & %", {old, value}));
+            case ReduceOp::LOr:
+            case ReduceOp::Max:
+                return vecWrite(reduce->var_, reduce->indices_,
+                                intrinsic("% | %", {old, value}));
+            default:
+                throw InvalidCPUVector("Only logical, min or max reductions "
+                                       "to packed_bool can be vectorized");
+            }
+        }
+        auto old =
+            broadcast(vec(makeLoad(reduce->var_, indices, dtype)), accType);
+        auto value = broadcast(vec(reduce->expr_), accType);
+        Expr result;
+        switch (reduce->op_) {
+        case ReduceOp::Add:
+            result = intrinsic("% + %", {old, value});
+            break;
+        case ReduceOp::Sub:
+            result = intrinsic("% - %", {old, value});
+            break;
+        case ReduceOp::Mul:
+            result = intrinsic("% * %", {old, value});
+            break;
+        case ReduceOp::Min:
+            result = intrinsic("simd_min" + lanes(accType) + "(%, %)",
+                               {old, value});
+            break;
+        case ReduceOp::Max:
+            result = intrinsic("simd_max" + lanes(accType) + "(%, %)",
+                               {old, value});
+            break;
+        default:
+            throw InvalidCPUVector("Vectorizing logical reductions is not "
+                                   "supported");
+        }
+        if (accType != dtype) {
+            result = intrinsic("simd_convert" + lanes(dtype) + "(%)", {result});
+        }
+        return vecWrite(reduce->var_, reduce->indices_, result);
+    }
+
+    case ASTNodeType::If: {
+        auto &&branch = op.as<IfNode>();
+        auto cond = vec(branch->cond_);
+        if (cond.kind_ == VecVal::Scalar) {
+            return makeIf(
+                deepCopy(branch->cond_), vecStmt(branch->thenCase_),
+                branch->elseCase_.isValid() ? vecStmt(branch->elseCase_)
+                                            : nullptr,
+                op->metadata(), op->id());
+        }
+        // The condition is re-evaluated in each masked access
+        for (auto &&name : allReads(branch->cond_)) {
+            if (allWrites(body_).count(name)) {
+                throw InvalidCPUVector("Vectorizing a branch whose condition "
+                                       "reads " +
+                                       name + " written in the loop is not "
+                                              "supported");
+            }
+        }
+        auto condMask = toMask(cond);
+        auto oldMask = mask_;
+        mask_ = oldMask.isValid()
+                    ? intrinsic("% & %", {deepCopy(oldMask), condMask})
+                    : condMask;
+        std::vector<Stmt> stmts{vecStmt(branch->thenCase_)};
+        if (branch->elseCase_.isValid()) {
+            mask_ = intrinsic("~%", {deepCopy(condMask)});
+            if (oldMask.isValid()) {
+                mask_ = intrinsic("% & %", {deepCopy(oldMask), mask_});
+            }
+            stmts.emplace_back(vecStmt(branch->elseCase_));
+        }
+        mask_ = oldMask;
+        return makeStmtSeq(std::move(stmts), op->metadata(), op->id());
+    }
+
+    default:
+        throw InvalidCPUVector("Vectorizing " + toString(op->nodeType()) +
+                               " is not supported");
+    }
+}
+
+std::vector<ReduceTo> LowerVector::horizontalReductions() const {
+    std::vector<ReduceTo> ret;
+    auto others = allUses(body_, AllUses::CHECK_LOAD | AllUses::CHECK_STORE);
+    std::unordered_map<std::string, std::vector<ReduceTo>> byVar;
+    for (auto &&stmt : findAllStmt(body_, "<ReduceTo>")) {
+        auto &&reduce = stmt.as<ReduceToNode>();
+        byVar[reduce->var_].emplace_back(reduce);
+    }
+    for (auto &&[var, reduces] : byVar) {
+        if (others.count(var) || isBool(buffer(var)->tensor()->dtype())) {
+            continue;
+        }
+        if (std::all_of(reduces.begin(), reduces.end(), [&](auto &&reduce) {
+                if (reduce->atomic_ || reduce->op_ != reduces.front()->op_ ||
+                    reduce->op_ == ReduceOp::LAnd ||
+                    reduce->op_ == ReduceOp::LOr) {
+                    return false;
+                }
+                for (auto &&idx : reduce->indices_) {
+                    if (allIters(idx).count(iter_) || !allReads(idx).empty()) {
+                        return false;
+                    }
+                }
+                return true;
+            })) {
+            ret.insert(ret.end(), reduces.begin(), reduces.end());
+        }
+    }
+    return ret;
+}
+
+Expr LowerVector::neutral(ReduceOp op, DataType dtype) const {
+    switch (op) {
+    case ReduceOp::Sub:
+        return neutralVal(dtype, ReduceOp::Add);
+    case ReduceOp::Mul:
+        return makeIntConst(1); // Converted by `simd_broadcast`
+    default:
+        return neutralVal(dtype, op);
+    }
+}
+
+Stmt LowerVector::lowerLoop(const For &op, int width) {
+    iter_ = op->iter_;
+    body_ = op->body_;
+    width_ = width;
+    mask_ = nullptr;
+    auto w = makeIntConst(width);
+
+    // Reductions to loop-invariant locations are accumulated in vectors, and
+    // reduced horizontally after the loop
+    std::vector<Stmt> inits, flushes;
+    std::vector<std::pair<std::string, DataType>> accDefs;
+    for (auto &&reduce : horizontalReductions()) {
+        auto name = reduce->var_ + ".vec_acc." + toString(reduce->id());
+        auto accType = accumulateType(buffer(reduce->var_)->tensor()->dtype());
+        auto t = lanes(accType);
+        accs_[reduce->id()] = name;
+        accDefs.emplace_back(name, accType);
+        inits.emplace_back(makeEval(intrinsic(
+            "simd_store" + t + "(&(%), simd_broadcast" + t + "(%))",
+            {makeLoad(name, {makeIntConst(0)}, accType),
+             neutral(reduce->op_, accType)},
+            DataType::Void)));
+        std::string func;
+        switch (reduce->op_) {
+        case ReduceOp::Add:
+        case ReduceOp::Sub:
+            func = "simd_reduce_add";
+            break;
+        case ReduceOp::Mul:
+            func = "simd_reduce_mul";
+            break;
+        case ReduceOp::Min:
+            func = "simd_reduce_min";
+            break;
+        case ReduceOp::Max:
+            func = "simd_reduce_max";
+            break;
+        default:
+            ASSERT(false);
+        }
+        std::vector<Expr> indices;
+        for (auto &&idx : reduce->indices_) {
+            indices.emplace_back(deepCopy(idx));
+        }
+        flushes.emplace_back(makeReduceTo(
+            reduce->var_, std::move(indices), reduce->op_,
+            intrinsic(func + t + "(simd_load" + t + "(&(%)))",
+                      {makeLoad(name, {makeIntConst(0)}, accType)}, accType),
+            false));
+    }
+
+    // Main loop: `width` lanes per iteration
+    base_ = makeVar(op->iter_);
+    count_ = nullptr;
+    aligned_ = op->begin_->nodeType() == ASTNodeType::IntConst &&
+               op->begin_.as<IntConstNode>()->val_ % width == 0;
+    auto mainBody = vecStmt(op->body_);
+    auto mainLen = makeFloorDiv(deepCopy(op->len_), w);
+    auto mainEnd = makeAdd(deepCopy(op->begin_),
+                           makeMul(deepCopy(mainLen), deepCopy(w)));
+    auto property = op->property_->withVectorize(false);
+    auto main = makeFor(op->iter_, deepCopy(op->begin_), mainEnd, deepCopy(w),
+                        mainLen, std::move(property), mainBody,
+                        op->metadata(), op->id());
+
+    // Tail: the remaining `len % width` iterations, masked
+    base_ = deepCopy(mainEnd);
+    count_ = makeMod(deepCopy(op->len_), deepCopy(w));
+    aligned_ = false;
+    auto tailBody = vecStmt(op->body_);
+    auto tail = makeIf(makeLAnd(makeGT(deepCopy(op->len_), makeIntConst(0)),
+                                makeNE(deepCopy(count_), makeIntConst(0))),
+                       tailBody);
+
+    iter_.clear();
+    body_ = nullptr;
+    base_ = count_ = nullptr;
+    accs_.clear();
+    if (accDefs.empty()) {
+        return makeStmtSeq(std::vector<Stmt>{main, tail});
+    }
+    std::vector<Stmt> stmts = std::move(inits);
+    stmts.emplace_back(main);
+    stmts.emplace_back(tail);
+    stmts.insert(stmts.end(), flushes.begin(), flushes.end());
+    Stmt ret = makeStmtSeq(std::move(stmts));
+    for (auto &&[name, accType] : accDefs) {
+        ret = makeVarDef(name,
+                         makeBuffer(makeTensor({makeIntConst(width)}, accType),
+                                    AccessType::Cache, MemType::CPU),
+                         std::nullopt, ret, false);
+    }
+    return ret;
+}
+
+Stmt LowerVector::visit(const For &op) {
+    bool oldStreamed = streamed_;
+    streamed_ = false;
+    bool parallel =
+        std::holds_alternative<OpenMPScope>(op->property_->parallel_);
+    loopDepth_++;
+    parallelDepth_ += parallel;
+    auto ret = visitLoop(op);
+    parallelDepth_ -= parallel;
+    loopDepth_--;
+    if (streamed_) {
+        // Streaming stores are weakly ordered. Fence them before other threads
+        // may read the results, i.e. before the implicit barrier of a parallel
+        // loop, or before returning. A fence at the end of the body of an
+        // OpenMP loop is emitted by codeGenCPU once per thread after the loop,
+        // instead of in every iteration
+        auto fence = makeEval(
+            makeIntrinsic("simd_stream_fence()", {}, DataType::Void, true));
+        if (std::holds_alternative<OpenMPScope>(op->property_->parallel_)) {
+            ASSERT(ret->nodeType() == ASTNodeType::For);
+            auto loop = ret.as<ForNode>();
+            loop->body_ = makeStmtSeq({loop->body_, fence});
+            streamed_ = false;
+        } else if (loopDepth_ == 0) {
+            ret = makeStmtSeq({ret, fence});
+            streamed_ = false;
+        }
+    }
+    streamed_ = streamed_ || oldStreamed;
+    return ret;
+}
+
+Stmt LowerVector::visitScalarLoop(const For &op) {
+    auto ret = BaseClass::visit(op);
+    // `#pragma omp simd` does not allow the lanes to reduce to the same
+    // location, so such loops are not vectorized by the backend compiler
+    for (auto &&reduce : findAllStmt(op->body_, "<ReduceTo>")) {
+        auto &&indices = reduce.as<ReduceToNode>()->indices_;
+        if (std::none_of(indices.begin(), indices.end(), [&](auto &&idx) {
+                return allIters(idx).count(op->iter_);
+            })) {
+            ASSERT(ret->nodeType() == ASTNodeType::For);
+            auto loop = ret.as<ForNode>();
+            loop->property_ = loop->property_->withVectorize(false);
+            break;
+        }
+    }
+    return ret;
+}
+
+Stmt LowerVector::visitLoop(const For &op) {
+    if (!op->property_->vectorize_ ||
+        op->property_->parallel_ != serialScope ||
+        op->step_->nodeType() != ASTNodeType::IntConst ||
+        op->step_.as<IntConstNode>()->val_ != 1) {
+        return BaseClass::visit(op);
+    }
+
+    try {
+        // The widest type determines the number of lanes. Variables defined
+        // inside the loop are not supported
+        size_t elemBytes = sizeOf(DataType::Int32); // The iterator
+        for (auto &&name : allUses(op->body_)) {
+            if (!hasDef(name)) {
+                throw InvalidCPUVector(
+                    "Vectorizing a loop defining variables is not supported");
+            }
+            // Bits of packed_bool do not limit the number of lanes
+            if (auto dtype = buffer(name)->tensor()->dtype();
+                dtype != DataType::PackedBool) {
+                elemBytes = std::max(elemBytes, sizeOf(dtype));
+            }
+        }
+        int width = vectorBytes_ / elemBytes;
+        if (width < 2) {
+            return visitScalarLoop(op);
+        }
+        return lowerLoop(op, width);
+    } catch (const InvalidCPUVector &e) {
+        WARNING("Vectorizing loop " + toString(op->id()) + "(" +
+                toString(op->metadata()) +
+                ") with explicit SIMD failed because: " + e.what() +
+                ". Leaving it to the backend compiler");
+        iter_.clear();
+        body_ = nullptr;
+        base_ = count_ = mask_ = nullptr;
+        accs_.clear();
+        streamed_ = false;
+        return visitScalarLoop(op);
+    }
+}
+
+Stmt lowerVector(const Stmt &_op, const Ref<CPUTarget> &target) {
+    // Write-only outputs: not loaded, not reduced to, and not aliased by views
+    std::unordered_set<std::string> streamVars;
+    if (target->streamingStores()) {
+        auto reads = allUses(_op, AllUses::CHECK_LOAD | AllUses::CHECK_REDUCE);
+        auto defs = findAllStmt(_op, "<VarDef>");
+        std::unordered_set<std::string> viewed;
+        for (auto &&def : defs) {
+            if (auto &&viewOf = def.as<VarDefNode>()->viewOf_;
+                viewOf.has_value()) {
+                viewed.insert(def.as<VarDefNode>()->name_);
+                viewed.insert(*viewOf);
+            }
+        }
+        for (auto &&def : defs) {
+            auto &&name = def.as<VarDefNode>()->name_;
+            if (def.as<VarDefNode>()->buffer_->atype() == AccessType::Output &&
+                !reads.count(name) && !viewed.count(name)) {
+                streamVars.insert(name);
+            }
+        }
+    }
+
+    auto op = LowerVector(target->vectorBytes(), streamVars)(_op);
+    return simplify(op);
+}
+
+} // namespace cpu
+
+} // namespace freetensor
@@ -222,7 +222,9 @@ Stmt MakeParallelReduction::visit(const For &_op) {
              cacheAtomic_.at(op->id())) {
             auto cacheName =
                 reduce->var_ + ".atomic_cache." + toString(reduce->id());
-            auto dtype = buffer(reduce->var_)->tensor()->dtype();
+            // The cache is kept in the accumulation type
+            auto dtype =
+                accumulateType(buffer(reduce->var_)->tensor()->dtype());
             auto mtype = localMType(buffer(reduce->var_)->mtype());
             std::vector<Expr> cacheIndices;
             for (size_t i = 0, j = 0, n = newShape.size(); i < n; i++) {
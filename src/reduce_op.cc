@@ -9,6 +9,8 @@ Expr neutralVal(DataType dtype, ReduceOp op) {
     switch (dtype) {
     case DataType::Float64:
     case DataType::Float32:
+    case DataType::Float16:
+    case DataType::BFloat16:
         switch (op) {
         case ReduceOp::Add:
             return makeFloatConst(0.);
@@ -44,7 +46,31 @@ Expr neutralVal(DataType dtype, ReduceOp op) {
             ASSERT(false);
         }
 
+    case DataType::Int8:
+        switch (op) {
+        case ReduceOp::Add:
+            return makeIntConst(0);
+        case ReduceOp::Max:
+            return makeIntConst(SCHAR_MIN);
+        case ReduceOp::Min:
+            return makeIntConst(SCHAR_MAX);
+        default:
+            ASSERT(false);
+        }
+
+    case DataType::UInt8:
+        switch (op) {
+        case ReduceOp::Add:
+        case ReduceOp::Max:
+            return makeIntConst(0);
+        case ReduceOp::Min:
+            return makeIntConst(UCHAR_MAX);
+        default:
+            ASSERT(false);
+        }
+
     case DataType::Bool:
+    case DataType::PackedBool:
         switch (op) {
         case ReduceOp::LAnd:
             return makeBoolConst(true);
@@ -108,7 +108,7 @@ std::vector<AutoScheduleTuneTrial> Schedule::tuneAutoSchedule(
             if (verbose_ >= 1) {
                 logger() << "Tuning auto_schedule: Batch " << i << std::endl;
             }
-            std::vector<Ref<Driver>> drivers(batchSize);
+            std::vector<std::shared_future<Ref<Driver>>> drivers(batchSize);
             exceptSafeParallelFor<size_t>(
                 0, batchSize, 1,
                 [&](size_t j) {
@@ -119,12 +119,20 @@ std::vector<AutoScheduleTuneTrial> Schedule::tuneAutoSchedule(
                     s.autoSchedule(*device->target(), trace);
                     lowered = lower(s.func(), device->target());
                     code = codeGen(lowered, device->target());
-                    drivers[j] = Ref<Driver>::make(lowered, code, device);
                 },
                 omp_sched_static); // use schedule(static) to guarantee
                                    // deterministic RNG
+            // Compile in background, so measuring a Driver overlaps with
+            // compiling the following ones. We can't overlap with the next
+            // batch, because it is sampled from what we learn from this batch
             for (int j = 0; j < batchSize; j++) {
-                auto &d = *drivers[j];
+                auto &&[_1, lowered, code, _2, _3] = trials[i * batchSize + j];
+                drivers[j] = buildDriverAsync(lowered, code, device);
+            }
+            for (int j = 0; j < batchSize; j++) {
+                auto driver = drivers[j].get();
+                drivers[j] = {}; // Unload after measured
+                auto &d = *driver;
                 auto &[trace, _1, _2, t, stddev] = trials[i * batchSize + j];
                 d.setArgs(args, kws);
                 // TODO: Allow setting measuring repeats
@@ -20,8 +20,15 @@ Stmt MakeCacheVar::visitStmt(const Stmt &op) {
         inStmt_ = true;
         auto ret = Mutator::visitStmt(op);
         inStmt_ = false;
+        Ref<Tensor> tensor = deepCopy(def_->buffer_->tensor());
+        if (isReduction_) {
+            // Reduce into the cache in the accumulation type, and round only
+            // once when reducing the cache back
+            tensor = makeTensor(tensor->shape(),
+                                accumulateType(tensor->dtype()));
+        }
         Ref<Buffer> newBuffer =
-            makeBuffer(def_->buffer_->tensor(), AccessType::Cache, mtype_);
+            makeBuffer(std::move(tensor), AccessType::Cache, mtype_);
         ret = makeVarDef(newVar_, std::move(newBuffer), std::nullopt,
                          std::move(ret), false);
         oldDef_ = def_->id();
@@ -183,9 +190,9 @@ Stmt MakeInitAndReduce::visitStmt(const Stmt &_op) {
             }
         }
 
-        Stmt init = makeStore(
-            newVar_, indices,
-            neutralVal(def_->buffer_->tensor()->dtype(), reduce_->op_));
+        auto accType = accumulateType(def_->buffer_->tensor()->dtype());
+        Stmt init =
+            makeStore(newVar_, indices, neutralVal(accType, reduce_->op_));
         initStmt_ = init->id();
         if (idx1d.isValid()) {
             init = makeIf(makeLT(idx1d, sizeLim), init);
@@ -196,8 +203,7 @@ Stmt MakeInitAndReduce::visitStmt(const Stmt &_op) {
 
         Stmt reduce = makeReduceTo(
             oldVar_, indices, reduce_->op_,
-            makeLoad(newVar_, indices, def_->buffer_->tensor()->dtype()),
-            false);
+            makeLoad(newVar_, indices, accType), false);
         reduceStmt_ = reduce->id();
         if (idx1d.isValid()) {
             reduce = makeIf(makeLT(idx1d, sizeLim), reduce);
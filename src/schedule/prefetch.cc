@@ -0,0 +1,195 @@
+#include <analyze/all_uses.h>
+#include <hash.h>
+#include <pass/replace_iter.h>
+#include <schedule.h>
+#include <schedule/prefetch.h>
+
+namespace freetensor {
+
+namespace {
+
+/**
+ * Collect Loads in post order, so a Load appears after the Loads in its
+ * indices
+ */
+class CollectLoads : public Visitor {
+    std::vector<Load> loads_;
+
+  public:
+    const std::vector<Load> &loads() const { return loads_; }
+
+  protected:
+    void visit(const Load &op) override {
+        Visitor::visit(op);
+        loads_.emplace_back(op);
+    }
+};
+
+} // Anonymous namespace
+
+Stmt Prefetch::makePrefetch(const std::vector<Expr> &indices, bool isWrite,
+                            const Stmt &from) {
+    auto &&iter = loopNode_->iter_;
+
+    // The future address can only be computed from the iterator and values
+    // that live across iterations
+    bool dependsOnIter = false;
+    for (auto &&idx : indices) {
+        if (allIters(idx).count(iter)) {
+            dependsOnIter = true;
+        }
+        for (auto &&name : allReads(idx)) {
+            if (defsInLoop_.count(name)) {
+                return nullptr;
+            }
+        }
+    }
+    if (!dependsOnIter) {
+        return nullptr;
+    }
+
+    auto future = makeAdd(makeVar(iter), makeIntConst(distance_ * step_));
+    std::vector<Expr> futureIndices;
+    futureIndices.reserve(indices.size());
+    for (auto &&idx : indices) {
+        futureIndices.emplace_back(ReplaceIter(iter, future)(deepCopy(idx)));
+    }
+    auto dtype = buffer(var_)->tensor()->dtype();
+    auto target = makeLoad(var_, futureIndices, dtype).as<LoadNode>();
+
+    // Only prefetch for iterations that exist, and only load indices in
+    // bounds. The guards of inner Loads come first, so the short-circuit
+    // evaluation never reads out of bounds
+    Expr cond = step_ > 0 ? makeLT(deepCopy(future), deepCopy(loopNode_->end_))
+                          : makeGT(deepCopy(future), deepCopy(loopNode_->end_));
+    CollectLoads collector;
+    for (auto &&idx : futureIndices) {
+        collector(idx);
+    }
+    auto loads = collector.loads();
+    loads.emplace_back(target);
+    for (auto &&load : loads) {
+        auto &&shape = buffer(load->var_)->tensor()->shape();
+        for (auto &&[idx, dim] : views::zip(load->indices_, shape)) {
+            cond = makeLAnd(cond, makeGE(deepCopy(idx), makeIntConst(0)));
+            cond = makeLAnd(cond, makeLT(deepCopy(idx), deepCopy(dim)));
+        }
+    }
+
+    auto call = makeIntrinsic("__builtin_prefetch(&(%), " +
+                                  std::to_string((int)isWrite) + ", 3)",
+                              {target}, DataType::Void, true, true);
+    return makeIf(cond, makeEval(call, makeMetadata("prefetch", from)));
+}
+
+Stmt Prefetch::visitStmt(const Stmt &op) {
+    auto ret = BaseClass::visitStmt(op);
+    if (!loopNode_.isValid() || defsInLoop_.count(var_) ||
+        (ret->nodeType() != ASTNodeType::Store &&
+         ret->nodeType() != ASTNodeType::ReduceTo)) {
+        return ret;
+    }
+
+    std::vector<std::pair<std::vector<Expr>, bool>> accesses;
+    CollectLoads collector;
+    collector(ret);
+    for (auto &&load : collector.loads()) {
+        if (load->var_ == var_) {
+            accesses.emplace_back(load->indices_, false);
+        }
+    }
+    if (ret->nodeType() == ASTNodeType::Store &&
+        ret.as<StoreNode>()->var_ == var_) {
+        accesses.emplace_back(ret.as<StoreNode>()->indices_, true);
+    }
+    if (ret->nodeType() == ASTNodeType::ReduceTo &&
+        ret.as<ReduceToNode>()->var_ == var_) {
+        accesses.emplace_back(ret.as<ReduceToNode>()->indices_, true);
+    }
+
+    std::vector<Stmt> stmts;
+    std::vector<Expr> prefetched;
+    for (auto &&[indices, isWrite] : accesses) {
+        if (auto pf = makePrefetch(indices, isWrite, ret); pf.isValid()) {
+            auto &&addr = pf.as<IfNode>()
+                              ->thenCase_.as<EvalNode>()
+                              ->expr_.as<IntrinsicNode>()
+                              ->params_.front();
+            if (std::none_of(prefetched.begin(), prefetched.end(),
+                             [&](const Expr &other) {
+                                 return HashComparator()(other, addr);
+                             })) {
+                prefetched.emplace_back(addr);
+                stmts.emplace_back(pf);
+            }
+        }
+    }
+    if (stmts.empty()) {
+        return ret;
+    }
+    inserted_ += stmts.size();
+    stmts.emplace_back(ret);
+    return makeStmtSeq(std::move(stmts));
+}
+
+Stmt Prefetch::visit(const For &op) {
+    if (op->id() != loop_) {
+        return BaseClass::visit(op);
+    }
+    if (op->step_->nodeType() != ASTNodeType::IntConst ||
+        op->step_.as<IntConstNode>()->val_ == 0) {
+        throw InvalidSchedule("The step of loop " + toString(loop_) +
+                              " should be a non-zero constant");
+    }
+    found_ = true;
+    loopNode_ = op;
+    step_ = op->step_.as<IntConstNode>()->val_;
+    auto ret = BaseClass::visit(op);
+    loopNode_ = nullptr;
+    return ret;
+}
+
+Stmt Prefetch::visit(const VarDef &op) {
+    if (!loopNode_.isValid()) {
+        return BaseClass::visit(op);
+    }
+    defsInLoop_.insert(op->name_);
+    auto ret = BaseClass::visit(op);
+    defsInLoop_.erase(op->name_);
+    return ret;
+}
+
+Stmt prefetch(const Stmt &_ast, const ID &loop, const std::string &var,
+              int distance) {
+    if (distance <= 0) {
+        throw InvalidSchedule("The distance to prefetch should be positive");
+    }
+    Prefetch mutator(loop, var, distance);
+    auto ast = mutator(_ast);
+    if (!mutator.found()) {
+        throw InvalidSchedule("Loop " + toString(loop) + " not found");
+    }
+    if (mutator.inserted() == 0) {
+        throw InvalidSchedule("No access to " + var + " in loop " +
+                              toString(loop) +
+                              " has a predictable address in later "
+                              "iterations");
+    }
+    return ast;
+}
+
+void Schedule::prefetch(const ID &loop, const std::string &var,
+                        int distance) {
+    beginTransaction();
+    auto log = appendLog(MAKE_SCHEDULE_LOG(Prefetch, freetensor::prefetch,
+                                           loop, var, distance));
+    try {
+        applyLog(log);
+        commitTransaction();
+    } catch (const InvalidSchedule &e) {
+        abortTransaction();
+        throw InvalidSchedule(log, ast(), e.what());
+    }
+}
+
+} // namespace freetensor
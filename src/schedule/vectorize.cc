@@ -1,4 +1,6 @@
+#include <analyze/all_uses.h>
 #include <analyze/deps.h>
+#include <analyze/find_stmt.h>
 #include <schedule.h>
 #include <schedule/vectorize.h>
 
@@ -24,10 +26,36 @@ Stmt vectorize(const Stmt &_ast, const ID &loop) {
     auto found = [&](const Dependency &d) {
         throw InvalidSchedule(toString(d) + " cannot be resolved");
     };
+    // Reductions on CPU to a location invariant in the loop are accumulated in
+    // vectors and reduced horizontally. See `cpu::lowerVector`
+    auto iter = findStmt(ast, loop).as<ForNode>()->iter_;
+    auto horizontal = [&](const AccessPoint &acc) {
+        if (acc.op_->nodeType() != ASTNodeType::ReduceTo ||
+            (acc.buffer_->mtype() != MemType::CPU &&
+             acc.buffer_->mtype() != MemType::CPUHeap)) {
+            return false;
+        }
+        auto &&reduce = acc.op_.as<ReduceToNode>();
+        if (reduce->atomic_ || reduce->op_ == ReduceOp::LAnd ||
+            reduce->op_ == ReduceOp::LOr ||
+            isBool(acc.buffer_->tensor()->dtype())) {
+            return false;
+        }
+        return std::none_of(reduce->indices_.begin(), reduce->indices_.end(),
+                            [&](const Expr &idx) {
+                                return allIters(idx).count(iter) ||
+                                       !allReads(idx).empty();
+                            });
+    };
     FindDeps()
         .direction({{{loop, DepDirection::Normal}}})
         .ignoreReductionWAW(false)
-        .filterSubAST(loop)(ast, found);
+        .filterSubAST(loop)
+        .filter([&](const AccessPoint &later, const AccessPoint &earlier) {
+            return !horizontal(later) || !horizontal(earlier) ||
+                   later.op_.as<ReduceToNode>()->op_ !=
+                       earlier.op_.as<ReduceToNode>()->op_;
+        })(ast, found);
     return ast;
 }
 
@@ -1,4 +1,5 @@
 #include <config.h>
+#include <driver/cpu_memory_pool.h>
 #include <serialize/load_driver.h>
 
 #include <cstring>
@@ -25,7 +26,12 @@ Ref<Target> loadTarget(const std::string &txt, const std::string &data) {
     }
 #endif // FT_WITH_CUDA
     case 'C': {
-        return Ref<CPUTarget>::make(useNativeArch);
+        int vectorBytes = 0;          // Absent in older dumps
+        bool streamingStores = false; // Absent in older dumps
+        std::string blas = "default"; // Absent in older dumps
+        iss >> vectorBytes >> streamingStores >> blas;
+        return Ref<CPUTarget>::make(useNativeArch, vectorBytes,
+                                    streamingStores, parseBLASProvider(blas));
     }
     default:
         ASSERT(false);
@@ -63,16 +69,16 @@ Ref<Array> newArray(const std::vector<size_t> &shape_,
                     const std::string &dtypestr_, const std::string &data_) {
 
     DataType dtype = parseDType(dtypestr_);
-    size_t siz = sizeOf(dtype);
-
+    size_t nElem = 1;
     for (auto len : shape_) {
-        siz *= len;
+        nElem *= len;
     }
+    size_t siz = storageBytes(dtype, nElem);
 
     // Data form: uint8_t
     ASSERT(data_.length() == siz);
 
-    uint8_t *addr = new uint8_t[siz];
+    auto addr = (uint8_t *)CPUMemoryPool::instance().alloc(siz);
     memcpy(addr, (uint8_t *)data_.c_str(), siz);
 
     auto ret = Ref<Array>::make(
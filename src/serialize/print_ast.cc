@@ -662,6 +662,9 @@ void PrintVisitor::visit(const Intrinsic &op) {
     if (op->hasSideEffect_) {
         os() << ", @!side_effect";
     }
+    if (op->isHint_) {
+        os() << ", @!hint";
+    }
     os() << ")";
 }
 
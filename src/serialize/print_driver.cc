@@ -11,6 +11,12 @@ std::pair<std::string, std::string> dumpTarget(const Ref<Target> &target_) {
     std::string ret_meta =
         target->toString() + " " + std::to_string(target->useNativeArch());
     std::string ret_data;
+    if (target->type() == TargetType::CPU) {
+        auto &&cpu = target.as<CPUTarget>();
+        ret_meta += " " + std::to_string(cpu->vectorBytes()) + " " +
+                    std::to_string(cpu->streamingStores()) + " " +
+                    toString(cpu->blas());
+    }
 
     // TODO
     switch (target->type()) {
@@ -0,0 +1,67 @@
+import freetensor as ft
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+
+
+def test_aligned_params():
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(256,), "float32", "input", "cpu"]
+        y: ft.Var[(256,), "float32", "output", "cpu"]
+        #! label: L
+        for i in range(256):
+            y[i] = x[i] * 2
+
+    s = ft.Schedule(f)
+    s.vectorize("L")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "runtime_assume_aligned<ALIGNED>" in str(code)
+    assert "simd_load_aligned_if<ALIGNED" in str(code)
+    driver = ft.build_binary(code, device)
+    x_np = np.random.rand(256).astype("float32")
+    y_arr = ft.Array(np.zeros((256,), dtype="float32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.array_equal(y_arr.numpy(), x_np * 2)
+
+
+def test_unaligned_borrowed_params():
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(256,), "float32", "input", "cpu"]
+        y: ft.Var[(256,), "float32", "output", "cpu"]
+        #! label: L
+        for i in range(256):
+            y[i] = x[i] * 2
+
+    s = ft.Schedule(f)
+    s.vectorize("L")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    driver = ft.build_binary(code, device)
+
+    # Offset by one element, so the borrowed data is never 64-byte aligned,
+    # and the Driver must fall back to `run_unaligned`
+    x_buf = np.random.rand(257).astype("float32")
+    y_buf = np.zeros((257,), dtype="float32")
+    x_arr = ft.Array(x_buf[1:])
+    y_arr = ft.Array(y_buf[1:])
+    assert x_arr.alignment_on(device) % 64 != 0
+    driver(x=x_arr, y=y_arr)
+    assert np.array_equal(y_buf[1:], x_buf[1:] * 2)
+
+
+def test_huge_pages():
+    old = ft.array_huge_pages()
+    try:
+        ft.set_array_huge_pages(True)
+        big = ft.Array.pack_bools(np.zeros((1 << 25,), dtype="bool"))
+        assert big.alignment_on(device) == 2 << 20
+        small = ft.Array.pack_bools(np.zeros((64,), dtype="bool"))
+        assert small.alignment_on(device) == 64
+    finally:
+        ft.set_array_huge_pages(old)
@@ -0,0 +1,155 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def test_slice_to_numpy():
+    x_np = np.random.rand(6, 8).astype("float32")
+    x_arr = ft.array(x_np)
+    assert np.array_equal(x_arr[2:5].numpy(), x_np[2:5])
+    assert np.array_equal(x_arr[1, 2:7:2].numpy(), x_np[1, 2:7:2])
+    assert np.array_equal(x_arr[:, -3:][1:4].numpy(), x_np[:, -3:][1:4])
+    assert x_arr[3].shape == [8]
+
+
+def test_contiguous_view_shares_memory():
+    x_np = np.zeros((10, 4, 5), dtype="float32")
+    x_arr = ft.array(x_np)
+    batch = x_arr[3:6]
+    assert batch.is_view
+    assert batch.contiguous
+    batch.numpy()[:] = 1
+    assert np.all(x_np[3:6] == 1)
+    assert np.all(x_np[:3] == 0)
+    assert not x_arr[:, 1:3].contiguous
+
+
+def test_contiguous_view_as_args():
+    x_np = np.random.rand(10, 4).astype("float32")
+    y_np = np.zeros((10, 4), dtype="float32")
+    y_arr = ft.array(y_np)
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(3, 4), "float32", "input", "cpu"]
+        y: ft.Var[(3, 4), "float32", "output", "cpu"]
+        for i in range(3):
+            for j in range(4):
+                y[i, j] = x[i, j] + 1
+
+    device = ft.CPU()
+    target = device.target()
+    driver = ft.build_binary(ft.codegen(ft.lower(f, target), target), device)
+    driver(x=ft.array(x_np)[2:5], y=y_arr[6:9])
+    # Written in place, and the other rows are kept
+    assert np.array_equal(y_np[6:9], x_np[2:5] + 1)
+    assert np.all(y_np[:6] == 0)
+    assert np.all(y_np[9:] == 0)
+
+
+def test_strided_view_as_args():
+    x_np = np.random.rand(4, 10).astype("float32")
+    y_np = np.zeros((6, 10), dtype="float32")
+    y_arr = ft.array(y_np)
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(3, 4), "float32", "input", "cpu"]
+        y: ft.Var[(3, 4), "float32", "output", "cpu"]
+        for i in range(3):
+            for j in range(4):
+                y[i, j] = x[i, j] + 1
+
+    device = ft.CPU()
+    target = device.target()
+    driver = ft.build_binary(ft.codegen(ft.lower(f, target), target), device)
+    driver(x=ft.array(x_np)[1:, 2:9:2], y=y_arr[1:6:2, 5:9])
+    y_std = np.zeros((6, 10), dtype="float32")
+    y_std[1:6:2, 5:9] = x_np[1:, 2:9:2] + 1
+    assert np.array_equal(y_arr.numpy(), y_std)
+
+
+def test_strided_view_bound_to_multiple_frames():
+    x_np = np.random.rand(4, 10).astype("float32")
+    x_arr = ft.array(x_np)
+    view = x_arr[1:, 2:9:2]
+    x_std = x_np[1:, 2:9:2].copy()  # `x_np` may be shared and written
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(3, 4), "float32", "input", "cpu"]
+        y: ft.Var[(3, 4), "float32", "output", "cpu"]
+        for i in range(3):
+            for j in range(4):
+                y[i, j] = x[i, j] + 1
+
+    @ft.transform
+    def g(x):
+        x: ft.Var[(4, 10), "float32", "inout", "cpu"]
+        for i in range(4):
+            for j in range(10):
+                x[i, j] *= 2
+
+    device = ft.CPU()
+    target = device.target()
+    driver = ft.build_binary(ft.codegen(ft.lower(f, target), target), device)
+    writer = ft.build_binary(ft.codegen(ft.lower(g, target), target), device)
+
+    # Both frames read the same gathered copy
+    frame1, frame2 = driver.new_frame(), driver.new_frame()
+    y1_arr = ft.array(np.zeros((3, 4), dtype="float32"))
+    y2_arr = ft.array(np.zeros((3, 4), dtype="float32"))
+    frame1.set_args(x=view, y=y1_arr)
+    frame2.set_args(x=view, y=y2_arr)
+    frame1.run()
+    frame2.run()
+    frame1.collect_returns()
+    frame2.collect_returns()
+    assert np.array_equal(y1_arr.numpy(), x_std + 1)
+    assert np.array_equal(y2_arr.numpy(), x_std + 1)
+
+    # Gathering again after the base is written would free the copy still
+    # used by the first frame
+    frame1.set_args(x=view, y=y1_arr)
+    writer(x_arr)
+    with pytest.raises(ft.DriverError):
+        frame2.set_args(x=view, y=y2_arr)
+    frame1.run()
+    frame1.collect_returns()
+    assert np.array_equal(y1_arr.numpy(), x_std + 1)
+
+    # Fine after the first frame is done
+    frame2.set_args(x=view, y=y2_arr)
+    frame2.run()
+    frame2.collect_returns()
+    assert np.array_equal(y2_arr.numpy(), x_std * 2 + 1)
+
+
+def test_batch_of_views():
+    x_np = np.random.rand(8, 3, 4).astype("float32")
+    y_np = np.zeros((8, 3, 4), dtype="float32")
+    x_arr, y_arr = ft.array(x_np), ft.array(y_np)
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(3, 4), "float32", "input", "cpu"]
+        y: ft.Var[(3, 4), "float32", "output", "cpu"]
+        for i in range(3):
+            for j in range(4):
+                y[i, j] = x[i, j] + 1
+
+    device = ft.CPU()
+    target = device.target()
+    driver = ft.build_binary(ft.codegen(ft.lower(f, target), target), device)
+    driver.run_batch([[x_arr[k], y_arr[k]] for k in range(8)])
+    assert np.array_equal(y_np, x_np + 1)
+
+
+def test_out_of_range():
+    x_arr = ft.array(np.zeros((4, 5), dtype="float32"))
+    with pytest.raises(IndexError):
+        x_arr[4]
+    with pytest.raises(ft.DriverError):
+        x_arr[::-1]
+    with pytest.raises(ft.DriverError):
+        x_arr[0, 0, 0]
@@ -0,0 +1,94 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def test_benchmark():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "float32"]
+        y = ft.empty((1000,), "float32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    f.set_args(np.random.rand(1000).astype("float32"))
+    result = f.benchmark(min_rounds=10, max_rounds=200)
+    f.collect_returns()
+
+    assert 10 <= result.rounds <= 200
+    assert len(result.times) == result.rounds
+    assert result.min <= result.median <= result.max
+    assert result.percentile(0) == result.min
+    assert result.percentile(100) == result.max
+    assert result.percentile(50) == result.median
+    assert result.min <= result.mean <= result.max
+    assert result.outliers < result.rounds
+    if result.converged:
+        assert result.rel_ci <= 0.01
+
+
+def test_benchmark_fixed_rounds():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "float32"]
+        y = ft.empty((1000,), "float32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    f.set_args(np.random.rand(1000).astype("float32"))
+    result = f.benchmark(min_rounds=20,
+                         max_rounds=20,
+                         target_rel_ci=0,
+                         time_budget=0,
+                         flush_cache=True,
+                         reject_outliers=False)
+    f.collect_returns()
+
+    assert result.rounds == 20
+    assert not result.converged
+    assert result.outliers == 0
+    assert result.mean == pytest.approx(np.mean(result.times))
+
+
+def test_benchmark_invalid_rounds():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "float32"]
+        y = ft.empty((1000,), "float32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    f.set_args(np.random.rand(1000).astype("float32"))
+    with pytest.raises(ft.DriverError):
+        f.benchmark(min_rounds=10, max_rounds=5)
+    f.collect_returns()
+
+
+def test_benchmark_perf_counters():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "float32"]
+        y = ft.empty((1000,), "float32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    f.set_args(np.random.rand(1000).astype("float32"))
+    result = f.benchmark(min_rounds=10, max_rounds=10, perf_counters=True)
+    f.collect_returns()
+
+    # Counters may be unavailable due to permission, in which case the result
+    # is still valid but without counters
+    assert result.rounds == 10
+    assert set(result.counters.keys()) <= {
+        "cycles", "instructions", "llc_misses", "l1d_misses", "branch_misses"
+    }
+    if "instructions" in result.counters:
+        assert result.counters["instructions"] > 1000
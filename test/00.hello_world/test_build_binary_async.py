@@ -0,0 +1,36 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def test_build_async():
+    with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                    ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            y[i] = x[i] + 1
+    func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+    code = ft.codegen(func)
+
+    futures = [ft.build_binary_async(code) for _ in range(4)]
+    for future in futures:
+        x_np = np.array([1, 2, 3, 4], dtype="int32")
+        y_np = np.zeros((4,), dtype="int32")
+        x_arr = ft.Array(x_np)
+        y_arr = ft.Array(y_np)
+        future.get()(x_arr, y_arr)
+        assert future.ready()
+        assert np.array_equal(y_arr.numpy(),
+                              np.array([2, 3, 4, 5], dtype="int32"))
+
+
+def test_build_async_error():
+    with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                    ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            y[i] = x[i] + 1
+    func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+    code = ft.codegen(func)
+    code = ft.NativeCode(code.func, "this is not C++", code.target)
+    future = ft.build_binary_async(code)
+    with pytest.raises(ft.DriverError):
+        future.get()
@@ -0,0 +1,73 @@
+import threading
+
+import freetensor as ft
+import numpy as np
+
+
+def test_frame():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "int32"]
+        y = ft.empty((1000,), "int32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    frame = f.new_frame()
+    x_np = np.random.randint(0, 100, (1000,)).astype("int32")
+    y_arr = frame(x_np)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+
+
+def test_frames_in_threads():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "int32"]
+        y = ft.empty((1000,), "int32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    errors = []
+
+    def worker():
+        try:
+            frame = f.new_frame()
+            for _ in range(20):
+                x_np = np.random.randint(0, 100, (1000,)).astype("int32")
+                frame.set_args(x_np)
+                frame.run()
+                y_arr = frame.collect_returns()
+                assert np.array_equal(y_arr.numpy(), x_np + 1)
+        except Exception as e:
+            errors.append(e)
+
+    threads = [threading.Thread(target=worker) for _ in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert errors == []
+
+
+def test_frame_does_not_affect_driver():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "int32"]
+        y = ft.empty((1000,), "int32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    x1_np = np.random.randint(0, 100, (1000,)).astype("int32")
+    x2_np = np.random.randint(0, 100, (1000,)).astype("int32")
+    f.set_args(x1_np)
+    frame = f.new_frame()
+    y2_arr = frame(x2_np)
+    f.run()
+    y1_arr = f.collect_returns()
+    assert np.array_equal(y1_arr.numpy(), x1_np + 1)
+    assert np.array_equal(y2_arr.numpy(), x2_np + 1)
@@ -0,0 +1,112 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def test_hit_after_miss(tmp_path):
+    old_dir = ft.kernel_cache_dir()
+    ft.set_kernel_cache_dir(str(tmp_path))
+    ft.reset_kernel_cache_stats()
+    try:
+        with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                        ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+            with ft.For("i", 0, 4) as i:
+                y[i] = x[i] + 1
+        func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+        code = ft.codegen(func)
+
+        x_np = np.array([1, 2, 3, 4], dtype="int32")
+        y1_np = np.zeros((4,), dtype="int32")
+        ft.build_binary(code)(ft.Array(x_np), ft.Array(y1_np))
+        assert ft.kernel_cache_misses() == 1
+        assert ft.kernel_cache_hits() == 0
+        y2_np = np.zeros((4,), dtype="int32")
+        ft.build_binary(code)(ft.Array(x_np), ft.Array(y2_np))
+        assert ft.kernel_cache_misses() == 1
+        assert ft.kernel_cache_hits() == 1
+    finally:
+        ft.set_kernel_cache_dir(old_dir)
+
+    y_std = np.array([2, 3, 4, 5], dtype="int32")
+    assert np.array_equal(y1_np, y_std)
+    assert np.array_equal(y2_np, y_std)
+
+
+def test_evict(tmp_path):
+    old_dir = ft.kernel_cache_dir()
+    old_limit = ft.kernel_cache_size_limit()
+    ft.set_kernel_cache_dir(str(tmp_path))
+    ft.set_kernel_cache_size_limit(0)  # Keep only the latest one
+    ft.reset_kernel_cache_stats()
+    try:
+        with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                        ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+            with ft.For("i", 0, 4) as i:
+                y[i] = x[i] + 1
+        func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+        code = ft.codegen(func)
+
+        ft.build_binary(code)
+        assert len(list(tmp_path.glob("*.so"))) == 1
+        ft.build_binary(code)
+        assert ft.kernel_cache_hits() == 1
+
+        with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                        ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+            with ft.For("i", 0, 4) as i:
+                y[i] = x[i] + 2
+        func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+        ft.build_binary(ft.codegen(func))
+        # The first entry is evicted together with its lock file
+        assert len(list(tmp_path.glob("*.so"))) == 1
+        locks = [p for p in tmp_path.glob("*.lock") if p.stem != "evict"]
+        assert len(locks) == 1
+    finally:
+        ft.set_kernel_cache_dir(old_dir)
+        ft.set_kernel_cache_size_limit(old_limit)
+
+
+def test_share_identical_kernels_in_process():
+    with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                    ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            y[i] = x[i] + 1
+    func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+    code = ft.codegen(func)
+    driver1 = ft.build_binary(code)
+    driver2 = ft.build_binary(code)
+    assert driver1.shares_kernel_with(driver2)
+
+    # Unloading one Driver should not affect the other one sharing the kernel
+    driver1.unload()
+    assert not driver1.shares_kernel_with(driver2)
+    del driver1
+    x_np = np.array([1, 2, 3, 4], dtype="int32")
+    y_np = np.zeros((4,), dtype="int32")
+    driver2(ft.Array(x_np), ft.Array(y_np))
+
+    y_std = np.array([2, 3, 4, 5], dtype="int32")
+    assert np.array_equal(y_np, y_std)
+
+
+def test_pch(tmp_path):
+    old_dir = ft.kernel_cache_dir()
+    old_pch = ft.backend_pch()
+    ft.set_kernel_cache_dir(str(tmp_path))
+    ft.set_backend_pch(True)
+    try:
+        with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                        ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+            with ft.For("i", 0, 4) as i:
+                y[i] = x[i] + 1
+        func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+        x_np = np.array([1, 2, 3, 4], dtype="int32")
+        y_np = np.zeros((4,), dtype="int32")
+        ft.build_binary(ft.codegen(func))(ft.Array(x_np), ft.Array(y_np))
+        assert len(list(tmp_path.glob("pch/*/cpu_runtime.h.gch"))) == 1
+    finally:
+        ft.set_kernel_cache_dir(old_dir)
+        ft.set_backend_pch(old_pch)
+
+    y_std = np.array([2, 3, 4, 5], dtype="int32")
+    assert np.array_equal(y_np, y_std)
@@ -0,0 +1,100 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def test_raw(tmp_path):
+    path = str(tmp_path / "x.bin")
+    x_np = np.random.rand(3, 5).astype("float32")
+    with open(path, "wb") as f:
+        f.write(b"header")
+        f.write(x_np.tobytes())
+    x_arr = ft.map_file(path, (3, 5), "float32", offset=6, advice="sequential")
+    assert x_arr.shape == [3, 5]
+    assert x_arr.read_only_on(ft.CPU())
+    assert np.array_equal(x_arr.numpy(), x_np)
+
+
+def test_npy(tmp_path):
+    path = str(tmp_path / "x.npy")
+    x_np = np.random.randint(0, 100, (4, 7)).astype("int32")
+    np.save(path, x_np)
+    x_arr = ft.map_file(path, advice=["willneed", "hugepage"])
+    assert x_arr.dtype == ft.DataType("int32")
+    assert np.array_equal(x_arr.numpy(), x_np)
+
+
+def test_read_only_input(tmp_path):
+    path = str(tmp_path / "x.npy")
+    x_np = np.random.rand(1000).astype("float32")
+    np.save(path, x_np)
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(1000,), "float32", "input", "cpu"]
+        y: ft.Var[(), "float32", "output", "cpu"]
+        y[()] = 0
+        for i in range(1000):
+            y[()] += x[i]
+
+    device = ft.CPU()
+    target = device.target()
+    driver = ft.build_binary(ft.codegen(ft.lower(f, target), target), device)
+    y_arr = ft.Array(np.zeros((), dtype="float32"))
+    driver(x=ft.map_file(path), y=y_arr)
+    assert np.isclose(y_arr.numpy(), np.sum(x_np), rtol=1e-4)
+
+
+def test_read_only_not_writable(tmp_path):
+    path = str(tmp_path / "x.npy")
+    np.save(path, np.zeros((100,), dtype="float32"))
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(100,), "float32", "inout", "cpu"]
+        y: ft.Var[(100,), "float32", "output", "cpu"]
+        for i in range(100):
+            y[i] = x[i] + 1
+            x[i] = 0
+
+    device = ft.CPU()
+    target = device.target()
+    driver = ft.build_binary(ft.codegen(ft.lower(f, target), target), device)
+    x_arr = ft.map_file(path)
+    assert not x_arr.numpy().flags.writeable
+    y_arr = ft.Array(np.zeros((100,), dtype="float32"))
+    with pytest.raises(ft.DriverError):
+        driver(x=x_arr, y=y_arr)
+
+
+def test_copy_on_write(tmp_path):
+    path = str(tmp_path / "x.npy")
+    x_np = np.random.rand(100).astype("float32")
+    np.save(path, x_np)
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(100,), "float32", "inout", "cpu"]
+        y: ft.Var[(100,), "float32", "output", "cpu"]
+        for i in range(100):
+            y[i] = x[i] + 1
+            x[i] = 0
+
+    device = ft.CPU()
+    target = device.target()
+    driver = ft.build_binary(ft.codegen(ft.lower(f, target), target), device)
+    x_arr = ft.map_file(path, mode="c")
+    y_arr = ft.Array(np.zeros((100,), dtype="float32"))
+    driver(x=x_arr, y=y_arr)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+    assert np.all(x_arr.numpy() == 0)
+    # The file is unchanged
+    assert np.array_equal(np.load(path), x_np)
+
+
+def test_file_too_small(tmp_path):
+    path = str(tmp_path / "x.bin")
+    with open(path, "wb") as f:
+        f.write(np.zeros((10,), dtype="float32").tobytes())
+    with pytest.raises(ft.DriverError):
+        ft.map_file(path, (11,), "float32")
@@ -0,0 +1,134 @@
+import os
+
+import freetensor as ft
+import numpy as np
+import pytest
+
+device = ft.CPU()
+target = device.target()
+
+
+def default_num_threads():
+    if "OMP_NUM_THREADS" in os.environ:
+        return int(os.environ["OMP_NUM_THREADS"].split(",")[0])
+    return len(os.sched_getaffinity(0))
+
+
+@pytest.mark.parametrize("num_threads", [1, 2, None])
+def test_fixed_num_threads(num_threads):
+
+    @ft.transform
+    def f(x, y, t):
+        x: ft.Var[(1000,), "int32", "input", "cpu"]
+        y: ft.Var[(1000,), "int32", "output", "cpu"]
+        t: ft.Var[(1000,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(1000):
+            y[i] = x[i] + 1
+            t[i] = ft.intrinsic("omp_get_num_threads()", ret_type="int32")
+
+    s = ft.Schedule(f)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target)
+    code = ft.codegen(func, target)
+    assert "num_threads(_ctx->numThreads())" in str(code)
+    driver = ft.build_binary(code, device)
+    driver.set_num_threads(num_threads)
+    x_np = np.random.randint(0, 100, (1000,)).astype("int32")
+    y_arr = ft.Array(np.zeros((1000,), dtype="int32"))
+    t_arr = ft.Array(np.zeros((1000,), dtype="int32"))
+    driver(x_np, y_arr, t_arr)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+    assert np.all(t_arr.numpy() == (num_threads or default_num_threads()))
+
+
+@pytest.mark.parametrize("n", [3, 1000])
+def test_auto_num_threads(n):
+
+    @ft.transform
+    def f(x, y, t):
+        x: ft.Var[(n,), "int32", "input", "cpu"]
+        y: ft.Var[(n,), "int32", "output", "cpu"]
+        t: ft.Var[(n,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(n):
+            y[i] = x[i] + 1
+            t[i] = ft.intrinsic("omp_get_num_threads()", ret_type="int32")
+
+    s = ft.Schedule(f)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target)
+    code = ft.codegen(func, target)
+    driver = ft.build_binary(code, device)
+    driver.set_num_threads("auto")
+    x_np = np.random.randint(0, 100, (n,)).astype("int32")
+    y_arr = ft.Array(np.zeros((n,), dtype="int32"))
+    t_arr = ft.Array(np.zeros((n,), dtype="int32"))
+    driver(x_np, y_arr, t_arr)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+
+    # One thread per core, but no more than the iterations
+    assert np.all(t_arr.numpy() == min(n, default_num_threads()))
+
+
+def test_invalid_num_threads():
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(4,), "int32", "input", "cpu"]
+        y: ft.Var[(4,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(4):
+            y[i] = x[i] + 1
+
+    s = ft.Schedule(f)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target)
+    code = ft.codegen(func, target)
+    driver = ft.build_binary(code, device)
+    with pytest.raises(ft.DriverError):
+        driver.set_num_threads(-2)
+
+
+def test_cpu_affinity():
+    cpus = sorted(os.sched_getaffinity(0))
+
+    @ft.transform
+    def f(x, y, t):
+        x: ft.Var[(1000,), "int32", "input", "cpu"]
+        y: ft.Var[(1000,), "int32", "output", "cpu"]
+        t: ft.Var[(1000,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(1000):
+            y[i] = x[i] + 1
+            t[i] = ft.intrinsic("omp_get_num_threads()", ret_type="int32")
+
+    s = ft.Schedule(f)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target)
+    code = ft.codegen(func, target)
+    driver = ft.build_binary(code, device)
+    driver.set_cpu_affinity(cpus[:1])
+    assert driver.cpu_affinity() == cpus[:1]
+    x_np = np.random.randint(0, 100, (1000,)).astype("int32")
+    y_arr = ft.Array(np.zeros((1000,), dtype="int32"))
+    t_arr = ft.Array(np.zeros((1000,), dtype="int32"))
+    driver(x_np, y_arr, t_arr)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+
+    # The default number of threads follows the binding
+    assert np.all(t_arr.numpy() == 1)
+
+    # The invoking thread is restored
+    assert sorted(os.sched_getaffinity(0)) == cpus
+
+    # Cancel the binding, and the OpenMP threads are restored as well
+    driver.set_cpu_affinity(None)
+    assert driver.cpu_affinity() == []
+    x_np = np.random.randint(0, 100, (1000,)).astype("int32")
+    y_arr = ft.Array(np.zeros((1000,), dtype="int32"))
+    t_arr = ft.Array(np.zeros((1000,), dtype="int32"))
+    driver(x_np, y_arr, t_arr)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+    assert np.all(t_arr.numpy() == default_num_threads())
+    assert sorted(os.sched_getaffinity(0)) == cpus
@@ -0,0 +1,133 @@
+import os
+
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+@pytest.mark.parametrize("policy", ["default", "interleave", "first_touch"])
+def test_place_and_run(policy):
+    n = 1 << 22  # Large enough to copy in parallel
+    device = ft.CPU()
+    device.set_numa_policy(policy)
+    assert device.numa_policy() == policy
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(n,), "float32", "input", "cpu"]
+        y: ft.Var[(n,), "float32", "output", "cpu"]
+        #! label: L
+        for i in range(n):
+            y[i] = x[i] + 1
+
+    s = ft.Schedule(f)
+    s.parallelize("L", "openmp")
+    target = device.target()
+    func = ft.lower(s.func(), target)
+    driver = ft.build_binary(ft.codegen(func, target), device)
+
+    x_np = np.random.rand(n).astype("float32")
+    x_arr = ft.Array(x_np)
+    x_arr.place_on(device)
+    x_np[0] = -1  # No longer shared
+    y_arr = ft.Array(np.zeros((n,), dtype="float32"))
+    y_arr.place_on(device)
+
+    driver(x_arr, y_arr)
+    y_np = y_arr.numpy()
+    assert y_np[0] != 0
+    assert np.array_equal(y_np[1:], x_np[1:] + 1)
+
+
+def test_interleave_placement():
+    nodes = ft.numa_allowed_nodes()
+    if len(nodes) < 2:
+        pytest.skip("Requires multiple NUMA nodes")
+    device = ft.CPU()
+    device.set_numa_policy("interleave")
+
+    x_arr = ft.Array(np.zeros((1 << 20,), dtype="float32"))
+    x_arr.place_on(device)
+    placed = {
+        x_arr.resident_node_on(device, offset)
+        for offset in range(0, 1 << 22, 1 << 16)
+    }
+    assert placed.issubset(nodes)
+    assert len(placed) > 1
+
+
+def test_bind():
+    nodes = ft.numa_allowed_nodes()
+    if len(nodes) < 2:
+        pytest.skip("Requires multiple NUMA nodes")
+    node = nodes[-1]  # Not the default one of the allocating thread
+    device = ft.CPU()
+    device.set_numa_policy("bind", node)
+    assert device.numa_node() == node
+
+    x_np = np.random.rand(1 << 16).astype("float32")
+    x_arr = ft.Array(x_np)
+    x_arr.place_on(device)
+    assert x_arr.numa_node_on(device) == node
+    assert x_arr.resident_node_on(device) == node
+    assert x_arr.resident_node_on(device, x_np.nbytes - 1) == node
+    assert np.array_equal(x_arr.numpy(), x_np)
+
+
+def test_bind_invalid_node():
+    nodes = ft.numa_allowed_nodes()
+    invalid = next(i for i in range(len(nodes) + 1) if i not in nodes)
+    with pytest.raises(ft.DriverError):
+        ft.CPU().set_numa_policy("bind", invalid)
+    with pytest.raises(ft.DriverError):
+        ft.CPU().set_numa_policy("bind", -1)
+
+
+def cpus_of_node(node):
+    with open(f"/sys/devices/system/node/node{node}/cpulist") as f:
+        ret = []
+        for part in f.read().strip().split(","):
+            begin, _, end = part.partition("-")
+            ret += range(int(begin), int(end or begin) + 1)
+    return sorted(set(ret) & os.sched_getaffinity(0))
+
+
+def test_first_touch_by_driver_threads():
+    nodes = ft.numa_allowed_nodes()
+    if len(nodes) < 2:
+        pytest.skip("Requires multiple NUMA nodes")
+    node = nodes[-1]  # Not the default one of the allocating thread
+    cpus = cpus_of_node(node)
+    if len(cpus) == 0:
+        pytest.skip(f"No CPU available on node {node}")
+
+    n = 1 << 22  # Large enough to copy in parallel
+    device = ft.CPU()
+    device.set_numa_policy("first_touch")
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(n,), "float32", "input", "cpu"]
+        y: ft.Var[(n,), "float32", "output", "cpu"]
+        #! label: L
+        for i in range(n):
+            y[i] = x[i] + 1
+
+    s = ft.Schedule(f)
+    s.parallelize("L", "openmp")
+    target = device.target()
+    func = ft.lower(s.func(), target)
+    driver = ft.build_binary(ft.codegen(func, target), device)
+    driver.set_cpu_affinity(cpus)
+    driver.set_num_threads(len(cpus))
+
+    # Touched by the threads of the Driver, which only run on the node
+    x_np = np.random.rand(n).astype("float32")
+    x_arr = ft.Array(x_np)
+    driver.place_array(x_arr)
+    for offset in range(0, x_np.nbytes, 1 << 20):
+        assert x_arr.resident_node_on(device, offset) == node
+
+    y_arr = ft.Array(np.zeros((n,), dtype="float32"))
+    driver(x_arr, y_arr)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
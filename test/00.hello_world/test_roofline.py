@@ -0,0 +1,100 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def test_machine_peak():
+    peak = ft.machine_peak()
+    assert peak.bandwidth > 0
+    assert peak.gflops32 > 0
+    assert peak.gflops64 > 0
+    assert peak.gflops(ft.DataType("float64")) == peak.gflops64
+
+    # Cached
+    peak2 = ft.machine_peak()
+    assert peak2.bandwidth == peak.bandwidth
+    assert peak2.gflops32 == peak.gflops32
+
+
+def test_roofline():
+
+    @ft.transform
+    def f(x, w, y, z):
+        x: ft.Var[(1000,), "float32", "input", "cpu"]
+        w: ft.Var[(64, 64), "float32", "input", "cpu"]
+        y: ft.Var[(1000,), "float32", "output", "cpu"]
+        z: ft.Var[(64, 64), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(1000):
+            y[i] = x[i] + 1
+        #! label: L2
+        for i in range(64):
+            for j in range(64):
+                z[i, j] = 0
+                for k in range(64):
+                    z[i, j] += w[i, k] * w[k, j]
+
+    func = ft.lower(f, verbose=1)
+    report = ft.roofline(func, np.random.rand(1000).astype("float32"),
+                         np.random.rand(64, 64).astype("float32"),
+                         np.zeros((1000,), dtype="float32"),
+                         np.zeros((64, 64), dtype="float32"))
+    ft.print_roofline(report)
+
+    assert len(report.nests) == 2
+    l1 = report.nests[0]
+    assert l1.flop == 1000
+    assert l1.bytes == 1000 * 4 * 2
+    assert l1.intensity == pytest.approx(1000 / 8000)
+    assert l1.memory_bound
+    assert l1.time > 0
+    assert l1.gflops == pytest.approx(l1.flop / l1.time / 1e6)
+    assert l1.bandwidth == pytest.approx(l1.bytes / l1.time / 1e6)
+
+    l2 = report.nests[1]
+    assert l2.flop == 64 * 64 * 64 * 2
+    assert l2.bytes >= 64 * 64 * 4 * 2
+    assert l2.intensity > l1.intensity
+
+    assert report.total.flop == l1.flop + l2.flop
+    assert report.total.time == report.benchmark.mean
+    assert report.peak.bandwidth > 0
+
+
+def test_roofline_of_vectorized_loop():
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(1000,), "float32", "input", "cpu"]
+        y: ft.Var[(1000,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(1000):
+            y[i] = x[i] + 1
+
+    s = ft.Schedule(f)
+    s.vectorize("L1")
+    func = ft.lower(s.func(), verbose=1)
+    assert "simd_" in str(ft.codegen(func))
+    report = ft.roofline(func, np.random.rand(1000).astype("float32"),
+                         np.zeros((1000,), dtype="float32"))
+
+    # Counted in every lane, as the scalar loop
+    assert len(report.nests) == 1
+    assert report.nests[0].flop == 1000
+    assert report.nests[0].bytes == 1000 * 4 * 2
+
+
+def test_roofline_not_instrumented():
+
+    @ft.transform
+    def f(x, y):
+        x: ft.Var[(1000,), "float32", "input", "cpu"]
+        y: ft.Var[(1000,), "float32", "output", "cpu"]
+        for i in range(1000):
+            y[i] = x[i] + 1
+
+    driver = ft.build_binary(ft.codegen(ft.lower(f)))
+    driver.set_args(np.random.rand(1000).astype("float32"),
+                    np.zeros((1000,), dtype="float32"))
+    with pytest.raises(ft.DriverError):
+        driver.roofline()
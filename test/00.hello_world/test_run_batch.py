@@ -0,0 +1,58 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+@pytest.mark.parametrize("parallelism", [1, 4])
+def test_run_batch(parallelism):
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "int32"]
+        y = ft.empty((1000,), "int32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    x_nps = [
+        np.random.randint(0, 100, (1000,)).astype("int32") for _ in range(16)
+    ]
+    results, latencies = f.run_batch([[x_np] for x_np in x_nps],
+                                     parallelism=parallelism)
+    assert len(results) == 16
+    assert len(latencies) == 16
+    for x_np, y_arr, latency in zip(x_nps, results, latencies):
+        assert np.array_equal(y_arr.numpy(), x_np + 1)
+        assert latency >= 0
+
+
+def test_run_batch_outputs():
+    with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                    ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            y[i] = x[i] * 2
+    func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()))
+    driver = ft.build_binary(ft.codegen(func))
+
+    x_nps = [np.random.randint(0, 100, (4,)).astype("int32") for _ in range(8)]
+    y_arrs = [ft.Array(np.zeros((4,), dtype="int32")) for _ in range(8)]
+    results, _ = driver.run_batch(list(zip(x_nps, y_arrs)), parallelism=2)
+    assert results == [None] * 8
+    for x_np, y_arr in zip(x_nps, y_arrs):
+        assert np.array_equal(y_arr.numpy(), x_np * 2)
+
+
+def test_run_batch_wrong_arguments():
+
+    @ft.optimize
+    def f(x):
+        x: ft.Var[(1000,), "int32"]
+        y = ft.empty((1000,), "int32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    with pytest.raises(ft.DriverError):
+        f.run_batch([[np.zeros((1000,), dtype="int32")], []])
+    with pytest.raises(ft.DriverError):
+        f.run_batch([[np.zeros((1000,), dtype="float32")]])
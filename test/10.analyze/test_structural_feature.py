@@ -126,3 +126,20 @@ def test_access_area_overlap():
     assert S1.load_area[ft.MemType('cpu')] == 48
     assert S1.store_area[ft.MemType('cpu')] == 64
     assert S1.access_area[ft.MemType('cpu')] == 112
+
+
+def test_access_bytes():
+    with ft.VarDef([
+        ("x", (32,), "float64", "input", "cpu"),
+        ("y", (32,), "int32", "output", "cpu"),
+    ]) as (x, y):
+        with ft.For("i", 0, 32, label='L1') as i:
+            y[i] = ft.cast(x[i], "int32")
+    ast = ft.pop_ast(verbose=True)
+
+    features = ft.structural_feature(ast)
+
+    L1 = features[ft.find_stmt(ast, 'L1').id]
+
+    assert L1.load_bytes[ft.MemType('cpu')] == 32 * 8
+    assert L1.store_bytes[ft.MemType('cpu')] == 32 * 4
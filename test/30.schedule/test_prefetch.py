@@ -0,0 +1,148 @@
+import freetensor as ft
+import pytest
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+
+
+def test_indirect_read():
+
+    @ft.transform
+    def test(idx, x, y):
+        idx: ft.Var[(64,), "int32", "input", "cpu"]
+        x: ft.Var[(1000,), "float32", "input", "cpu"]
+        y: ft.Var[(64,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(64):
+            y[i] = x[idx[i]] * 2
+
+    s = ft.Schedule(test)
+    s.prefetch("L1", "x", 8)
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "__builtin_prefetch" in str(code)
+
+    idx_np = np.random.randint(0, 1000, (64,)).astype("int32")
+    x_np = np.random.rand(1000).astype("float32")
+    y_arr = ft.Array(np.zeros((64,), dtype="float32"))
+    ft.build_binary(code, device)(idx=ft.Array(idx_np),
+                                  x=ft.Array(x_np),
+                                  y=y_arr)
+    assert np.allclose(y_arr.numpy(), x_np[idx_np] * 2)
+
+
+def test_write():
+
+    @ft.transform
+    def test(idx, x, y):
+        idx: ft.Var[(64,), "int32", "input", "cpu"]
+        x: ft.Var[(64,), "float32", "input", "cpu"]
+        y: ft.Var[(1000,), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(64):
+            y[idx[i]] += x[i]
+
+    s = ft.Schedule(test)
+    s.prefetch("L1", "y", 16)
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "__builtin_prefetch" in str(code)
+
+    idx_np = np.random.permutation(1000)[:64].astype("int32")
+    x_np = np.random.rand(64).astype("float32")
+    y_np = np.zeros((1000,), dtype="float32")
+    y_arr = ft.Array(y_np)
+    ft.build_binary(code, device)(idx=ft.Array(idx_np),
+                                  x=ft.Array(x_np),
+                                  y=y_arr)
+    y_std = y_np.copy()
+    y_std[idx_np] += x_np
+    assert np.allclose(y_arr.numpy(), y_std)
+
+
+def test_not_found():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(64,), "float32", "input", "cpu"]
+        y: ft.Var[(64,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(64):
+            y[i] = x[i] * 2
+
+    s = ft.Schedule(test)
+    with pytest.raises(ft.InvalidSchedule):
+        s.prefetch("L2", "x", 8)
+    with pytest.raises(ft.InvalidSchedule):
+        s.prefetch("L1", "x", 0)
+
+
+def test_invariant_address():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4,), "float32", "input", "cpu"]
+        y: ft.Var[(64,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(64):
+            y[i] = x[2] * i
+
+    s = ft.Schedule(test)
+    with pytest.raises(ft.InvalidSchedule):
+        s.prefetch("L1", "x", 8)
+
+
+def test_ast():
+    with ft.VarDef([("idx", (64,), "int32", "input", "cpu"),
+                    ("x", (1000,), "float32", "input", "cpu"),
+                    ("y", (64,), "float32", "output", "cpu")]) as (idx, x, y):
+        with ft.For("i", 0, 64, label="L1") as i:
+            y[i] = x[idx[i]] * 2
+    ast = ft.pop_ast(verbose=True)
+    s = ft.Schedule(ast)
+    s.prefetch("L1", "x", 8)
+    ast = s.ast()
+    print(ast)
+
+    with ft.VarDef([("idx", (64,), "int32", "input", "cpu"),
+                    ("x", (1000,), "float32", "input", "cpu"),
+                    ("y", (64,), "float32", "output", "cpu")]) as (idx, x, y):
+        with ft.For("i", 0, 64) as i:
+            cond = ft.l_and(
+                ft.l_and(ft.l_and(ft.l_and(i + 8 < 64, i + 8 >= 0), i + 8 < 64),
+                         idx[i + 8] >= 0), idx[i + 8] < 1000)
+            with ft.If(cond):
+                ft.Eval(
+                    ft.intrinsic("__builtin_prefetch(&(%), 0, 3)",
+                                 x[idx[i + 8]],
+                                 has_side_effect=True,
+                                 is_hint=True))
+            y[i] = x[idx[i]] * 2
+    std = ft.pop_ast()
+
+    assert std.match(ast)
+
+
+def test_parallelize_after_prefetch():
+
+    @ft.transform
+    def test(x):
+        x: ft.Var[(64,), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(64):
+            x[i] = x[i] * 2
+
+    s = ft.Schedule(test)
+    s.prefetch("L1", "x", 8)
+    # The prefetch of x[i + 8] is not a read, so there is no dependence across
+    # iterations
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "__builtin_prefetch" in str(code)
+
+    x_np = np.random.rand(64).astype("float32")
+    x_arr = ft.Array(x_np.copy())
+    ft.build_binary(code, device)(x=x_arr)
+    assert np.allclose(x_arr.numpy(), x_np * 2)
@@ -41,10 +41,11 @@ def test_dep_not_met():
 
 def test_dep_not_met_reduction():
     with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
-                    ("y", (), "int32", "output", "cpu")]) as (x, y):
-        y[...] = 0
+                    ("y", (2,), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 2) as i:
+            y[i] = 0
         with ft.For("i", 0, 4, label="L1") as i:
-            y[...] += x[i]
+            y[i // 2] += x[i]
     func = ft.Func("main", ["x", "y"], [], ft.pop_ast())
 
     s = ft.Schedule(func)
@@ -191,7 +191,7 @@ def test_vectorize_for():
     s.vectorize("L1")
     func = ft.lower(s.func(), target, verbose=1)
     code = ft.codegen(func, target, verbose=True)
-    assert "#pragma omp simd" in str(code)
+    assert "simd_store" in str(code)
     x_np = np.array([1, 2, 3, 4], dtype="int32")
     y_np = np.zeros((4,), dtype="int32")
     x_arr = ft.Array(x_np)
@@ -201,3 +201,200 @@ def test_vectorize_for():
 
     y_std = np.array([2, 3, 4, 5], dtype="int32")
     assert np.array_equal(y_np, y_std)
+
+
+def test_stack_reused_across_calls():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4, 8), "int32", "input", "cpu"]
+        y: ft.Var[(4, 8), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(0, 4):
+            t = ft.empty((8,), "int32", "cpu")
+            for j in range(0, 8):
+                t[j] = x[i, j] * 2
+            for j in range(0, 8):
+                y[i, j] = t[7 - j]
+
+    s = ft.Schedule(test)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "new uint8_t" not in str(code)
+    driver = ft.build_binary(code, device)
+
+    for _ in range(3):
+        x_np = np.random.randint(0, 100, (4, 8)).astype("int32")
+        y_np = np.zeros((4, 8), dtype="int32")
+        x_arr = ft.Array(x_np)
+        y_arr = ft.Array(y_np)
+        driver(x=x_arr, y=y_arr)
+        y_np = y_arr.numpy()
+
+        y_std = x_np[:, ::-1] * 2
+        assert np.array_equal(y_np, y_std)
+
+
+def test_heap_alloc_from_memory_pool():
+    with ft.VarDef("n", (), "int32", "input", "byvalue") as n:
+        with ft.VarDef([("x", (n[...],), "int32", "input", "cpu"),
+                        ("s", (), "int32", "output", "cpu")]) as (x, s):
+            with ft.VarDef("y", (n[...],), "int32", "cache", "cpu") as y:
+                with ft.For("i", 0, n[...]) as i:
+                    y[i] = x[i] * 2
+                s[...] = 0
+                with ft.For("i", 0, n[...]) as i:
+                    s[...] += y[i]
+    func = ft.lower(ft.Func("main", ["n", "x", "s"], [], ft.pop_ast()),
+                    target,
+                    verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "_ctx->alloc" in str(code)
+    assert "_ctx->free" in str(code)
+    driver = ft.build_binary(code, device)
+
+    for n in [10, 100, 10]:
+        x_np = np.random.randint(0, 100, (n,)).astype("int32")
+        s_np = np.zeros((), dtype="int32")
+        s_arr = ft.Array(s_np)
+        driver(n=ft.Array(np.array(n, dtype="int32")),
+               x=ft.Array(x_np),
+               s=s_arr)
+        assert s_arr.numpy()[()] == np.sum(x_np) * 2
+
+
+def test_return_value_from_memory_pool():
+
+    @ft.optimize(verbose=1)
+    def test(x):
+        x: ft.Var[(1000,), "int32"]
+        y = ft.empty((1000,), "int32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    x_np = np.random.randint(0, 100, (1000,)).astype("int32")
+    live_bytes = ft.cpu_memory_pool_stats()["live_bytes"]
+    y_arr = test(x_np)
+    assert ft.cpu_memory_pool_stats()["live_bytes"] >= live_bytes + 4000
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+
+    del y_arr
+    assert ft.cpu_memory_pool_stats()["live_bytes"] == live_bytes
+
+
+def test_trim_memory_pool_of_all_threads():
+    with ft.VarDef("n", (), "int32", "input", "byvalue") as n:
+        with ft.VarDef([("x", (16, n[...]), "int32", "input", "cpu"),
+                        ("s", (16,), "int32", "output", "cpu")]) as (x, s):
+            with ft.For("i", 0, 16, label="L1") as i:
+                with ft.VarDef("y", (n[...],), "int32", "cache", "cpu") as y:
+                    with ft.For("j", 0, n[...]) as j:
+                        y[j] = x[i, j] * 2
+                    s[i] = 0
+                    with ft.For("j", 0, n[...]) as j:
+                        s[i] += y[j]
+    s = ft.Schedule(ft.Func("main", ["n", "x", "s"], [], ft.pop_ast()))
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "_ctx->alloc" in str(code)
+    driver = ft.build_binary(code, device)
+
+    n = 1000
+    x_np = np.random.randint(0, 100, (16, n)).astype("int32")
+    s_arr = ft.Array(np.zeros((16,), dtype="int32"))
+    driver(n=ft.Array(np.array(n, dtype="int32")), x=ft.Array(x_np), s=s_arr)
+    assert np.array_equal(s_arr.numpy(), np.sum(x_np, axis=1) * 2)
+
+    # Blocks freed by the OpenMP workers are cached in their own threads, but
+    # still counted, and drained by `trim`
+    assert ft.cpu_memory_pool_stats()["cached_bytes"] >= n * 4
+    ft.trim_cpu_memory_pool()
+    assert ft.cpu_memory_pool_stats()["cached_bytes"] == 0
+
+
+def test_profile():
+
+    @ft.transform
+    def test(x, y, z):
+        x: ft.Var[(4, 8), "int32", "input", "cpu"]
+        y: ft.Var[(4, 8), "int32", "output", "cpu"]
+        z: ft.Var[(4,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(0, 4):
+            for j in range(0, 8):
+                y[i, j] = x[i, j] * 2
+        #! label: L2
+        for i in range(0, 4):
+            z[i] = 0
+            #! label: L3
+            for j in range(0, 8):
+                z[i] += x[i, j]
+
+    s = ft.Schedule(test)
+    s.parallelize("L2", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+
+    # Outermost loops by default
+    code = ft.codegen(func, target, verbose=True, profile=True)
+    driver = ft.build_binary(code, device)
+    x_np = np.random.randint(0, 100, (4, 8)).astype("int32")
+    for _ in range(3):
+        driver(ft.Array(x_np), ft.Array(np.zeros((4, 8), dtype="int32")),
+               ft.Array(np.zeros((4,), dtype="int32")))
+    profile = driver.profile()
+    assert len(profile) == 2
+    for entry in profile:
+        assert entry.count == 3
+        assert entry.time >= 0
+        assert entry.max_thread_time <= entry.time + 1e-9
+    assert "L1" in str(profile[0].metadata)
+    assert "L2" in str(profile[1].metadata)
+
+    driver.reset_profile()
+    assert all(entry.count == 0 for entry in driver.profile())
+
+
+def test_profile_in_parallel_loop():
+
+    @ft.transform
+    def test(x, z):
+        x: ft.Var[(4, 8), "int32", "input", "cpu"]
+        z: ft.Var[(4,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(0, 4):
+            z[i] = 0
+            #! label: L2
+            for j in range(0, 8):
+                z[i] += x[i, j]
+
+    s = ft.Schedule(test)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True, profile="L2")
+    driver = ft.build_binary(code, device)
+    x_np = np.random.randint(0, 100, (4, 8)).astype("int32")
+    z_arr = ft.Array(np.zeros((4,), dtype="int32"))
+    driver(ft.Array(x_np), z_arr)
+    assert np.array_equal(z_arr.numpy(), x_np.sum(axis=1))
+
+    profile = driver.profile()
+    assert len(profile) == 1
+    assert profile[0].count == 4  # Summed over threads
+
+
+def test_profile_not_instrumented():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4,), "int32", "input", "cpu"]
+        y: ft.Var[(4,), "int32", "output", "cpu"]
+        for i in range(0, 4):
+            y[i] = x[i] + 1
+
+    driver = ft.build_binary(ft.codegen(ft.lower(test, target), target),
+                             device)
+    with pytest.raises(ft.DriverError):
+        driver.profile()
@@ -0,0 +1,99 @@
+import ctypes.util
+
+import freetensor as ft
+import pytest
+import numpy as np
+
+
+def available(blas):
+    if blas == "mkl":
+        return bool(ft.with_mkl())
+    if blas in ("openblas", "blis"):
+        return ctypes.util.find_library(blas) is not None
+    return True
+
+
+providers = [
+    pytest.param(blas,
+                 marks=pytest.mark.skipif(not available(blas),
+                                          reason=f"{blas} not found"))
+    for blas in ("builtin", "mkl", "openblas", "blis")
+]
+
+
+def build(func, blas):
+    device = ft.CPU()
+    target = device.target()
+    target.set_blas(blas)
+    func = ft.lower(func, target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    return code, ft.Driver(func, code, device)
+
+
+def matmul_func(batch, m, k, n, dtype):
+
+    @ft.transform
+    def f(a, b, c):
+        a: ft.Var[(batch, m, k), dtype, "input", "cpu"]
+        b: ft.Var[(batch, k, n), dtype, "input", "cpu"]
+        c: ft.Var[(batch, m, n), dtype, "output", "cpu"]
+        #! label: L0
+        for p in range(batch):
+            for i in range(m):
+                for j in range(n):
+                    c[p, i, j] = 0
+                    for q in range(k):
+                        c[p, i, j] += a[p, i, q] * b[p, q, j]
+
+    s = ft.Schedule(f)
+    s.as_matmul("L0")
+    return s.func()
+
+
+def test_set_blas():
+    target = ft.CPU().target()
+    target.set_blas("BUILTIN")
+    assert target.blas() == "builtin"
+    target.set_blas()
+    assert target.blas() == ("mkl" if ft.with_mkl() else "builtin")
+    with pytest.raises(ft.ffi.Error):
+        target.set_blas("foo")
+    if not ft.with_mkl():
+        with pytest.raises(ft.DriverError):
+            target.set_blas("mkl")
+
+
+def test_int_uses_builtin():
+    code, _ = build(matmul_func(1, 4, 5, 6, "int32"), "openblas")
+    assert "runtime_gemm_batch_strided<int32_t>" in str(code)
+
+
+# Shapes from test/60.libop/test_gemm.py and test_matmul.py, and a larger one
+@pytest.mark.parametrize('batch,m,k,n', [(1, 4, 5, 6), (3, 4, 5, 6),
+                                         (2, 48, 64, 72), (1, 37, 101, 19)])
+@pytest.mark.parametrize('blas', providers)
+def test_providers(blas, batch, m, k, n):
+    code, driver = build(matmul_func(batch, m, k, n, "float32"), blas)
+    if blas != "builtin":
+        assert "runtime_gemm_batch_strided" not in str(code)
+
+    a_np = np.random.uniform(size=(batch, m, k)).astype("float32")
+    b_np = np.random.uniform(size=(batch, k, n)).astype("float32")
+    c_arr = ft.Array(np.zeros((batch, m, n), dtype="float32"))
+    driver(a=ft.Array(a_np), b=ft.Array(b_np), c=c_arr)
+    assert np.allclose(c_arr.numpy(), a_np @ b_np, rtol=1e-4)
+
+
+@pytest.mark.parametrize('blas', providers)
+def test_switch_threading(blas):
+    # One batch is computed by the library with all threads, and many batches
+    # are distributed to threads, each calling the library single-threaded.
+    # Alternate between them
+    shapes = [(1, 256), (64, 32), (1, 256)]
+    for batch, n in shapes:
+        _, driver = build(matmul_func(batch, n, n, n, "float32"), blas)
+        a_np = np.random.uniform(size=(batch, n, n)).astype("float32")
+        b_np = np.random.uniform(size=(batch, n, n)).astype("float32")
+        c_arr = ft.Array(np.zeros((batch, n, n), dtype="float32"))
+        driver(a=ft.Array(a_np), b=ft.Array(b_np), c=c_arr)
+        assert np.allclose(c_arr.numpy(), a_np @ b_np, rtol=1e-4)
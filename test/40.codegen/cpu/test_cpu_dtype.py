@@ -0,0 +1,129 @@
+import freetensor as ft
+import pytest
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+
+
+def test_float16():
+
+    @ft.lower(target=target, verbose=1)
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4, 4), "float16", "input", "cpu"]
+        y: ft.Var[(4, 4), "float16", "output", "cpu"]
+        for i in range(4):
+            for j in range(4):
+                y[i, j] = x[i, j] * 2 + 1
+
+    code = ft.codegen(test, target, verbose=True)
+    x_np = np.random.uniform(-4, 4, (4, 4)).astype("float16")
+    y_arr = ft.Array(np.zeros((4, 4), dtype="float16"))
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+    y_np = y_arr.numpy()
+
+    assert y_np.dtype == np.float16
+    assert np.array_equal(y_np, x_np * 2 + 1)
+
+
+def test_bfloat16():
+
+    @ft.lower(target=target, verbose=1)
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(16,), "float32", "input", "cpu"]
+        y: ft.Var[(16,), "float32", "output", "cpu"]
+        t = ft.empty((16,), "bfloat16", "cpu")
+        for i in range(16):
+            t[i] = ft.cast(x[i], "bfloat16")
+        for i in range(16):
+            y[i] = ft.cast(t[i], "float32")
+
+    code = ft.codegen(test, target, verbose=True)
+    x_np = np.random.uniform(-100, 100, (16,)).astype("float32")
+    y_arr = ft.Array(np.zeros((16,), dtype="float32"))
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+    y_np = y_arr.numpy()
+
+    # Round to nearest even on the upper 16 bits
+    bits = x_np.view("uint32").astype("uint64")
+    bits = (bits + 0x7fff + ((bits >> 16) & 1)) >> 16 << 16
+    y_std = bits.astype("uint32").view("float32")
+    assert np.array_equal(y_np, y_std)
+
+
+@pytest.mark.parametrize('dtype', ['int8', 'uint8'])
+def test_int8(dtype):
+
+    @ft.lower(target=target, verbose=1)
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4, 4), dtype, "input", "cpu"]
+        y: ft.Var[(4, 4), dtype, "output", "cpu"]
+        for i in range(4):
+            for j in range(4):
+                y[i, j] = x[i, j] + x[j, i]
+
+    code = ft.codegen(test, target, verbose=True)
+    x_np = np.random.randint(0, 60, (4, 4)).astype(dtype)
+    y_arr = ft.Array(np.zeros((4, 4), dtype=dtype))
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+    y_np = y_arr.numpy()
+
+    assert y_np.dtype == np.dtype(dtype)
+    assert np.array_equal(y_np, x_np + x_np.T)
+
+
+def test_reduce_float16_accumulates_in_float32():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4096,), "float16", "input", "cpu"]
+        y: ft.Var[(1,), "float16", "inout", "cpu"]
+        #! label: L
+        for i in range(4096):
+            y[0] += x[i]
+
+    x_np = np.ones((4096,), dtype="float16")
+
+    # Without a cache, y is rounded to float16 after each step, and stops
+    # growing at 2048
+    func = ft.lower(test, target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    y_arr = ft.Array(np.zeros((1,), dtype="float16"))
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+    assert y_arr.numpy()[0] == 2048
+
+    # The reduction cache is kept in float32
+    s = ft.Schedule(test)
+    s.cache_reduction("L", "y", "cpu")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "float " in str(code)
+    y_arr = ft.Array(np.zeros((1,), dtype="float16"))
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+    assert y_arr.numpy()[0] == 4096
+
+
+def test_parallel_reduce_int8():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4, 64), "int8", "input", "cpu"]
+        y: ft.Var[(4,), "int32", "inout", "cpu"]
+        #! label: L
+        for j in range(64):
+            for i in range(4):
+                y[i] += x[i, j]
+
+    s = ft.Schedule(test)
+    s.parallelize("L", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    x_np = np.random.randint(-128, 128, (4, 64)).astype("int8")
+    y_arr = ft.Array(np.zeros((4,), dtype="int32"))
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+
+    y_std = np.sum(x_np.astype("int32"), axis=1)
+    assert np.array_equal(y_arr.numpy(), y_std)
@@ -0,0 +1,206 @@
+import freetensor as ft
+import pytest
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+target.set_blas("builtin")
+
+
+def test_basic():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(48, 64), "float32", "input", "cpu"]
+        b: ft.Var[(64, 72), "float32", "input", "cpu"]
+        c: ft.Var[(48, 72), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(48):
+            for j in range(72):
+                for k in range(64):
+                    c[i, j] += a[i, k] * b[k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "runtime_gemm_batch_strided<float>" in str(code)
+    a_np = np.random.uniform(size=(48, 64)).astype("float32")
+    b_np = np.random.uniform(size=(64, 72)).astype("float32")
+    c_np = np.random.uniform(size=(48, 72)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    ft.Driver(func, code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
+
+
+@pytest.mark.parametrize('dtype', ['float64', 'int32'])
+def test_dtype(dtype):
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(37, 101), dtype, "input", "cpu"]
+        b: ft.Var[(101, 19), dtype, "input", "cpu"]
+        c: ft.Var[(37, 19), dtype, "inout", "cpu"]
+        #! label: L1
+        for i in range(37):
+            for j in range(19):
+                c[i, j] = 0
+                for k in range(101):
+                    c[i, j] += a[i, k] * b[k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "runtime_gemm_batch_strided" in str(code)
+    a_np = np.random.randint(-10, 10, (37, 101)).astype(dtype)
+    b_np = np.random.randint(-10, 10, (101, 19)).astype(dtype)
+    c_np = np.zeros((37, 19), dtype=dtype)
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np)
+    ft.Driver(func, code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.array_equal(c_result, a_np @ b_np)
+
+
+def test_trans_a_b():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(300, 48), "float32", "input", "cpu"]
+        b: ft.Var[(72, 300), "float32", "input", "cpu"]
+        c: ft.Var[(48, 72), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(48):
+            for j in range(72):
+                for k in range(300):
+                    c[i, j] += a[k, i] * b[j, k]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "runtime_gemm_batch_strided<float>(true, true" in str(code)
+    a_np = np.random.uniform(size=(300, 48)).astype("float32")
+    b_np = np.random.uniform(size=(72, 300)).astype("float32")
+    c_np = np.random.uniform(size=(48, 72)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    ft.Driver(func, code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np.T @ b_np.T, rtol=1e-4))
+
+
+def test_batch():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(4, 48, 64), "float32", "input", "cpu"]
+        b: ft.Var[(4, 64, 72), "float32", "input", "cpu"]
+        c: ft.Var[(4, 48, 72), "float32", "inout", "cpu"]
+        #! label: L1
+        for n in range(4):
+            for i in range(48):
+                for j in range(72):
+                    for k in range(64):
+                        c[n, i, j] += a[n, i, k] * b[n, k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "runtime_gemm_batch_strided" in str(code)
+    a_np = np.random.uniform(size=(4, 48, 64)).astype("float32")
+    b_np = np.random.uniform(size=(4, 64, 72)).astype("float32")
+    c_np = np.random.uniform(size=(4, 48, 72)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    ft.Driver(func, code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
+
+
+def test_in_parallel():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(16, 48, 64), "float32", "input", "cpu"]
+        b: ft.Var[(16, 64, 72), "float32", "input", "cpu"]
+        c: ft.Var[(16, 48, 72), "float32", "inout", "cpu"]
+        #! label: L1
+        for n in range(16):
+            #! label: L2
+            for i in range(48):
+                for j in range(72):
+                    for k in range(64):
+                        c[n, i, j] += a[n, i, k] * b[n, k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L2")
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "runtime_gemm_batch_strided" in str(code)
+    assert "_ctx->numThreads());" not in str(code).split(
+        "runtime_gemm_batch_strided")[1].split("\n")[0]
+    a_np = np.random.uniform(size=(16, 48, 64)).astype("float32")
+    b_np = np.random.uniform(size=(16, 64, 72)).astype("float32")
+    c_np = np.random.uniform(size=(16, 48, 72)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    ft.Driver(func, code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
+
+
+def test_same_as_loop_nest():
+    n = 256
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(n, n), "float32", "input", "cpu"]
+        b: ft.Var[(n, n), "float32", "input", "cpu"]
+        c: ft.Var[(n, n), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(n):
+            #! label: L2
+            for j in range(n):
+                #! label: L3
+                for k in range(n):
+                    c[i, j] += a[i, k] * b[k, j]
+
+    a_np = np.random.uniform(size=(n, n)).astype("float32")
+    b_np = np.random.uniform(size=(n, n)).astype("float32")
+
+    def run(s):
+        func = ft.lower(s.func(), target)
+        driver = ft.Driver(func, ft.codegen(func, target), device)
+        c_arr = ft.Array(np.zeros((n, n), dtype="float32"))
+        driver(a=ft.Array(a_np), b=ft.Array(b_np), c=c_arr)
+        return c_arr.numpy()
+
+    # The loop nest schedule: parallel rows, vectorized columns
+    s = ft.Schedule(test)
+    s.reorder(["L1", "L3", "L2"])
+    s.parallelize("L1", "openmp")
+    s.vectorize("L2")
+    loop_result = run(s)
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    gemm_result = run(s)
+
+    assert np.allclose(loop_result, a_np @ b_np, rtol=1e-4)
+    assert np.allclose(gemm_result, a_np @ b_np, rtol=1e-4)
@@ -0,0 +1,115 @@
+import freetensor as ft
+import pytest
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+
+
+def test_array_round_trip():
+    x_np = np.random.rand(3, 100) < 0.5
+    x_arr = ft.array(x_np, packed=True)
+    assert x_arr.dtype == ft.DataType("packed_bool")
+    assert x_arr.shape == [3, 100]
+    assert np.array_equal(x_arr.numpy(), x_np)
+
+
+def test_array_only_packs_bool():
+    with pytest.raises(ft.DriverError):
+        ft.array(np.zeros((4,), dtype="int32"), packed=True)
+
+
+def test_load_and_store():
+
+    @ft.lower(target=target, verbose=1)
+    @ft.transform
+    def test(x, y, z):
+        x: ft.Var[(4, 100), "packed_bool", "input", "cpu"]
+        y: ft.Var[(4, 100), "packed_bool", "input", "cpu"]
+        z: ft.Var[(4, 100), "packed_bool", "output", "cpu"]
+        for i in range(4):
+            for j in range(100):
+                z[i, j] = ft.l_and(x[i, j], ft.l_not(y[i, j]))
+
+    code = ft.codegen(test, target, verbose=True)
+    assert "mdspan_packed<const packed_bool" in str(code)
+    x_np = np.random.rand(4, 100) < 0.5
+    y_np = np.random.rand(4, 100) < 0.5
+    z_arr = ft.array(np.zeros((4, 100), dtype="bool"), packed=True)
+    ft.build_binary(code, device)(x=ft.array(x_np, packed=True),
+                                  y=ft.array(y_np, packed=True),
+                                  z=z_arr)
+    assert np.array_equal(z_arr.numpy(), x_np & ~y_np)
+
+
+def test_parallel_store():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(1000,), "float32", "input", "cpu"]
+        y: ft.Var[(1000,), "packed_bool", "output", "cpu"]
+        #! label: L
+        for i in range(1000):
+            y[i] = x[i] > 0.5
+
+    s = ft.Schedule(test)
+    s.parallelize("L", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    # Neighboring bits in a word may be written by different threads
+    assert "atomic_store" in str(code)
+    x_np = np.random.rand(1000).astype("float32")
+    y_arr = ft.array(np.zeros((1000,), dtype="bool"), packed=True)
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+    assert np.array_equal(y_arr.numpy(), x_np > 0.5)
+
+
+def test_vectorize():
+
+    @ft.transform
+    def test(x, y, z):
+        x: ft.Var[(4, 100), "packed_bool", "input", "cpu"]
+        y: ft.Var[(4, 100), "float32", "input", "cpu"]
+        z: ft.Var[(4, 100), "packed_bool", "inout", "cpu"]
+        for i in range(4):
+            #! label: L
+            for j in range(100):
+                z[i, j] = ft.l_or(z[i, j], ft.l_and(x[i, j], y[i, j] > 0))
+
+    s = ft.Schedule(test)
+    s.vectorize("L")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "simd_packed_load<" in str(code)
+    assert "simd_packed_store" in str(code)
+    x_np = np.random.rand(4, 100) < 0.5
+    y_np = np.random.rand(4, 100).astype("float32") - 0.5
+    z_np = np.random.rand(4, 100) < 0.5
+    z_arr = ft.array(z_np, packed=True)
+    ft.build_binary(code, device)(x=ft.array(x_np, packed=True),
+                                  y=ft.Array(y_np),
+                                  z=z_arr)
+    assert np.array_equal(z_arr.numpy(), z_np | (x_np & (y_np > 0)))
+
+
+def test_parallel_reduce():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(70, 16), "packed_bool", "input", "cpu"]
+        y: ft.Var[(70,), "packed_bool", "output", "cpu"]
+        for i in range(70):
+            y[i] = False
+        #! label: L
+        for j in range(16):
+            for i in range(70):
+                y[i] = ft.l_or(y[i], x[i, j])
+
+    s = ft.Schedule(test)
+    s.parallelize("L", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    x_np = np.random.rand(70, 16) < 0.05
+    y_arr = ft.array(np.zeros((70,), dtype="bool"), packed=True)
+    ft.build_binary(code, device)(x=ft.array(x_np, packed=True), y=y_arr)
+    assert np.array_equal(y_arr.numpy(), np.any(x_np, axis=1))
@@ -464,3 +464,112 @@ def test_serial_reduction_2():
 
     y_std = np.sum(x_np, axis=1) * 2
     assert np.array_equal(y_np, y_std)
+
+
+def test_parallel_reduction_different_ops():
+
+    @ft.transform
+    def test(x, y1, y2):
+        x: ft.Var[(4, 64), "int32", "input", "cpu"]
+        y1: ft.Var[(4,), "int32", "inout", "cpu"]
+        y2: ft.Var[(4,), "int32", "inout", "cpu"]
+        #! label: L1
+        for i in range(0, 4):
+            #! label: L2
+            for j in range(0, 64):
+                y1[i] += x[i, j]
+                y2[i] = ft.max(y2[i], x[i, j])
+
+    s = ft.Schedule(test)
+    s.parallelize("L2", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+
+    code = ft.codegen(func, target, verbose=True)
+    assert re.search(r"pragma omp parallel for.* reduction\(\+:.* "
+                     r"reduction\(max:", str(code))
+    assert "#pragma omp atomic" not in str(code)
+    x_np = np.random.randint(0, 100, (4, 64)).astype("int32")
+    y1_np = np.zeros((4,), dtype="int32")
+    y2_np = np.zeros((4,), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y1_arr = ft.Array(y1_np)
+    y2_arr = ft.Array(y2_np)
+    ft.build_binary(code, device)(x=x_arr, y1=y1_arr, y2=y2_arr)
+    y1_np = y1_arr.numpy()
+    y2_np = y2_arr.numpy()
+
+    assert np.array_equal(y1_np, np.sum(x_np, axis=1))
+    assert np.array_equal(y2_np, np.max(x_np, axis=1))
+
+
+def test_parallel_reduction_on_large_array():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(64, 4096), "int32", "input", "cpu"]
+        y: ft.Var[(4096,), "int32", "inout", "cpu"]
+        #! label: L1
+        for i in range(0, 64):
+            #! label: L2
+            for j in range(0, 4096):
+                y[j] += x[i, j]
+
+    s = ft.Schedule(test)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+
+    # Reduced by per-thread partials instead of a reduction clause
+    code = ft.codegen(func, target, verbose=True)
+    assert "reduction" not in str(code)
+    assert "omp_get_thread_num()" in str(code)
+    assert "#pragma omp atomic" not in str(code)
+    x_np = np.random.randint(0, 100, (64, 4096)).astype("int32")
+    y_np = np.zeros((4096,), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    ft.build_binary(code, device)(x=x_arr, y=y_arr)
+    y_np = y_arr.numpy()
+
+    y_std = np.sum(x_np, axis=0)
+    assert np.array_equal(y_np, y_std)
+
+
+@pytest.mark.parametrize('dtype', ['int32', 'float32', 'float64'])
+def test_atomic_min_max(dtype):
+
+    @ft.transform
+    def test(idx, x, y1, y2):
+        idx: ft.Var[(64,), "int32", "input", "cpu"]
+        x: ft.Var[(64,), dtype, "input", "cpu"]
+        y1: ft.Var[(8,), dtype, "inout", "cpu"]
+        y2: ft.Var[(8,), dtype, "inout", "cpu"]
+        #! label: L1
+        for i in range(0, 64):
+            y1[idx[i]] = ft.min(y1[idx[i]], x[i])
+            y2[idx[i]] = ft.max(y2[idx[i]], x[i])
+
+    s = ft.Schedule(test)
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+
+    code = ft.codegen(func, target, verbose=True)
+    assert "runtime_atomic_min" in str(code)
+    assert "runtime_atomic_max" in str(code)
+    idx_np = np.random.randint(0, 8, (64,)).astype("int32")
+    x_np = (np.random.rand(64) * 200 - 100).astype(dtype)
+    y1_np = np.full((8,), 1000, dtype=dtype)
+    y2_np = np.full((8,), -1000, dtype=dtype)
+    idx_arr = ft.Array(idx_np)
+    x_arr = ft.Array(x_np)
+    y1_arr = ft.Array(y1_np)
+    y2_arr = ft.Array(y2_np)
+    ft.build_binary(code, device)(idx=idx_arr, x=x_arr, y1=y1_arr, y2=y2_arr)
+    y1_np = y1_arr.numpy()
+    y2_np = y2_arr.numpy()
+
+    y1_std = np.full((8,), 1000, dtype=dtype)
+    y2_std = np.full((8,), -1000, dtype=dtype)
+    np.minimum.at(y1_std, idx_np, x_np)
+    np.maximum.at(y2_std, idx_np, x_np)
+    assert np.array_equal(y1_np, y1_std)
+    assert np.array_equal(y2_np, y2_std)
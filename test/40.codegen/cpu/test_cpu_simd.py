@@ -0,0 +1,292 @@
+import freetensor as ft
+import pytest
+import numpy as np
+
+
+def build(func, vector_bytes=32, streaming_stores=False):
+    device = ft.CPU()
+    target = device.target()
+    target.set_vector_bytes(vector_bytes)
+    target.set_streaming_stores(streaming_stores)
+    func = ft.lower(func, target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    return code, ft.Driver(func, code, device)
+
+
+def test_vector_bytes():
+    target = ft.CPU().target()
+    assert target.vector_bytes() in (16, 32, 64)
+    target.set_vector_bytes(32)
+    assert target.vector_bytes() == 32
+
+
+def test_tail():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(21,), "float32", "input", "cpu"]
+        y: ft.Var[(21,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(21):
+            y[i] = x[i] * 2 + i
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_load<float, 8>" in str(code)
+    assert "simd_store_partial<float, 8>" in str(code)
+    assert "#pragma omp simd" not in str(code)
+
+    x_np = np.random.rand(21).astype("float32")
+    y_arr = ft.Array(np.zeros((21,), dtype="float32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.allclose(y_arr.numpy(), x_np * 2 + np.arange(21))
+
+
+def test_width_of_widest_type():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(16,), "float32", "input", "cpu"]
+        y: ft.Var[(16,), "float64", "output", "cpu"]
+        #! label: L1
+        for i in range(16):
+            y[i] = x[i] + 1
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_load<float, 4>" in str(code)
+    assert "simd_store<double, 4>" in str(code)
+
+    x_np = np.random.rand(16).astype("float32")
+    y_arr = ft.Array(np.zeros((16,), dtype="float64"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.allclose(y_arr.numpy(), x_np + 1)
+
+
+def test_cond():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(20,), "int32", "input", "cpu"]
+        y: ft.Var[(20,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(20):
+            if x[i] > 0:
+                y[i] = x[i] // 3
+            else:
+                y[i] = -x[i] if x[i] < -5 else 0
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_store_masked<int32_t, 8>" in str(code)
+
+    x_np = np.random.randint(-10, 10, (20,)).astype("int32")
+    y_arr = ft.Array(np.zeros((20,), dtype="int32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    y_std = np.where(x_np > 0, x_np // 3, np.where(x_np < -5, -x_np, 0))
+    assert np.array_equal(y_arr.numpy(), y_std)
+
+
+def test_gather():
+
+    @ft.transform
+    def test(x, idx, y):
+        x: ft.Var[(100,), "float32", "input", "cpu"]
+        idx: ft.Var[(30,), "int32", "input", "cpu"]
+        y: ft.Var[(30,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(30):
+            y[i] = x[idx[i]]
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_gather<float, 8>" in str(code)
+    assert "simd_gather_masked<float, 8>" in str(code)
+
+    x_np = np.random.rand(100).astype("float32")
+    idx_np = np.random.randint(0, 100, (30,)).astype("int32")
+    y_arr = ft.Array(np.zeros((30,), dtype="float32"))
+    driver(x=ft.Array(x_np), idx=ft.Array(idx_np), y=y_arr)
+    assert np.array_equal(y_arr.numpy(), x_np[idx_np])
+
+
+def test_strided():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(16, 4), "float32", "input", "cpu"]
+        y: ft.Var[(16,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(16):
+            y[i] = x[i, 1]
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_gather<float, 8>" in str(code)
+
+    x_np = np.random.rand(16, 4).astype("float32")
+    y_arr = ft.Array(np.zeros((16,), dtype="float32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.array_equal(y_arr.numpy(), x_np[:, 1])
+
+
+def test_reduce():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4, 20), "float32", "input", "cpu"]
+        y: ft.Var[(20,), "float32", "output", "cpu"]
+        for i in range(20):
+            y[i] = 0
+        for k in range(4):
+            #! label: L1
+            for i in range(20):
+                y[i] = ft.max(y[i], x[k, i])
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_max<float, 8>" in str(code)
+
+    x_np = np.random.rand(4, 20).astype("float32")
+    y_arr = ft.Array(np.zeros((20,), dtype="float32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.allclose(y_arr.numpy(), np.max(x_np, axis=0))
+
+
+def test_horizontal_sum():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(21,), "float32", "input", "cpu"]
+        y: ft.Var[(), "float32", "output", "cpu"]
+        y[...] = 0
+        #! label: L1
+        for i in range(21):
+            y[...] += x[i]
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_reduce_add<float, 8>" in str(code)
+    assert "#pragma omp simd" not in str(code)
+
+    x_np = np.random.rand(21).astype("float32")
+    y_arr = ft.Array(np.zeros((), dtype="float32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.allclose(y_arr.numpy(), np.sum(x_np))
+
+
+def test_horizontal_max_in_tail():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(3, 21), "float32", "input", "cpu"]
+        y: ft.Var[(3,), "float32", "output", "cpu"]
+        for k in range(3):
+            y[k] = -1e30
+            #! label: L1
+            for i in range(21):
+                y[k] = ft.max(y[k], x[k, i])
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_reduce_max<float, 8>" in str(code)
+
+    # All negative, so the inactive lanes in the tail must not count as 0
+    x_np = -np.random.rand(3, 21).astype("float32") - 1
+    y_arr = ft.Array(np.zeros((3,), dtype="float32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.allclose(y_arr.numpy(), np.max(x_np, axis=1))
+
+
+def test_fallback_to_omp_simd():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4, 8), "int32", "input", "cpu"]
+        y: ft.Var[(4, 8), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(4):
+            for j in range(8):
+                y[i, j] = x[i, j] + 1
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "#pragma omp simd" in str(code)
+
+    x_np = np.random.randint(0, 100, (4, 8)).astype("int32")
+    y_arr = ft.Array(np.zeros((4, 8), dtype="int32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.array_equal(y_arr.numpy(), x_np + 1)
+
+
+def test_streaming_stores():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(4, 100), "float32", "input", "cpu"]
+        y: ft.Var[(4, 100), "float32", "output", "cpu"]
+        #! label: L0
+        for i in range(4):
+            #! label: L1
+            for j in range(100):
+                y[i, j] = x[i, j] * 2
+
+    s = ft.Schedule(test)
+    s.parallelize("L0", "openmp")
+    s.vectorize("L1")
+    code, driver = build(s.func(), streaming_stores=True)
+    assert "simd_store_stream<float, 8>" in str(code)
+    assert "simd_store_partial<float, 8>" in str(code)  # The tail
+    assert str(code).count("simd_stream_fence()") == 1
+    # Once per thread after the loop, not in every iteration
+    assert "#pragma omp for nowait" in str(code)
+
+    x_np = np.random.rand(4, 100).astype("float32")
+    y_arr = ft.Array(np.zeros((4, 100), dtype="float32"))
+    driver(x=ft.Array(x_np), y=y_arr)
+    assert np.allclose(y_arr.numpy(), x_np * 2)
+
+
+def test_no_streaming_stores_to_read_outputs():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(64,), "float32", "input", "cpu"]
+        y: ft.Var[(64,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(64):
+            y[i] = x[i] * 2
+        #! label: L2
+        for i in range(64):
+            y[i] += 1
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func(), streaming_stores=True)
+    assert "simd_store_stream" not in str(code)
+    assert "simd_stream_fence" not in str(code)
+
+
+def test_no_streaming_stores_by_default():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(64,), "float32", "input", "cpu"]
+        y: ft.Var[(64,), "float32", "output", "cpu"]
+        #! label: L1
+        for i in range(64):
+            y[i] = x[i] * 2
+
+    s = ft.Schedule(test)
+    s.vectorize("L1")
+    code, driver = build(s.func())
+    assert "simd_store_stream" not in str(code)
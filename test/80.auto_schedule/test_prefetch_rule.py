@@ -0,0 +1,51 @@
+import freetensor as ft
+import numpy as np
+
+target = ft.CPU()
+device = ft.Device(target.type())
+
+
+def test_indirect_read():
+    a = 64
+    b = 64
+
+    @ft.transform
+    def test(w, x, idx, y):
+        w: ft.Var[(a, b), "float32", "input", "cpu"]
+        x: ft.Var[(b, a), "float32", "input", "cpu"]
+        idx: ft.Var[(a,), "int32", "input", "cpu"]
+        y: ft.Var[(a, a), "float32", "output", "cpu"]
+        #! label: L1
+        for p in range(a):
+            #! label: L2
+            for q in range(a):
+                #! label: Init
+                y[p, q] = 0
+                #! label: L3
+                for k in range(b):
+                    y[p, q] = y[p, q] + w[p, k] * x[k, idx[q]]
+
+    s = ft.Schedule(test)
+    s = ft.AutoSchedule(
+        s,
+        target,
+        device,
+        rule_set={"multi_level_tiling", "parallelize", "prefetch"})
+    sch = s.test_round()
+    sch_log = sch.pretty_logs()
+    print(sch_log)
+    assert any(log.startswith("prefetch(") for log in sch_log)
+    func = ft.lower(sch.func(), target)
+    print(func)
+    code = ft.codegen(func, target, verbose=True)
+    assert "__builtin_prefetch" in str(code)
+
+    w_np = np.random.rand(a, b).astype("float32")
+    x_np = np.random.rand(b, a).astype("float32")
+    idx_np = np.random.permutation(a).astype("int32")
+    y_arr = ft.Array(np.zeros((a, a), dtype="float32"))
+    ft.build_binary(code, device)(w=ft.Array(w_np),
+                                  x=ft.Array(x_np),
+                                  idx=ft.Array(idx_np),
+                                  y=y_arr)
+    assert np.allclose(y_arr.numpy(), w_np @ x_np[:, idx_np], rtol=1e-4)